@@ -32,6 +32,7 @@
 #include <QMimeData>
 
 #include "MainSpectrum.h"
+#include "DeviceHotplugMonitor.h"
 
 using namespace SigDigger;
 
@@ -63,6 +64,10 @@ Application::Application(QWidget *parent) : QMainWindow(parent), m_ui(this)
   m_deviceDetectWorker = new DeviceDetectWorker();
   m_deviceDetectWorker->moveToThread(m_deviceDetectThread);
   m_deviceDetectThread->start();
+  m_hotplugMonitor = new DeviceHotplugMonitor(this);
+
+  m_detectTimeout.setSingleShot(true);
+  m_detectTimeout.setInterval(SIGDIGGER_DEVICE_DETECT_TIMEOUT_MS);
 
   setAcceptDrops(true);
 }
@@ -317,6 +322,18 @@ Application::connectDeviceDetect()
         SIGNAL(finished()),
         this,
         SLOT(onDetectFinished()));
+
+  connect(
+        &m_detectTimeout,
+        SIGNAL(timeout()),
+        this,
+        SLOT(onDetectTimeout()));
+
+  connect(
+        m_hotplugMonitor,
+        SIGNAL(changed()),
+        this,
+        SLOT(onHotplug()));
 }
 
 QString
@@ -731,13 +748,69 @@ Application::onSeek(struct timeval tv)
 void
 Application::onDeviceRefresh()
 {
+  this->requestDeviceDetect();
+}
+
+//
+// Sweeps are serialized: requests arriving while one is in progress (e.g.
+// a burst of hot-plug events) are folded into a single sweep after it.
+//
+void
+Application::requestDeviceDetect()
+{
+  if (m_detecting) {
+    m_detectPending = true;
+    return;
+  }
+
+  m_detecting = true;
+  m_detectTimeout.start();
+
   emit detectDevices();
 }
 
 void
 Application::onDetectFinished()
 {
-  m_mediator->refreshDevicesDone();
+  Suscan::Singleton *sing = Suscan::Singleton::get_instance();
+  std::vector<Suscan::Source::Device> added, removed;
+  bool changed;
+
+  m_detecting = false;
+  m_detectTimeout.stop();
+
+  changed = sing->updateDevices(added, removed);
+
+  for (auto const &dev : added)
+    SU_INFO("Device available: %s\n", dev.getDesc().c_str());
+
+  for (auto const &dev : removed)
+    SU_INFO("Device gone: %s\n", dev.getDesc().c_str());
+
+  m_mediator->refreshDevicesDone(changed);
+
+  if (m_detectPending) {
+    m_detectPending = false;
+    this->requestDeviceDetect();
+  }
+}
+
+void
+Application::onDetectTimeout()
+{
+  // Let the user go on with the devices we know of. The late results will
+  // be merged when they arrive.
+  SU_WARNING(
+        "Device discovery still running after %d seconds\n",
+        SIGDIGGER_DEVICE_DETECT_TIMEOUT_MS / 1000);
+
+  m_mediator->refreshDevicesDone(false);
+}
+
+void
+Application::onHotplug()
+{
+  this->requestDeviceDetect();
 }
 
 void
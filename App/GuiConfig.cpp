@@ -41,6 +41,7 @@ GuiConfig::loadDefaults(void)
   this->useMaxBlending = false;
   this->enableMsgTTL   = true;
   this->msgTTL         = 15; // in milliseconds
+  this->adaptivePSD    = true;
   this->infoTextColor  = SIGDIGGER_DEFAULT_INFOTEXT_COLOR;
 }
 
@@ -68,6 +69,7 @@ GuiConfig::serialize(void)
   STORE(useGlInWindows);
   STORE(enableMsgTTL);
   STORE(msgTTL);
+  STORE(adaptivePSD);
   STORE(infoText);
   CCSTORE(infoTextColor);
 
@@ -84,6 +86,7 @@ GuiConfig::deserialize(Suscan::Object const &conf)
   LOAD(useGlInWindows);
   LOAD(enableMsgTTL);
   LOAD(msgTTL);
+  LOAD(adaptivePSD);
   LOAD(infoText);
   CCLOAD(infoTextColor);
 }
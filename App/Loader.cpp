@@ -24,6 +24,7 @@
 #include <SigDiggerHelpers.h>
 
 #include <Loader.h>
+#include <StartupTaskGraph.h>
 
 #ifdef HAVE_CURL
 #include <curl/curl.h>
@@ -34,47 +35,105 @@ using namespace SigDigger;
 //////////////////////////////// Loader thread ///////////////////////////////
 InitThread::InitThread(QObject *parent) : QThread(parent) { }
 
+void
+InitThread::setProfiling(bool profile)
+{
+  m_profile = profile;
+}
+
+//
+// The suscan config database is not thread safe, so stages reading from it
+// are chained in their original order. The built-in class registries,
+// wisdom generation and TLE parsing are independent from it.
+//
 void
 InitThread::run()
 {
   Suscan::Singleton *sing = Suscan::Singleton::get_instance();
+  StartupTaskGraph graph;
   QString verString;
+  int prev;
+  std::vector<int> ends;
+
+  struct Stage {
+    const char *name;
+    const char *message;
+    void (Suscan::Singleton::*init)();
+  };
+
+  static const Stage configStages[] = {
+    {"sources",       "Loading signal sources",    &Suscan::Singleton::init_sources},
+    {"palettes",      "Loading palettes",          &Suscan::Singleton::init_palettes},
+    {"fats",          "Loading frequency tables",  &Suscan::Singleton::init_fats},
+    {"bookmarks",     "Loading bookmarks",         &Suscan::Singleton::init_bookmarks},
+    {"locations",     "Loading locations",         &Suscan::Singleton::init_locations},
+    {"tle_sources",   "Loading TLE sources",       &Suscan::Singleton::init_tle_sources},
+    {"autogains",     "Loading auto gains",        &Suscan::Singleton::init_autogains},
+    {"ui_config",     "Loading UI config",         &Suscan::Singleton::init_ui_config},
+    {"recent",        "Loading profile history",   &Suscan::Singleton::init_recent_list}
+  };
+
+  static const Stage classStages[] = {
+    {"spectrum_sources", "Loading spectrum sources", &Suscan::Singleton::init_spectrum_sources},
+    {"estimators",       "Loading estimators",       &Suscan::Singleton::init_estimators},
+    {"inspectors",       "Loading inspectors",       &Suscan::Singleton::init_inspectors}
+  };
+
+  auto addChain = [&] (const Stage *stages, size_t count) {
+    prev = -1;
+    for (size_t i = 0; i < count; ++i) {
+      auto init = stages[i].init;
+      prev = graph.add(
+            stages[i].name,
+            stages[i].message,
+            [sing, init] () { (sing->*init)(); },
+            prev < 0 ? std::vector<int>() : std::vector<int>{prev});
+    }
+    ends.push_back(prev);
+  };
 
   try {
-    emit change("Generating FFT wisdom (this may take a while)");
-    su_lib_gen_wisdom();
-    emit change("Loading signal sources");
-    sing->init_sources();
-    emit change("Loading spectrum sources");
-    sing->init_spectrum_sources();
-    emit change("Loading estimators");
-    sing->init_estimators();
-    emit change("Loading inspectors");
-    sing->init_inspectors();
-    emit change("Loading palettes");
-    sing->init_palettes();
-    emit change("Loading frequency tables");
-    sing->init_fats();
-    emit change("Loading bookmarks");
-    sing->init_bookmarks();
-    emit change("Loading locations");
-    sing->init_locations();
-    emit change("Loading TLE sources");
-    sing->init_tle_sources();
-    emit change("Loading satellites from TLE");
-    sing->init_tle();
-    emit change("Loading auto gains");
-    sing->init_autogains();
-    emit change("Loading UI config");
-    sing->init_ui_config();
-    emit change("Loading profile history");
-    sing->init_recent_list();
-    emit change("Init done, triggering delayed plugin tasks...");
-    sing->trigger_delayed();
+    QString tleDir;
+
+    sing->init_startup_cache();
+
+    // Resolved before the config stages start using the confdb
+    tleDir = sing->getUserTLEDir();
+
+    ends.push_back(
+          graph.add(
+            "wisdom",
+            "Generating FFT wisdom (this may take a while)",
+            [] () { su_lib_gen_wisdom(); }));
+
+    addChain(configStages, sizeof(configStages) / sizeof(configStages[0]));
+    addChain(classStages, sizeof(classStages) / sizeof(classStages[0]));
+
+    ends.push_back(
+          graph.add(
+            "tle",
+            "Loading satellites from TLE",
+            [sing, tleDir] () { sing->init_tle(tleDir); }));
+
+    graph.add(
+          "delayed",
+          "Init done, triggering delayed plugin tasks",
+          [sing] () { sing->trigger_delayed(); },
+          ends);
+
+    graph.run([this] (QString const &message) { emit change(message); });
+
+    sing->saveStartupCache();
   } catch (Suscan::Exception const &e) {
     emit failure(QString(e.what()));
   }
 
+  if (m_profile)
+    fprintf(
+          stderr,
+          "Startup profile:\n%s",
+          graph.report().toStdString().c_str());
+
   verString =
       "SigDigger "
       + SigDiggerHelpers::version()
@@ -246,6 +305,8 @@ Loader::saveConfig()
     sing->sync();
 
     Suscan::ConfigContext::saveAll();
+
+    sing->saveStartupCache();
   } catch (Suscan::Exception const &e) {
     QWidget *parent = isVisible()
         ? SCAST(QWidget *, this)
@@ -267,6 +328,12 @@ Loader::showMessage(const QString &message)
 }
 
 
+void
+Loader::setStartupProfile(bool profile)
+{
+  m_initThread->setProfiling(profile);
+}
+
 void
 Loader::load()
 {
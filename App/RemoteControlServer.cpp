@@ -20,6 +20,10 @@
 #include "RemoteControlServer.h"
 #include <QTcpSocket>
 #include <QTcpServer>
+#include <QTimer>
+#include <QtEndian>
+#include <cstring>
+#include <cstddef>
 #include <QCommandLineParser>
 #include <GlobalProperty.h>
 #include <Suscan/Logger.h>
@@ -33,10 +37,66 @@ using namespace SigDigger;
 #  define sliced(...) mid(__VA_ARGS__)
 #endif
 
+// Time until something last pushed at `last' can be pushed again
+static inline qint64
+dueIn(qint64 last, qint64 interval, qint64 now)
+{
+  if (last < 0)
+    return 0;
+
+  return qMax<qint64>(last + interval - now, 0);
+}
+
+static bool
+parseRate(QString const &string, qint64 &interval)
+{
+  bool ok;
+  qreal rate = string.toDouble(&ok);
+
+  if (!ok || rate < 0)
+    return false;
+
+  interval = rate > 0 ? qMax<qint64>(qRound64(1000 / rate), 1) : 0;
+
+  return true;
+}
+
+static QString
+rateString(qint64 interval)
+{
+  return interval > 0 ? QString::number(1000. / interval) : QString("0");
+}
+
+template<typename T>
+static inline void
+appendLE(QByteArray &buffer, T value)
+{
+  T le = qToLittleEndian(value);
+  buffer.append(reinterpret_cast<const char *>(&le), sizeof(T));
+}
+
+static inline void
+appendF32(QByteArray &buffer, float value)
+{
+  quint32 bits;
+  memcpy(&bits, &value, sizeof(float));
+  appendLE(buffer, bits);
+}
+
+static inline void
+appendF64(QByteArray &buffer, double value)
+{
+  quint64 bits;
+  memcpy(&bits, &value, sizeof(double));
+  appendLE(buffer, bits);
+}
+
 RemoteControlClient::RemoteControlClient(
-    QTcpSocket *socket)
+    QTcpSocket *socket,
+    RemoteControlServer *server)
 {
   this->socket   = socket;
+  this->server   = server;
 
   SU_INFO("Remote client created\n");
   write(
@@ -51,6 +111,451 @@ RemoteControlClient::write(QString const &data)
   socket->write(data.toUtf8());
 }
 
+bool
+RemoteControlClient::isSubscribed(QString const &name) const
+{
+  return subscribeAll || subscriptions.contains(name);
+}
+
+//
+// Push pending property changes (prefixed by `!' so they can be told apart
+// from command replies) and stream frames that are due. Returns the time
+// (in ms) after which this should be attempted again, or 0 if nothing is
+// left.
+//
+qint64
+RemoteControlClient::flush(qint64 now)
+{
+  qint64 next = 0;
+  qint64 delay;
+
+  auto update = [&next] (qint64 d) {
+    if (d > 0 && (next == 0 || d < next))
+      next = d;
+  };
+
+  if (!pending.isEmpty()) {
+    if (lastPush >= 0 && now - lastPush < interval) {
+      update(lastPush + interval - now);
+    } else if (socket->bytesToWrite() > SIGDIGGER_REMOTE_CONTROL_MAX_BACKLOG) {
+      // The client is not reading. Keep coalescing until it catches up.
+      update(qMax<qint64>(interval, 10));
+    } else {
+      QString data;
+
+      for (auto &name : pending) {
+        GlobalProperty *prop = GlobalProperty::lookupProperty(name);
+        if (prop != nullptr)
+          data += "! " + name + " = " + prop->toString() + "\n";
+      }
+
+      pending.clear();
+      lastPush = now;
+
+      if (!data.isEmpty())
+        write(data);
+    }
+  }
+
+  if ((delay = flushPSD(now)) > 0)
+    update(delay);
+
+  for (auto it = power.begin(); it != power.end(); ++it)
+    if ((delay = flushPower(it.key(), it.value(), now)) > 0)
+      update(delay);
+
+  return next;
+}
+
+void
+RemoteControlClient::beginFrame(
+    uint8_t type,
+    uint16_t source,
+    uint32_t sequence)
+{
+  frame.resize(0); // Keeps the allocation
+
+  appendLE<quint8>(frame, SIGDIGGER_REMOTE_CONTROL_FRAME_SYNC);
+  appendLE<quint8>(frame, type);
+  appendLE<quint16>(frame, source);
+  appendLE<quint32>(frame, sequence);
+  appendLE<quint32>(frame, 0); // Length, set by endFrame
+}
+
+void
+RemoteControlClient::endFrame()
+{
+  quint32 length = qToLittleEndian<quint32>(
+        static_cast<quint32>(
+          frame.size() - sizeof(RemoteControlFrameHeader)));
+
+  memcpy(
+        frame.data() + offsetof(RemoteControlFrameHeader, length),
+        &length,
+        sizeof(quint32));
+
+  socket->write(frame);
+}
+
+qint64
+RemoteControlClient::flushPSD(qint64 now)
+{
+  const std::vector<float> *data;
+  quint64 frameNo;
+  qreal timeStamp, frequency, sampleRate;
+  size_t decimation = 1, bins, size;
+
+  if (!psdStream)
+    return 0;
+
+  if (!server->getPSD(frameNo, timeStamp, frequency, sampleRate, data))
+    return 0;
+
+  if (frameNo == psd.lastFrame)
+    return 0;
+
+  if (psd.lastPush >= 0 && now - psd.lastPush < psd.interval)
+    return psd.lastPush + psd.interval - now;
+
+  // Skip frames instead of queuing them
+  if (socket->bytesToWrite() > SIGDIGGER_REMOTE_CONTROL_MAX_BACKLOG)
+    return qMax<qint64>(psd.interval, 10);
+
+  size = data->size();
+  if (psd.bins > 0 && size > psd.bins)
+    decimation = (size + psd.bins - 1) / psd.bins;
+  bins = (size + decimation - 1) / decimation;
+
+  beginFrame(SIGDIGGER_REMOTE_CONTROL_FRAME_PSD, 0, psd.sequence++);
+  frame.reserve(
+        static_cast<int>(
+          sizeof(RemoteControlFrameHeader) + 32 + bins * sizeof(float)));
+
+  appendF64(frame, timeStamp);
+  appendF64(frame, frequency);
+  appendF64(frame, sampleRate);
+  appendLE<quint32>(frame, static_cast<quint32>(bins));
+  appendLE<quint32>(frame, static_cast<quint32>(decimation));
+
+  // Decimate by keeping the peak of each group, so that narrow carriers
+  // survive the reduction
+  for (size_t i = 0; i < size; i += decimation) {
+    size_t end = qMin(i + decimation, size);
+    float max = (*data)[i];
+
+    for (size_t j = i + 1; j < end; ++j)
+      if ((*data)[j] > max)
+        max = (*data)[j];
+
+    appendF32(frame, max);
+  }
+
+  endFrame();
+
+  psd.lastFrame = frameNo;
+  psd.lastPush  = now;
+
+  return 0;
+}
+
+qint64
+RemoteControlClient::flushPower(
+    int id,
+    RemoteControlStream &stream,
+    qint64 now)
+{
+  if (stream.samples.empty())
+    return 0;
+
+  if (stream.lastPush >= 0 && now - stream.lastPush < stream.interval)
+    return stream.lastPush + stream.interval - now;
+
+  // Keep batching (up to MAX_POWER_BATCH) until the client catches up
+  if (socket->bytesToWrite() > SIGDIGGER_REMOTE_CONTROL_MAX_BACKLOG)
+    return qMax<qint64>(stream.interval, 10);
+
+  beginFrame(
+        SIGDIGGER_REMOTE_CONTROL_FRAME_POWER,
+        static_cast<uint16_t>(id),
+        stream.sequence++);
+
+  appendLE<quint32>(frame, static_cast<quint32>(stream.samples.size()));
+  appendLE<quint32>(frame, stream.dropped);
+
+  for (auto &sample : stream.samples) {
+    appendF64(frame, sample.timestamp);
+    appendF32(frame, static_cast<float>(sample.power));
+  }
+
+  endFrame();
+
+  stream.samples.clear();
+  stream.dropped  = 0;
+  stream.lastPush = now;
+
+  return 0;
+}
+
+void
+RemoteControlClient::pushPowerSample(int id, qreal timestamp, qreal value)
+{
+  auto it = power.find(id);
+
+  if (it != power.end()) {
+    auto &samples = it.value().samples;
+
+    if (samples.size() >= SIGDIGGER_REMOTE_CONTROL_MAX_POWER_BATCH) {
+      samples.pop_front();
+      ++it.value().dropped;
+    }
+
+    samples.push_back({timestamp, value});
+  }
+}
+
+// set <prop> <value> [<prop> <value> ...]
+void
+RemoteControlClient::doSet(QStringList const &args)
+{
+  QList<GlobalProperty *> props;
+  QString reply;
+
+  if (args.size() < 3 || (args.size() & 1) == 0) {
+    write(args[0] + ": invalid number of arguments\n");
+    return;
+  }
+
+  // Validate everything first: a batch is applied entirely or not at all
+  for (int i = 1; i < args.size(); i += 2) {
+    GlobalProperty *prop = GlobalProperty::lookupProperty(args[i]);
+    if (prop == nullptr) {
+      write(args[0] + " " + args[i] + ": unknown property\n");
+      return;
+    } else if (!prop->adjustable()) {
+      write(args[0] + " " + args[i] + ": property is read-only\n");
+      return;
+    }
+
+    props.append(prop);
+  }
+
+  for (int i = 0; i < props.size(); ++i)
+    props[i]->setValue(args[2 * i + 2]);
+
+  // Values are read back, as the property may not accept the requested one
+  for (auto prop : props)
+    reply += prop->name() + " = " + prop->toString() + "\n";
+
+  write(reply);
+}
+
+// get <prop> [<prop> ...]
+void
+RemoteControlClient::doGet(QStringList const &args)
+{
+  QString reply;
+
+  if (args.size() < 2) {
+    write(args[0] + ": invalid number of arguments\n");
+    return;
+  }
+
+  for (int i = 1; i < args.size(); ++i) {
+    GlobalProperty *prop = GlobalProperty::lookupProperty(args[i]);
+    if (prop == nullptr)
+      reply += args[0] + " " + args[i] + ": unknown property\n";
+    else
+      reply += args[i] + " = " + prop->toString() + "\n";
+  }
+
+  write(reply);
+}
+
+// subscribe [<prop> ...]: no properties (or `*') means all of them.
+// Replies with the current value of each property, as `get' does.
+void
+RemoteControlClient::doSubscribe(QStringList const &args)
+{
+  QStringList names;
+  QString reply;
+
+  if (args.size() == 1 || args.contains("*")) {
+    subscribeAll = true;
+    subscriptions.clear();
+    names = GlobalProperty::getProperties();
+  } else {
+    names = args.sliced(1);
+  }
+
+  for (auto &name : names) {
+    GlobalProperty *prop = GlobalProperty::lookupProperty(name);
+    if (prop == nullptr) {
+      reply += args[0] + " " + name + ": unknown property\n";
+    } else {
+      if (!subscribeAll)
+        subscriptions.insert(name);
+      server->watchProperty(prop);
+      reply += name + " = " + prop->toString() + "\n";
+    }
+  }
+
+  write(reply);
+}
+
+// unsubscribe [<prop> ...]: no properties (or `*') means all of them.
+void
+RemoteControlClient::doUnsubscribe(QStringList const &args)
+{
+  if (args.size() == 1 || args.contains("*")) {
+    subscribeAll = false;
+    subscriptions.clear();
+  } else {
+    if (subscribeAll) {
+      for (auto &name : GlobalProperty::getProperties())
+        subscriptions.insert(name);
+      subscribeAll = false;
+    }
+
+    for (int i = 1; i < args.size(); ++i)
+      subscriptions.remove(args[i]);
+  }
+
+  for (auto it = pending.begin(); it != pending.end(); )
+    if (!isSubscribed(*it))
+      it = pending.erase(it);
+    else
+      ++it;
+
+  write(
+        args[0]
+        + ": "
+        + QString::number(subscriptions.size())
+        + " subscriptions left\n");
+}
+
+// rate [<Hz>]: maximum rate of pushed updates, 0 for unlimited
+void
+RemoteControlClient::doRate(QStringList const &args)
+{
+  if (args.size() > 2) {
+    write(args[0] + ": invalid number of arguments\n");
+    return;
+  }
+
+  if (args.size() == 2 && !parseRate(args[1], interval)) {
+    write(args[0] + " " + args[1] + ": invalid rate\n");
+    return;
+  }
+
+  write("rate = " + rateString(interval) + "\n");
+}
+
+//
+// stream list
+// stream psd [<Hz> [<bins>]]
+// stream power <source> [<Hz>]
+// stream stop [psd | power <source>]
+//
+void
+RemoteControlClient::doStream(QStringList const &args)
+{
+  QString what = args.size() > 1 ? args[1].toLower() : QString();
+  QString prefix = args[0] + " " + what;
+  auto const &sources = server->powerSources();
+
+  if (what == "list") {
+    QString reply;
+
+    for (auto it = sources.begin(); it != sources.end(); ++it)
+      reply += "power " + QString::number(it.key()) + " = " + it.value() + "\n";
+
+    if (reply.isEmpty())
+      reply = prefix + ": no power sources\n";
+
+    write(reply);
+  } else if (what == "psd") {
+    RemoteControlStream stream;
+
+    if (args.size() > 4) {
+      write(prefix + ": invalid number of arguments\n");
+      return;
+    }
+
+    if (args.size() > 2 && !parseRate(args[2], stream.interval)) {
+      write(prefix + " " + args[2] + ": invalid rate\n");
+      return;
+    }
+
+    if (args.size() > 3) {
+      bool ok;
+      stream.bins = args[3].toUInt(&ok);
+      if (!ok) {
+        write(prefix + " " + args[3] + ": invalid number of bins\n");
+        return;
+      }
+    }
+
+    // Keep the frame counter so that clients can adjust on the fly
+    stream.sequence = psd.sequence;
+    psd = stream;
+    psdStream = true;
+
+    write(
+          prefix
+          + ": rate = " + rateString(psd.interval)
+          + ", bins = " + QString::number(psd.bins) + "\n");
+  } else if (what == "power") {
+    RemoteControlStream stream;
+    bool ok;
+    int id;
+
+    if (args.size() < 3 || args.size() > 4) {
+      write(prefix + ": invalid number of arguments\n");
+      return;
+    }
+
+    id = args[2].toInt(&ok);
+    if (!ok || !sources.contains(id)) {
+      write(prefix + " " + args[2] + ": unknown power source\n");
+      return;
+    }
+
+    if (args.size() > 3 && !parseRate(args[3], stream.interval)) {
+      write(prefix + " " + args[3] + ": invalid rate\n");
+      return;
+    }
+
+    if (power.contains(id)) {
+      power[id].interval = stream.interval;
+    } else {
+      power[id] = std::move(stream);
+    }
+
+    write(
+          prefix + " " + args[2]
+          + ": rate = " + rateString(power[id].interval) + "\n");
+  } else if (what == "stop") {
+    if (args.size() == 2) {
+      psdStream = false;
+      power.clear();
+    } else if (args[2].toLower() == "psd" && args.size() == 3) {
+      psdStream = false;
+    } else if (args[2].toLower() == "power" && args.size() == 4) {
+      power.remove(args[3].toInt());
+    } else {
+      write(prefix + ": invalid arguments\n");
+      return;
+    }
+
+    write(
+          prefix + ": "
+          + QString::number(power.size() + (psdStream ? 1 : 0))
+          + " streams left\n");
+  } else {
+    write(args[0] + ": expected list, psd, power or stop\n");
+  }
+}
+
 void
 RemoteControlClient::process()
 {
@@ -65,31 +570,20 @@ RemoteControlClient::process()
       } else if (args.size() > 0) {
         QString command = args[0].toLower();
 
+        args[0] = command;
+
         if (command == "set") {
-          if (args.size() != 3) {
-            write(command + ": invalid number of arguments\n");
-          } else {
-            GlobalProperty *prop = GlobalProperty::lookupProperty(args[1]);
-            if (prop == nullptr) {
-              write(command + " " + args[1] + ": unknown property\n");
-            } else if (!prop->adjustable()) {
-              write(command + " " + args[1] + ": property is read-only\n");
-            } else {
-              prop->setValue(args[2]);
-              write(args[1] + " = " + prop->toString() + "\n");
-            }
-          }
+          doSet(args);
         } else if (command == "get") {
-          if (args.size() != 2) {
-            write(command + ": invalid number of arguments\n");
-          } else {
-            GlobalProperty *prop = GlobalProperty::lookupProperty(args[1]);
-            if (prop == nullptr) {
-              write(command + " " + args[1] + ": unknown property\n");
-            } else {
-              write(args[1] + " = " + prop->toString() + "\n");
-            }
-          }
+          doGet(args);
+        } else if (command == "subscribe") {
+          doSubscribe(args);
+        } else if (command == "unsubscribe") {
+          doUnsubscribe(args);
+        } else if (command == "rate") {
+          doRate(args);
+        } else if (command == "stream") {
+          doStream(args);
         } else if (command == "list") {
           if (args.size() != 1) {
             write(command + ": invalid number of arguments\n");
@@ -119,6 +613,9 @@ RemoteControlClient::~RemoteControlClient()
 RemoteControlServer::RemoteControlServer(QObject *parent) : QObject(parent)
 {
   m_server = new QTcpServer(this);
+  m_pushTimer = new QTimer(this);
+  m_pushTimer->setSingleShot(true);
+  m_clock.start();
 
   connectAll();
 }
@@ -131,12 +628,162 @@ RemoteControlServer::connectAll()
         SIGNAL(newConnection()),
         this,
         SLOT(onNewConnection()));
+
+  connect(
+        m_pushTimer,
+        SIGNAL(timeout()),
+        this,
+        SLOT(onPushTimeout()));
+}
+
+qint64
+RemoteControlServer::now() const
+{
+  return m_clock.elapsed();
+}
+
+void
+RemoteControlServer::watchProperty(GlobalProperty *prop)
+{
+  if (!m_watched.contains(prop)) {
+    m_watched.insert(prop);
+    connect(
+          prop,
+          SIGNAL(changed()),
+          this,
+          SLOT(onPropertyChanged()));
+  }
+}
+
+bool
+RemoteControlServer::wantsPSD() const
+{
+  for (auto client : m_clientList)
+    if (client->psdStream)
+      return true;
+
+  return false;
+}
+
+void
+RemoteControlServer::publishPSD(
+    qreal timeStamp,
+    qreal frequency,
+    qreal sampleRate,
+    const SUFLOAT *data,
+    size_t size)
+{
+  qint64 t = now();
+  qint64 next = -1;
+
+  m_psd.resize(size);
+  for (size_t i = 0; i < size; ++i)
+    m_psd[i] = static_cast<float>(data[i]);
+
+  m_psdTimeStamp  = timeStamp;
+  m_psdFrequency  = frequency;
+  m_psdSampleRate = sampleRate;
+  ++m_psdFrame;
+
+  for (auto client : m_clientList) {
+    if (client->psdStream) {
+      qint64 due = dueIn(client->psd.lastPush, client->psd.interval, t);
+      if (next < 0 || due < next)
+        next = due;
+    }
+  }
+
+  if (next >= 0)
+    schedulePush(next);
+}
+
+bool
+RemoteControlServer::getPSD(
+    quint64 &frame,
+    qreal &timeStamp,
+    qreal &frequency,
+    qreal &sampleRate,
+    std::vector<float> const *&data) const
+{
+  if (m_psdFrame == 0)
+    return false;
+
+  frame      = m_psdFrame;
+  timeStamp  = m_psdTimeStamp;
+  frequency  = m_psdFrequency;
+  sampleRate = m_psdSampleRate;
+  data       = &m_psd;
+
+  return true;
+}
+
+int
+RemoteControlServer::registerPowerSource(QString const &label)
+{
+  // Ids must fit in the 16-bit source field of the frame header
+  do {
+    if (++m_lastPowerSource > 0xffff)
+      m_lastPowerSource = 1;
+  } while (m_powerSources.contains(m_lastPowerSource));
+
+  m_powerSources.insert(m_lastPowerSource, label);
+
+  return m_lastPowerSource;
+}
+
+void
+RemoteControlServer::unregisterPowerSource(int id)
+{
+  if (m_powerSources.remove(id) > 0) {
+    for (auto client : m_clientList) {
+      if (client->power.remove(id) > 0)
+        client->write(
+              "! stream power "
+              + QString::number(id)
+              + ": source closed\n");
+    }
+  }
+}
+
+void
+RemoteControlServer::publishPower(int id, qreal timeStamp, qreal value)
+{
+  qint64 t = now();
+  qint64 next = -1;
+
+  for (auto client : m_clientList) {
+    auto it = client->power.find(id);
+
+    if (it != client->power.end()) {
+      client->pushPowerSample(id, timeStamp, value);
+
+      qint64 due = dueIn(it.value().lastPush, it.value().interval, t);
+      if (next < 0 || due < next)
+        next = due;
+    }
+  }
+
+  if (next >= 0)
+    schedulePush(next);
+}
+
+QMap<int, QString> const &
+RemoteControlServer::powerSources() const
+{
+  return m_powerSources;
+}
+
+void
+RemoteControlServer::schedulePush(qint64 delay)
+{
+  if (!m_pushTimer->isActive() || m_pushTimer->remainingTime() > delay)
+    m_pushTimer->start(static_cast<int>(delay));
 }
 
 void
 RemoteControlServer::addConnection(QTcpSocket *socket)
 {
-  RemoteControlClient *client = new RemoteControlClient(socket);
+  RemoteControlClient *client = new RemoteControlClient(socket, this);
 
   m_clientList.push_front(client);
   client->iterator = m_clientList.begin();
@@ -256,3 +903,46 @@ RemoteControlServer::onDisconnect()
 
   removeConnection(socket);
 }
+
+void
+RemoteControlServer::onPropertyChanged()
+{
+  GlobalProperty *prop = qobject_cast<GlobalProperty *>(QObject::sender());
+
+  if (prop == nullptr)
+    return;
+
+  QString name = prop->name();
+  qint64 t = now();
+  qint64 next = -1;
+
+  for (auto client : m_clientList) {
+    if (client->isSubscribed(name)) {
+      qint64 due = dueIn(client->lastPush, client->interval, t);
+      client->pending.insert(name);
+      if (next < 0 || due < next)
+        next = due;
+    }
+  }
+
+  // Deferred to the event loop, so that bursts of changes (e.g. date,
+  // time and datetime) are delivered together
+  if (next >= 0)
+    schedulePush(next);
+}
+
+void
+RemoteControlServer::onPushTimeout()
+{
+  qint64 t = now();
+  qint64 next = 0;
+
+  for (auto client : m_clientList) {
+    qint64 delay = client->flush(t);
+    if (delay > 0 && (next == 0 || delay < next))
+      next = delay;
+  }
+
+  if (next > 0)
+    schedulePush(next);
+}
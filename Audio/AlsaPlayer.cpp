@@ -29,7 +29,8 @@ using namespace SigDigger;
 AlsaPlayer::AlsaPlayer(
     std::string const &dev,
     unsigned int rate,
-    size_t bufSiz) :
+    size_t bufSiz,
+    unsigned int channels) :
   GenericAudioPlayer(rate)
 {
   int err;
@@ -64,8 +65,8 @@ AlsaPlayer::AlsaPlayer(
         "set buffer size");
 
   ATTEMPT(
-        snd_pcm_hw_params_set_channels(this->pcm, params, 1),
-        "set output to mono");
+        snd_pcm_hw_params_set_channels(this->pcm, params, channels),
+        "set number of output channels");
 
   ATTEMPT(
         snd_pcm_hw_params_set_rate_near(this->pcm, params, &rate, nullptr),
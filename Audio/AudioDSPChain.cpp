@@ -0,0 +1,529 @@
+//
+//    AudioDSPChain.cpp: Client-side audio processing stages
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <AudioDSPChain.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace SigDigger;
+
+/////////////////////////////// AudioDSPStage //////////////////////////////////
+AudioDSPStage::AudioDSPStage()
+  : m_enabled(false),
+    m_cpuLoad(0.f),
+    m_sampRate(44100)
+{
+}
+
+AudioDSPStage::~AudioDSPStage()
+{
+}
+
+size_t
+AudioDSPStage::latency() const
+{
+  return 0;
+}
+
+void
+AudioDSPStage::setEnabled(bool enabled)
+{
+  m_enabled = enabled;
+}
+
+bool
+AudioDSPStage::isEnabled() const
+{
+  return m_enabled;
+}
+
+float
+AudioDSPStage::getCpuLoad() const
+{
+  return m_cpuLoad;
+}
+
+unsigned int
+AudioDSPStage::getSampleRate() const
+{
+  return m_sampRate;
+}
+
+void
+AudioDSPStage::setSampleRate(unsigned int rate)
+{
+  m_sampRate = rate;
+  this->reset();
+}
+
+void
+AudioDSPStage::run(float *data, size_t len)
+{
+  bool enabled = m_enabled.load(std::memory_order_relaxed);
+
+  // Stages start from a clean state every time they are enabled
+  if (enabled != m_active) {
+    m_active = enabled;
+    if (enabled) {
+      this->reset();
+    } else {
+      m_loadAvg = 0;
+      m_cpuLoad = 0;
+    }
+  }
+
+  if (!m_active || len == 0)
+    return;
+
+  auto t0 = std::chrono::steady_clock::now();
+  this->process(data, len);
+  auto t1 = std::chrono::steady_clock::now();
+
+  float elapsed  = std::chrono::duration<float>(t1 - t0).count();
+  float duration = static_cast<float>(len) / static_cast<float>(m_sampRate);
+
+  m_loadAvg += SIGDIGGER_AUDIO_DSP_LOAD_ALPHA * (elapsed / duration - m_loadAvg);
+  m_cpuLoad.store(m_loadAvg, std::memory_order_relaxed);
+}
+
+////////////////////////////// AudioDeemphasis /////////////////////////////////
+AudioDeemphasis::AudioDeemphasis() : m_tau(50e-6f)
+{
+}
+
+const char *
+AudioDeemphasis::name() const
+{
+  return "De-emphasis";
+}
+
+void
+AudioDeemphasis::setTau(float tau)
+{
+  m_tau = tau;
+}
+
+void
+AudioDeemphasis::reset()
+{
+  m_curTau = 0;
+  m_y      = 0;
+}
+
+void
+AudioDeemphasis::process(float *data, size_t len)
+{
+  float tau = m_tau.load(std::memory_order_relaxed);
+  float y   = m_y;
+
+  if (tau != m_curTau) {
+    m_curTau = tau;
+    m_alpha  = tau > 0
+        ? 1.f - expf(-1.f / (static_cast<float>(m_sampRate) * tau))
+        : 1.f;
+  }
+
+  // First-order lowpass. Recursive, so it cannot be vectorized, but it
+  // is a single multiply-add per sample.
+  for (size_t i = 0; i < len; ++i) {
+    y += m_alpha * (data[i] - y);
+    data[i] = y;
+  }
+
+  m_y = y;
+}
+
+///////////////////////////////// AudioNotch ///////////////////////////////////
+AudioNotch::AudioNotch() : m_freq(1000.f), m_q(10.f)
+{
+}
+
+const char *
+AudioNotch::name() const
+{
+  return "Notch";
+}
+
+void
+AudioNotch::setFrequency(float freq)
+{
+  m_freq = freq;
+}
+
+void
+AudioNotch::setQ(float q)
+{
+  m_q = q;
+}
+
+void
+AudioNotch::design()
+{
+  float fs = static_cast<float>(m_sampRate);
+
+  m_bypass = m_curFreq <= 0 || m_curFreq >= .5f * fs || m_curQ <= 0;
+
+  if (!m_bypass) {
+    // RBJ cookbook notch
+    float w0    = static_cast<float>(2 * M_PI) * m_curFreq / fs;
+    float alpha = sinf(w0) / (2 * m_curQ);
+    float a0    = 1 + alpha;
+
+    m_b0 = 1 / a0;
+    m_b1 = -2 * cosf(w0) / a0;
+    m_b2 = 1 / a0;
+    m_a1 = m_b1;
+    m_a2 = (1 - alpha) / a0;
+  }
+}
+
+void
+AudioNotch::reset()
+{
+  m_curFreq = m_curQ = 0;
+  m_z1 = m_z2 = 0;
+}
+
+void
+AudioNotch::process(float *data, size_t len)
+{
+  float freq = m_freq.load(std::memory_order_relaxed);
+  float q    = m_q.load(std::memory_order_relaxed);
+  float z1   = m_z1;
+  float z2   = m_z2;
+
+  if (freq != m_curFreq || q != m_curQ) {
+    m_curFreq = freq;
+    m_curQ    = q;
+    this->design();
+  }
+
+  if (m_bypass)
+    return;
+
+  for (size_t i = 0; i < len; ++i) {
+    float x = data[i];
+    float y = m_b0 * x + z1;
+
+    z1 = m_b1 * x - m_a1 * y + z2;
+    z2 = m_b2 * x - m_a2 * y;
+
+    data[i] = y;
+  }
+
+  m_z1 = z1;
+  m_z2 = z2;
+}
+
+///////////////////////////// AudioNoiseReduction //////////////////////////////
+AudioNoiseReduction::AudioNoiseReduction() : m_strength(.5f)
+{
+  const unsigned int N = SIGDIGGER_AUDIO_NR_FFT_SIZE;
+
+  m_window.resize(N);
+  m_input.resize(N);
+  m_ola.resize(N);
+  m_output.resize(SIGDIGGER_AUDIO_NR_HOP);
+  m_power.resize(N / 2 + 1);
+  m_noise.resize(N / 2 + 1);
+  m_gain.resize(N / 2 + 1);
+
+  // Periodic sqrt-Hann. Applied both on analysis and synthesis, its
+  // square adds up to one at 50% overlap.
+  for (unsigned int i = 0; i < N; ++i)
+    m_window[i] = sqrtf(.5f * (1.f - cosf(static_cast<float>(2 * M_PI * i / N))));
+
+  m_frame    = static_cast<float *>(fftwf_malloc(N * sizeof(float)));
+  m_spectrum = static_cast<fftwf_complex *>(
+        fftwf_malloc((N / 2 + 1) * sizeof(fftwf_complex)));
+
+  if (m_frame != nullptr && m_spectrum != nullptr) {
+    m_forward  = fftwf_plan_dft_r2c_1d(
+          static_cast<int>(N),
+          m_frame,
+          m_spectrum,
+          FFTW_ESTIMATE);
+    m_backward = fftwf_plan_dft_c2r_1d(
+          static_cast<int>(N),
+          m_spectrum,
+          m_frame,
+          FFTW_ESTIMATE);
+  }
+}
+
+AudioNoiseReduction::~AudioNoiseReduction()
+{
+  if (m_forward != nullptr)
+    fftwf_destroy_plan(m_forward);
+
+  if (m_backward != nullptr)
+    fftwf_destroy_plan(m_backward);
+
+  if (m_frame != nullptr)
+    fftwf_free(m_frame);
+
+  if (m_spectrum != nullptr)
+    fftwf_free(m_spectrum);
+}
+
+const char *
+AudioNoiseReduction::name() const
+{
+  return "Noise reduction";
+}
+
+size_t
+AudioNoiseReduction::latency() const
+{
+  return SIGDIGGER_AUDIO_NR_FFT_SIZE;
+}
+
+void
+AudioNoiseReduction::setStrength(float strength)
+{
+  m_strength = std::min(std::max(strength, 0.f), 1.f);
+}
+
+void
+AudioNoiseReduction::reset()
+{
+  std::fill(m_input.begin(),  m_input.end(),  0.f);
+  std::fill(m_ola.begin(),    m_ola.end(),    0.f);
+  std::fill(m_output.begin(), m_output.end(), 0.f);
+  std::fill(m_gain.begin(),   m_gain.end(),   1.f);
+
+  m_fill   = 0;
+  m_primed = false;
+}
+
+void
+AudioNoiseReduction::processFrame()
+{
+  const size_t N    = SIGDIGGER_AUDIO_NR_FFT_SIZE;
+  const size_t hop  = SIGDIGGER_AUDIO_NR_HOP;
+  float strength    = m_strength.load(std::memory_order_relaxed);
+  float oversub     = 1.f + 3.f * strength;
+  float floor       = powf(10.f, -1.5f * strength); // Down to -30 dB
+  float scale       = 1.f / static_cast<float>(N);
+
+  // Let the noise floor rise by 3 dB/s, so it follows a changing
+  // background without locking onto signal peaks.
+  float rise = powf(
+        10.f,
+        .3f * static_cast<float>(hop) / static_cast<float>(m_sampRate));
+
+  for (size_t i = 0; i < N; ++i)
+    m_frame[i] = m_input[i] * m_window[i];
+
+  fftwf_execute(m_forward);
+
+  for (size_t k = 0; k <= N / 2; ++k) {
+    float p = m_spectrum[k][0] * m_spectrum[k][0]
+        + m_spectrum[k][1] * m_spectrum[k][1];
+    float g;
+
+    if (m_primed) {
+      m_power[k] += .3f * (p - m_power[k]);
+      m_noise[k]  = std::min(m_power[k], m_noise[k] * rise);
+    } else {
+      m_power[k] = m_noise[k] = p;
+    }
+
+    g = 1.f - oversub * m_noise[k] / (m_power[k] + 1e-20f);
+    g = std::max(g, floor);
+
+    // Temporal smoothing of the gain limits musical noise
+    m_gain[k] = .5f * (m_gain[k] + g);
+
+    // Only the non-negative half is stored: the signal is real
+    m_spectrum[k][0] *= m_gain[k];
+    m_spectrum[k][1] *= m_gain[k];
+  }
+
+  m_primed = true;
+
+  fftwf_execute(m_backward);
+
+  for (size_t i = 0; i < N; ++i)
+    m_ola[i] += m_frame[i] * m_window[i] * scale;
+
+  std::memcpy(m_output.data(), m_ola.data(), hop * sizeof(float));
+  std::memmove(m_ola.data(), m_ola.data() + hop, (N - hop) * sizeof(float));
+  std::fill(m_ola.begin() + (N - hop), m_ola.end(), 0.f);
+  std::memmove(m_input.data(), m_input.data() + hop, (N - hop) * sizeof(float));
+}
+
+void
+AudioNoiseReduction::process(float *data, size_t len)
+{
+  const size_t N   = SIGDIGGER_AUDIO_NR_FFT_SIZE;
+  const size_t hop = SIGDIGGER_AUDIO_NR_HOP;
+
+  if (m_forward == nullptr || m_backward == nullptr)
+    return;
+
+  while (len > 0) {
+    size_t chunk = std::min(len, hop - m_fill);
+
+    std::memcpy(m_input.data() + N - hop + m_fill, data, chunk * sizeof(float));
+    std::memcpy(data, m_output.data() + m_fill, chunk * sizeof(float));
+
+    m_fill += chunk;
+    data   += chunk;
+    len    -= chunk;
+
+    if (m_fill == hop) {
+      this->processFrame();
+      m_fill = 0;
+    }
+  }
+}
+
+////////////////////////////////// AudioAGC ////////////////////////////////////
+AudioAGC::AudioAGC() : m_target(-12.f), m_maxGain(30.f), m_release(.5f)
+{
+}
+
+const char *
+AudioAGC::name() const
+{
+  return "AGC";
+}
+
+void
+AudioAGC::setTarget(float target)
+{
+  m_target = target;
+}
+
+void
+AudioAGC::setMaxGain(float maxGain)
+{
+  m_maxGain = maxGain;
+}
+
+void
+AudioAGC::setRelease(float release)
+{
+  m_release = release;
+}
+
+void
+AudioAGC::reset()
+{
+  m_envelope = 0;
+  m_gain     = 1;
+}
+
+void
+AudioAGC::process(float *data, size_t len)
+{
+  float target  = powf(10.f, m_target.load(std::memory_order_relaxed) / 20.f);
+  float maxGain = powf(10.f, m_maxGain.load(std::memory_order_relaxed) / 20.f);
+  float release = m_release.load(std::memory_order_relaxed);
+  float peak = 0, decay, gain, step;
+
+  for (size_t i = 0; i < len; ++i)
+    peak = std::max(peak, fabsf(data[i]));
+
+  // Instant attack, exponential release (per block)
+  decay = release > 0
+      ? expf(-static_cast<float>(len)
+             / (release * static_cast<float>(m_sampRate)))
+      : 0.f;
+  m_envelope = std::max(peak, m_envelope * decay);
+
+  gain = m_envelope > 0 ? std::min(target / m_envelope, maxGain) : maxGain;
+
+  // Ramp the gain across the block to avoid zipper noise
+  step = (gain - m_gain) / static_cast<float>(len);
+  for (size_t i = 0; i < len; ++i)
+    data[i] *= m_gain + step * static_cast<float>(i + 1);
+
+  m_gain = gain;
+}
+
+/////////////////////////////// AudioDSPChain //////////////////////////////////
+AudioDSPChain::AudioDSPChain()
+{
+  // Processing order
+  m_stages[0] = &m_deemphasis;
+  m_stages[1] = &m_notch;
+  m_stages[2] = &m_noiseReduction;
+  m_stages[3] = &m_agc;
+}
+
+void
+AudioDSPChain::setConfig(AudioDSPConfig const &config)
+{
+  m_deemphasis.setTau(config.deemphTau);
+  m_deemphasis.setEnabled(config.deemphasis);
+
+  m_notch.setFrequency(config.notchFreq);
+  m_notch.setQ(config.notchQ);
+  m_notch.setEnabled(config.notch);
+
+  m_noiseReduction.setStrength(config.nrStrength);
+  m_noiseReduction.setEnabled(config.noiseReduction);
+
+  m_agc.setTarget(config.agcTarget);
+  m_agc.setMaxGain(config.agcMaxGain);
+  m_agc.setRelease(config.agcRelease);
+  m_agc.setEnabled(config.agc);
+}
+
+void
+AudioDSPChain::getStats(std::vector<AudioDSPStageStats> &stats) const
+{
+  stats.clear();
+
+  for (auto stage : m_stages) {
+    AudioDSPStageStats entry;
+    bool enabled = stage->isEnabled();
+
+    entry.name    = stage->name();
+    entry.enabled = enabled;
+    entry.latency = enabled
+        ? 1e3f * static_cast<float>(stage->latency())
+          / static_cast<float>(stage->getSampleRate())
+        : 0.f;
+    entry.cpuLoad = stage->getCpuLoad();
+
+    stats.push_back(entry);
+  }
+}
+
+void
+AudioDSPChain::reset(unsigned int rate)
+{
+  for (auto stage : m_stages)
+    stage->setSampleRate(rate);
+}
+
+void
+AudioDSPChain::process(float *data, size_t len, unsigned int rate)
+{
+  if (rate != m_stages[0]->getSampleRate())
+    this->reset(rate);
+
+  for (auto stage : m_stages)
+    stage->run(data, len);
+}
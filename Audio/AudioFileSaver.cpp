@@ -20,6 +20,15 @@
 #include <AudioFileSaver.h>
 #include <sndfile.h>
 #include <unistd.h>
+#include <type_traits>
+
+#ifdef HAVE_VOLK
+#  include <volk/volk.h>
+#endif // HAVE_VOLK
+
+// Frames converted per libsndfile call. The conversion buffer is allocated
+// once and reused, so recording does not touch the heap after prepare().
+#define SIGDIGGER_AUDIO_FILE_CONV_FRAMES 4096
 
 using namespace SigDigger;
 
@@ -29,6 +38,10 @@ namespace SigDigger {
     std::string fullPath;
     std::string lastError;
     SNDFILE *sfp = nullptr;
+    std::vector<float> convBuffer;
+
+    sf_count_t writeReal(const SUCOMPLEX *, size_t);
+    sf_count_t writeIQ(const SUCOMPLEX *, size_t);
 
   public:
     AudioFileWriter(AudioFileSaver::AudioFileParams const &params);
@@ -42,6 +55,43 @@ namespace SigDigger {
   };
 }
 
+static inline void
+deinterleaveReal(
+    float *__restrict out,
+    const SUCOMPLEX *__restrict in,
+    size_t len)
+{
+#ifdef HAVE_VOLK
+  if constexpr (std::is_same<SUFLOAT, float>::value) {
+    volk_32fc_deinterleave_real_32f(
+          out,
+          reinterpret_cast<const lv_32fc_t *>(in),
+          static_cast<unsigned int>(len));
+    return;
+  }
+#endif // HAVE_VOLK
+
+  // Strided copy, trivially vectorized by the compiler
+  const SUFLOAT *__restrict asFloat = reinterpret_cast<const SUFLOAT *>(in);
+
+  for (size_t i = 0; i < len; ++i)
+    out[i] = static_cast<float>(asFloat[i << 1]);
+}
+
+static inline void
+convertIQ(
+    float *__restrict out,
+    const SUCOMPLEX *__restrict in,
+    size_t len)
+{
+  const SUFLOAT *__restrict asFloat = reinterpret_cast<const SUFLOAT *>(in);
+
+  len <<= 1;
+
+  for (size_t i = 0; i < len; ++i)
+    out[i] = static_cast<float>(asFloat[i]);
+}
+
 std::string
 AudioFileWriter::getError(void) const
 {
@@ -56,6 +106,7 @@ AudioFileWriter::prepare(void)
     unsigned int index = 1;
     SF_INFO sfinfo;
     std::string modulation;
+    const char *extension = "wav";
 
     switch (this->params.modulation) {
       case AM:
@@ -75,21 +126,39 @@ AudioFileWriter::prepare(void)
         break;
     }
 
+    if (this->params.iq)
+      modulation += "-IQ";
+
+    switch (this->params.format) {
+      case AudioFileSaver::AUDIO_FILE_FORMAT_WAV_PCM16:
+        sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+        break;
+
+      case AudioFileSaver::AUDIO_FILE_FORMAT_WAV_FLOAT:
+        sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+        break;
+
+      case AudioFileSaver::AUDIO_FILE_FORMAT_FLAC:
+        sfinfo.format = SF_FORMAT_FLAC | SF_FORMAT_PCM_16;
+        extension = "flac";
+        break;
+    }
+
     do {
       snprintf(
             fileName,
             sizeof(fileName),
-            "audio-%s-%.0lf-%d-%04d.wav",
+            "audio-%s-%.0lf-%d-%04d.%s",
             modulation.c_str(),
             this->params.frequency,
             this->params.sampRate,
-            index++);
+            index++,
+            extension);
       this->fullPath = this->params.savePath + "/" + fileName;
     } while (access(this->fullPath.c_str(), F_OK) != -1);
 
-    sfinfo.channels = 1;
+    sfinfo.channels = this->params.iq ? 2 : 1;
     sfinfo.samplerate = static_cast<int>(this->params.sampRate);
-    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
 
     if ((this->sfp = sf_open(this->fullPath.c_str(), SFM_WRITE, &sfinfo))
         == nullptr) {
@@ -100,6 +169,9 @@ AudioFileWriter::prepare(void)
           + sf_strerror(nullptr);
       return false;
     }
+
+    // Saturate instead of wrapping around when converting to integer PCM
+    sf_command(this->sfp, SFC_SET_CLIPPING, nullptr, SF_TRUE);
   }
 
   return true;
@@ -108,6 +180,7 @@ AudioFileWriter::prepare(void)
 AudioFileWriter::AudioFileWriter(AudioFileSaver::AudioFileParams const &p)
 {
   this->params = p;
+  this->convBuffer.resize(2 * SIGDIGGER_AUDIO_FILE_CONV_FRAMES);
 }
 
 AudioFileWriter::~AudioFileWriter(void)
@@ -121,26 +194,94 @@ AudioFileWriter::canWrite(void) const
   return this->sfp != nullptr;
 }
 
+sf_count_t
+AudioFileWriter::writeReal(const SUCOMPLEX *data, size_t len)
+{
+  float *buf = this->convBuffer.data();
+  sf_count_t written = 0;
+
+  while (len > 0) {
+    size_t chunk = SU_MIN(len, SIGDIGGER_AUDIO_FILE_CONV_FRAMES);
+    sf_count_t got;
+
+    deinterleaveReal(buf, data, chunk);
+
+    got = sf_writef_float(this->sfp, buf, static_cast<sf_count_t>(chunk));
+    if (got <= 0)
+      break;
+
+    written += got;
+    if (static_cast<size_t>(got) < chunk)
+      break;
+
+    data += chunk;
+    len  -= chunk;
+  }
+
+  return written;
+}
+
+sf_count_t
+AudioFileWriter::writeIQ(const SUCOMPLEX *data, size_t len)
+{
+  // Single-precision complex samples are already interleaved I/Q frames
+  if constexpr (std::is_same<SUFLOAT, float>::value) {
+    return sf_writef_float(
+          this->sfp,
+          reinterpret_cast<const float *>(data),
+          static_cast<sf_count_t>(len));
+  } else {
+    float *buf = this->convBuffer.data();
+    sf_count_t written = 0;
+
+    while (len > 0) {
+      size_t chunk = SU_MIN(len, SIGDIGGER_AUDIO_FILE_CONV_FRAMES);
+      sf_count_t got;
+
+      convertIQ(buf, data, chunk);
+
+      got = sf_writef_float(this->sfp, buf, static_cast<sf_count_t>(chunk));
+      if (got <= 0)
+        break;
+
+      written += got;
+      if (static_cast<size_t>(got) < chunk)
+        break;
+
+      data += chunk;
+      len  -= chunk;
+    }
+
+    return written;
+  }
+}
+
 ssize_t
 AudioFileWriter::write(const void *data, size_t len)
 {
-  ssize_t result;
-  std::vector<SUFLOAT> realData;
   const SUCOMPLEX *asComplex = reinterpret_cast<const SUCOMPLEX *>(data);
-  unsigned int i;
+  sf_count_t result;
 
   if (this->sfp == nullptr)
     return 0;
 
-  // Convert length to a length in samples
+  // Convert length to a length in samples. This runs in the saver's
+  // worker thread, away from the inspector sample path.
   len /= sizeof(SUCOMPLEX);
 
-  realData.resize(len);
+  if (this->params.iq)
+    result = this->writeIQ(asComplex, len);
+  else
+    result = this->writeReal(asComplex, len);
 
-  for (i = 0; i < len; ++i)
-    realData[i] = SU_C_REAL(asComplex[i]);
-
-  result = sf_write_float(this->sfp, realData.data(), len);
+  if (static_cast<size_t>(result) < len) {
+    this->lastError =
+        std::string("Write to ")
+        + this->fullPath
+        + std::string(" failed: ")
+        + sf_strerror(this->sfp);
+    return -1;
+  }
 
   // Return this in bytes
   return result * static_cast<ssize_t>(sizeof(SUCOMPLEX));
@@ -159,17 +300,25 @@ AudioFileWriter::close(void)
 //////////////////////////////// AudioFileSaver ///////////////////////////////
 
 
-AudioFileSaver::~AudioFileSaver()
-{
-  if (this->writer != nullptr)
-    delete this->writer;
-}
-
 AudioFileSaver::AudioFileSaver(
     AudioFileParams const &params,
     QObject *parent) :
   GenericDataSaver(this->writer = new AudioFileWriter(params), parent)
 {
   this->params = params;
+  this->setWriterOwnership(true);
   this->setSampleRate(params.sampRate);
 }
+
+quint64
+AudioFileSaver::getFileSize(void) const
+{
+  quint64 frames = this->getSize() / sizeof(SUCOMPLEX);
+  quint64 sampleSize =
+      this->params.format == AUDIO_FILE_FORMAT_WAV_FLOAT
+      ? sizeof(float)
+      : sizeof(int16_t);
+
+  // FLAC output is compressed, this is an upper bound
+  return frames * sampleSize * (this->params.iq ? 2 : 1);
+}
@@ -20,7 +20,8 @@
 #include <iostream>
 #include "AudioPlayback.h"
 #include <stdexcept>
-#include <sigutils/util/compat-mman.h>
+#include <algorithm>
+#include <cmath>
 #include <QCoreApplication>
 #include <GenericAudioPlayer.h>
 
@@ -30,10 +31,6 @@
 #  include "PortAudioPlayer.h"
 #endif // SIGIDGGER_HAVE_ALSA
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-#  define QMutexLocker QMutexLocker<QRecursiveMutex>
-#endif
-
 
 using namespace SigDigger;
 
@@ -59,14 +56,22 @@ PlaybackWorker::calcBufferSizeForRate(unsigned int rate)
 }
 
 PlaybackWorker::PlaybackWorker(
-    AudioBufferList *instance,
+    AudioMixerChannel *channels,
     std::string const &dev,
     unsigned int sampRate)
 {
   this->device     = dev;
   this->sampRate   = sampRate;
-  this->instance   = instance;
+  this->channels   = channels;
   this->bufferSize = calcBufferSizeForRate(sampRate);
+
+  // Allocated once, so that mixing never allocates memory
+  this->mixBuffer.resize(
+        SIGDIGGER_AUDIO_OUTPUT_CHANNELS * SIGDIGGER_AUDIO_BUFFER_SIZE);
+  this->scratch.resize(
+        static_cast<size_t>(
+          SIGDIGGER_AUDIO_BUFFER_SIZE
+          * (1 + SIGDIGGER_AUDIO_MAX_RATE_CORRECTION)) + 2);
 }
 
 unsigned int
@@ -82,21 +87,135 @@ PlaybackWorker::setGain(float vol)
 }
 
 void
-PlaybackWorker::play(void)
+PlaybackWorker::updateRateCorrection(AudioMixerChannel &channel)
 {
-  float *buffer;
-  unsigned int i;
+  double target = SIGDIGGER_AUDIO_TARGET_BUFFERS * this->bufferSize;
+  double error  = (static_cast<double>(channel.ring.available()) - target) / target;
+  double max    = SIGDIGGER_AUDIO_MAX_RATE_CORRECTION;
 
-  while (this->player != nullptr && (buffer = this->instance->next()) != nullptr) {
-    bool ok;
+  // Slow PI loop on the (smoothed) fill level of the ring. The integral
+  // term tracks the steady clock drift between the analyzer and the
+  // soundcard, the proportional term pulls the latency back to target.
+  channel.avgError += SIGDIGGER_AUDIO_FILL_AVG_ALPHA * (error - channel.avgError);
+  channel.integral  = qBound(
+        -max,
+        channel.integral + SIGDIGGER_AUDIO_DRIFT_KI * channel.avgError,
+        +max);
+
+  channel.ratio = 1. + qBound(
+        -max,
+        SIGDIGGER_AUDIO_DRIFT_KP * channel.avgError + channel.integral,
+        +max);
+
+  channel.rateCorrection = static_cast<float>(channel.ratio - 1.);
+}
+
+bool
+PlaybackWorker::mixChannel(AudioMixerChannel &channel, float *output)
+{
+  float *input = this->scratch.data();
+  size_t need, maxFill, i, n;
+  double pos;
+  float gainL, gainR, frac, sample;
+
+  // Input samples needed to produce bufferSize output samples
+  need = static_cast<size_t>(
+        floor(channel.phase + this->bufferSize * channel.ratio));
+
+  if (channel.ring.available() < need) {
+    // Real underrun: wait until the producer fills the ring again
+    channel.buffering = true;
+    ++channel.underruns;
+    return false;
+  }
+
+  // Way above target (e.g. after a burst), catch up at once
+  maxFill = SIGDIGGER_AUDIO_TARGET_BUFFERS * this->bufferSize * 4;
+  if (channel.ring.available() > maxFill)
+    channel.ring.skip(channel.ring.available() - maxFill / 4);
+
+  input[0] = channel.last;
+  channel.ring.read(input + 1, need);
+  channel.dsp.process(input + 1, need, this->sampRate);
+
+  gainL = this->gain * channel.gainL;
+  gainR = this->gain * channel.gainR;
+
+  // Linear interpolation at the corrected rate. For ratio = 1 and
+  // phase = 0 this is an exact copy.
+  pos = channel.phase;
+  for (i = 0; i < this->bufferSize; ++i) {
+    n      = static_cast<size_t>(pos);
+    frac   = static_cast<float>(pos - n);
+    sample = n < need
+        ? input[n] + frac * (input[n + 1] - input[n])
+        : input[need];
+
+    output[2 * i]     += gainL * sample;
+    output[2 * i + 1] += gainR * sample;
+
+    pos += channel.ratio;
+  }
+
+  channel.last  = input[need];
+  channel.phase = channel.phase + this->bufferSize * channel.ratio - need;
+
+  this->updateRateCorrection(channel);
+
+  return true;
+}
+
+bool
+PlaybackWorker::mix(void)
+{
+  float *output = this->mixBuffer.data();
+  bool haveData = false;
+
+  std::fill(
+        output,
+        output + SIGDIGGER_AUDIO_OUTPUT_CHANNELS * this->bufferSize,
+        0.f);
+
+  for (unsigned int j = 0; j < SIGDIGGER_AUDIO_MAX_CHANNELS; ++j) {
+    AudioMixerChannel &channel = this->channels[j];
+
+    // Channel (re)opened or rate changed: drop stale samples
+    if (channel.flush.exchange(false)) {
+      channel.ring.discard(channel.flushMark);
+      channel.phase    = 0;
+      channel.last     = 0;
+      channel.ratio    = 1;
+      channel.avgError = 0;
+      channel.integral = 0;
+      channel.rateCorrection = 0;
+      channel.dsp.reset(this->sampRate);
+    }
+
+    // Channels still buffering are not mixed. The producer will
+    // restart us when they are ready.
+    if (!channel.enabled || channel.buffering)
+      continue;
+
+    if (this->mixChannel(channel, output))
+      haveData = true;
+  }
+
+  return haveData;
+}
+
+void
+PlaybackWorker::play(void)
+{
+  // Restart requests may arrive while we are already playing
+  if (this->playing)
+    return;
 
-    for (i = 0; i < this->bufferSize; ++i)
-      buffer[i] *= this->gain;
+  this->playing = true;
 
-    ok = this->player->write(buffer, this->bufferSize);
+  while (this->player != nullptr && this->mix()) {
+    bool ok;
 
-    // Done with this buffer, mark as free.
-    this->instance->release();
+    ok = this->player->write(this->mixBuffer.data(), this->bufferSize);
 
     if (!ok) {
       this->stopPlayback();
@@ -107,6 +226,8 @@ PlaybackWorker::play(void)
     QCoreApplication::processEvents();
   }
 
+  this->playing = false;
+
   if (this->player != nullptr)
     emit starving();
 }
@@ -115,20 +236,23 @@ void
 PlaybackWorker::startPlayback()
 {
   if (this->player == nullptr) {
-    // Reset buffer list
-    this->instance->clear();
+    // Drop whatever was left in the rings
+    for (unsigned int i = 0; i < SIGDIGGER_AUDIO_MAX_CHANNELS; ++i)
+      this->channels[i].requestFlush();
 
     try {
   #ifdef SIGDIGGER_HAVE_ALSA
     this->player = new AlsaPlayer(
           this->device,
           this->sampRate,
-          this->bufferSize);
+          this->bufferSize,
+          SIGDIGGER_AUDIO_OUTPUT_CHANNELS);
   #elif defined(SIGDIGGER_HAVE_PORTAUDIO)
     this->player = new PortAudioPlayer(
           this->device,
           this->sampRate,
-          this->bufferSize);
+          this->bufferSize,
+          SIGDIGGER_AUDIO_OUTPUT_CHANNELS);
   #else
     throw std::runtime_error(
         "Cannot create audio playback object: audio support disabled at compile time");
@@ -207,204 +331,31 @@ PlaybackWorker::halt(void)
   emit finished();
 }
 
-////////////////////////////////// Audio buffer ///////////////////////////////
-AudioBuffer::AudioBuffer()
-{
-  float *buf;
-
-  // Ladies and gentlemen, behold the COBOL
-  if ((buf = static_cast<float *>(mmap(
-         nullptr,
-         SIGDIGGER_AUDIO_BUFFER_ALLOC,
-         PROT_READ | PROT_WRITE,
-         MAP_PRIVATE | MAP_ANONYMOUS,
-         -1,
-         0))) == reinterpret_cast<float *>(-1)) {
-    throw std::runtime_error(
-          "Failed to allocate "
-          + std::to_string(SIGDIGGER_AUDIO_BUFFER_ALLOC)
-          + " of buffer bytes for soundcard.");
-  }
-
-  this->data = buf;
-}
-
-AudioBuffer::~AudioBuffer()
-{
-  if (this->data != nullptr)
-    munmap(this->data, SIGDIGGER_AUDIO_BUFFER_ALLOC);
-}
-
-////////////////////////////// AudioBufferList /////////////////////////////////
-AudioBufferList::AudioBufferList(unsigned int num)
-#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
-  : listMutex(QMutex::Recursive)
-#endif
-{
-  unsigned int i;
-
-  this->allocation.resize(num);
-
-  for (i = 0; i < num; ++i) {
-    AudioBuffer *buffer = &this->allocation[i];
-    buffer->next = this->freeList;
-    this->freeList = buffer;
-  }
-
-  this->freeLen = this->totalLen = num;
-}
-
-void
-AudioBufferList::reset(void)
-{
-  QMutexLocker locker(&this->listMutex);
-
-  if (this->current != nullptr) {
-    AudioBuffer *buffer = this->current;
-    this->current = nullptr;
-
-    buffer->next = this->freeList;
-    this->freeList = buffer;
-  }
-
-  if (this->playBuffer != nullptr) {
-    AudioBuffer *buffer = this->playBuffer;
-    this->playBuffer = nullptr;
-
-    buffer->next = this->freeList;
-    this->freeList = buffer;
-  }
-
-  // Moving the current playlist is actually pretty easy
-
-  if (this->playListHead != nullptr) {
-    this->playListTail->next = this->freeList;
-    this->freeList = this->playListHead;
-
-    this->playListHead = this->playListTail = nullptr;
-  }
-
-  this->freeLen = this->totalLen;
-  this->playListLen = 0;
-}
-
-float *
-AudioBufferList::reserve(void)
-{
-  QMutexLocker locker(&this->listMutex);
-
-  // You cannot reserve a buffer before committing int
-  if (this->current != nullptr) {
-    std::cerr << "Invalid reserve(), please call commit() first!" << std::endl;
-    return nullptr;
-  } else if (this->freeList == nullptr) {
-    // std::cerr << "Free audio buffer list exhausted!" << std::endl;
-    return nullptr;
-  }
-
-  this->current = this->freeList;
-  this->freeList = this->freeList->next;
-  --this->freeLen;
-
-  return this->current->data;
-}
-
-void
-AudioBufferList::commit(void)
-{
-  QMutexLocker locker(&this->listMutex);
-
-  // You cannot commit if the current buffer is null
-  if (this->current == nullptr) {
-    std::cerr << "Calling commit() with no reserve() is forbidden." << std::endl;
-  } else {
-    AudioBuffer *buffer = this->current;
-    this->current = nullptr;
-
-    buffer->prev = nullptr;
-    buffer->next = this->playListHead;
-    if (this->playListHead != nullptr)
-      this->playListHead->prev = buffer;
-
-    this->playListHead = buffer;
-
-    if (this->playListTail == nullptr)
-      this->playListTail = buffer;
-    ++this->playListLen;
-  }
-}
-
-float *
-AudioBufferList::next(void)
-{
-  QMutexLocker locker(&this->listMutex);
-
-  if (this->playBuffer != nullptr) {
-    std::cerr << "Invalid next(), please call release() first!" << std::endl;
-    return nullptr;
-  } else if (this->playListTail == nullptr) {
-    // Starving
-    return nullptr;
-  } else {
-    AudioBuffer *buffer = this->playListTail;
-    this->playBuffer = buffer;
-
-    this->playListTail = buffer->prev;
-
-    if (this->playListTail == nullptr)
-      this->playListHead = nullptr;
-    --this->playListLen;
-
-    return buffer->data;
-  }
-}
-
-void
-AudioBufferList::release(void)
+/////////////////////////////// AudioMixerChannel //////////////////////////////
+AudioMixerChannel::AudioMixerChannel()
+  : ring(SIGDIGGER_AUDIO_RING_ORDER),
+    enabled(false),
+    buffering(true),
+    flush(false),
+    flushMark(0),
+    gainL(1.f),
+    gainR(1.f),
+    rateCorrection(0.f),
+    underruns(0)
 {
-  QMutexLocker locker(&this->listMutex);
-
-  if (this->playBuffer == nullptr) {
-    std::cerr << "Invalid release(), please call next() first!" << std::endl;
-  } else {
-    AudioBuffer *buffer = this->playBuffer;
-    this->playBuffer = nullptr;
-
-    buffer->next = this->freeList;
-    this->freeList = buffer;
-    ++this->freeLen;
-  }
 }
 
 void
-AudioBufferList::clear(void)
+AudioMixerChannel::requestFlush()
 {
-  QMutexLocker locker(&this->listMutex);
-
-  // You cannot commit if the current buffer is null
-  if (this->current != nullptr) {
-    AudioBuffer *buffer = this->current;
-    this->current = nullptr;
-
-    buffer->prev = nullptr;
-    buffer->next = this->playListHead;
-    if (this->playListHead != nullptr)
-      this->playListHead->prev = buffer;
-
-    this->playListHead = buffer;
-
-    if (this->playListTail == nullptr)
-      this->playListTail = buffer;
-    ++this->playListLen;
-  }
-
-  while (next())
-    release();
+  // The worker may only see the request after the producer has already
+  // refilled the ring, so we record where the stale data ends.
+  this->flushMark = this->ring.mark();
+  this->flush = true;
 }
 
 //////////////////////////////// AudioBuffer ///////////////////////////////////
 AudioPlayback::AudioPlayback(std::string const &dev, unsigned int rate)
-  : bufferList(SIGDIGGER_AUDIO_BUFFER_NUM)
 {
   this->device = dev;
   this->sampRate = rate;
@@ -416,7 +367,7 @@ void
 AudioPlayback::startWorker()
 {
   this->worker = new PlaybackWorker(
-        &this->bufferList,
+        this->channels,
         this->device,
         this->sampRate);
 
@@ -486,12 +437,13 @@ AudioPlayback::onError(QString desc)
 void
 AudioPlayback::onStarving(void)
 {
-  if (this->bufferList.getPlayListLen() < SIGDIGGER_AUDIO_BUFFERING_WATERMARK) {
-    this->completed = 0;
-    this->buffering = true;
-    std::cout << "AudioPlayback: reached watermark, buffering again..." << std::endl;
-  } else {
-    emit restart();
+  // The worker marks underrun channels as buffering. If some channel
+  // became ready in the meantime, the restart signal may have been lost.
+  for (auto &channel : this->channels) {
+    if (channel.enabled && !channel.buffering) {
+      emit restart();
+      break;
+    }
   }
 }
 
@@ -519,10 +471,12 @@ void
 AudioPlayback::cancelPlayBack(void)
 {
   this->bufferSize = PlaybackWorker::calcBufferSizeForRate(this->sampRate);
-  this->ptr = 0;
   this->ready = false;
-  this->current_buffer = nullptr;
-  this->completed = 0;
+
+  for (auto &channel : this->channels) {
+    channel.buffering = true;
+    channel.requestFlush();
+  }
 }
 
 void
@@ -559,8 +513,10 @@ void
 AudioPlayback::start(void)
 {
   if (!this->running) {
+    for (auto &channel : this->channels)
+      channel.buffering = true;
+
     emit startPlayback();
-    this->buffering = true;
     this->running = true;
   }
 }
@@ -575,51 +531,176 @@ AudioPlayback::stop(void)
   }
 }
 
+int
+AudioPlayback::openChannel(void)
+{
+  for (int i = 0; i < SIGDIGGER_AUDIO_MAX_CHANNELS; ++i) {
+    AudioMixerChannel &channel = this->channels[i];
+
+    if (!channel.enabled) {
+      // Drop whatever was left from a previous user of this channel
+      channel.buffering = true;
+      channel.requestFlush();
+      channel.underruns = 0;
+      channel.volume = 0;
+      channel.pan    = 0;
+      channel.muted  = false;
+      channel.dsp.setConfig(AudioDSPConfig());
+      this->refreshChannelGain(i);
+
+      channel.enabled = true;
+
+      if (this->openChannels++ == 0)
+        this->start();
+
+      return i;
+    }
+  }
+
+  return -1;
+}
+
 void
-AudioPlayback::write(const SUCOMPLEX *samples, SUSCOUNT size)
+AudioPlayback::closeChannel(int index)
 {
-  unsigned int bufferSize = this->bufferSize;
+  if (index >= 0 && index < SIGDIGGER_AUDIO_MAX_CHANNELS) {
+    AudioMixerChannel &channel = this->channels[index];
 
-  while (size > 0 && this->running && this->ready) {
-    SUSCOUNT chunk = size;
-    SUSCOUNT remaining;
-    float *start;
+    if (channel.enabled) {
+      channel.enabled = false;
+      channel.buffering = true;
 
-    // No current buffer, try to allocate
-    if (this->current_buffer == nullptr) {
-      this->ptr = 0;
-      if ((this->current_buffer = this->bufferList.reserve()) == nullptr) {
-        // Somehow the playback thread is slow...
-        return;
-      }
+      if (--this->openChannels == 0)
+        this->stop();
     }
+  }
+}
+
+unsigned int
+AudioPlayback::getOpenChannelCount(void) const
+{
+  return this->openChannels;
+}
 
-    start = this->current_buffer + this->ptr;
+void
+AudioPlayback::refreshChannelGain(int index)
+{
+  AudioMixerChannel &channel = this->channels[index];
+  float gain, theta;
 
-    if (chunk > bufferSize - this->ptr)
-      chunk = bufferSize - this->ptr;
-    remaining = chunk;
+  if (channel.muted || channel.volume < -60)
+    gain = 0;
+  else
+    gain = SU_MAG_RAW(channel.volume);
 
-    while (remaining-- > 0)
-      *start++ = SU_C_REAL(*samples++);
+  // Constant power pan law, normalized to unity gain at the center
+  theta = static_cast<float>(.25 * M_PI) * (channel.pan + 1.f);
 
-    this->ptr += chunk;
-    size -= chunk;
+  channel.gainL = gain * static_cast<float>(M_SQRT2) * cosf(theta);
+  channel.gainR = gain * static_cast<float>(M_SQRT2) * sinf(theta);
+}
 
-    // Buffer full, send to playback thread.
-    if (this->ptr == bufferSize) {
-      this->current_buffer = nullptr;
-      this->bufferList.commit();
+void
+AudioPlayback::setChannelVolume(int index, float volume)
+{
+  if (index >= 0 && index < SIGDIGGER_AUDIO_MAX_CHANNELS) {
+    this->channels[index].volume = volume;
+    this->refreshChannelGain(index);
+  }
+}
 
-      // If buffering, we wait until we have SIGDIGGER_AUDIO_BUFFER_MIN
-      // buffers full. When that happens, we restart the thread.
-      if (this->buffering) {
-        if (++this->completed == SIGDIGGER_AUDIO_BUFFER_MIN) {
-          emit restart();
-          this->buffering = false;
-        }
-      }
-    }
+void
+AudioPlayback::setChannelPan(int index, float pan)
+{
+  if (index >= 0 && index < SIGDIGGER_AUDIO_MAX_CHANNELS) {
+    this->channels[index].pan = qBound(-1.f, pan, 1.f);
+    this->refreshChannelGain(index);
+  }
+}
+
+void
+AudioPlayback::setChannelMuted(int index, bool muted)
+{
+  if (index >= 0 && index < SIGDIGGER_AUDIO_MAX_CHANNELS) {
+    this->channels[index].muted = muted;
+    this->refreshChannelGain(index);
+  }
+}
+
+float
+AudioPlayback::getChannelRateCorrection(int index) const
+{
+  if (index >= 0 && index < SIGDIGGER_AUDIO_MAX_CHANNELS)
+    return this->channels[index].rateCorrection;
+
+  return 0;
+}
+
+unsigned int
+AudioPlayback::getChannelUnderruns(int index) const
+{
+  if (index >= 0 && index < SIGDIGGER_AUDIO_MAX_CHANNELS)
+    return this->channels[index].underruns;
+
+  return 0;
+}
+
+void
+AudioPlayback::setChannelDSPConfig(int index, AudioDSPConfig const &config)
+{
+  if (index >= 0 && index < SIGDIGGER_AUDIO_MAX_CHANNELS)
+    this->channels[index].dsp.setConfig(config);
+}
+
+void
+AudioPlayback::getChannelDSPStats(
+    int index,
+    std::vector<AudioDSPStageStats> &stats) const
+{
+  if (index >= 0 && index < SIGDIGGER_AUDIO_MAX_CHANNELS)
+    this->channels[index].dsp.getStats(stats);
+  else
+    stats.clear();
+}
+
+void
+AudioPlayback::write(int index, const SUCOMPLEX *samples, SUSCOUNT size)
+{
+  size_t target = SIGDIGGER_AUDIO_TARGET_BUFFERS * this->bufferSize;
+
+  if (index < 0 || index >= SIGDIGGER_AUDIO_MAX_CHANNELS)
+    return;
+
+  AudioMixerChannel &channel = this->channels[index];
+
+  if (!this->running || !this->ready || !channel.enabled)
+    return;
+
+  while (size > 0) {
+    float *start;
+    SUSCOUNT chunk = channel.ring.writeSpan(&start);
+
+    // Ring full. Somehow the playback thread is slow...
+    if (chunk == 0)
+      break;
+
+    if (chunk > size)
+      chunk = size;
+
+    for (SUSCOUNT i = 0; i < chunk; ++i)
+      start[i] = SU_C_REAL(samples[i]);
+
+    channel.ring.commitWrite(chunk);
+
+    samples += chunk;
+    size    -= chunk;
+  }
+
+  // If buffering, we wait until the ring reaches the target latency.
+  // When that happens, we restart the thread.
+  if (channel.buffering && channel.ring.available() >= target) {
+    channel.buffering = false;
+    emit restart();
   }
 }
 
@@ -0,0 +1,121 @@
+//
+//    AudioRingBuffer.cpp: Wait-free single producer, single consumer ring
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <AudioRingBuffer.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace SigDigger;
+
+AudioRingBuffer::AudioRingBuffer(unsigned int order)
+  : m_head(0), m_tail(0)
+{
+  m_buffer.resize(static_cast<size_t>(1) << order);
+  m_mask = m_buffer.size() - 1;
+}
+
+size_t
+AudioRingBuffer::writeSpan(float **ptr)
+{
+  size_t head  = m_head.load(std::memory_order_relaxed);
+  size_t tail  = m_tail.load(std::memory_order_acquire);
+  size_t space = this->capacity() - (head - tail);
+  size_t index = head & m_mask;
+
+  *ptr = m_buffer.data() + index;
+
+  // Only the contiguous part, up to the end of the allocation
+  return std::min(space, this->capacity() - index);
+}
+
+void
+AudioRingBuffer::commitWrite(size_t len)
+{
+  m_head.store(
+        m_head.load(std::memory_order_relaxed) + len,
+        std::memory_order_release);
+}
+
+void
+AudioRingBuffer::discard(size_t mark)
+{
+  size_t tail = m_tail.load(std::memory_order_relaxed);
+  size_t head = m_head.load(std::memory_order_acquire);
+
+  // Only move forward, and never past what was actually written
+  if (mark - tail <= head - tail)
+    m_tail.store(mark, std::memory_order_release);
+}
+
+size_t
+AudioRingBuffer::write(const float *data, size_t len)
+{
+  size_t written = 0;
+  size_t chunk;
+  float *ptr;
+
+  while (written < len && (chunk = this->writeSpan(&ptr)) > 0) {
+    chunk = std::min(chunk, len - written);
+    memcpy(ptr, data + written, chunk * sizeof(float));
+    this->commitWrite(chunk);
+    written += chunk;
+  }
+
+  return written;
+}
+
+size_t
+AudioRingBuffer::read(float *data, size_t len)
+{
+  size_t tail  = m_tail.load(std::memory_order_relaxed);
+  size_t head  = m_head.load(std::memory_order_acquire);
+  size_t index = tail & m_mask;
+  size_t chunk;
+
+  len   = std::min(len, head - tail);
+  chunk = std::min(len, this->capacity() - index);
+
+  memcpy(data, m_buffer.data() + index, chunk * sizeof(float));
+  if (chunk < len)
+    memcpy(data + chunk, m_buffer.data(), (len - chunk) * sizeof(float));
+
+  m_tail.store(tail + len, std::memory_order_release);
+
+  return len;
+}
+
+size_t
+AudioRingBuffer::skip(size_t len)
+{
+  size_t tail = m_tail.load(std::memory_order_relaxed);
+  size_t head = m_head.load(std::memory_order_acquire);
+
+  len = std::min(len, head - tail);
+  m_tail.store(tail + len, std::memory_order_release);
+
+  return len;
+}
+
+void
+AudioRingBuffer::discard()
+{
+  m_tail.store(
+        m_head.load(std::memory_order_acquire),
+        std::memory_order_release);
+}
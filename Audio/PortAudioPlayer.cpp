@@ -52,7 +52,8 @@ PortAudioPlayer::paFinalizer()
 PortAudioPlayer::PortAudioPlayer(
     std::string const &devStr,
     unsigned int rate,
-    size_t bufSiz)
+    size_t bufSiz,
+    unsigned int channels)
   : GenericAudioPlayer(rate)
 {
   PaStreamParameters outputParameters;
@@ -67,7 +68,7 @@ PortAudioPlayer::PortAudioPlayer(
     throw std::runtime_error("Failed to initialize PortAudio library: playback device not found");
 
   outputParameters.device = index;
-  outputParameters.channelCount = 1;
+  outputParameters.channelCount = static_cast<int>(channels);
   outputParameters.sampleFormat = paFloat32;
   outputParameters.suggestedLatency =
       Pa_GetDeviceInfo(outputParameters.device)->defaultHighOutputLatency;
@@ -18,6 +18,7 @@
 //
 #include <DeviceDialog.h>
 #include "ui_DeviceDialog.h"
+#include <algorithm>
 
 using namespace SigDigger;
 
@@ -27,6 +28,7 @@ DeviceDialog::DeviceDialog(QWidget *parent) :
 {
   ui->setupUi(this);
 
+  this->setHeaders();
   this->connectAll();
 }
 
@@ -52,15 +54,17 @@ DeviceDialog::getDeviceIcon(Suscan::Source::Device const &dev)
   return QPixmap(iconPath + ".png");
 }
 
+//
+// The list shown is always usable, even while a sweep is in progress: it
+// only gets updated with whatever changes when the sweep finishes.
+//
 void
 DeviceDialog::setRefreshing(bool refreshing)
 {
   if (refreshing) {
-    this->ui->okButton->setEnabled(false);
     this->ui->refreshButton->setEnabled(false);
     this->ui->refreshProgress->setMaximum(0);
   } else {
-    this->ui->okButton->setEnabled(true);
     this->ui->refreshButton->setEnabled(true);
     this->ui->refreshProgress->setMaximum(1);
   }
@@ -81,18 +85,10 @@ DeviceDialog::run(void)
 }
 
 void
-DeviceDialog::refreshDevices(void)
+DeviceDialog::setHeaders(void)
 {
-  int i = 0;
-  Suscan::Singleton *s = Suscan::Singleton::get_instance();
-  std::vector<Suscan::Source::Device>::const_iterator start
-      = s->getFirstDevice();
-  std::vector<Suscan::Source::Device>::const_iterator end
-      = s->getLastDevice();
+  this->ui->deviceTable->setColumnCount(3);
 
-  this->ui->deviceTable->clear();
-
-  // Set headers
   this->ui->deviceTable->setHorizontalHeaderItem(
         0,
         new QTableWidgetItem(""));
@@ -109,24 +105,80 @@ DeviceDialog::refreshDevices(void)
         Qt::AlignLeft);
   this->ui->deviceTable->horizontalHeaderItem(2)->setTextAlignment(
         Qt::AlignLeft);
+}
+
+void
+DeviceDialog::setRow(int row, Suscan::Source::Device const &dev)
+{
+  QTableWidgetItem *iconItem = new QTableWidgetItem();
+  iconItem->setIcon(QIcon(getDeviceIcon(dev)));
+
+  this->ui->deviceTable->setItem(row, 0, iconItem);
+  this->ui->deviceTable->setItem(
+        row,
+        1,
+        new QTableWidgetItem(QString::fromStdString(dev.getDesc())));
+  this->ui->deviceTable->setItem(
+        row,
+        2,
+        new QTableWidgetItem(QString::fromStdString(dev.getDriver())));
+}
+
+//
+// Rows are matched to devices by their suscan instance, so that only the
+// devices that appeared, disappeared or changed availability are touched.
+//
+void
+DeviceDialog::refreshDevices(void)
+{
+  Suscan::Singleton *s = Suscan::Singleton::get_instance();
+  std::vector<Suscan::Source::Device>::const_iterator start
+      = s->getFirstDevice();
+  std::vector<Suscan::Source::Device>::const_iterator end
+      = s->getLastDevice();
+  std::vector<const suscan_source_device_t *> current;
+  bool added = false;
+
+  for (auto p = start; p != end; ++p)
+    current.push_back(p->getInstance());
+
+  for (int i = static_cast<int>(this->rowDevices.size()) - 1; i >= 0; --i) {
+    auto index = static_cast<size_t>(i);
+
+    if (std::find(current.begin(), current.end(), this->rowDevices[index])
+        == current.end()) {
+      this->ui->deviceTable->removeRow(i);
+      this->rowDevices.erase(this->rowDevices.begin() + i);
+      this->rowAvailable.erase(this->rowAvailable.begin() + i);
+    }
+  }
 
   for (auto p = start; p != end; ++p) {
-    QTableWidgetItem *iconItem = new QTableWidgetItem();
-    iconItem->setIcon(QIcon(getDeviceIcon(*p)));
-    this->ui->deviceTable->setRowCount(i + 1);
-    this->ui->deviceTable->setItem(i, 0, iconItem);
-    this->ui->deviceTable->setItem(
-          i,
-          1,
-          new QTableWidgetItem(QString::fromStdString(p->getDesc())));
-    this->ui->deviceTable->setItem(
-          i,
-          2,
-          new QTableWidgetItem(QString::fromStdString(p->getDriver())));
-    ++i;
+    auto row = std::find(
+          this->rowDevices.begin(),
+          this->rowDevices.end(),
+          p->getInstance());
+
+    if (row == this->rowDevices.end()) {
+      int i = static_cast<int>(this->rowDevices.size());
+
+      this->ui->deviceTable->setRowCount(i + 1);
+      this->setRow(i, *p);
+      this->rowDevices.push_back(p->getInstance());
+      this->rowAvailable.push_back(p->isAvailable());
+      added = true;
+    } else {
+      auto index = static_cast<size_t>(row - this->rowDevices.begin());
+
+      if (this->rowAvailable[index] != p->isAvailable()) {
+        this->setRow(static_cast<int>(index), *p);
+        this->rowAvailable[index] = p->isAvailable();
+      }
+    }
   }
 
-  this->ui->deviceTable->resizeColumnToContents(1);
+  if (added)
+    this->ui->deviceTable->resizeColumnToContents(1);
 }
 
 void
@@ -19,6 +19,7 @@
 #include "DopplerDialog.h"
 #include "ui_DopplerDialog.h"
 #include <SuWidgetsHelpers.h>
+#include <TextBlockWriter.h>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <cmath>
@@ -59,7 +60,7 @@ DopplerDialog::exportToMatlab(QString const &path)
 {
   std::ofstream of(path.toStdString().c_str(), std::ofstream::binary);
   const SUCOMPLEX *data = this->data.data();
-  int length = static_cast<int>(this->data.size());
+  TextBlockWriter writer(of, SIGDIGGER_TEXT_MAX_NUMBER_LENGTH + 2);
 
   if (!of.is_open())
     return false;
@@ -77,8 +78,17 @@ DopplerDialog::exportToMatlab(QString const &path)
   of << "deltaV = " << 1 / this->fs << ";\n";
   of << "v = [ ";
 
-  for (int i = 0; i <= length; ++i)
-    of << SU_C_REAL(data[i]) << ", ";
+  if (!writer.write(
+        this->data.size(),
+        [data] (char *p, size_t from, size_t to) {
+          for (size_t i = from; i < to; ++i) {
+            p = formatReal(p, SU_C_REAL(data[i]));
+            p = formatString(p, ", ");
+          }
+
+          return p;
+        }))
+    return false;
 
   of << "];\n";
 
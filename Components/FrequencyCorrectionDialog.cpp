@@ -22,6 +22,7 @@
 #include "SigDiggerHelpers.h"
 #include <SuWidgetsHelpers.h>
 #include <Suscan/Analyzer.h>
+#include <UpcomingPassesDialog.h>
 
 #define FREQUENCY_CORRECTION_DIALOG_OVERSAMPLING 2
 #define FREQUENCY_EV_TICKS 10
@@ -249,8 +250,7 @@ FrequencyCorrectionDialog::paintAzimuthElevationPass(QPainter &p)
       // Have we just left the satellite behind?
       if (visible && !timercmp(&this->timeStamp, &t, >)) {
         if (i > 0) {
-          sgdp4_prediction_update(&this->prediction, &this->timeStamp);
-          sgdp4_prediction_get_azel(&this->prediction, &azel);
+          this->evaluate(this->timeStamp, azel);
           p.drawLine(QLineF(this->azElToPoint(pAzEl), this->azElToPoint(azel)));
         }
 
@@ -262,8 +262,7 @@ FrequencyCorrectionDialog::paintAzimuthElevationPass(QPainter &p)
         pen.setWidth(FREQUENCY_CORRECTION_DIALOG_OVERSAMPLING);
         p.setPen(pen);
       } else { // No.
-        sgdp4_prediction_update(&this->prediction, &t);
-        sgdp4_prediction_get_azel(&this->prediction, &azel);
+        this->evaluate(t, azel);
       }
 
       if (i > 0)
@@ -289,8 +288,7 @@ FrequencyCorrectionDialog::paintAzimuthElevationPass(QPainter &p)
           QString::asprintf("%02u:%02u", losTm.tm_hour, losTm.tm_min));
 
     if (haveSourceStart) {
-      sgdp4_prediction_update(&this->prediction, &this->startTime);
-      sgdp4_prediction_get_azel(&this->prediction, &azel);
+      this->evaluate(this->startTime, azel);
 
       p.setBrush(Qt::yellow);
       p.drawEllipse(
@@ -300,8 +298,7 @@ FrequencyCorrectionDialog::paintAzimuthElevationPass(QPainter &p)
     }
 
     if (haveSourceEnd) {
-      sgdp4_prediction_update(&this->prediction, &this->endTime);
-      sgdp4_prediction_get_azel(&this->prediction, &azel);
+      this->evaluate(this->endTime, azel);
 
       p.setBrush(Qt::yellow);
       p.drawEllipse(
@@ -328,8 +325,7 @@ FrequencyCorrectionDialog::paintAzimuthElevationSatPath(QPixmap &pixmap)
 
     this->paintAzimuthElevationPass(p);
 
-    sgdp4_prediction_update(&this->prediction, &this->timeStamp);
-    sgdp4_prediction_get_azel(&this->prediction, &azel);
+    this->evaluate(this->timeStamp, azel);
 
     if (azel.elevation > 0) {
       p.setBrush(Qt::cyan);
@@ -385,6 +381,9 @@ FrequencyCorrectionDialog::setFrequency(SUFREQ freq)
           freq,
           4,
           "Hz"));
+
+  if (this->passesDialog != nullptr)
+    this->passesDialog->setFrequency(freq);
 }
 
 void
@@ -548,6 +547,71 @@ FrequencyCorrectionDialog::recalcALOS(void)
   }
 }
 
+void
+FrequencyCorrectionDialog::requestDopplerTable(void)
+{
+  if (!this->haveALOS) {
+    this->dopplerTable = DopplerTablePtr();
+    this->dopplerTableKey = "";
+  } else {
+    struct timeval margin, start, end;
+    QString key;
+
+    margin.tv_sec  = static_cast<time_t>(SIGDIGGER_DOPPLER_TABLE_MARGIN);
+    margin.tv_usec = 0;
+
+    timersub(&this->aosTime, &margin, &start);
+    timeradd(&this->losTime, &margin, &end);
+
+    key = DopplerTableService::makeKey(
+          this->currentOrbit,
+          this->rxSite,
+          static_cast<double>(start.tv_sec) + 1e-6 * start.tv_usec,
+          static_cast<double>(end.tv_sec) + 1e-6 * end.tv_usec);
+
+    // Already have it, or already waiting for it
+    if (key == this->dopplerTableKey)
+      return;
+
+    this->dopplerTable = DopplerTableService::instance()->request(
+          this->currentOrbit,
+          this->rxSite,
+          start,
+          end,
+          &this->dopplerTableKey);
+  }
+}
+
+void
+FrequencyCorrectionDialog::evaluate(
+    struct timeval const &tv,
+    xyz_t &azel,
+    qreal *rangeRate)
+{
+  double t = static_cast<double>(tv.tv_sec) + 1e-6 * tv.tv_usec;
+
+  // Use the shared table of the current pass when possible, and fall back
+  // to direct evaluation out of it.
+  if (this->dopplerTable && this->dopplerTable->covers(t)) {
+    qreal accel;
+
+    this->dopplerTable->azel(t, azel);
+    if (rangeRate != nullptr)
+      this->dopplerTable->rangeRate(t, *rangeRate, accel);
+  } else {
+    struct timeval copy = tv;
+    xyz_t v_azel;
+
+    sgdp4_prediction_update(&this->prediction, &copy);
+    sgdp4_prediction_get_azel(&this->prediction, &azel);
+
+    if (rangeRate != nullptr) {
+      sgdp4_prediction_get_vel_azel(&this->prediction, &v_azel);
+      *rangeRate = v_azel.distance;
+    }
+  }
+}
+
 void
 FrequencyCorrectionDialog::setCurrentOrbit(const orbit_t *orbit)
 {
@@ -559,6 +623,8 @@ FrequencyCorrectionDialog::setCurrentOrbit(const orbit_t *orbit)
     sgdp4_prediction_finalize(&this->prediction);
     this->haveOrbit = false;
     this->haveALOS  = false;
+    this->dopplerTable = DopplerTablePtr();
+    this->dopplerTableKey = "";
   }
 
   if (orbit != nullptr) {
@@ -666,15 +732,13 @@ FrequencyCorrectionDialog::updatePrediction(void)
 {
   struct timeval diff;
   qreal seconds;
-  xyz_t azel, v_azel;
+  qreal rangeRate;
+  xyz_t azel;
 
   if (this->haveOrbit) {
     this->recalcALOS();
-
-    sgdp4_prediction_update(&this->prediction, &this->timeStamp);
-
-    sgdp4_prediction_get_azel(&this->prediction, &azel);
-    sgdp4_prediction_get_vel_azel(&this->prediction, &v_azel);
+    this->requestDopplerTable();
+    this->evaluate(this->timeStamp, azel, &rangeRate);
 
     this->ui->visibleLabel->setText(azel.elevation < 0 ? "No" : "Yes");
     this->ui->azimuthLabel->setText(
@@ -691,17 +755,29 @@ FrequencyCorrectionDialog::updatePrediction(void)
             false));
     this->ui->dopplerLabel->setText(
           SuWidgetsHelpers::formatQuantity(
-            -v_azel.distance * this->centerFreq / SPEED_OF_LIGHT_KM_S,
+            -rangeRate * this->centerFreq / SPEED_OF_LIGHT_KM_S,
             4,
             "Hz",
             false));
     this->ui->speedLabel->setText(
           SuWidgetsHelpers::formatQuantity(
-            v_azel.distance * 1e3,
+            rangeRate * 1e3,
             4,
             "m/s",
             false));
 
+    if (this->dopplerTable && this->dopplerTable->covers(this->timeStamp))
+      this->ui->dopplerLabel->setToolTip(
+            "Interpolated from the Doppler table of this pass (error below "
+            + SuWidgetsHelpers::formatQuantity(
+              this->dopplerTable->maxDopplerError(this->centerFreq),
+              2,
+              "Hz",
+              false)
+            + ")");
+    else
+      this->ui->dopplerLabel->setToolTip("");
+
     if (orbit_is_geo(&this->currentOrbit))
       this->ui->periodLabel->setText("Geostationary");
     else if (orbit_is_decayed(&this->currentOrbit, &this->timeStamp))
@@ -807,7 +883,7 @@ FrequencyCorrectionDialog::setCurrentSatellite(QString sat)
 
   this->desiredSelected = sat;
 
-  if ((ndx = this->ui->satCombo->findText(sat)) > 0) {
+  if ((ndx = this->ui->satCombo->findText(sat)) >= 0) {
     bool blocking = this->ui->satCombo->signalsBlocked();
     this->ui->satCombo->blockSignals(true);
     this->ui->satCombo->setCurrentIndex(ndx);
@@ -862,6 +938,19 @@ FrequencyCorrectionDialog::connectAll(void)
         SIGNAL(timeout(void)),
         this,
         SLOT(onTick(void)));
+
+  connect(
+        this->ui->passesButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onShowPasses(void)));
+
+  connect(
+        DopplerTableService::instance(),
+        SIGNAL(tableReady(QString)),
+        this,
+        SLOT(onDopplerTableReady(QString)),
+        Qt::QueuedConnection);
 }
 
 FrequencyCorrectionDialog::FrequencyCorrectionDialog(
@@ -984,4 +1073,47 @@ FrequencyCorrectionDialog::onTick(void)
     this->timeStamp = tv;
     this->updatePrediction();
   }
+
+  // Keep the pass list anchored to the current time, so that refreshing
+  // it does not search from the moment it was opened
+  if (this->passesDialog != nullptr)
+    this->passesDialog->setTimestamp(this->timeStamp);
+}
+
+void
+FrequencyCorrectionDialog::onShowPasses(void)
+{
+  if (this->passesDialog == nullptr) {
+    this->passesDialog = new UpcomingPassesDialog(this);
+
+    connect(
+          this->passesDialog,
+          SIGNAL(passSelected(QString)),
+          this,
+          SLOT(onPassSelected(QString)));
+  }
+
+  if (this->haveQth)
+    this->passesDialog->setQth(this->rxSite);
+
+  this->passesDialog->setFrequency(this->centerFreq);
+  this->passesDialog->setTimestamp(this->timeStamp);
+  this->passesDialog->show();
+  this->passesDialog->refresh();
+}
+
+void
+FrequencyCorrectionDialog::onPassSelected(QString satellite)
+{
+  this->ui->satRadio->setChecked(true);
+  this->setCurrentSatellite(satellite);
+}
+
+void
+FrequencyCorrectionDialog::onDopplerTableReady(QString key)
+{
+  if (this->haveOrbit && !this->dopplerTable && key == this->dopplerTableKey) {
+    this->dopplerTable = DopplerTableService::instance()->find(key);
+    this->updatePrediction();
+  }
 }
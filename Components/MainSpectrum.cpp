@@ -28,6 +28,7 @@
 #include <SuWidgetsHelpers.h>
 #include <GlobalProperty.h>
 #include <SigDiggerHelpers.h>
+#include <BookmarkIndex.h>
 
 using namespace SigDigger;
 
@@ -45,6 +46,15 @@ using namespace SigDigger;
 
 namespace SigDigger {
   class SuscanBookmarkSource : public BookmarkSource {
+      BookmarkIndex m_index;
+      std::vector<const BookmarkIndexEntry *> m_hits;
+
+      // The waterfall asks for the same range on every repaint
+      QList<BookmarkInfo> m_cached;
+      qint64  m_cachedStart = 0;
+      qint64  m_cachedEnd   = -1;
+      quint64 m_cachedRev   = 0;
+
     public:
       virtual QList<BookmarkInfo> getBookmarksInRange(qint64, qint64) override;
   };
@@ -53,21 +63,27 @@ namespace SigDigger {
 QList<BookmarkInfo>
 SuscanBookmarkSource::getBookmarksInRange(qint64 start, qint64 end)
 {
-  QList<BookmarkInfo> list;
+  bool rebuilt = m_index.refresh();
 
-  auto p = Suscan::Singleton::get_instance()->getBookmarkFrom(start);
+  if (!rebuilt
+      && start == m_cachedStart
+      && end == m_cachedEnd
+      && m_index.revision() == m_cachedRev)
+    return m_cached;
 
-  while (p != Suscan::Singleton::get_instance()->getLastBookmark()) {
-    try {
-      if (p->info.frequency <= end) {
-        list.push_back(p->info);
-      }
+  m_index.queryLOD(start, end, m_hits);
 
-    } catch (Suscan::Exception const &) { }
-    ++p;
-  }
+  m_cached.clear();
+  m_cached.reserve(static_cast<int>(m_hits.size()));
+
+  for (auto p : m_hits)
+    m_cached.push_back(p->info);
+
+  m_cachedStart = start;
+  m_cachedEnd   = end;
+  m_cachedRev   = m_index.revision();
 
-  return list;
+  return m_cached;
 }
 
 MainSpectrum::MainSpectrum(QWidget *parent) :
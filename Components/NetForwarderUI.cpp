@@ -30,6 +30,12 @@ NetForwarderUI::connectAll(void)
         SIGNAL(clicked(bool)),
         this,
         SLOT(onForwardStartStop(void)));
+
+  connect(
+        this->ui->socketTypeCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onSocketTypeChanged(void)));
 }
 
 NetForwarderUI::NetForwarderUI(QWidget *parent) :
@@ -43,6 +49,7 @@ NetForwarderUI::NetForwarderUI(QWidget *parent) :
   this->spinner->setInnerRadius(5);
   this->ui->spinGrid->addWidget(this->spinner);
 
+  this->onSocketTypeChanged();
   this->connectAll();
 }
 
@@ -92,7 +99,14 @@ NetForwarderUI::setForwardState(bool state)
 
   this->ui->hostEdit->setEnabled(!state);
   this->ui->portSpin->setEnabled(!state);
-  this->ui->frameLen->setEnabled(!state);
+  this->ui->socketTypeCombo->setEnabled(!state);
+
+  if (state) {
+    this->ui->frameLen->setEnabled(false);
+    this->ui->seqHeaderCheck->setEnabled(false);
+  } else {
+    this->onSocketTypeChanged();
+  }
 
   this->ui->udpStartStopButton->setText(state ? "Stop" : "Forward");
 
@@ -131,10 +145,35 @@ NetForwarderUI::setCaptureSize(quint64 size)
         formatCaptureSize(size * sizeof(float _Complex)));
 }
 
+void
+NetForwarderUI::setServerStats(
+    quint64 size,
+    unsigned int subscribers,
+    quint64 dropped)
+{
+  QString text =
+      formatCaptureSize(size * sizeof(float _Complex))
+      + ", "
+      + QString::number(subscribers)
+      + (subscribers == 1 ? " subscriber" : " subscribers");
+
+  if (dropped > 0)
+    text += " (" + formatCaptureSize(dropped) + " dropped)";
+
+  this->ui->txLenLabel->setText(text);
+}
+
 void
 NetForwarderUI::setTcp(bool tcp)
 {
   this->ui->socketTypeCombo->setCurrentIndex(tcp ? 1 : 0);
+  this->onSocketTypeChanged();
+}
+
+void
+NetForwarderUI::setSeqHeader(bool header)
+{
+  this->ui->seqHeaderCheck->setChecked(header);
 }
 
 std::string
@@ -167,6 +206,24 @@ NetForwarderUI::getTcp(void) const
   return this->ui->socketTypeCombo->currentIndex() == 1;
 }
 
+bool
+NetForwarderUI::getSeqHeader(void) const
+{
+  return this->ui->seqHeaderCheck->isChecked();
+}
+
+bool
+NetForwarderUI::isServer(void) const
+{
+  return this->ui->socketTypeCombo->currentIndex() >= 2;
+}
+
+bool
+NetForwarderUI::isLocalServer(void) const
+{
+  return this->ui->socketTypeCombo->currentIndex() == 3;
+}
+
 ///////////////////////////////// Slots ///////////////////////////////////////
 void
 NetForwarderUI::onForwardStartStop(void)
@@ -178,3 +235,14 @@ NetForwarderUI::onForwardStartStop(void)
 
   emit forwardStateChanged(this->ui->udpStartStopButton->isChecked());
 }
+
+void
+NetForwarderUI::onSocketTypeChanged(void)
+{
+  bool udp = this->ui->socketTypeCombo->currentIndex() == 0;
+
+  // Servers take a bind address (or a socket path) instead of a host
+  this->ui->portSpin->setEnabled(!this->isLocalServer());
+  this->ui->frameLen->setEnabled(udp);
+  this->ui->seqHeaderCheck->setEnabled(udp);
+}
@@ -23,9 +23,8 @@
 #include "MainSpectrum.h"
 #include <SuWidgetsHelpers.h>
 #include <SigDiggerHelpers.h>
+#include <TextBlockWriter.h>
 #include <fstream>
-#include <iomanip>
-#include <limits>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <Waterfall.h>
@@ -45,6 +44,8 @@ bool
 SavedSpectrum::exportToFile(QString const &path)
 {
   std::ofstream of(path.toStdString().c_str(), std::ofstream::binary);
+  const float *psd = this->data.data();
+  TextBlockWriter writer(of, SIGDIGGER_TEXT_MAX_NUMBER_LENGTH + 1);
 
   if (!of.is_open())
     return false;
@@ -57,10 +58,17 @@ SavedSpectrum::exportToFile(QString const &path)
   of << "freqMax = " << this->end << ";\n";
   of << "PSD = [ ";
 
-  of << std::setprecision(std::numeric_limits<float>::digits10);
+  if (!writer.write(
+        this->data.size(),
+        [psd] (char *p, size_t from, size_t to) {
+          for (size_t i = from; i < to; ++i) {
+            p = formatReal(p, psd[i]);
+            *p++ = ' ';
+          }
 
-  for (auto p : this->data)
-    of << p << " ";
+          return p;
+        }))
+    return false;
 
   of << "];\n";
 
@@ -0,0 +1,304 @@
+//
+//    RMSDashboard.cpp: Overview of all RMS viewer connections
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include <RMSDashboard.h>
+#include <QPainter>
+#include <QPainterPath>
+#include <QMouseEvent>
+#include <QContextMenuEvent>
+#include <QMenu>
+#include <algorithm>
+#include <cmath>
+
+using namespace SigDigger;
+
+#define RMS_DASHBOARD_MARGIN     4
+#define RMS_DASHBOARD_RATE_ALPHA .5
+
+static inline qreal
+toDb(float mag)
+{
+  // Keep zero power inside the plot
+  return 10 * std::log10(std::max(mag, 1e-20f));
+}
+
+RMSDashboard::RMSDashboard(QWidget *parent) : QWidget(parent)
+{
+  m_clock.start();
+  m_timer.start(RMS_DASHBOARD_REFRESH_MS);
+
+  connect(
+        &m_timer,
+        SIGNAL(timeout()),
+        this,
+        SLOT(onTimeout()));
+}
+
+void
+RMSDashboard::addFeed(RMSFeedPtr const &feed)
+{
+  RMSDashboardCell cell;
+
+  cell.feed = feed;
+  cell.name = QString::fromStdString(feed->peer());
+  m_cells.push_back(std::move(cell));
+
+  relayout();
+}
+
+void
+RMSDashboard::removeFeed(int index)
+{
+  if (index >= 0 && index < count()) {
+    m_cells.erase(m_cells.begin() + index);
+    relayout();
+  }
+}
+
+int
+RMSDashboard::count() const
+{
+  return static_cast<int>(m_cells.size());
+}
+
+RMSFeedPtr
+RMSDashboard::feed(int index) const
+{
+  return m_cells[static_cast<size_t>(index)].feed;
+}
+
+QString
+RMSDashboard::name(int index) const
+{
+  return m_cells[static_cast<size_t>(index)].name;
+}
+
+void
+RMSDashboard::relayout()
+{
+  int rows = (count() + columns() - 1) / columns();
+
+  setMinimumHeight(rows * RMS_DASHBOARD_CELL_HEIGHT);
+  update();
+}
+
+int
+RMSDashboard::columns() const
+{
+  return std::max(1, width() / RMS_DASHBOARD_CELL_WIDTH);
+}
+
+QRect
+RMSDashboard::cellRect(int index) const
+{
+  int cols = columns();
+  int w = width() / cols;
+
+  return QRect(
+        (index % cols) * w,
+        (index / cols) * RMS_DASHBOARD_CELL_HEIGHT,
+        w,
+        RMS_DASHBOARD_CELL_HEIGHT).adjusted(
+        RMS_DASHBOARD_MARGIN,
+        RMS_DASHBOARD_MARGIN,
+        -RMS_DASHBOARD_MARGIN,
+        -RMS_DASHBOARD_MARGIN);
+}
+
+int
+RMSDashboard::cellAt(QPoint const &point) const
+{
+  for (int i = 0; i < count(); ++i)
+    if (cellRect(i).contains(point))
+      return i;
+
+  return -1;
+}
+
+void
+RMSDashboard::paintCell(
+    QPainter &p,
+    RMSDashboardCell const &cell,
+    QRect const &rect)
+{
+  QPalette pal = palette();
+  QColor fg = cell.stats.closed
+      ? pal.color(QPalette::Disabled, QPalette::WindowText)
+      : pal.color(QPalette::WindowText);
+  QColor trace = cell.stats.closed ? fg : pal.color(QPalette::Highlight);
+  QColor band = trace;
+  QFontMetrics metrics(font());
+  int th = metrics.height();
+  QRect header(rect.left() + 4, rect.top() + 2, rect.width() - 8, th);
+  QRect footer(rect.left() + 4, rect.bottom() - th - 2, rect.width() - 8, th);
+  QRect plot(
+        rect.left() + 4,
+        header.bottom() + 4,
+        rect.width() - 8,
+        footer.top() - header.bottom() - 8);
+
+  p.fillRect(rect, pal.color(QPalette::Base));
+  p.setPen(pal.color(QPalette::Mid));
+  p.drawRect(rect);
+
+  p.setPen(fg);
+  p.drawText(
+        header,
+        Qt::AlignLeft | Qt::AlignVCenter,
+        metrics.elidedText(cell.name, Qt::ElideRight, header.width() * 2 / 3));
+
+  if (cell.stats.samples > 0)
+    p.drawText(
+          header,
+          Qt::AlignRight | Qt::AlignVCenter,
+          QString::asprintf("%.2f dB", toDb(cell.stats.last)));
+
+  p.drawText(
+        footer,
+        Qt::AlignLeft | Qt::AlignVCenter,
+        (cell.stats.closed ? QString("Closed") : QString::asprintf(
+            "%.1f S/s", cell.ingestRate))
+        + " · backlog " + QString::number(cell.stats.backlog)
+        + " · dropped " + QString::number(cell.stats.dropped)
+        + " · errors " + QString::number(cell.stats.errors));
+
+  if (cell.summary.empty() || plot.height() < 4)
+    return;
+
+  // Vertical range from the bucket extrema
+  qreal min = +INFINITY, max = -INFINITY;
+  for (auto const &b : cell.summary) {
+    min = std::min(min, toDb(b.min));
+    max = std::max(max, toDb(b.max));
+  }
+
+  if (max - min < 1) {
+    min -= .5;
+    max += .5;
+  }
+
+  size_t n = cell.summary.size();
+  qreal dx = static_cast<qreal>(plot.width()) / n;
+  qreal ky = plot.height() / (max - min);
+  QPainterPath mean;
+
+  band.setAlpha(64);
+  p.setPen(band);
+
+  for (size_t i = 0; i < n; ++i) {
+    auto const &b = cell.summary[i];
+    qreal x = plot.left() + (i + .5) * dx;
+    qreal yMin = plot.bottom() - (toDb(b.min) - min) * ky;
+    qreal yMax = plot.bottom() - (toDb(b.max) - min) * ky;
+    qreal yMean = plot.bottom() - (toDb(b.mean) - min) * ky;
+
+    p.drawLine(QPointF(x, yMin), QPointF(x, yMax));
+
+    if (i == 0)
+      mean.moveTo(x, yMean);
+    else
+      mean.lineTo(x, yMean);
+  }
+
+  p.setPen(trace);
+  p.drawPath(mean);
+
+  p.setPen(pal.color(QPalette::Disabled, QPalette::WindowText));
+  p.drawText(
+        plot,
+        Qt::AlignRight | Qt::AlignTop,
+        QString::asprintf("%.1f dB", max));
+  p.drawText(
+        plot,
+        Qt::AlignRight | Qt::AlignBottom,
+        QString::asprintf("%.1f dB", min));
+}
+
+void
+RMSDashboard::paintEvent(QPaintEvent *)
+{
+  QPainter p(this);
+
+  p.setRenderHint(QPainter::Antialiasing, true);
+
+  for (int i = 0; i < count(); ++i)
+    paintCell(p, m_cells[static_cast<size_t>(i)], cellRect(i));
+}
+
+void
+RMSDashboard::mouseDoubleClickEvent(QMouseEvent *event)
+{
+  int index = cellAt(event->pos());
+
+  if (index != -1)
+    emit feedActivated(index);
+}
+
+void
+RMSDashboard::contextMenuEvent(QContextMenuEvent *event)
+{
+  int index = cellAt(event->pos());
+
+  if (index == -1)
+    return;
+
+  QMenu menu(this);
+  QAction *open = menu.addAction("Open power graph");
+  QAction *disconnect = menu.addAction("Disconnect");
+  QAction *remove = menu.addAction("Remove");
+
+  disconnect->setEnabled(!m_cells[static_cast<size_t>(index)].stats.closed);
+
+  QAction *chosen = menu.exec(event->globalPos());
+
+  if (chosen == open)
+    emit feedActivated(index);
+  else if (chosen == disconnect)
+    emit feedDisconnectRequested(index);
+  else if (chosen == remove)
+    emit feedRemoveRequested(index);
+}
+
+////////////////////////////////// Slots ///////////////////////////////////////
+void
+RMSDashboard::onTimeout()
+{
+  qint64 now = m_clock.elapsed();
+  qreal dt = (now - m_lastUpdate) * 1e-3;
+
+  m_lastUpdate = now;
+
+  for (auto &cell : m_cells) {
+    std::string title = cell.feed->title();
+    std::string peer  = cell.feed->peer();
+
+    cell.stats = cell.feed->stats();
+    cell.span  = cell.feed->summary(cell.summary);
+    cell.name  = QString::fromStdString(title.empty() ? peer : title);
+
+    if (dt > 0) {
+      qreal rate = (cell.stats.samples - cell.prevSamples) / dt;
+      cell.ingestRate +=
+          RMS_DASHBOARD_RATE_ALPHA * (rate - cell.ingestRate);
+    }
+
+    cell.prevSamples = cell.stats.samples;
+  }
+
+  relayout();
+}
@@ -0,0 +1,217 @@
+//
+//    RMSIngestServer.cpp: Accept data loggers on a pool of I/O threads
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include <RMSIngestServer.h>
+#include <QThread>
+#include <QTcpSocket>
+#include <QHostAddress>
+
+using namespace SigDigger;
+
+////////////////////////////// RMSIngestWorker /////////////////////////////////
+RMSIngestWorker::RMSIngestWorker(QObject *parent) : QObject(parent)
+{
+  m_buffer.resize(RMS_INGEST_READ_SIZE);
+}
+
+RMSIngestWorker::~RMSIngestWorker()
+{
+  for (auto it = m_sockets.begin(); it != m_sockets.end(); ++it)
+    it.value()->setClosed();
+}
+
+void
+RMSIngestWorker::adopt(qintptr descriptor, RMSFeedPtr feed)
+{
+  QTcpSocket *socket = new QTcpSocket(this);
+
+  if (!socket->setSocketDescriptor(descriptor)) {
+    feed->setPeer("<error>");
+    feed->setClosed();
+    delete socket;
+    return;
+  }
+
+  feed->setPeer(socket->peerAddress().toString().toStdString());
+  m_sockets.insert(socket, feed);
+
+  connect(
+        socket,
+        SIGNAL(readyRead()),
+        this,
+        SLOT(onReadyRead()));
+
+  connect(
+        socket,
+        SIGNAL(disconnected()),
+        this,
+        SLOT(onDisconnected()));
+
+  // Data may have arrived before the signals were connected
+  readAll(socket);
+}
+
+void
+RMSIngestWorker::close(RMSFeedPtr feed)
+{
+  for (auto it = m_sockets.begin(); it != m_sockets.end(); ++it) {
+    if (it.value() == feed) {
+      // Emits disconnected(), which does the cleanup
+      it.key()->abort();
+      break;
+    }
+  }
+}
+
+void
+RMSIngestWorker::readAll(QTcpSocket *socket)
+{
+  auto it = m_sockets.find(socket);
+  qint64 got;
+
+  if (it == m_sockets.end())
+    return;
+
+  RMSFeedPtr feed = it.value();
+
+  while (socket->bytesAvailable() > 0) {
+    got = socket->read(m_buffer.data(), static_cast<qint64>(m_buffer.size()));
+    if (got < 1)
+      break;
+
+    if (!feed->ingest(m_buffer.data(), static_cast<size_t>(got))) {
+      // Line too long: flooding peer
+      socket->abort();
+      break;
+    }
+  }
+}
+
+void
+RMSIngestWorker::onReadyRead()
+{
+  readAll(static_cast<QTcpSocket *>(QObject::sender()));
+}
+
+void
+RMSIngestWorker::onDisconnected()
+{
+  QTcpSocket *socket = static_cast<QTcpSocket *>(QObject::sender());
+  auto it = m_sockets.find(socket);
+
+  if (it != m_sockets.end()) {
+    it.value()->setClosed();
+    m_sockets.erase(it);
+    socket->deleteLater();
+  }
+}
+
+////////////////////////////// RMSIngestServer /////////////////////////////////
+RMSIngestServer::RMSIngestServer(QObject *parent) : QTcpServer(parent)
+{
+  int threads = QThread::idealThreadCount();
+
+  if (threads < 1)
+    threads = 1;
+  else if (threads > RMS_INGEST_MAX_THREADS)
+    threads = RMS_INGEST_MAX_THREADS;
+
+  for (int i = 0; i < threads; ++i) {
+    QThread *thread = new QThread(this);
+    RMSIngestWorker *worker = new RMSIngestWorker();
+
+    worker->moveToThread(thread);
+
+    connect(
+          thread,
+          SIGNAL(finished()),
+          worker,
+          SLOT(deleteLater()));
+
+    thread->start();
+
+    m_threads.push_back(thread);
+    m_workers.push_back(worker);
+  }
+}
+
+RMSIngestServer::~RMSIngestServer()
+{
+  for (auto thread : m_threads) {
+    thread->quit();
+    thread->wait();
+  }
+}
+
+unsigned int
+RMSIngestServer::threadCount() const
+{
+  return static_cast<unsigned int>(m_threads.size());
+}
+
+void
+RMSIngestServer::incomingConnection(qintptr descriptor)
+{
+  RMSIngestWorker *worker = m_workers[m_next++ % m_workers.size()];
+  RMSFeedPtr feed = std::make_shared<RMSFeed>();
+
+  m_feedToWorker.insert(feed.get(), worker);
+  m_pendingFeeds.push_back(feed);
+
+  QMetaObject::invokeMethod(
+        worker,
+        [worker, descriptor, feed] () {
+          worker->adopt(descriptor, feed);
+        },
+        Qt::QueuedConnection);
+
+  emit newFeed();
+}
+
+RMSFeedPtr
+RMSIngestServer::nextPendingFeed()
+{
+  RMSFeedPtr feed;
+
+  if (!m_pendingFeeds.empty()) {
+    feed = m_pendingFeeds.front();
+    m_pendingFeeds.pop_front();
+  }
+
+  return feed;
+}
+
+void
+RMSIngestServer::closeFeed(RMSFeedPtr const &feed)
+{
+  auto it = m_feedToWorker.find(feed.get());
+
+  if (it != m_feedToWorker.end()) {
+    RMSIngestWorker *worker = it.value();
+    RMSFeedPtr ref = feed; // Kept alive until the worker is done
+
+    m_feedToWorker.erase(it);
+
+    QMetaObject::invokeMethod(
+          worker,
+          [worker, ref] () {
+            worker->close(ref);
+          },
+          Qt::QueuedConnection);
+  }
+}
@@ -19,9 +19,7 @@
 
 #include <RMSViewTab.h>
 #include <QMessageBox>
-#include <cctype>
 #include "ui_RMSViewTab.h"
-#include <sstream>
 #include <utility>
 #include <string>
 #include <QDateTime>
@@ -29,7 +27,10 @@
 #include <QMessageBox>
 #include <complex.h>
 #include <QToolTip>
-#define MAX_LINE_SIZE  4096
+#include <cmath>
+#define READ_BUFFER_SIZE  (64 << 10)
+#define MAX_DISPLAY_POINTS (1 << 22)
+#define SAVE_CHUNK_SIZE    (1 << 16)
 #define TIMER_INTERVAL_MS 100
 using namespace SigDigger;
 
@@ -54,8 +55,10 @@ RMSViewTab::RMSViewTab(QWidget *parent, QTcpSocket *socket) :
 
   this->timer.start(TIMER_INTERVAL_MS);
 
-  if (socket != nullptr)
+  if (socket != nullptr) {
+    m_readBuffer.resize(READ_BUFFER_SIZE);
     this->processSocketData();
+  }
 
   this->connectAll();
 
@@ -110,11 +113,22 @@ RMSViewTab::getIntegrationTimeHint() const
 }
 
 
+qreal
+RMSViewTab::getDisplayRate() const
+{
+  qreal rate = this->rate / this->ui->intSpin->value();
+
+  for (unsigned int i = 0; i < m_displayLevel; ++i)
+    rate /= RMS_HISTORY_DECIMATION;
+
+  return rate;
+}
+
 void
 RMSViewTab::setSampleRate(qreal rate)
 {
   this->rate = rate;
-  this->ui->waveform->setSampleRate(rate / this->ui->intSpin->value());
+  this->ui->waveform->setSampleRate(getDisplayRate());
 
   bool blocked = ui->averageTimeSpinBox->blockSignals(true);
   this->ui->averageTimeSpinBox->setTimeMin(1. / rate);
@@ -150,7 +164,11 @@ RMSViewTab::feed(qreal timeStamp, qreal mag)
   if (this->data.size() > 0) {
     QDateTime date;
     date.setSecsSinceEpoch(static_cast<qint64>(this->last));
-    this->ui->lastLabel->setText("Last: " + date.toString());
+
+    if (m_deferRefresh)
+      m_refreshPending = true;
+    else
+      this->ui->lastLabel->setText("Last: " + date.toString());
 
     if (this->data.size() == 1) {
       this->first = this->last;
@@ -241,12 +259,20 @@ RMSViewTab::saveToMatlab(QString const &path)
   fprintf(fp, "RATE=%.9f;\n", this->rate / this->ui->intSpin->value());
   fprintf(fp, "TIMESTAMP=%.6f;\n", this->first);
   fprintf(fp, "X=[\n");
-  for (size_t i = 0; i < this->data.size(); ++i)
-    fprintf(
-          fp,
-          "  %.9e, %.9f\n",
-          SU_C_REAL(this->data[i]),
-          SU_C_IMAG(this->data[i]));
+
+  // Saved at full resolution, regardless of what is being displayed
+  std::vector<float> chunk(SAVE_CHUNK_SIZE);
+  size_t got;
+
+  for (size_t i = 0;
+       (got = m_history.read(i, chunk.data(), chunk.size())) > 0;
+       i += got)
+    for (size_t j = 0; j < got; ++j)
+      fprintf(
+            fp,
+            "  %.9e, %.9f\n",
+            SU_ASFLOAT(chunk[j]),
+            SU_ASFLOAT(SU_POWER_DB_RAW(chunk[j])));
 
   fprintf(fp, "];\n");
   fclose(fp);
@@ -263,106 +289,267 @@ RMSViewTab::integrateMeasure(qreal timestamp, SUFLOAT mag)
 
   if (++this->accum_ctr == intLen) {
     this->energy_accum /= intLen;
-    this->data.push_back(
-          this->energy_accum
-          + SU_I * SU_ASFLOAT(SU_POWER_DB_RAW(this->energy_accum)));
+    m_history.append(SU_ASFLOAT(this->energy_accum));
+    this->appendToDisplay();
     this->last = timestamp;
     this->accum_ctr = 0;
     this->energy_accum = 0;
-    this->ui->waveform->refreshData();
-    if (this->ui->autoFitButton->isChecked())
-      this->fitVertical();
-    this->ui->waveform->invalidate();
+
+    // The first point is drawn right away, as feed() zooms to it
+    if (m_deferRefresh && this->data.size() > 1)
+      m_refreshPending = true;
+    else
+      this->refreshWaveform();
   } else {
     if (m_haveCurrSamplePoint) {
-      if (this->data.size() == 0) {
+      if (m_history.size() == 0) {
         mag = this->energy_accum / this->accum_ctr;
       } else {
-        SUFLOAT prev = SU_C_REAL(this->data[this->data.size() - 1]);
+        SUFLOAT prev = m_history.last();
         mag = (prev * (intLen - this->accum_ctr) + this->energy_accum) / intLen;
       }
 
       SUCOMPLEX curr = mag + SU_I * SU_ASFLOAT(SU_POWER_DB_RAW(mag));
       m_currSampleIterator->point = curr;
-      m_currSampleIterator->t = this->data.size() * getCurrentTimeDelta();
+      m_currSampleIterator->t = m_history.size() * getCurrentTimeDelta();
       m_currSampleIterator = ui->waveform->refreshPoint(m_currSampleIterator);
     }
   }
 }
 
-bool
-RMSViewTab::parseLine(void)
+static inline SUCOMPLEX
+makePoint(SUFLOAT mag)
 {
-  SUFLOAT mag, db;
-  QDateTime date;
-  long sec;
-  qreal usec;
-  qreal rate;
-  std::vector<std::string> fields;
-  std::istringstream iss(this->line);
+  return mag + SU_I * SU_ASFLOAT(SU_POWER_DB_RAW(mag));
+}
 
-  // Description line allows commas and stuff
-  if (line.compare(0, 5, "DESC,") == 0) {
-    emit titleChanged(QString(line.c_str() + 5));
-    return true;
+void
+RMSViewTab::appendToDisplay(void)
+{
+  if (m_displayLevel == 0) {
+    this->data.push_back(makePoint(m_history.last()));
+  } else {
+    size_t avail = m_history.size(m_displayLevel);
+    while (this->data.size() < avail)
+      this->data.push_back(
+            makePoint(m_history.bucket(m_displayLevel, this->data.size()).mean));
   }
 
-  for (std::string token; std::getline(iss, token, ','); )
-    fields.push_back(std::move(token));
+  // Too many points to keep: switch to a coarser level
+  if (this->data.size() > MAX_DISPLAY_POINTS)
+    this->setDisplayLevel(this->levelForView());
+}
 
-  if (fields.size() == 2) {
-    if (fields[0] == "RATE") {
-      if (sscanf(fields[1].c_str(), "%lf", &rate) < 1)
-        return false;
+//
+// Coarsest level that still gives at least one point per pixel in the
+// visible range, but never one with more than MAX_DISPLAY_POINTS points.
+//
+unsigned int
+RMSViewTab::levelForView() const
+{
+  qreal spp = 0;
+  qreal span = 1;
+  unsigned int level = 0;
+  int width = this->ui->waveform->size().width();
+
+  if (m_viewEnd > m_viewStart && width > 0) {
+    spp = static_cast<qreal>(m_viewEnd - m_viewStart) / width;
+    for (unsigned int i = 0; i < m_displayLevel; ++i)
+      spp *= RMS_HISTORY_DECIMATION;
+  }
 
-      this->setSampleRate(rate);
-    } else {
-      return false;
+  while (level + 1 < m_history.levels()
+         && m_history.size(level + 1) > 0
+         && span * RMS_HISTORY_DECIMATION <= spp) {
+    span *= RMS_HISTORY_DECIMATION;
+    ++level;
+  }
+
+  while (level + 1 < m_history.levels()
+         && m_history.size(level) > MAX_DISPLAY_POINTS)
+    ++level;
+
+  return level;
+}
+
+void
+RMSViewTab::setDisplayLevel(unsigned int level)
+{
+  size_t size = m_history.size(level);
+  qreal scale = 1;
+  qint64 start = m_viewStart;
+  qint64 end = m_viewEnd;
+
+  if (level == m_displayLevel && this->data.size() == size)
+    return;
+
+  // Same visible time range, in points of the new level
+  for (unsigned int i = level; i < m_displayLevel; ++i)
+    scale *= RMS_HISTORY_DECIMATION;
+  for (unsigned int i = m_displayLevel; i < level; ++i)
+    scale /= RMS_HISTORY_DECIMATION;
+
+  m_displayLevel = level;
+
+  this->data.resize(size);
+  if (level == 0) {
+    std::vector<float> chunk(SAVE_CHUNK_SIZE);
+
+    for (size_t p = 0; p < size; p += chunk.size()) {
+      size_t got = m_history.read(p, chunk.data(), chunk.size());
+      for (size_t i = 0; i < got; ++i)
+        this->data[p + i] = makePoint(chunk[i]);
     }
-  } else if (fields.size() == 4) {
-    if (sscanf(fields[0].c_str(), "%ld", &sec) < 1)
-      return false;
-    if (sscanf(fields[1].c_str(), "%lf", &usec) < 1)
-      return false;
-    if (sscanf(fields[2].c_str(), "%e", &mag) < 1)
-      return false;
-    if (sscanf(fields[3].c_str(), "%g", &db) < 1)
-      return false;
+  } else {
+    for (size_t i = 0; i < size; ++i)
+      this->data[i] = makePoint(m_history.bucket(level, i).mean);
+  }
 
-    this->feed(SCAST(qreal, sec) + usec, SCAST(qreal, mag));
+  m_changingLevel = true;
+  this->ui->waveform->setSampleRate(getDisplayRate());
+  this->ui->waveform->refreshData();
 
-    return true;
+  if (end > start) {
+    m_viewStart = static_cast<qint64>(std::floor(start * scale));
+    m_viewEnd   = static_cast<qint64>(std::ceil(end * scale));
+    this->ui->waveform->zoomHorizontal(m_viewStart, m_viewEnd);
   }
+  m_changingLevel = false;
+
+  m_refreshPending = true;
+}
+
+void
+RMSViewTab::refreshWaveform(void)
+{
+  this->ui->waveform->refreshData();
+  if (this->ui->autoFitButton->isChecked())
+    this->fitVertical();
+  this->ui->waveform->invalidate();
+}
+
+void
+RMSViewTab::refreshLastLabel(void)
+{
+  QDateTime date;
+
+  date.setSecsSinceEpoch(static_cast<qint64>(this->last));
+  this->ui->lastLabel->setText("Last: " + date.toString());
+}
+
+void
+RMSViewTab::onTitle(const char *title, size_t len)
+{
+  emit titleChanged(QString::fromUtf8(title, SCAST(int, len)));
+}
+
+void
+RMSViewTab::onRate(double rate)
+{
+  this->setSampleRate(rate);
+}
 
-  return false;
+void
+RMSViewTab::onSample(double timeStamp, double mag)
+{
+  this->feed(timeStamp, mag);
 }
 
 void
 RMSViewTab::processSocketData(void)
 {
-  char c;
+  qint64 got;
+  bool ok = true;
+
+  m_deferRefresh = true;
 
-  while (this->socket->bytesAvailable() > 0) {
-    if (this->socket->read(&c, 1) < 1) {
+  while (ok && this->socket->bytesAvailable() > 0) {
+    got = this->socket->read(
+          m_readBuffer.data(),
+          SCAST(qint64, m_readBuffer.size()));
+
+    if (got < 1) {
+      m_deferRefresh = false;
       this->disconnectSocket();
       return;
     }
 
-    if (c == '\n') {
-      this->parseLine();
-      this->line.clear();
-    } else if (isprint(c)) {
-      this->line += c;
-      if (this->line.size() >= MAX_LINE_SIZE) {
-        this->line.clear();
-        this->disconnect();
-        QMessageBox::critical(
-              this,
-              "Max line size exceeded",
-              "Remote peer attempted to flood us. Preventively disconnected");
-      }
+    ok = m_parser.feed(m_readBuffer.data(), SCAST(size_t, got), this);
+  }
+
+  m_deferRefresh = false;
+
+  if (m_refreshPending) {
+    m_refreshPending = false;
+    if (!this->data.empty()) {
+      this->refreshWaveform();
+      this->refreshLastLabel();
+    }
+  }
+
+  if (!ok) {
+    this->disconnectSocket();
+    QMessageBox::critical(
+          this,
+          "Max line size exceeded",
+          "Remote peer attempted to flood us. Preventively disconnected");
+  }
+}
+
+void
+RMSViewTab::processFeedData(void)
+{
+  RMSFeedStats stats = m_feed->stats();
+  std::string title = m_feed->title();
+
+  if (title != m_feedTitle) {
+    m_feedTitle = title;
+    emit titleChanged(QString::fromStdString(title));
+  }
+
+  if (stats.rate > 0 && stats.rate != m_feedRate) {
+    m_feedRate = stats.rate;
+    this->setSampleRate(stats.rate);
+  }
+
+  if (m_feed->take(m_feedBuffer)) {
+    m_deferRefresh = true;
+    for (auto const &sample : m_feedBuffer)
+      this->feed(sample.timeStamp, SCAST(qreal, sample.mag));
+    m_deferRefresh = false;
+
+    if (m_refreshPending) {
+      m_refreshPending = false;
+      this->refreshWaveform();
+      this->refreshLastLabel();
     }
   }
+
+  if (stats.closed && this->ui->stopButton->isEnabled()) {
+    this->ui->stopButton->setEnabled(false);
+    this->ui->stopButton->setChecked(false);
+    this->ui->stopButton->setIcon(QIcon(":/icons/offline.png"));
+  }
+}
+
+void
+RMSViewTab::setFeed(RMSFeedPtr const &feed)
+{
+  if (m_feed != nullptr)
+    m_feed->setDetailed(false);
+
+  m_feed = feed;
+
+  if (m_feed != nullptr) {
+    m_feed->setDetailed(m_running);
+    this->processFeedData();
+  }
+}
+
+RMSFeedPtr
+RMSViewTab::feed(void) const
+{
+  return m_feed;
 }
 
 void
@@ -442,17 +629,24 @@ RMSViewTab::getMax() const
 void
 RMSViewTab::fitVertical(void)
 {
-  if (this->ui->waveform->getDataLength() > 0) {
-    SUCOMPLEX dataMin = this->ui->waveform->getDataMin();
-    SUCOMPLEX dataMax = this->ui->waveform->getDataMax();
+  float magMin, magMax;
+
+  // Extrema are kept by the history, no need to walk the data
+  if (m_history.extrema(m_displayLevel, magMin, magMax)) {
     qreal min, max;
 
     if (this->ui->dbButton->isChecked()) {
-      min = SU_C_IMAG(dataMin);
-      max = SU_C_IMAG(dataMax);
+      min = SU_POWER_DB_RAW(magMin);
+      max = SU_POWER_DB_RAW(magMax);
+
+      // Zero power somewhere: let the widget find the finite range
+      if (!std::isfinite(min))
+        min = SU_C_IMAG(this->ui->waveform->getDataMin());
+      if (!std::isfinite(max))
+        max = SU_C_IMAG(this->ui->waveform->getDataMax());
     } else {
-      min = SU_C_REAL(dataMin);
-      max = SU_C_REAL(dataMax);
+      min = magMin;
+      max = magMax;
     }
 
     if (min == max) {
@@ -580,6 +774,12 @@ RMSViewTab::connectAll(void)
         this,
         SLOT(onToolTip(int,int,qreal,qreal)));
 
+  connect(
+        this->ui->waveform,
+        SIGNAL(horizontalRangeChanged(qint64, qint64)),
+        this,
+        SLOT(onHZoom(qint64, qint64)));
+
   connect(
         this->ui->timeScaleCombo,
         SIGNAL(activated(int)),
@@ -601,6 +801,9 @@ RMSViewTab::running() const
 
 RMSViewTab::~RMSViewTab()
 {
+  if (m_feed != nullptr)
+    m_feed->setDetailed(false);
+
   this->disconnectSocket();
   delete ui;
 }
@@ -667,8 +870,11 @@ RMSViewTab::onToggleStartStop(void)
 {
   if (m_running != ui->stopButton->isChecked()) {
     if (m_running) {
-      // Disconnect
+      // Disconnect. Feeds belong to the ingest server and stay open, we
+      // just stop taking samples from them.
       this->disconnectSocket();
+      if (m_feed != nullptr)
+        m_feed->setDetailed(false);
     } else {
       // Starting
       if (!userClear(
@@ -678,6 +884,9 @@ RMSViewTab::onToggleStartStop(void)
       }
 
       onValueChanged(0);
+
+      if (m_feed != nullptr)
+        m_feed->setDetailed(true);
     }
     m_running = ui->stopButton->isChecked();
     emit toggleState();
@@ -689,6 +898,8 @@ RMSViewTab::onTimeout(void)
 {
   if (this->socket != nullptr)
     this->processSocketData();
+  else if (m_feed != nullptr)
+    this->processFeedData();
 }
 
 void
@@ -708,6 +919,20 @@ RMSViewTab::onResetZoom(void)
   this->ui->waveform->zoomHorizontalReset();
 }
 
+void
+RMSViewTab::onHZoom(qint64 min, qint64 max)
+{
+  m_viewStart = min;
+  m_viewEnd   = max;
+
+  if (!m_changingLevel) {
+    unsigned int level = this->levelForView();
+
+    if (level != m_displayLevel)
+      this->setDisplayLevel(level);
+  }
+}
+
 void
 RMSViewTab::onSocketDisconnected(void)
 {
@@ -723,7 +948,10 @@ RMSViewTab::onValueChanged(int)
   this->ui->sinceLabel->setText("Since: N/A");
   this->ui->lastLabel->setText("Last: N/A");
   this->data.clear();
-  this->ui->waveform->setSampleRate(rate / this->ui->intSpin->value());
+  m_history.clear();
+  m_displayLevel = 0;
+  m_viewStart = m_viewEnd = 0;
+  this->ui->waveform->setSampleRate(getDisplayRate());
   this->ui->waveform->refreshData();
   if (this->ui->autoFitButton->isChecked())
     this->fitVertical();
@@ -19,9 +19,11 @@
 
 #include <RMSViewer.h>
 #include <RMSViewTab.h>
+#include <RMSDashboard.h>
 #include <QMessageBox>
+#include <QScrollArea>
+#include <QTabBar>
 #include <RMSViewerSettingsDialog.h>
-#include <QMessageBox>
 
 #include "ui_RMSViewer.h"
 
@@ -35,26 +37,67 @@ RMSViewer::RMSViewer(QWidget *parent) :
 
   this->settingsDialog = new RMSViewerSettingsDialog(this);
   this->settingsDialog->setWindowTitle("TCP server settings");
+
+  // Every connection shows up here. Full power graphs are opened on demand.
+  QScrollArea *scrollArea = new QScrollArea(this);
+  this->dashboard = new RMSDashboard(scrollArea);
+  scrollArea->setWidget(this->dashboard);
+  scrollArea->setWidgetResizable(true);
+  this->dashboardPage = scrollArea;
+
+  this->ui->serverTabWidget->addTab(scrollArea, "Dashboard");
+  this->ui->serverTabWidget->tabBar()->setTabButton(
+        0,
+        QTabBar::RightSide,
+        nullptr);
+  this->ui->serverTabWidget->tabBar()->setTabButton(
+        0,
+        QTabBar::LeftSide,
+        nullptr);
+
+  this->ui->statusbar->showMessage(
+        QString::number(this->server.threadCount())
+        + " I/O thread(s) ready");
+
   this->connectAll();
 }
 
-void
-RMSViewer::openNewView(QTcpSocket *socket)
+RMSViewTab *
+RMSViewer::findView(RMSFeedPtr const &feed) const
 {
-  RMSViewTab *tab = new RMSViewTab(this, socket);
+  for (int i = 0; i < this->ui->serverTabWidget->count(); ++i) {
+    RMSViewTab *tab = qobject_cast<RMSViewTab *>(
+          this->ui->serverTabWidget->widget(i));
+    if (tab != nullptr && tab->feed() == feed)
+      return tab;
+  }
 
-  int ndx = this->ui->serverTabWidget->addTab(
-        tab,
-        "Power graph [" + socket->peerAddress().toString() + "]");
+  return nullptr;
+}
 
-  connect(
-        tab,
-        SIGNAL(titleChanged(QString)),
-        this,
-        SLOT(onTitleChanged(QString)));
+void
+RMSViewer::openFeedView(int index)
+{
+  RMSFeedPtr feed = this->dashboard->feed(index);
+  RMSViewTab *tab = this->findView(feed);
+
+  if (tab == nullptr) {
+    tab = new RMSViewTab(this, nullptr);
+    this->ui->serverTabWidget->addTab(
+          tab,
+          "Power graph [" + this->dashboard->name(index) + "]");
+
+    connect(
+          tab,
+          SIGNAL(titleChanged(QString)),
+          this,
+          SLOT(onTitleChanged(QString)));
 
-  this->ui->stackedWidget->setCurrentIndex(0);
-  this->ui->serverTabWidget->setCurrentIndex(ndx);
+    // Samples are kept for the tab only from now on
+    tab->setFeed(feed);
+  }
+
+  this->ui->serverTabWidget->setCurrentWidget(tab);
 }
 
 bool
@@ -146,9 +189,27 @@ RMSViewer::connectAll(void)
 
   connect(
         &this->server,
-        SIGNAL(newConnection()),
+        SIGNAL(newFeed()),
+        this,
+        SLOT(onNewFeed()));
+
+  connect(
+        this->dashboard,
+        SIGNAL(feedActivated(int)),
+        this,
+        SLOT(onFeedActivated(int)));
+
+  connect(
+        this->dashboard,
+        SIGNAL(feedDisconnectRequested(int)),
+        this,
+        SLOT(onFeedDisconnectRequested(int)));
+
+  connect(
+        this->dashboard,
+        SIGNAL(feedRemoveRequested(int)),
         this,
-        SLOT(onNewConnection()));
+        SLOT(onFeedRemoveRequested(int)));
 
   connect(
         this->ui->actionStartStop,
@@ -188,12 +249,50 @@ RMSViewer::onAcceptError(QAbstractSocket::SocketError)
 }
 
 void
-RMSViewer::onNewConnection(void)
+RMSViewer::onNewFeed(void)
+{
+  RMSFeedPtr feed;
+
+  while ((feed = this->server.nextPendingFeed()) != nullptr)
+    this->dashboard->addFeed(feed);
+
+  this->ui->stackedWidget->setCurrentIndex(0);
+}
+
+void
+RMSViewer::onFeedActivated(int index)
+{
+  this->openFeedView(index);
+}
+
+void
+RMSViewer::onFeedDisconnectRequested(int index)
+{
+  this->server.closeFeed(this->dashboard->feed(index));
+}
+
+void
+RMSViewer::onFeedRemoveRequested(int index)
 {
-  QTcpSocket *socket;
+  RMSFeedPtr feed = this->dashboard->feed(index);
+  RMSViewTab *tab = this->findView(feed);
 
-  while ((socket = this->server.nextPendingConnection()) != nullptr)
-    this->openNewView(socket);
+  if (QMessageBox::question(
+        this,
+        "Remove connection",
+        "You are about to remove " + this->dashboard->name(index) + " from "
+        "the dashboard. This will close the connection and clear unsaved "
+        "data. Are you sure?") != QMessageBox::Yes)
+    return;
+
+  if (tab != nullptr) {
+    this->ui->serverTabWidget->removeTab(
+          this->ui->serverTabWidget->indexOf(tab));
+    delete tab;
+  }
+
+  this->server.closeFeed(feed);
+  this->dashboard->removeFeed(index);
 }
 
 void
@@ -249,17 +348,18 @@ RMSViewer::onTabCloseRequested(int ndx)
 {
   QString name = this->ui->serverTabWidget->tabText(ndx);
 
+  if (this->ui->serverTabWidget->widget(ndx) == this->dashboardPage)
+    return;
+
   if (QMessageBox::question(
         this,
         "Close tab",
-        "You are about to close tab " + name + ". This will "
-        "close the connection and clear unsaved data. Are you sure?") ==
+        "You are about to close tab " + name + ". This will clear unsaved "
+        "data, while the connection remains in the dashboard. Are you "
+        "sure?") ==
       QMessageBox::Yes) {
     QWidget *widget = this->ui->serverTabWidget->widget(ndx);
     this->ui->serverTabWidget->removeTab(ndx);
     delete widget;
-
-    if (this->ui->serverTabWidget->count() == 0)
-      this->ui->stackedWidget->setCurrentIndex(1);
   }
 }
@@ -0,0 +1,293 @@
+//
+//    SpectrogramView.cpp: Spectrogram of time window captures
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SpectrogramView.h"
+#include <QContextMenuEvent>
+#include <QMenu>
+#include <QPainter>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace SigDigger;
+
+#define SIGDIGGER_SPECTROGRAM_ZOOM_FACTOR 1.25
+
+SpectrogramView::SpectrogramView(QWidget *parent) : QFrame(parent)
+{
+  // Grayscale until a palette is set
+  for (int i = 0; i < 256; ++i)
+    m_colors[i] = qRgb(i, i, i);
+
+  setMinimumHeight(64);
+
+  connect(
+        &m_engine,
+        SIGNAL(tileReady()),
+        this,
+        SLOT(onTileReady()));
+}
+
+void
+SpectrogramView::setData(const SUCOMPLEX *data, size_t length)
+{
+  m_engine.setData(data, length);
+
+  m_data   = data;
+  m_length = length;
+  m_start  = 0;
+  m_end    = static_cast<qint64>(length);
+
+  update();
+}
+
+void
+SpectrogramView::setTimeRange(qint64 start, qint64 end)
+{
+  if (start != m_start || end != m_end) {
+    m_start = start;
+    m_end   = end;
+    update();
+  }
+}
+
+void
+SpectrogramView::setFftSize(unsigned int size)
+{
+  size = qBound<unsigned int>(
+        SIGDIGGER_SPECTROGRAM_MIN_FFT,
+        size,
+        SIGDIGGER_SPECTROGRAM_MAX_FFT);
+
+  if (size != m_fftSize) {
+    m_fftSize = size;
+    update();
+  }
+}
+
+void
+SpectrogramView::setDynamicRange(qreal range)
+{
+  if (range > 0) {
+    m_range = range;
+    update();
+  }
+}
+
+void
+SpectrogramView::setGradient(const QColor *gradient)
+{
+  for (int i = 0; i < 256; ++i)
+    m_colors[i] = gradient[i].rgb();
+
+  update();
+}
+
+void
+SpectrogramView::setBackgroundColor(QColor const &color)
+{
+  m_background = color;
+  update();
+}
+
+unsigned int
+SpectrogramView::getFftSize() const
+{
+  return m_fftSize;
+}
+
+void
+SpectrogramView::paintEvent(QPaintEvent *)
+{
+  QPainter painter(this);
+  int width  = this->width();
+  int height = this->height();
+  qint64 start = std::max<qint64>(m_start, 0);
+  qint64 end   = std::min<qint64>(m_end, static_cast<qint64>(m_length));
+  qreal samplesPerPixel;
+  size_t hop, span, first, last, center;
+  std::vector<SpectrogramTilePtr> tiles;
+  std::vector<SpectrogramTileKey> missing;
+  std::vector<const float *> columns;
+  std::vector<unsigned int> bins;
+  float top = -std::numeric_limits<float>::infinity();
+  float k;
+
+  if (m_data == nullptr || end <= start || width <= 0 || height <= 0) {
+    painter.fillRect(rect(), m_background);
+    return;
+  }
+
+  samplesPerPixel = static_cast<qreal>(m_end - m_start) / width;
+  hop   = SpectrogramEngine::hopForZoom(samplesPerPixel);
+  span  = SpectrogramEngine::tileSamples(hop);
+  first = static_cast<size_t>(start) / span;
+  last  = static_cast<size_t>(end - 1) / span;
+
+  // Tiles we already have, and the ones to compute (center first)
+  for (size_t i = first; i <= last; ++i) {
+    SpectrogramTileKey key = {m_fftSize, hop, i};
+    SpectrogramTilePtr tile = m_engine.tile(key);
+
+    tiles.push_back(tile);
+
+    if (tile)
+      top = std::max(top, tile->max);
+    else
+      missing.push_back(key);
+  }
+
+  center = (first + last) / 2;
+  std::sort(
+        missing.begin(),
+        missing.end(),
+        [center] (SpectrogramTileKey const &a, SpectrogramTileKey const &b) {
+          qint64 c = static_cast<qint64>(center);
+
+          return qAbs(static_cast<qint64>(a.index) - c)
+              < qAbs(static_cast<qint64>(b.index) - c);
+        });
+  m_engine.request(missing);
+
+  if (m_image.width() != width || m_image.height() != height)
+    m_image = QImage(width, height, QImage::Format_RGB32);
+
+  m_image.fill(m_background);
+
+  // Spectrum column shown at each pixel column
+  columns.resize(static_cast<size_t>(width), nullptr);
+  for (int x = 0; x < width; ++x) {
+    qreal sample = m_start + (x + .5) * samplesPerPixel;
+    size_t pos, t, c;
+
+    if (sample < start || sample >= end)
+      continue;
+
+    pos = static_cast<size_t>(sample);
+    t   = pos / span;
+    c   = (pos - t * span) / hop;
+
+    if (tiles[t - first] && c < tiles[t - first]->columns)
+      columns[static_cast<size_t>(x)] =
+          tiles[t - first]->column(static_cast<unsigned int>(c));
+  }
+
+  // FFT bin shown at each row. Bins are DC centered.
+  bins.resize(static_cast<size_t>(height));
+  for (int y = 0; y < height; ++y) {
+    qreal f = m_freqMax - (y + .5) / height * (m_freqMax - m_freqMin);
+    qint64 bin = static_cast<qint64>(std::floor((f + .5) * m_fftSize));
+
+    bins[static_cast<size_t>(y)] = static_cast<unsigned int>(
+          qBound<qint64>(0, bin, m_fftSize - 1));
+  }
+
+  k = static_cast<float>(255. / m_range);
+
+  for (int y = 0; y < height; ++y) {
+    QRgb *line = reinterpret_cast<QRgb *>(m_image.scanLine(y));
+    unsigned int bin = bins[static_cast<size_t>(y)];
+
+    for (int x = 0; x < width; ++x) {
+      const float *column = columns[static_cast<size_t>(x)];
+
+      if (column != nullptr) {
+        int level = static_cast<int>((column[bin] - top) * k + 255.f);
+        line[x] = m_colors[qBound(0, level, 255)];
+      }
+    }
+  }
+
+  painter.drawImage(0, 0, m_image);
+}
+
+void
+SpectrogramView::wheelEvent(QWheelEvent *event)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+  qreal y = event->position().y();
+#else
+  qreal y = event->pos().y();
+#endif // QT_VERSION_CHECK
+  qreal f = m_freqMax - y / height() * (m_freqMax - m_freqMin);
+  qreal factor = event->angleDelta().y() > 0
+      ? 1. / SIGDIGGER_SPECTROGRAM_ZOOM_FACTOR
+      : SIGDIGGER_SPECTROGRAM_ZOOM_FACTOR;
+  qreal minWidth = 4. / m_fftSize;
+  qreal newMin = f - (f - m_freqMin) * factor;
+  qreal newMax = f + (m_freqMax - f) * factor;
+
+  // Keep the frequency under the cursor in place
+  if (newMax - newMin < minWidth) {
+    newMin = f - minWidth / 2;
+    newMax = f + minWidth / 2;
+  }
+
+  m_freqMin = std::max(newMin, -.5);
+  m_freqMax = std::min(newMax, +.5);
+
+  event->accept();
+  update();
+}
+
+void
+SpectrogramView::resetFrequencyZoom()
+{
+  m_freqMin = -.5;
+  m_freqMax = +.5;
+  update();
+}
+
+void
+SpectrogramView::mouseDoubleClickEvent(QMouseEvent *)
+{
+  resetFrequencyZoom();
+}
+
+void
+SpectrogramView::contextMenuEvent(QContextMenuEvent *event)
+{
+  QMenu menu(this);
+  QMenu *sizes = menu.addMenu("FFT size");
+  QAction *selected;
+
+  for (unsigned int size = SIGDIGGER_SPECTROGRAM_MIN_FFT;
+       size <= SIGDIGGER_SPECTROGRAM_MAX_FFT;
+       size <<= 1) {
+    QAction *action = sizes->addAction(QString::number(size));
+    action->setCheckable(true);
+    action->setChecked(size == m_fftSize);
+    action->setData(size);
+  }
+
+  menu.addAction("Reset frequency zoom", this, SLOT(resetFrequencyZoom()));
+
+  selected = menu.exec(event->globalPos());
+
+  if (selected != nullptr && selected->data().isValid())
+    setFftSize(selected->data().toUInt());
+}
+
+///////////////////////////////// Slots ////////////////////////////////////////
+void
+SpectrogramView::onTileReady()
+{
+  update();
+}
@@ -38,6 +38,7 @@
 #include <AGCTask.h>
 #include <DelayedConjTask.h>
 #include <LPFTask.h>
+#include <CaptureOverview.h>
 
 #include "ui_TimeWindow.h"
 
@@ -268,6 +269,12 @@ TimeWindow::connectAll()
         this,
         SLOT(onPhaseDerivative()));
 
+  connect(
+        ui->actionShowSpectrogram,
+        SIGNAL(triggered(bool)),
+        this,
+        SLOT(onShowSpectrogram()));
+
   connect(
         ui->periodicSelectionCheck,
         SIGNAL(stateChanged(int)),
@@ -334,6 +341,12 @@ TimeWindow::connectAll()
         this,
         SLOT(onTaskError(QString)));
 
+  connect(
+        &m_statsEngine,
+        SIGNAL(ready(quint64)),
+        this,
+        SLOT(onStatsReady(quint64)));
+
   connect(
         ui->guessCarrierButton,
         SIGNAL(clicked()),
@@ -458,6 +471,14 @@ TimeWindow::getDisplayDataLength() const
   return m_displayDataLength;
 }
 
+// Overviews describe the original capture, not the results of processing it
+bool
+TimeWindow::overviewCoversDisplayData() const
+{
+  return m_overview != nullptr
+      && m_overview->covers(m_displayDataPtr, m_displayDataLength);
+}
+
 void
 TimeWindow::showEvent(QShowEvent *)
 {
@@ -516,6 +537,8 @@ TimeWindow::setColorConfig(ColorConfig const &cfg)
   ui->imagWaveform->setTextColor(cfg.spectrumText);
   ui->imagWaveform->setSelectionColor(cfg.selection);
 
+  ui->spectrogram->setBackgroundColor(cfg.spectrumBackground);
+
   m_histogramDialog->setColorConfig(cfg);
   m_samplerDialog->setColorConfig(cfg);
   m_dopplerDialog->setColorConfig(cfg);
@@ -600,6 +623,10 @@ TimeWindow::getTransformRegion(
   SUCOMPLEX *dest;
   length = 0;
 
+  // The statistics and spectrogram of the processed data are about to change
+  m_statsEngine.invalidate();
+  ui->spectrogram->setData(nullptr, 0);
+
   m_processedData.resize(getDisplayDataLength());
   dest = m_processedData.data();
 
@@ -819,10 +846,12 @@ TimeWindow::refreshMeasures()
   qreal selStart = 0;
   qreal selEnd   = 0;
   qreal deltaT = 1. / ui->realWaveform->getSampleRate();
-  SUCOMPLEX min, max, mean;
-  SUFLOAT rms;
+  SUCOMPLEX min = 0, max = 0, mean = 0;
+  SUFLOAT rms = 0;
+  SampleStats stats;
   int length = static_cast<int>(getDisplayDataLength());
-  bool selection = false;
+  bool rmsBound = false;
+  bool exact;
 
   if (ui->realWaveform->getHorizontalSelectionPresent()) {
     selStart = ui->realWaveform->getHorizontalSelectionStart();
@@ -834,9 +863,7 @@ TimeWindow::refreshMeasures()
       selEnd = length;
   }
 
-  if (selEnd - selStart > 0 && ui->realWaveform->isComplete()) {
-    WaveLimits limits;
-
+  if (selEnd - selStart > 0) {
     qreal period =
         (selEnd - selStart) /
         (ui->periodicSelectionCheck->isChecked()
@@ -845,30 +872,35 @@ TimeWindow::refreshMeasures()
         * deltaT;
     qreal baud = 1 / period;
 
-#if 0
-    const SUCOMPLEX *data = getDisplayData();
-
-    SuWidgetsHelpers::kahanMeanAndRms(
-          &mean,
-          &rms,
-          data + static_cast<qint64>(selStart),
-          SCAST(SUSCOUNT, selEnd - selStart));
-    SuWidgetsHelpers::calcLimits(
-          &min,
-          &max,
-          data + static_cast<qint64>(selStart),
-          SCAST(SUSCOUNT, selEnd - selStart));
-#else
-    ui->realWaveform->computeLimits(selStart, selEnd, limits);
-
-    mean = limits.mean;
-    min  = limits.min;
-    max  = limits.max;
-    rms  = limits.envelope;
-
-    selection = true;
+    exact = m_statsEngine.request(
+          getDisplayData(),
+          static_cast<size_t>(selStart),
+          static_cast<size_t>(selEnd),
+          stats);
+
+    // Show what is known already until the exact figures are ready
+    if (!exact && overviewCoversDisplayData()) {
+      CaptureOverviewStats approx = m_overview->stats(
+            static_cast<size_t>(selStart),
+            static_cast<size_t>(selEnd));
+
+      mean = approx.mean;
+      min  = approx.min;
+      max  = approx.max;
+      rms  = approx.rms;
+    } else if (!exact && ui->realWaveform->isComplete()) {
+      WaveLimits limits;
+
+      ui->realWaveform->computeLimits(selStart, selEnd, limits);
+
+      mean = limits.mean;
+      min  = limits.min;
+      max  = limits.max;
+      rms  = limits.envelope;
+
+      rmsBound = true;
+    }
 
-#endif
     ui->periodLabel->setText(
           SuWidgetsHelpers::formatQuantityFromDelta(
             period,
@@ -900,10 +932,25 @@ TimeWindow::refreshMeasures()
             "s")
           + " (" + SuWidgetsHelpers::formatReal(selEnd - selStart) + ")");
   } else {
-    min  = ui->realWaveform->getDataMin();
-    max  = ui->realWaveform->getDataMax();
-    mean = ui->realWaveform->getDataMean();
-    rms  = ui->realWaveform->getDataRMS();
+    exact = m_statsEngine.request(
+          getDisplayData(),
+          0,
+          getDisplayDataLength(),
+          stats);
+
+    if (!exact && overviewCoversDisplayData()) {
+      CaptureOverviewStats approx = m_overview->stats();
+
+      min  = approx.min;
+      max  = approx.max;
+      mean = approx.mean;
+      rms  = approx.rms;
+    } else if (!exact) {
+      min  = ui->realWaveform->getDataMin();
+      max  = ui->realWaveform->getDataMax();
+      mean = ui->realWaveform->getDataMean();
+      rms  = ui->realWaveform->getDataRMS();
+    }
 
     ui->periodLabel->setText("N/A");
     ui->baudLabel->setText("N/A");
@@ -912,6 +959,25 @@ TimeWindow::refreshMeasures()
     ui->selLengthLabel->setText("N/A");
   }
 
+  if (exact) {
+    min  = stats.min;
+    max  = stats.max;
+    mean = stats.mean;
+    rms  = stats.rms;
+  }
+
+  if (exact && stats.count > 0) {
+    ui->paprLabel->setText(
+          QString::number(stats.papr, 'f', 2) + " dB");
+    ui->percentilesLabel->setText(
+          SuWidgetsHelpers::formatScientific(stats.p50) + " / "
+          + SuWidgetsHelpers::formatScientific(stats.p90) + " / "
+          + SuWidgetsHelpers::formatScientific(stats.p99));
+  } else {
+    ui->paprLabel->setText(exact ? "N/A" : "Computing...");
+    ui->percentilesLabel->setText(exact ? "N/A" : "Computing...");
+  }
+
   ui->lengthLabel->setText(QString::number(length) + " samples");
 
   ui->durationLabel->setText(
@@ -939,7 +1005,7 @@ TimeWindow::refreshMeasures()
         SuWidgetsHelpers::formatScientific(SU_C_IMAG(mean)));
 
   ui->rmsLabel->setText(
-        (selection ? "< " : "") +
+        (rmsBound ? "< " : "") +
         SuWidgetsHelpers::formatReal(rms));
 }
 
@@ -968,12 +1034,16 @@ TimeWindow::setDisplayData(
 {
   QCursor cursor = this->cursor();
 
+  m_statsEngine.invalidate();
+
   m_displayDataPtr    = displayData;
   m_displayDataLength = displayLen;
 
   // This is just a workaround. TODO: fix build method in Waveformview
   setCursor(Qt::WaitCursor);
 
+  ui->spectrogram->setData(displayData, displayLen);
+
   if (displayLen == 0) {
     ui->realWaveform->setData(nullptr, false);
     ui->imagWaveform->setData(nullptr, false);
@@ -988,6 +1058,10 @@ TimeWindow::setDisplayData(
       ui->realWaveform->zoomHorizontal(currStart, currEnd);
       ui->imagWaveform->zoomHorizontal(currStart, currEnd);
     }
+
+    ui->spectrogram->setTimeRange(
+          ui->realWaveform->getSampleStart(),
+          ui->realWaveform->getSampleEnd());
   }
 
   setCursor(Qt::ArrowCursor);
@@ -1029,6 +1103,25 @@ TimeWindow::setData(std::vector<SUCOMPLEX> const &data, qreal fs, qreal bw)
   setData(data.data(), data.size(), fs, bw);
 }
 
+void
+TimeWindow::setOverview(const CaptureOverview *overview)
+{
+  if (m_overview != nullptr)
+    disconnect(m_overview, nullptr, this, nullptr);
+
+  m_overview = overview;
+
+  if (m_overview != nullptr) {
+    connect(
+          m_overview,
+          SIGNAL(ready()),
+          this,
+          SLOT(onOverviewReady()));
+
+    refreshMeasures();
+  }
+}
+
 void
 TimeWindow::adjustButtonToSize(QPushButton *button, QString text)
 {
@@ -1043,6 +1136,10 @@ TimeWindow::adjustButtonToSize(QPushButton *button, QString text)
 void
 TimeWindow::closeEvent(QCloseEvent *)
 {
+  // The data may be released as soon as the window is closed
+  m_statsEngine.invalidate();
+  ui->spectrogram->setData(nullptr, 0);
+
   emit closed();
 }
 
@@ -1072,6 +1169,9 @@ TimeWindow::TimeWindow(QWidget *parent) :
 
   ui->imagWaveform->reuseDisplayData(ui->realWaveform);
 
+  ui->spectrogram->setVisible(false);
+  ui->spectrogramLabel->setVisible(false);
+
   ui->syncFreqSpin->setExtraDecimals(6);
 
 #ifdef __APPLE__
@@ -1123,6 +1223,8 @@ TimeWindow::onHZoom(qint64 min, qint64 max)
 {
   QObject* obj = sender();
 
+  ui->spectrogram->setTimeRange(min, max);
+
   if (!m_adjusting) {
     Waveform *wf = nullptr;
     m_adjusting = true;
@@ -1371,6 +1473,20 @@ TimeWindow::onFit()
     ui->realWaveform->zoomHorizontalReset();
     ui->imagWaveform->zoomHorizontalReset();
 
+    ui->realWaveform->invalidate();
+    ui->imagWaveform->invalidate();
+  } else if (overviewCoversDisplayData()) {
+    // The waveforms are still being built, but the envelope is known
+    qreal envelope = m_overview->stats().envelope;
+
+    if (envelope > 0) {
+      ui->realWaveform->zoomVertical(-envelope, envelope);
+      ui->imagWaveform->zoomVertical(-envelope, envelope);
+    }
+
+    ui->realWaveform->zoomHorizontalReset();
+    ui->imagWaveform->zoomHorizontalReset();
+
     ui->realWaveform->invalidate();
     ui->imagWaveform->invalidate();
   }
@@ -1495,6 +1611,20 @@ TimeWindow::onPhaseDerivative()
         ui->actionPhaseDerivative->isChecked());
 }
 
+void
+TimeWindow::onShowSpectrogram()
+{
+  bool visible = ui->actionShowSpectrogram->isChecked();
+
+  ui->spectrogram->setVisible(visible);
+  ui->spectrogramLabel->setVisible(visible);
+
+  if (visible)
+    ui->spectrogram->setTimeRange(
+          ui->realWaveform->getSampleStart(),
+          ui->realWaveform->getSampleEnd());
+}
+
 void
 TimeWindow::onPaletteChanged(int index)
 {
@@ -1503,6 +1633,7 @@ TimeWindow::onPaletteChanged(int index)
   if (palette != nullptr) {
     ui->realWaveform->setPalette(palette->getGradient());
     ui->imagWaveform->setPalette(palette->getGradient());
+    ui->spectrogram->setGradient(palette->getGradient());
   }
 
   emit configChanged();
@@ -2329,3 +2460,23 @@ TimeWindow::onZeroPointChanged()
     ui->imagWaveform->setACursorList(aEmpty);
   }
 }
+
+void
+TimeWindow::onOverviewReady()
+{
+  // Queued from an overview that is no longer attached
+  if (m_overview == nullptr || sender() != m_overview)
+    return;
+
+  refreshMeasures();
+}
+
+void
+TimeWindow::onStatsReady(quint64 generation)
+{
+  // Queued before the data changed or was released
+  if (generation != m_statsEngine.generation())
+    return;
+
+  refreshMeasures();
+}
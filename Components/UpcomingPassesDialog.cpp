@@ -0,0 +1,167 @@
+//
+//    UpcomingPassesDialog.cpp: Sortable table of upcoming satellite passes
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <UpcomingPassesDialog.h>
+#include "ui_UpcomingPassesDialog.h"
+#include <SatellitePassPredictor.h>
+#include <SatellitePassTableModel.h>
+#include <QSortFilterProxyModel>
+#include <QHeaderView>
+
+using namespace SigDigger;
+
+UpcomingPassesDialog::UpcomingPassesDialog(QWidget *parent) :
+  QDialog(parent),
+  ui(new Ui::UpcomingPassesDialog)
+{
+  ui->setupUi(this);
+
+  this->predictor = new SatellitePassPredictor(this);
+  this->model = new SatellitePassTableModel(this);
+  this->proxy = new QSortFilterProxyModel(this);
+  this->proxy->setSourceModel(this->model);
+  this->proxy->setSortRole(SIGDIGGER_PASS_SORT_ROLE);
+
+  this->ui->passView->setModel(this->proxy);
+  this->ui->passView->setSortingEnabled(true);
+  this->ui->passView->sortByColumn(1, Qt::AscendingOrder);
+  this->ui->passView->horizontalHeader()->setSectionResizeMode(
+        0,
+        QHeaderView::Stretch);
+
+  this->connectAll();
+}
+
+UpcomingPassesDialog::~UpcomingPassesDialog()
+{
+  delete ui;
+}
+
+void
+UpcomingPassesDialog::connectAll(void)
+{
+  connect(
+        this->ui->refreshButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onRefresh(void)));
+
+  connect(
+        this->predictor,
+        SIGNAL(progress(int, int)),
+        this,
+        SLOT(onProgress(int, int)),
+        Qt::QueuedConnection);
+
+  connect(
+        this->predictor,
+        SIGNAL(finished(void)),
+        this,
+        SLOT(onFinished(void)),
+        Qt::QueuedConnection);
+
+  connect(
+        this->ui->passView,
+        SIGNAL(activated(QModelIndex const &)),
+        this,
+        SLOT(onCellActivated(QModelIndex const &)));
+}
+
+void
+UpcomingPassesDialog::setQth(xyz_t const &qth)
+{
+  this->predictor->setQth(qth);
+}
+
+void
+UpcomingPassesDialog::setFrequency(qreal freq)
+{
+  this->model->setFrequency(freq);
+}
+
+void
+UpcomingPassesDialog::setTimestamp(struct timeval const &tv)
+{
+  this->timeStamp = tv;
+  this->haveTimeStamp = true;
+}
+
+SatellitePassPredictor *
+UpcomingPassesDialog::getPredictor(void) const
+{
+  return this->predictor;
+}
+
+void
+UpcomingPassesDialog::refresh(void)
+{
+  struct timeval tv;
+
+  if (this->haveTimeStamp)
+    tv = this->timeStamp;
+  else
+    gettimeofday(&tv, nullptr);
+
+  this->predictor->setMinElevation(this->ui->elevationSpin->value());
+
+  if (this->predictor->start(tv, 3600. * this->ui->hoursSpin->value())) {
+    this->ui->progressBar->setValue(0);
+    this->ui->statusLabel->setText("Computing passes...");
+  } else {
+    this->ui->statusLabel->setText("No receiver location has been set");
+  }
+}
+
+////////////////////////////////// Slots ///////////////////////////////////////
+void
+UpcomingPassesDialog::onRefresh(void)
+{
+  this->refresh();
+}
+
+void
+UpcomingPassesDialog::onProgress(int done, int total)
+{
+  this->ui->progressBar->setMaximum(total);
+  this->ui->progressBar->setValue(done);
+}
+
+void
+UpcomingPassesDialog::onFinished(void)
+{
+  QVector<SatellitePass> passes = this->predictor->passes();
+
+  this->ui->progressBar->setValue(this->ui->progressBar->maximum());
+  this->model->setPasses(passes);
+  this->ui->passView->resizeColumnsToContents();
+
+  this->ui->statusLabel->setText(
+        QString::number(passes.size())
+        + " passes found. Double click on a pass to select its satellite.");
+}
+
+void
+UpcomingPassesDialog::onCellActivated(QModelIndex const &index)
+{
+  SatellitePass const *pass =
+      this->model->passAt(this->proxy->mapToSource(index).row());
+
+  if (pass != nullptr)
+    emit passSelected(pass->satellite);
+}
@@ -0,0 +1,315 @@
+//
+//    AudioChannelWidget.cpp: Secondary audio channel controls
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "AudioChannelWidget.h"
+#include "ui_AudioChannelWidget.h"
+#include "AudioProcessor.h"
+#include <UIMediator.h>
+#include <SuWidgetsHelpers.h>
+
+using namespace SigDigger;
+
+AudioChannelWidget::AudioChannelWidget(
+    UIMediator *mediator,
+    AudioProcessor *primary,
+    SUFREQ frequency,
+    SUFREQ bandwidth,
+    AudioDemod demod,
+    QWidget *parent) :
+  QFrame(parent),
+  m_ui(new Ui::AudioChannelWidget)
+{
+  m_ui->setupUi(this);
+
+  m_spectrum  = mediator->getMainSpectrum();
+  m_frequency = frequency;
+  m_bandwidth = bandwidth;
+  m_demod     = demod;
+  m_processor = new AudioProcessor(mediator, primary, this);
+
+  connectAll();
+  refreshUi();
+}
+
+AudioChannelWidget::~AudioChannelWidget()
+{
+  if (m_haveNamChan) {
+    m_spectrum->removeChannel(m_namChan);
+    m_spectrum->updateOverlay();
+  }
+
+  // Make sure the processor releases its mixer channel before we go
+  delete m_processor;
+  delete m_ui;
+}
+
+void
+AudioChannelWidget::connectAll()
+{
+  connect(
+        m_ui->volumeSlider,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onVolumeChanged()));
+
+  connect(
+        m_ui->panSlider,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onPanChanged()));
+
+  connect(
+        m_ui->muteButton,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onMuteToggled(bool)));
+
+  connect(
+        m_ui->recordButton,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onRecordToggled(bool)));
+
+  connect(
+        m_ui->removeButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onRemove()));
+
+  connect(
+        m_processor,
+        SIGNAL(audioOpened()),
+        this,
+        SLOT(onAudioOpened()));
+
+  connect(
+        m_processor,
+        SIGNAL(audioClosed()),
+        this,
+        SLOT(onAudioClosed()));
+
+  connect(
+        m_processor,
+        SIGNAL(recStopped()),
+        this,
+        SLOT(onRecStopped()));
+
+  connect(
+        m_processor,
+        SIGNAL(recSwamped()),
+        this,
+        SLOT(onRecStopped()));
+}
+
+void
+AudioChannelWidget::refreshUi()
+{
+  int pan = m_ui->panSlider->value();
+  bool opened = m_processor->isOpened();
+
+  m_ui->nameLabel->setText(
+        SuWidgetsHelpers::formatQuantity(m_frequency, 6, "Hz")
+        + " ("
+        + QString::fromStdString(SigDiggerHelpers::demodToStr(m_demod))
+        + ")");
+
+  m_ui->volumeLabel->setText(
+        QString::number(m_ui->volumeSlider->value()) + " dB");
+
+  if (pan == 0)
+    m_ui->panLabel->setText("C");
+  else if (pan < 0)
+    m_ui->panLabel->setText("L" + QString::number(-pan));
+  else
+    m_ui->panLabel->setText("R" + QString::number(pan));
+
+  m_ui->volumeSlider->setEnabled(!m_ui->muteButton->isChecked());
+  m_ui->volumeLabel->setEnabled(!m_ui->muteButton->isChecked());
+  m_ui->recordButton->setEnabled(opened);
+
+  refreshNamedChannel();
+}
+
+void
+AudioChannelWidget::refreshNamedChannel()
+{
+  bool shouldHaveNamChan = m_processor->isOpened();
+
+  if (shouldHaveNamChan != m_haveNamChan) {
+    m_haveNamChan = shouldHaveNamChan;
+
+    if (m_haveNamChan) {
+      auto chBw = static_cast<qint32>(m_processor->calcTrueBandwidth());
+
+      m_namChan = m_spectrum->addChannel(
+            "",
+            static_cast<qint64>(m_processor->getTrueChannelFreq()),
+            -chBw / 2,
+            +chBw / 2,
+            QColor("#2fbf2f"),
+            QColor(Qt::white),
+            QColor("#2fbf2f"));
+    } else {
+      m_spectrum->removeChannel(m_namChan);
+      m_spectrum->updateOverlay();
+    }
+  }
+
+  if (m_haveNamChan) {
+    qint32 chBw = static_cast<qint32>(m_processor->calcTrueBandwidth());
+
+    m_namChan.value()->frequency   =
+        static_cast<qint64>(m_processor->getTrueChannelFreq());
+    m_namChan.value()->lowFreqCut  = -chBw / 2;
+    m_namChan.value()->highFreqCut = +chBw / 2;
+    m_namChan.value()->name        =
+        m_ui->muteButton->isChecked()
+        ? "Audio channel (muted)"
+        : "Audio channel";
+
+    m_spectrum->refreshChannel(m_namChan);
+  }
+}
+
+AudioProcessor *
+AudioChannelWidget::processor() const
+{
+  return m_processor;
+}
+
+SUFREQ
+AudioChannelWidget::getFrequency() const
+{
+  return m_frequency;
+}
+
+SUFREQ
+AudioChannelWidget::getBandwidth() const
+{
+  return m_bandwidth;
+}
+
+AudioDemod
+AudioChannelWidget::getDemod() const
+{
+  return m_demod;
+}
+
+void
+AudioChannelWidget::setAnalyzer(Suscan::Analyzer *analyzer)
+{
+  m_processor->setAnalyzer(analyzer);
+  refreshUi();
+}
+
+void
+AudioChannelWidget::setTunerFreq(SUFREQ tuner)
+{
+  // The channel stays at the same absolute frequency
+  m_processor->setTunerFreq(tuner);
+  m_processor->setLoFreq(m_frequency - tuner);
+
+  refreshNamedChannel();
+}
+
+void
+AudioChannelWidget::setSavePath(QString const &path)
+{
+  m_savePath = path;
+
+  if (m_processor->isRecording()) {
+    m_processor->stopRecording();
+    m_ui->recordButton->setChecked(m_processor->startRecording(path));
+  }
+}
+
+////////////////////////////////// Slots ///////////////////////////////////////
+void
+AudioChannelWidget::onVolumeChanged()
+{
+  m_processor->setChannelVolume(m_ui->volumeSlider->value());
+  refreshUi();
+}
+
+void
+AudioChannelWidget::onPanChanged()
+{
+  m_processor->setChannelPan(m_ui->panSlider->value() * 1e-2f);
+  refreshUi();
+}
+
+void
+AudioChannelWidget::onMuteToggled(bool muted)
+{
+  m_ui->muteButton->setIcon(
+        QIcon(
+          muted
+          ? ":/icons/audio-volume-muted-panel.png"
+          : ":/icons/audio-volume-medium-panel.png"));
+
+  m_processor->setChannelMuted(muted);
+  refreshUi();
+}
+
+void
+AudioChannelWidget::onRecordToggled(bool recording)
+{
+  bool nowRec = false;
+
+  if (recording)
+    nowRec = m_processor->startRecording(m_savePath);
+  else
+    m_processor->stopRecording();
+
+  if (nowRec != recording) {
+    m_ui->recordButton->blockSignals(true);
+    m_ui->recordButton->setChecked(nowRec);
+    m_ui->recordButton->blockSignals(false);
+  }
+}
+
+void
+AudioChannelWidget::onRemove()
+{
+  emit removeRequested();
+}
+
+void
+AudioChannelWidget::onAudioOpened()
+{
+  refreshUi();
+}
+
+void
+AudioChannelWidget::onAudioClosed()
+{
+  m_ui->recordButton->blockSignals(true);
+  m_ui->recordButton->setChecked(false);
+  m_ui->recordButton->blockSignals(false);
+
+  refreshUi();
+}
+
+void
+AudioChannelWidget::onRecStopped()
+{
+  m_ui->recordButton->blockSignals(true);
+  m_ui->recordButton->setChecked(false);
+  m_ui->recordButton->blockSignals(false);
+}
@@ -0,0 +1,94 @@
+//
+//    AudioChannelWidget.h: Secondary audio channel controls
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef AUDIOCHANNELWIDGET_H
+#define AUDIOCHANNELWIDGET_H
+
+#include <QFrame>
+#include <MainSpectrum.h>
+#include <SigDiggerHelpers.h>
+
+namespace Ui {
+  class AudioChannelWidget;
+}
+
+namespace SigDigger {
+  class AudioProcessor;
+  class UIMediator;
+
+  //
+  // A secondary audio channel stays at a fixed frequency and is mixed
+  // with the main audio preview. It owns its own audio processor (and
+  // therefore its own audio inspector).
+  //
+  class AudioChannelWidget : public QFrame
+  {
+    Q_OBJECT
+
+    AudioProcessor *m_processor = nullptr; // Owned
+    MainSpectrum   *m_spectrum  = nullptr; // Borrowed
+    SUFREQ          m_frequency = 0;
+    SUFREQ          m_bandwidth = 0;
+    AudioDemod      m_demod     = AudioDemod::FM;
+    QString         m_savePath;
+
+    NamedChannelSetIterator m_namChan;
+    bool m_haveNamChan = false;
+
+    Ui::AudioChannelWidget *m_ui = nullptr;
+
+    void connectAll();
+    void refreshUi();
+    void refreshNamedChannel();
+
+  public:
+    AudioChannelWidget(
+        UIMediator *mediator,
+        AudioProcessor *primary,
+        SUFREQ frequency,
+        SUFREQ bandwidth,
+        AudioDemod demod,
+        QWidget *parent = nullptr);
+    ~AudioChannelWidget() override;
+
+    AudioProcessor *processor() const;
+    SUFREQ getFrequency() const;
+    SUFREQ getBandwidth() const;
+    AudioDemod getDemod() const;
+
+    void setAnalyzer(Suscan::Analyzer *);
+    void setTunerFreq(SUFREQ);
+    void setSavePath(QString const &);
+
+  signals:
+    void removeRequested();
+
+  public slots:
+    void onVolumeChanged();
+    void onPanChanged();
+    void onMuteToggled(bool);
+    void onRecordToggled(bool);
+    void onRemove();
+
+    void onAudioOpened();
+    void onAudioClosed();
+    void onRecStopped();
+  };
+}
+
+#endif // AUDIOCHANNELWIDGET_H
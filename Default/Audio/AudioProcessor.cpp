@@ -32,14 +32,20 @@ AudioProcessor::assertAudioDevice()
 {
   std::string devStr = m_mediator->getAppConfig()->audioConfig.devStr;
 
+  // Secondary processors share the playback of the primary one
+  if (m_primary != nullptr)
+    return;
+
   if (m_playBack == nullptr || devStr != m_audioDevice) {
-    if (m_playBack != nullptr)
+    if (m_playBack != nullptr) {
+      emit playbackReset();
       delete m_playBack;
+    }
 
     try {
       m_audioDevice = devStr;
       m_playBack = new AudioPlayback(m_audioDevice, m_sampleRate);
-
+      emit playbackChanged();
     } catch (std::runtime_error &e) {
       m_audioError = e.what();
       m_playBack = nullptr;
@@ -47,6 +53,51 @@ AudioProcessor::assertAudioDevice()
   }
 }
 
+AudioPlayback *
+AudioProcessor::playBack() const
+{
+  return m_primary != nullptr ? m_primary->m_playBack : m_playBack;
+}
+
+bool
+AudioProcessor::acquireChannel()
+{
+  AudioPlayback *playBack = this->playBack();
+
+  if (m_channel == -1 && playBack != nullptr) {
+    m_channel = playBack->openChannel();
+    if (m_channel != -1) {
+      this->applyChannelGain();
+      playBack->setChannelDSPConfig(m_channel, m_dspConfig);
+    }
+  }
+
+  return m_channel != -1;
+}
+
+void
+AudioProcessor::releaseChannel()
+{
+  AudioPlayback *playBack = this->playBack();
+
+  if (m_channel != -1 && playBack != nullptr)
+    playBack->closeChannel(m_channel);
+
+  m_channel = -1;
+}
+
+void
+AudioProcessor::applyChannelGain()
+{
+  AudioPlayback *playBack = this->playBack();
+
+  if (m_channel != -1 && playBack != nullptr) {
+    playBack->setChannelVolume(m_channel, m_channelVolume);
+    playBack->setChannelPan(m_channel, m_channelPan);
+    playBack->setChannelMuted(m_channel, m_channelMuted);
+  }
+}
+
 AudioProcessor::AudioProcessor(UIMediator *mediator, QObject *parent)
   : QObject(parent)
 {
@@ -60,15 +111,53 @@ AudioProcessor::AudioProcessor(UIMediator *mediator, QObject *parent)
   m_squelchLevel = 1e-2;
 }
 
+AudioProcessor::AudioProcessor(
+    UIMediator *mediator,
+    AudioProcessor *primary,
+    QObject *parent)
+  : QObject(parent)
+{
+  m_mediator = mediator;
+  m_primary  = primary;
+
+  m_tracker = new Suscan::AnalyzerRequestTracker(this);
+  this->connectAll();
+
+  connect(
+        m_primary,
+        SIGNAL(playbackReset()),
+        this,
+        SLOT(onPlaybackReset()));
+
+  connect(
+        m_primary,
+        SIGNAL(playbackChanged()),
+        this,
+        SLOT(onPlaybackChanged()));
+
+  m_squelchLevel = 1e-2;
+}
+
 AudioProcessor::~AudioProcessor()
 {
   if (m_audioCfgTemplate != nullptr)
     suscan_config_destroy(m_audioCfgTemplate);
 
-  if (m_playBack != nullptr)
+  if (m_primary != nullptr) {
+    // Secondary channels come and go while the analyzer is running
+    if (m_analyzer != nullptr)
+      this->closeAudio();
+    this->releaseChannel();
+  } else if (m_playBack != nullptr)
     delete m_playBack;
 }
 
+bool
+AudioProcessor::isSecondary() const
+{
+  return m_primary != nullptr;
+}
+
 void
 AudioProcessor::connectAll()
 {
@@ -111,7 +200,9 @@ AudioProcessor::openAudio()
   if (!m_opened) {
     assertAudioDevice();
 
-    if (m_playBack != nullptr) {
+    AudioPlayback *playBack = this->playBack();
+
+    if (playBack != nullptr) {
       Suscan::Channel ch;
       unsigned int reqRate = m_requestedRate;
 
@@ -124,17 +215,26 @@ AudioProcessor::openAudio()
       if (reqRate > m_maxAudioBw)
         reqRate = SCAST(unsigned int, floor(m_maxAudioBw));
 
-      // Configure sample rate
-      m_playBack->setVolume(m_volume);
-      m_playBack->setSampleRate(reqRate);
-      m_playBack->start();
+      // Configure sample rate. Secondary processors follow the rate
+      // of the playback, which is dictated by the primary.
+      if (m_primary == nullptr) {
+        playBack->setVolume(m_volume);
+        playBack->setSampleRate(reqRate);
+      }
+
+      if (!this->acquireChannel()) {
+        emit audioError("Too many audio channels open");
+        m_opening = false;
+        m_mediator->setUIBusy(false);
+        return false;
+      }
 
-      m_sampleRate = m_playBack->getSampleRate();
+      m_sampleRate = playBack->getSampleRate();
 
       if (m_sampleRate < 1) {
         emit audioError("Audio device does not support the current sample rate");
         m_opening = false;
-        m_playBack->stop();
+        this->releaseChannel();
         m_mediator->setUIBusy(false);
         return false;
       }
@@ -154,7 +254,7 @@ AudioProcessor::openAudio()
 
       if (!opening) {
         emit audioError("Internal Suscan error while opening audio inspector");
-        m_playBack->stop();
+        this->releaseChannel();
       }
     } else {
       emit audioError("Cannot enable audio, playback support failed to start");
@@ -183,7 +283,7 @@ AudioProcessor::closeAudio()
     if (!m_opened)
       m_tracker->cancelAll();
 
-    m_playBack->stop();
+    this->releaseChannel();
   }
 
   // Just in case
@@ -396,11 +496,54 @@ AudioProcessor::setVolume(float volume)
   if (!sufeq(m_volume, volume, 1e-1f)) {
     m_volume = volume;
 
-    if (m_playBack != nullptr)
+    if (m_primary == nullptr && m_playBack != nullptr)
       m_playBack->setVolume(volume);
   }
 }
 
+void
+AudioProcessor::setChannelVolume(float volume)
+{
+  m_channelVolume = volume;
+  this->applyChannelGain();
+}
+
+void
+AudioProcessor::setChannelPan(float pan)
+{
+  m_channelPan = pan;
+  this->applyChannelGain();
+}
+
+void
+AudioProcessor::setChannelMuted(bool muted)
+{
+  m_channelMuted = muted;
+  this->applyChannelGain();
+}
+
+void
+AudioProcessor::setDSPConfig(AudioDSPConfig const &config)
+{
+  AudioPlayback *playBack = this->playBack();
+
+  m_dspConfig = config;
+
+  if (m_channel != -1 && playBack != nullptr)
+    playBack->setChannelDSPConfig(m_channel, m_dspConfig);
+}
+
+void
+AudioProcessor::getDSPStats(std::vector<AudioDSPStageStats> &stats) const
+{
+  AudioPlayback *playBack = this->playBack();
+
+  if (m_channel != -1 && playBack != nullptr)
+    playBack->getChannelDSPStats(m_channel, stats);
+  else
+    stats.clear();
+}
+
 void
 AudioProcessor::setAudioCorrection(Suscan::Orbit const &orbit)
 {
@@ -459,7 +602,7 @@ AudioProcessor::setSampleRate(unsigned rate)
       m_analyzer->setInspectorWatermark(
             m_audioInspHandle,
             PlaybackWorker::calcBufferSizeForRate(m_sampleRate) / 2);
-    } else {
+    } else if (m_primary == nullptr && m_playBack != nullptr) {
       m_playBack->setSampleRate(rate);
     }
 
@@ -470,6 +613,32 @@ AudioProcessor::setSampleRate(unsigned rate)
   }
 }
 
+void
+AudioProcessor::setRecordFormat(AudioFileSaver::AudioFileFormat format)
+{
+  if (m_recFormat != format) {
+    m_recFormat = format;
+
+    if (m_audioFileSaver != nullptr) {
+      this->stopRecording();
+      this->startRecording(m_savedPath);
+    }
+  }
+}
+
+void
+AudioProcessor::setRecordIQ(bool iq)
+{
+  if (m_recIQ != iq) {
+    m_recIQ = iq;
+
+    if (m_audioFileSaver != nullptr) {
+      this->stopRecording();
+      this->startRecording(m_savedPath);
+    }
+  }
+}
+
 void
 AudioProcessor::setCutOff(float cutOff)
 {
@@ -546,7 +715,7 @@ AudioProcessor::getChannelBandwidth() const
 bool
 AudioProcessor::isAudioAvailable() const
 {
-  return m_playBack != nullptr;
+  return this->playBack() != nullptr;
 }
 
 QString
@@ -573,6 +742,12 @@ AudioProcessor::getSaveSize() const
   return m_audioFileSaver == nullptr ? 0 : m_audioFileSaver->getSize();
 }
 
+quint64
+AudioProcessor::getSaveFileSize() const
+{
+  return m_audioFileSaver == nullptr ? 0 : m_audioFileSaver->getFileSize();
+}
+
 bool
 AudioProcessor::startRecording(QString path)
 {
@@ -586,6 +761,8 @@ AudioProcessor::startRecording(QString path)
     params.savePath   = path.toStdString();
     params.frequency  = m_tuner + m_lo;
     params.modulation = m_demod;
+    params.format     = m_recFormat;
+    params.iq         = m_recIQ;
 
     m_audioFileSaver = new AudioFileSaver(params, nullptr);
     this->connectAudioFileSaver();
@@ -631,7 +808,8 @@ AudioProcessor::onInspectorMessage(Suscan::InspectorMessage const &msg)
           if (value != nullptr) {
             if (m_sampleRate == value->as_int) {
               m_settingRate = false;
-              m_playBack->setSampleRate(m_sampleRate);
+              if (m_primary == nullptr)
+                m_playBack->setSampleRate(m_sampleRate);
             }
           } else {
             // This should never happen, but just in case the server is not
@@ -674,7 +852,7 @@ AudioProcessor::onInspectorSamples(Suscan::SamplesMessage const &msg)
     const SUCOMPLEX *samples = msg.getSamples();
     unsigned int count = msg.getCount();
 
-    m_playBack->write(samples, count);
+    this->playBack()->write(m_channel, samples, count);
 
     if (m_audioFileSaver != nullptr)
       m_audioFileSaver->write(samples, count);
@@ -734,7 +912,7 @@ AudioProcessor::onCancelled(Suscan::AnalyzerRequest const &)
 
   m_opening = false;
   m_settingRate = false;
-  m_playBack->stop();
+  this->releaseChannel();
 }
 
 void
@@ -744,8 +922,33 @@ AudioProcessor::onError(Suscan::AnalyzerRequest const &, std::string const &err)
 
   m_opening = false;
   m_settingRate = false;
-  m_playBack->stop();
+  this->releaseChannel();
 
   emit audioError(
         "Failed to open audio channel: " + QString::fromStdString(err));
 }
+
+/////////////////////////// Primary playback slots /////////////////////////////
+void
+AudioProcessor::onPlaybackReset()
+{
+  // The primary is about to delete the playback we are mixed into
+  if (m_analyzer != nullptr && (m_opened || m_opening)) {
+    this->closeAudio();
+    m_reopenPending = true;
+    emit audioClosed();
+  }
+
+  m_channel = -1;
+}
+
+void
+AudioProcessor::onPlaybackChanged()
+{
+  if (m_reopenPending) {
+    m_reopenPending = false;
+
+    if (m_enabled && m_analyzer != nullptr)
+      this->openAudio();
+  }
+}
@@ -23,6 +23,7 @@
 #include <Suscan/Library.h>
 #include <Suscan/Analyzer.h>
 #include <AudioFileSaver.h>
+#include <AudioDSPChain.h>
 
 namespace Suscan {
   class Analyzer;
@@ -54,10 +55,22 @@ namespace SigDigger {
     SUFLOAT         m_squelchLevel;
     SUFREQ          m_bw = 2e5; // Hz
 
+    // Mixer channel state
+    AudioProcessor *m_primary = nullptr; // Borrowed, owns the playback
+    int             m_channel = -1;
+    float           m_channelVolume = 0; // dB
+    float           m_channelPan = 0;
+    bool            m_channelMuted = false;
+    bool            m_reopenPending = false;
+    AudioDSPConfig  m_dspConfig;
+
     // Composed objects
     AudioFileSaver *m_audioFileSaver = nullptr;
     QString         m_savedPath;
-    AudioPlayback  *m_playBack = nullptr;
+    AudioFileSaver::AudioFileFormat m_recFormat =
+        AudioFileSaver::AUDIO_FILE_FORMAT_WAV_PCM16;
+    bool            m_recIQ = false;
+    AudioPlayback  *m_playBack = nullptr; // Only owned by the primary
     Suscan::AnalyzerRequestTracker *m_tracker = nullptr;
     QString         m_audioError;
     std::string     m_audioDevice;
@@ -88,11 +101,20 @@ namespace SigDigger {
     void setTrueLoFreq();
     void setTrueBandwidth();
     void assertAudioDevice();
+    AudioPlayback *playBack() const;
+    bool acquireChannel();
+    void releaseChannel();
+    void applyChannelGain();
 
   public:
     explicit AudioProcessor(UIMediator *, QObject *parent = nullptr);
+
+    // Secondary processor, mixed in the playback of the primary one
+    AudioProcessor(UIMediator *, AudioProcessor *primary, QObject *parent);
     virtual ~AudioProcessor() override;
 
+    bool isSecondary() const;
+
     SUFREQ calcTrueLoFreq() const;
     SUFREQ calcTrueBandwidth() const;
 
@@ -109,6 +131,12 @@ namespace SigDigger {
     void setTunerFreq(SUFREQ);
     void setLoFreq(SUFREQ);
     void setBandwidth(SUFREQ);
+    void setChannelVolume(float);
+    void setChannelPan(float);
+    void setChannelMuted(bool);
+    void setRecordFormat(AudioFileSaver::AudioFileFormat);
+    void setRecordIQ(bool);
+    void setDSPConfig(AudioDSPConfig const &);
 
     SUFREQ getTrueChannelFreq() const;
     SUFREQ getChannelFreq() const;
@@ -119,6 +147,8 @@ namespace SigDigger {
     bool isRecording() const;
     bool isOpened() const;
     size_t getSaveSize() const;
+    quint64 getSaveFileSize() const;
+    void getDSPStats(std::vector<AudioDSPStageStats> &) const;
 
   signals:
     void audioClosed();
@@ -133,6 +163,10 @@ namespace SigDigger {
     void orbitReport(Suscan::InspectorMessage const &);
     void setTLE(Suscan::InspectorMessage const &);
 
+    // Playback replacement notifications (primary only)
+    void playbackReset();
+    void playbackChanged();
+
   public slots:
     // These two are slots to trigger the recording stop on signal
     bool startRecording(QString);
@@ -143,6 +177,9 @@ namespace SigDigger {
     void onOpened(Suscan::AnalyzerRequest const &);
     void onCancelled(Suscan::AnalyzerRequest const &);
     void onError(Suscan::AnalyzerRequest const &, std::string const &);
+
+    void onPlaybackReset();
+    void onPlaybackChanged();
   };
 }
 
@@ -28,8 +28,11 @@
 #include <AddBookmarkDialog.h>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QTimer>
 #include <UIMediator.h>
 #include "AudioProcessor.h"
+#include "AudioChannelWidget.h"
+#include <AudioPlayback.h>
 #include <SuWidgetsHelpers.h>
 #include <MainSpectrum.h>
 
@@ -75,6 +78,13 @@ AudioWidgetConfig::deserialize(Suscan::Object const &conf)
   LOAD(cutOff);
   LOAD(volume);
   LOAD(savePath);
+  LOAD(recordFormat);
+  LOAD(recordIQ);
+  LOAD(deemphasis);
+  LOAD(noiseReduction);
+  LOAD(agc);
+  LOAD(notch);
+  LOAD(notchFreq);
   LOAD(squelch);
   LOAD(amSquelch);
   LOAD(ssbSquelch);
@@ -99,6 +109,13 @@ AudioWidgetConfig::serialize()
   STORE(cutOff);
   STORE(volume);
   STORE(savePath);
+  STORE(recordFormat);
+  STORE(recordIQ);
+  STORE(deemphasis);
+  STORE(noiseReduction);
+  STORE(agc);
+  STORE(notch);
+  STORE(notchFreq);
   STORE(squelch);
   STORE(amSquelch);
   STORE(ssbSquelch);
@@ -126,6 +143,9 @@ AudioWidget::AudioWidget(
 
   setRecordSavePath(QDir::currentPath().toStdString());
 
+  m_dspStatsTimer = new QTimer(this);
+  m_dspStatsTimer->setInterval(500);
+
   m_fcDialog = new FrequencyCorrectionDialog(
       this,
       m_demodFreq,
@@ -140,6 +160,10 @@ AudioWidget::AudioWidget(
 
 AudioWidget::~AudioWidget()
 {
+  // Secondary channels borrow the playback of the main processor
+  qDeleteAll(m_channels);
+  m_channels.clear();
+
   delete m_ui;
 }
 
@@ -217,6 +241,54 @@ AudioWidget::connectAll()
         this,
         SLOT(onRecordStartStop()));
 
+  connect(
+        m_ui->recordFormatCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onRecordFormatChanged()));
+
+  connect(
+        m_ui->recordIQCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onRecordFormatChanged()));
+
+  connect(
+        m_ui->deemphCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onDSPChanged()));
+
+  connect(
+        m_ui->nrCheck,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onDSPChanged()));
+
+  connect(
+        m_ui->agcCheck,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onDSPChanged()));
+
+  connect(
+        m_ui->notchCheck,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onDSPChanged()));
+
+  connect(
+        m_ui->notchFreqSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onDSPChanged()));
+
+  connect(
+        m_dspStatsTimer,
+        SIGNAL(timeout()),
+        this,
+        SLOT(onDSPStatsTimeout()));
+
   connect(
         m_ui->sqlButton,
         SIGNAL(clicked(bool)),
@@ -235,6 +307,12 @@ AudioWidget::connectAll()
         this,
         SLOT(onOpenDopplerSettings()));
 
+  connect(
+        m_ui->addChannelButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onAddChannel()));
+
   connect(
         m_fcDialog,
         SIGNAL(accepted()),
@@ -338,6 +416,10 @@ AudioWidget::refreshUi()
   m_ui->sampleRateCombo->setEnabled(openAudio);
   m_ui->cutoffSlider->setEnabled(openAudio);
   m_ui->recordStartStopButton->setEnabled(openAudio);
+  m_ui->addChannelButton->setEnabled(
+        openAudio
+        && m_analyzer != nullptr
+        && m_channels.size() < SIGDIGGER_AUDIO_MAX_CHANNELS - 1);
 
   m_ui->sqlButton->setEnabled(openAudio);
   m_ui->sqlLevelSpin->setEnabled(
@@ -553,6 +635,9 @@ AudioWidget::setSampleRate(unsigned int rate)
     m_ui->cutoffSlider->setMaximum(rate / 2);
 
     m_processor->setSampleRate(rate);
+    for (auto ch : m_channels)
+      ch->processor()->setSampleRate(rate);
+
     refreshNamedChannel();
   }
 }
@@ -678,6 +763,26 @@ AudioWidget::refreshNamedChannel()
   }
 }
 
+void
+AudioWidget::applyDSPConfig()
+{
+  AudioDSPConfig config;
+
+  config.deemphasis     = m_panelConfig->deemphasis != 0;
+  config.deemphTau      = m_panelConfig->deemphasis == 2 ? 75e-6f : 50e-6f;
+  config.noiseReduction = m_panelConfig->noiseReduction;
+  config.agc            = m_panelConfig->agc;
+  config.notch          = m_panelConfig->notch;
+  config.notchFreq      = m_panelConfig->notchFreq;
+
+  m_ui->notchFreqSpin->setEnabled(m_panelConfig->notch);
+
+  m_processor->setDSPConfig(config);
+
+  for (auto ch : m_channels)
+    ch->processor()->setDSPConfig(config);
+}
+
 void
 AudioWidget::applySpectrumState()
 {
@@ -785,6 +890,27 @@ AudioWidget::applyConfig()
   if (m_panelConfig->savePath.size() > 0)
     setRecordSavePath(m_panelConfig->savePath);
 
+  if (m_panelConfig->recordFormat
+      < static_cast<unsigned>(m_ui->recordFormatCombo->count()))
+    m_ui->recordFormatCombo->setCurrentIndex(
+        static_cast<int>(m_panelConfig->recordFormat));
+  m_ui->recordIQCheck->setChecked(m_panelConfig->recordIQ);
+  m_processor->setRecordFormat(
+        static_cast<AudioFileSaver::AudioFileFormat>(
+          m_ui->recordFormatCombo->currentIndex()));
+  m_processor->setRecordIQ(m_panelConfig->recordIQ);
+
+  // Client-side processing
+  if (m_panelConfig->deemphasis
+      < static_cast<unsigned>(m_ui->deemphCombo->count()))
+    m_ui->deemphCombo->setCurrentIndex(
+        static_cast<int>(m_panelConfig->deemphasis));
+  m_ui->nrCheck->setChecked(m_panelConfig->noiseReduction);
+  m_ui->agcCheck->setChecked(m_panelConfig->agc);
+  m_ui->notchCheck->setChecked(m_panelConfig->notch);
+  m_ui->notchFreqSpin->setValue(static_cast<int>(m_panelConfig->notchFreq));
+  applyDSPConfig();
+
   // Update processor parameters
   applySpectrumState();
 }
@@ -824,8 +950,11 @@ AudioWidget::setState(int state, Suscan::Analyzer *analyzer)
   if (state != m_state)
     m_state = state;
 
-  if (analyzer == nullptr)
+  if (analyzer == nullptr) {
     m_processor->setAnalyzer(analyzer);
+    for (auto ch : m_channels)
+      ch->setAnalyzer(analyzer);
+  }
 
   applySpectrumState();
 }
@@ -892,6 +1021,8 @@ AudioWidget::setProfile(Suscan::Source::Config &profile)
   m_fcDialog->setTimeLimits(start, end);
 
   m_processor->setTunerFreq(profile.getFreq());
+  for (auto ch : m_channels)
+    ch->setTunerFreq(profile.getFreq());
 
   refreshNamedChannel();
 }
@@ -914,6 +1045,9 @@ AudioWidget::onSpectrumLoChanged(qint64)
 void
 AudioWidget::onSpectrumFrequencyChanged(qint64)
 {
+  for (auto ch : m_channels)
+    ch->setTunerFreq(SCAST(SUFREQ, m_spectrum->getCenterFreq()));
+
   if (!m_panelConfig->lockToFreq)
     applySpectrumState();
 }
@@ -990,6 +1124,9 @@ AudioWidget::onChangeSavePath()
     m_panelConfig->savePath = path.toStdString();
     refreshDiskUsage();
 
+    for (auto ch : m_channels)
+      ch->setSavePath(path);
+
     if (m_ui->recordStartStopButton->isChecked()) {
       bool recording;
       m_processor->stopRecording();
@@ -1018,6 +1155,70 @@ AudioWidget::onRecordStartStop()
   refreshUi();
 }
 
+void
+AudioWidget::onRecordFormatChanged()
+{
+  auto format = static_cast<AudioFileSaver::AudioFileFormat>(
+        m_ui->recordFormatCombo->currentIndex());
+  bool iq = m_ui->recordIQCheck->isChecked();
+
+  m_panelConfig->recordFormat = static_cast<unsigned>(format);
+  m_panelConfig->recordIQ     = iq;
+
+  // Active recordings are restarted in a new file
+  m_processor->setRecordFormat(format);
+  m_processor->setRecordIQ(iq);
+
+  for (auto ch : m_channels) {
+    ch->processor()->setRecordFormat(format);
+    ch->processor()->setRecordIQ(iq);
+  }
+}
+
+void
+AudioWidget::onDSPChanged()
+{
+  m_panelConfig->deemphasis =
+      static_cast<unsigned>(m_ui->deemphCombo->currentIndex());
+  m_panelConfig->noiseReduction = m_ui->nrCheck->isChecked();
+  m_panelConfig->agc            = m_ui->agcCheck->isChecked();
+  m_panelConfig->notch          = m_ui->notchCheck->isChecked();
+  m_panelConfig->notchFreq      =
+      static_cast<SUFLOAT>(m_ui->notchFreqSpin->value());
+
+  applyDSPConfig();
+}
+
+void
+AudioWidget::onDSPStatsTimeout()
+{
+  std::vector<AudioDSPStageStats> stats;
+  QStringList entries;
+  float latency = 0;
+
+  m_processor->getDSPStats(stats);
+
+  for (auto const &stage : stats) {
+    if (stage.enabled) {
+      latency += stage.latency;
+      entries.push_back(
+            QString::asprintf(
+              "%s %.1f%%",
+              stage.name,
+              static_cast<double>(100 * stage.cpuLoad)));
+    }
+  }
+
+  if (entries.isEmpty())
+    m_ui->dspStatsLabel->setText("Idle");
+  else
+    m_ui->dspStatsLabel->setText(
+          entries.join(", ")
+          + QString::asprintf(
+            " (+%.1f ms)",
+            static_cast<double>(latency)));
+}
+
 void
 AudioWidget::onToggleSquelch()
 {
@@ -1107,12 +1308,15 @@ void
 AudioWidget::onAudioOpened()
 {
   refreshNamedChannel();
+  m_dspStatsTimer->start();
 }
 
 void
 AudioWidget::onAudioClosed()
 {
   refreshNamedChannel();
+  m_dspStatsTimer->stop();
+  m_ui->dspStatsLabel->setText("Idle");
 }
 
 void
@@ -1148,7 +1352,7 @@ AudioWidget::onAudioSaveRate(qreal)
 void
 AudioWidget::onAudioCommit()
 {
-  auto len = m_processor->getSaveSize() * sizeof(uint16_t) / sizeof(SUCOMPLEX);
+  auto len = m_processor->getSaveFileSize();
   m_ui->captureSizeLabel->setText(formatCaptureSize(len));
 }
 
@@ -1163,6 +1367,8 @@ AudioWidget::onSourceInfoMessage(Suscan::SourceInfoMessage const &msg)
       // We do not update processor parameters until source info is available
       applySpectrumState();
       m_processor->setAnalyzer(m_analyzer);
+      for (auto ch : m_channels)
+        ch->setAnalyzer(m_analyzer);
     }
 
     m_haveSourceInfo = true;
@@ -1176,5 +1382,66 @@ AudioWidget::onLockToFreqChanged()
   setLockToFreq(getLockToFreq());
 }
 
+void
+AudioWidget::onAddChannel()
+{
+  AudioChannelWidget *ch;
+  AudioProcessor *proc;
+
+  if (m_channels.size() >= SIGDIGGER_AUDIO_MAX_CHANNELS - 1)
+    return;
+
+  // The new channel starts as a copy of the current one
+  ch = new AudioChannelWidget(
+        m_mediator,
+        m_processor,
+        m_processor->getChannelFreq(),
+        m_processor->getChannelBandwidth(),
+        getDemod(),
+        this);
+
+  proc = ch->processor();
+  proc->setSampleRate(getSampleRate());
+  proc->setCutOff(getCutOff());
+  proc->setDemod(getDemod());
+  proc->setBandwidth(m_processor->getChannelBandwidth());
+  proc->setSquelchLevel(getSquelchLevel());
+  proc->setSquelchEnabled(getSquelchEnabled());
+  proc->setEnabled(true);
+
+  ch->setTunerFreq(SCAST(SUFREQ, m_spectrum->getCenterFreq()));
+  ch->setSavePath(QString::fromStdString(getRecordSavePath()));
+  proc->setRecordFormat(
+        static_cast<AudioFileSaver::AudioFileFormat>(
+          m_ui->recordFormatCombo->currentIndex()));
+  proc->setRecordIQ(m_ui->recordIQCheck->isChecked());
+
+  connect(
+        ch,
+        SIGNAL(removeRequested()),
+        this,
+        SLOT(onRemoveChannel()));
+
+  m_ui->channelsLayout->addWidget(ch);
+  m_channels.push_back(ch);
+  applyDSPConfig();
+
+  ch->setAnalyzer(m_analyzer);
+
+  refreshUi();
+}
+
+void
+AudioWidget::onRemoveChannel()
+{
+  AudioChannelWidget *ch = qobject_cast<AudioChannelWidget *>(sender());
+
+  if (ch != nullptr && m_channels.removeOne(ch)) {
+    m_ui->channelsLayout->removeWidget(ch);
+    ch->deleteLater();
+    refreshUi();
+  }
+}
+
 
 ////////////////// TODO: implement onJumpToBookmark ////////////////////////////
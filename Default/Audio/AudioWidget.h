@@ -27,8 +27,11 @@ namespace Ui {
   class AudioPanel;
 }
 
+class QTimer;
+
 namespace SigDigger {
   class AudioProcessor;
+  class AudioChannelWidget;
   class AudioWidgetFactory;
   class FrequencyCorrectionDialog;
   class MainSpectrum;
@@ -41,6 +44,13 @@ namespace SigDigger {
 
     std::string demod;
     std::string savePath;
+    unsigned int recordFormat = 0;
+    bool recordIQ       = false;
+    unsigned int deemphasis = 0;
+    bool noiseReduction = false;
+    bool agc            = false;
+    bool notch          = false;
+    SUFLOAT notchFreq   = 1000;
     unsigned int rate   = 44100;
     SUFLOAT cutOff      = 15000;
     SUFLOAT volume      = -6;
@@ -73,6 +83,7 @@ namespace SigDigger {
 
     // Processing members
     AudioProcessor *m_processor  = nullptr;
+    QList<AudioChannelWidget *> m_channels;
     Suscan::Analyzer *m_analyzer = nullptr; // Borrowed
     bool m_haveSourceInfo = false;
     bool m_audioAllowed = true;
@@ -86,6 +97,7 @@ namespace SigDigger {
     NamedChannelSetIterator m_namChan;
     bool m_haveNamChan = false;
     qreal m_lastCorrection = 0;
+    QTimer *m_dspStatsTimer = nullptr;
 
     // Private methods
     void connectAll();
@@ -93,6 +105,7 @@ namespace SigDigger {
     void refreshUi();
     void refreshNamedChannel();
     void applySpectrumState();
+    void applyDSPConfig();
 
     // Private setters
     void setBandwidth(SUFLOAT);
@@ -165,10 +178,15 @@ namespace SigDigger {
     void onAcceptCorrectionSetting();
     void onChangeSavePath();
     void onRecordStartStop();
+    void onRecordFormatChanged();
+    void onDSPChanged();
+    void onDSPStatsTimeout();
     void onToggleSquelch();
     void onSquelchLevelChanged();
     void onOpenDopplerSettings();
     void onLockToFreqChanged();
+    void onAddChannel();
+    void onRemoveChannel();
 
     // Notifications
     void onSetTLE(Suscan::InspectorMessage const &);
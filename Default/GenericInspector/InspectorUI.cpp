@@ -679,12 +679,22 @@ bool
 InspectorUI::installNetForwarder(void)
 {
   if (this->socketForwarder == nullptr) {
-    this->socketForwarder = new SocketForwarder(
-          this->netForwarderUI->getHost(),
-          this->netForwarderUI->getPort(),
-          this->netForwarderUI->getFrameLen(),
-          this->netForwarderUI->getTcp(),
-          this);
+    if (this->netForwarderUI->isServer()) {
+      this->streamServer = new SocketStreamServer(
+            this->netForwarderUI->getHost(),
+            this->netForwarderUI->getPort(),
+            this->netForwarderUI->isLocalServer(),
+            this);
+      this->socketForwarder = this->streamServer;
+    } else {
+      this->socketForwarder = new SocketForwarder(
+            this->netForwarderUI->getHost(),
+            this->netForwarderUI->getPort(),
+            this->netForwarderUI->getFrameLen(),
+            this->netForwarderUI->getTcp(),
+            this->netForwarderUI->getSeqHeader(),
+            this);
+    }
     this->recordingRate = this->getBaudRate();
     this->socketForwarder->setSampleRate(recordingRate);
     connectNetForwarder();
@@ -701,6 +711,7 @@ InspectorUI::uninstallNetForwarder(void)
   if (this->socketForwarder)
     this->socketForwarder->deleteLater();
   this->socketForwarder = nullptr;
+  this->streamServer = nullptr;
 }
 
 void
@@ -785,6 +796,7 @@ InspectorUI::onToggleSNR(void)
     this->estimator.setSigma(1.f);
     this->estimator.setAlpha(1.f / (this->decider.getIntervals()));
     gettimeofday(&this->last_estimator_update, nullptr);
+    timerclear(&this->last_estimator_iteration);
   } else {
     std::vector<float> empty;
     this->ui->histogram->setSNRModel(empty);
@@ -813,14 +825,24 @@ InspectorUI::feed(const SUCOMPLEX *data, unsigned int size)
   this->ui->constellation->feed(data, size);
   this->ui->histogram->feed(data, size);
 
+  // The histogram is cumulative, so the estimator does not need to see
+  // every feed. Step it at a fixed rate regardless of the feed rate.
   if (this->estimating) {
     struct timeval tv, res;
-    this->estimator.feed(this->ui->histogram->getHistory());
     gettimeofday(&tv, nullptr);
 
-    timersub(&this->last_estimator_update, &tv, &res);
+    timersub(&tv, &this->last_estimator_iteration, &res);
+
+    if (res.tv_sec > 0
+        || res.tv_usec > SIGDIGGER_INSPECTOR_UI_SNR_ITERATION_INTERVAL_US) {
+      this->estimator.feed(this->ui->histogram->getHistory());
+      this->last_estimator_iteration = tv;
+    }
+
+    timersub(&tv, &this->last_estimator_update, &res);
 
-    if (res.tv_sec > 0 || res.tv_usec > 100000) {
+    if (res.tv_sec > 0
+        || res.tv_usec > SIGDIGGER_INSPECTOR_UI_SNR_UPDATE_INTERVAL_US) {
       this->ui->histogram->setSNRModel(this->estimator.getModel());
       this->ui->snrLabel->setText(
             QString::number(
@@ -1633,7 +1655,13 @@ InspectorUI::onNetRate(qreal rate)
 void
 InspectorUI::onNetCommit(void)
 {
-  this->netForwarderUI->setCaptureSize(this->socketForwarder->getSize());
+  if (this->streamServer != nullptr)
+    this->netForwarderUI->setServerStats(
+          this->socketForwarder->getSize(),
+          this->streamServer->getSubscriberCount(),
+          this->streamServer->getDroppedBytes());
+  else
+    this->netForwarderUI->setCaptureSize(this->socketForwarder->getSize());
 }
 
 void
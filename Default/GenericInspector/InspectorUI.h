@@ -34,6 +34,7 @@
 #include <SNREstimator.h>
 #include <sys/time.h>
 #include <SocketForwarder.h>
+#include <SocketStreamServer.h>
 #include <AbstractWaterfall.h>
 
 #include "ThrottleableWidget.h"
@@ -59,6 +60,9 @@ namespace Ui {
 #define SIGDIGGER_INSPECTOR_UI_SOFT_BITS_Q    3
 #define SIGDIGGER_INSPECTOR_UI_SYMBOLS        4
 
+#define SIGDIGGER_INSPECTOR_UI_SNR_ITERATION_INTERVAL_US 25000
+#define SIGDIGGER_INSPECTOR_UI_SNR_UPDATE_INTERVAL_US    100000
+
 namespace SigDigger {
   class FrequencyCorrectionDialog;
   class AppConfig;
@@ -108,6 +112,7 @@ namespace SigDigger {
 
     bool estimating = false;
     struct timeval last_estimator_update;
+    struct timeval last_estimator_iteration;
     std::vector<SUFLOAT>  floatBuffer;
     std::vector<SUFLOAT>  fftData;
 
@@ -131,7 +136,8 @@ namespace SigDigger {
     DataSaverUI *saverUI = nullptr;
     NetForwarderUI *netForwarderUI = nullptr;
     FileDataSaver *dataSaver = nullptr;
-    SocketForwarder *socketForwarder = nullptr;
+    GenericDataSaver *socketForwarder = nullptr;
+    SocketStreamServer *streamServer = nullptr; // Same object, if serving
     TVProcessorTab *tvTab = nullptr;
     FACTab *facTab = nullptr;
     WaveformTab *wfTab = nullptr;
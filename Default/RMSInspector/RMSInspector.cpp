@@ -21,6 +21,7 @@
 #include "ui_RMSInspector.h"
 #include "SuWidgetsHelpers.h"
 #include "UIMediator.h"
+#include "RemoteControlServer.h"
 #include "Default/FFT/FFTWidget.h"
 #include "SigDiggerHelpers.h"
 #include <sys/stat.h>
@@ -212,6 +213,11 @@ RMSInspector::RMSInspector(
   connectAll();
 
   updateMaxSamples();
+
+  m_remoteControl = mediator->getRemoteControl();
+  if (m_remoteControl != nullptr)
+    m_powerSourceId = m_remoteControl->registerPowerSource(
+          getInspectorTabTitle());
 }
 
 void
@@ -227,6 +233,9 @@ RMSInspector::closeRequested()
 
 RMSInspector::~RMSInspector()
 {
+  if (m_remoteControl != nullptr && m_powerSourceId >= 0)
+    m_remoteControl->unregisterPowerSource(m_powerSourceId);
+
   if (m_datasaver != nullptr)
     suscli_datasaver_destroy(m_datasaver);
 
@@ -259,6 +268,12 @@ RMSInspector::pushPowerSample(qreal mean)
     struct timeval currTv, diff;
     struct timeval tv = m_analyzer->getSourceTimeStamp();
 
+    if (m_remoteControl != nullptr && m_powerSourceId >= 0)
+      m_remoteControl->publishPower(
+            m_powerSourceId,
+            SCAST(qreal, tv.tv_sec) + 1e-6 * SCAST(qreal, tv.tv_usec),
+            mean);
+
     if (m_rmsTab->running()) {
       if (m_firstMeasurement) {
         if (!m_uiConfig->autoFit) {
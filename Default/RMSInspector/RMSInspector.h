@@ -22,6 +22,7 @@
 #include <QWidget>
 
 #include <QWidget>
+#include <QPointer>
 #include <Suscan/Analyzer.h>
 #include <Suscan/Config.h>
 #include <cli/datasaver.h>
@@ -36,6 +37,7 @@ namespace Ui {
 namespace SigDigger {
   class AppConfig;
   class RMSViewTab;
+  class RemoteControlServer;
 
   extern "C" {
     typedef void (*datasaver_param_init_cb) (
@@ -97,6 +99,10 @@ namespace SigDigger {
 
     qint64 m_tunerFreq = 0;
 
+    // Remote control power stream
+    QPointer<RemoteControlServer> m_remoteControl;
+    int m_powerSourceId = -1;
+
     QString getInspectorTabTitle() const;
 
     void updateMaxSamples();
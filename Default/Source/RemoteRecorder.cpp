@@ -0,0 +1,353 @@
+//
+//    RemoteRecorder.cpp: Record remote sessions through an inspector channel
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "RemoteRecorder.h"
+#include <Suscan/AnalyzerRequestTracker.h>
+#include <GenericDataSaver.h>
+#include <cmath>
+#include <limits>
+
+using namespace SigDigger;
+
+RemoteRecorder::RemoteRecorder(QObject *parent) : QObject(parent)
+{
+  m_tracker = new Suscan::AnalyzerRequestTracker(this);
+
+  this->connectAll();
+}
+
+RemoteRecorder::~RemoteRecorder()
+{
+  if (m_analyzer != nullptr)
+    this->close();
+}
+
+void
+RemoteRecorder::connectAll()
+{
+  connect(
+        m_tracker,
+        SIGNAL(opened(Suscan::AnalyzerRequest const &)),
+        this,
+        SLOT(onOpened(Suscan::AnalyzerRequest const &)));
+
+  connect(
+        m_tracker,
+        SIGNAL(cancelled(Suscan::AnalyzerRequest const &)),
+        this,
+        SLOT(onCancelled(Suscan::AnalyzerRequest const &)));
+
+  connect(
+        m_tracker,
+        SIGNAL(error(Suscan::AnalyzerRequest const &, const std::string &)),
+        this,
+        SLOT(onError(Suscan::AnalyzerRequest const &, const std::string &)));
+}
+
+void
+RemoteRecorder::connectAnalyzer()
+{
+  connect(
+        m_analyzer,
+        SIGNAL(samples_message(const Suscan::SamplesMessage &)),
+        this,
+        SLOT(onInspectorSamples(const Suscan::SamplesMessage &)));
+}
+
+void
+RemoteRecorder::disconnectAnalyzer()
+{
+  disconnect(m_analyzer, nullptr, this, nullptr);
+}
+
+//
+// The server delivers complex floats no matter what, so the only knob we
+// have over the link usage is the width of the channel.
+//
+qreal
+RemoteRecorder::channelRateForBudget(qreal sourceRate, qreal budget)
+{
+  qreal rate = sourceRate;
+
+  if (budget > 0) {
+    qreal maxRate = budget / SIGDIGGER_REMOTE_RECORDER_WIRE_SAMPLE_SIZE;
+    if (rate > maxRate)
+      rate = maxRate;
+  }
+
+  if (rate < SIGDIGGER_REMOTE_RECORDER_MIN_RATE)
+    rate = SIGDIGGER_REMOTE_RECORDER_MIN_RATE;
+
+  return rate;
+}
+
+//
+// Automatic selection keeps the disk throughput in the same ballpark as
+// that of a local float32 capture at a few Msps. Narrow channels are cheap
+// enough to be stored as they come.
+//
+RemoteRecorderFormat
+RemoteRecorder::resolveFormat(RemoteRecorderFormat format, qreal channelRate)
+{
+  if (format != REMOTE_RECORDER_FORMAT_AUTO)
+    return format;
+
+  if (channelRate <= 1e6)
+    return REMOTE_RECORDER_FORMAT_FLOAT32;
+  else if (channelRate <= 1e7)
+    return REMOTE_RECORDER_FORMAT_INT16;
+
+  return REMOTE_RECORDER_FORMAT_INT8;
+}
+
+unsigned int
+RemoteRecorder::sampleSize(RemoteRecorderFormat format)
+{
+  switch (format) {
+    case REMOTE_RECORDER_FORMAT_INT16:
+      return 2 * sizeof(int16_t);
+
+    case REMOTE_RECORDER_FORMAT_INT8:
+      return 2 * sizeof(int8_t);
+
+    default:
+      return sizeof(SUCOMPLEX);
+  }
+}
+
+const char *
+RemoteRecorder::formatName(RemoteRecorderFormat format)
+{
+  switch (format) {
+    case REMOTE_RECORDER_FORMAT_INT16:
+      return "int16";
+
+    case REMOTE_RECORDER_FORMAT_INT8:
+      return "int8";
+
+    default:
+      return "float32";
+  }
+}
+
+void
+RemoteRecorder::setAnalyzer(Suscan::Analyzer *analyzer)
+{
+  if (m_analyzer != nullptr) {
+    this->close();
+    this->disconnectAnalyzer();
+  }
+
+  m_analyzer = analyzer;
+  m_tracker->setAnalyzer(analyzer);
+
+  if (m_analyzer != nullptr)
+    this->connectAnalyzer();
+}
+
+void
+RemoteRecorder::setFormat(RemoteRecorderFormat format)
+{
+  m_format = format;
+}
+
+void
+RemoteRecorder::setLinkBudget(qreal budget)
+{
+  m_budget = budget;
+}
+
+bool
+RemoteRecorder::open(qreal sourceRate)
+{
+  Suscan::Channel ch;
+  qreal rate;
+
+  if (m_analyzer == nullptr)
+    return false;
+
+  if (m_opening || m_opened)
+    return true;
+
+  rate = channelRateForBudget(sourceRate, m_budget);
+
+  ch.bw    = rate;
+  ch.ft    = 0;
+  ch.fc    = 0;
+  ch.fLow  = -.5 * rate;
+  ch.fHigh = +.5 * rate;
+
+  m_resolved = resolveFormat(m_format, rate);
+  m_clipped  = 0;
+  m_opening  = m_tracker->requestOpen("raw", ch, QVariant(), true);
+
+  return m_opening;
+}
+
+void
+RemoteRecorder::close()
+{
+  m_saver = nullptr;
+
+  if (m_analyzer != nullptr) {
+    if (m_opened)
+      m_analyzer->closeInspector(m_handle);
+    else if (m_opening)
+      m_tracker->cancelAll();
+  }
+
+  m_opening = false;
+  m_opened  = false;
+  m_handle  = -1;
+}
+
+void
+RemoteRecorder::setDataSaver(GenericDataSaver *saver)
+{
+  m_saver = saver;
+}
+
+bool
+RemoteRecorder::isOpened() const
+{
+  return m_opened;
+}
+
+qreal
+RemoteRecorder::getSampleRate() const
+{
+  return m_rate;
+}
+
+qreal
+RemoteRecorder::getBandwidth() const
+{
+  return m_bandwidth;
+}
+
+quint64
+RemoteRecorder::getClippedSamples() const
+{
+  return m_clipped;
+}
+
+RemoteRecorderFormat
+RemoteRecorder::getResolvedFormat() const
+{
+  return m_resolved;
+}
+
+//
+// Integer formats are interleaved I/Q with full scale at 1.0, the same
+// convention as the SigMF ci16/ci8 datatypes.
+//
+template<typename T> static quint64
+quantizeAs(const SUCOMPLEX *samples, unsigned int count, T *out)
+{
+  const SUFLOAT fullScale = std::numeric_limits<T>::max();
+  quint64 clipped = 0;
+
+  for (unsigned int i = 0; i < count; ++i) {
+    SUFLOAT re = SU_C_REAL(samples[i]) * fullScale;
+    SUFLOAT im = SU_C_IMAG(samples[i]) * fullScale;
+
+    if (SU_ABS(re) > fullScale || SU_ABS(im) > fullScale) {
+      ++clipped;
+      re = SU_MAX(SU_MIN(re, fullScale), -fullScale);
+      im = SU_MAX(SU_MIN(im, fullScale), -fullScale);
+    }
+
+    out[2 * i]     = SCAST(T, lrintf(re));
+    out[2 * i + 1] = SCAST(T, lrintf(im));
+  }
+
+  return clipped;
+}
+
+void
+RemoteRecorder::quantize(const SUCOMPLEX *samples, unsigned int count)
+{
+  m_scratch.resize(count * sampleSize(m_resolved));
+
+  if (m_resolved == REMOTE_RECORDER_FORMAT_INT16)
+    m_clipped += quantizeAs(
+          samples,
+          count,
+          reinterpret_cast<int16_t *>(m_scratch.data()));
+  else
+    m_clipped += quantizeAs(
+          samples,
+          count,
+          reinterpret_cast<int8_t *>(m_scratch.data()));
+}
+
+////////////////////////////////// Slots ///////////////////////////////////////
+void
+RemoteRecorder::onInspectorSamples(Suscan::SamplesMessage const &msg)
+{
+  if (m_opened && m_saver != nullptr && msg.getInspectorId() == m_inspId) {
+    const SUCOMPLEX *samples = msg.getSamples();
+    unsigned int count = msg.getCount();
+
+    if (m_resolved == REMOTE_RECORDER_FORMAT_FLOAT32) {
+      m_saver->write(samples, count);
+    } else {
+      this->quantize(samples, count);
+      m_saver->write(m_scratch.data(), m_scratch.size());
+    }
+  }
+}
+
+void
+RemoteRecorder::onOpened(Suscan::AnalyzerRequest const &req)
+{
+  m_opening = false;
+
+  if (m_analyzer == nullptr)
+    return;
+
+  m_opened    = true;
+  m_handle    = req.handle;
+  m_inspId    = req.inspectorId;
+  m_rate      = SCAST(qreal, req.equivRate);
+  m_bandwidth = SCAST(qreal, req.bandwidth);
+
+  // Fewer, larger sample batches are much friendlier to the link
+  m_analyzer->setInspectorWatermark(
+        m_handle,
+        SCAST(SUSCOUNT, m_rate * SIGDIGGER_REMOTE_RECORDER_BATCH_TIME));
+
+  emit opened(m_rate, m_bandwidth);
+}
+
+void
+RemoteRecorder::onCancelled(Suscan::AnalyzerRequest const &)
+{
+  m_opening = false;
+}
+
+void
+RemoteRecorder::onError(Suscan::AnalyzerRequest const &, const std::string &err)
+{
+  m_opening = false;
+
+  emit error(
+        "Failed to open remote recording channel: "
+        + QString::fromStdString(err));
+}
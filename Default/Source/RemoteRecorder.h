@@ -0,0 +1,120 @@
+//
+//    RemoteRecorder.h: Record remote sessions through an inspector channel
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef REMOTERECORDER_H
+#define REMOTERECORDER_H
+
+#include <QObject>
+#include <Suscan/Analyzer.h>
+#include <vector>
+
+// Bytes per complex sample as delivered by the server (complex float)
+#define SIGDIGGER_REMOTE_RECORDER_WIRE_SAMPLE_SIZE 8
+// Deliver samples in batches of this many seconds
+#define SIGDIGGER_REMOTE_RECORDER_BATCH_TIME       .1
+// Never narrow the channel below this rate
+#define SIGDIGGER_REMOTE_RECORDER_MIN_RATE         1000.
+
+namespace Suscan {
+  class AnalyzerRequestTracker;
+  struct AnalyzerRequest;
+};
+
+namespace SigDigger {
+  class GenericDataSaver;
+
+  enum RemoteRecorderFormat {
+    REMOTE_RECORDER_FORMAT_AUTO,
+    REMOTE_RECORDER_FORMAT_FLOAT32,
+    REMOTE_RECORDER_FORMAT_INT16,
+    REMOTE_RECORDER_FORMAT_INT8
+  };
+
+  //
+  // Remote analyzers do not expose the baseband filter, so remote sessions
+  // are recorded by opening a raw inspector centered in the spectrum and
+  // writing the samples it delivers. The channel is narrowed so that its
+  // sample stream fits in the link budget, and the samples are quantized
+  // to the storage format before hitting the disk.
+  //
+  class RemoteRecorder : public QObject
+  {
+    Q_OBJECT
+
+    Suscan::Analyzer               *m_analyzer = nullptr; // Borrowed
+    Suscan::AnalyzerRequestTracker *m_tracker  = nullptr;
+    GenericDataSaver               *m_saver    = nullptr; // Borrowed
+
+    RemoteRecorderFormat m_format   = REMOTE_RECORDER_FORMAT_AUTO;
+    RemoteRecorderFormat m_resolved = REMOTE_RECORDER_FORMAT_FLOAT32;
+    qreal                m_budget   = 0; // Bytes per second, 0 = unlimited
+
+    bool                 m_opening  = false;
+    bool                 m_opened   = false;
+    Suscan::Handle       m_handle   = -1;
+    uint32_t             m_inspId   = 0;
+    qreal                m_rate     = 0;
+    qreal                m_bandwidth = 0;
+    quint64              m_clipped  = 0;
+
+    std::vector<uint8_t> m_scratch;
+
+    void connectAll();
+    void connectAnalyzer();
+    void disconnectAnalyzer();
+    void quantize(const SUCOMPLEX *, unsigned int);
+
+  public:
+    RemoteRecorder(QObject *parent = nullptr);
+    ~RemoteRecorder() override;
+
+    void setAnalyzer(Suscan::Analyzer *);
+    void setFormat(RemoteRecorderFormat);
+    void setLinkBudget(qreal);
+
+    // Asynchronous: wait for opened() before attaching a saver
+    bool open(qreal sourceRate);
+    void close();
+    void setDataSaver(GenericDataSaver *);
+
+    bool isOpened() const;
+    qreal getSampleRate() const;
+    qreal getBandwidth() const;
+    quint64 getClippedSamples() const;
+    RemoteRecorderFormat getResolvedFormat() const;
+
+    static qreal channelRateForBudget(qreal sourceRate, qreal budget);
+    static RemoteRecorderFormat resolveFormat(
+        RemoteRecorderFormat format,
+        qreal channelRate);
+    static unsigned int sampleSize(RemoteRecorderFormat);
+    static const char *formatName(RemoteRecorderFormat);
+
+  signals:
+    void opened(qreal rate, qreal bandwidth);
+    void error(QString);
+
+  public slots:
+    void onOpened(Suscan::AnalyzerRequest const &);
+    void onCancelled(Suscan::AnalyzerRequest const &);
+    void onError(Suscan::AnalyzerRequest const &, const std::string &);
+    void onInspectorSamples(Suscan::SamplesMessage const &);
+  };
+}
+
+#endif // REMOTERECORDER_H
@@ -23,6 +23,7 @@
 #include "ui_SourceWidget.h"
 #include <QMessageBox>
 #include <FileDataSaver.h>
+#include "RemoteRecorder.h"
 #include <fcntl.h>
 #include <UIMediator.h>
 #include <SigDiggerHelpers.h>
@@ -72,6 +73,8 @@ SourceWidgetConfig::deserialize(Suscan::Object const &conf)
   LOAD(gainPresetEnabled);
   LOAD(allocHistory);
   LOAD(replayAllocationMiB);
+  LOAD(remoteLinkBudget);
+  LOAD(remoteFormat);
 
   try {
     Suscan::Object field = conf.getField("dataSaverConfig");
@@ -118,6 +121,8 @@ SourceWidgetConfig::serialize(void)
   STORE(gainPresetEnabled);
   STORE(allocHistory);
   STORE(replayAllocationMiB);
+  STORE(remoteLinkBudget);
+  STORE(remoteFormat);
 
   dataSaverConfig = this->dataSaverConfig->serialize();
 
@@ -154,6 +159,8 @@ SourceWidget::SourceWidget(
   m_ui->throttleSpin->setUnits("sps");
   m_ui->throttleSpin->setMinimum(0);
 
+  m_remoteRecorder = new RemoteRecorder(this);
+
   assertConfig();
   connectAll();
 
@@ -187,6 +194,18 @@ SourceWidget::connectAll(void)
         this,
         SLOT(onRecordStartStop()));
 
+  connect(
+        m_remoteRecorder,
+        SIGNAL(opened(qreal, qreal)),
+        this,
+        SLOT(onRemoteRecorderOpened(qreal, qreal)));
+
+  connect(
+        m_remoteRecorder,
+        SIGNAL(error(QString)),
+        this,
+        SLOT(onRemoteRecorderError(QString)));
+
   connect(
         m_ui->autoGainCombo,
         SIGNAL(activated(int)),
@@ -258,6 +277,18 @@ SourceWidget::connectAll(void)
         SIGNAL(toggled(bool)),
         this,
         SLOT(onToggleReplay()));
+
+  connect(
+        m_ui->remoteFormatCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onRemoteFormatChanged()));
+
+  connect(
+        m_ui->remoteBudgetSpin,
+        SIGNAL(valueChanged(qreal)),
+        this,
+        SLOT(onRemoteLinkBudgetChanged()));
 }
 
 
@@ -552,7 +583,6 @@ SourceWidget::refreshUi()
     m_ui->antennaCombo->setEnabled(m_profile->isRealTime());
     m_ui->bwSpin->setEnabled(m_profile->isRealTime());
     m_ui->ppmSpinBox->setEnabled(m_profile->isRealTime() || isRemote);
-    m_saverUI->setEnabled(!isRemote);
 
     seekable = m_profile->isSeekable();
   }
@@ -561,6 +591,8 @@ SourceWidget::refreshUi()
     seekable = m_sourceInfo.isSeekable();
 
   m_ui->replayWidget->setVisible(!seekable);
+  m_ui->remoteRecordWidget->setVisible(
+        m_profile != nullptr && m_profile->isRemote());
 
   // These depend on the source info only
   m_ui->dcRemoveCheck->setEnabled(
@@ -870,6 +902,26 @@ SourceWidget::deserializeAutoGains(void)
   }
 }
 
+// Same order as the entries of remoteFormatCombo
+static const char *const g_remoteFormats[] = {
+  "auto",
+  "float32",
+  "int16",
+  "int8"
+};
+#define REMOTE_FORMAT_COUNT \
+  (sizeof(g_remoteFormats) / sizeof(g_remoteFormats[0]))
+
+static int
+remoteFormatIndex(std::string const &format)
+{
+  for (unsigned int i = 0; i < REMOTE_FORMAT_COUNT; ++i)
+    if (format == g_remoteFormats[i])
+      return SCAST(int, i);
+
+  return 0;
+}
+
 // Configuration methods
 Suscan::Serializable *
 SourceWidget::allocConfig()
@@ -894,6 +946,12 @@ SourceWidget::applyConfig()
   BLOCKSIG(m_ui->gainPresetCheck, setChecked(m_panelConfig->gainPresetEnabled));
   BLOCKSIG(m_ui->allocHistoryCheck, setChecked(m_panelConfig->allocHistory));
   BLOCKSIG(m_ui->allocSizeSpin, setValue(m_panelConfig->replayAllocationMiB));
+  BLOCKSIG(
+        m_ui->remoteFormatCombo,
+        setCurrentIndex(remoteFormatIndex(m_panelConfig->remoteFormat)));
+  BLOCKSIG(
+        m_ui->remoteBudgetSpin,
+        setValue(m_panelConfig->remoteLinkBudget * 1e-3));
 
   setProperty("collapsed", m_panelConfig->collapsed);
 
@@ -969,6 +1027,7 @@ SourceWidget::setState(int state, Suscan::Analyzer *analyzer)
     m_filterInstalled = false; // The filter is not installed anymore.
 
     m_analyzer = analyzer;
+    m_remoteRecorder->setAnalyzer(analyzer);
 
     m_haveSourceInfo = false;
 
@@ -1080,10 +1139,21 @@ SourceWidget::openCaptureFile(void)
   char datetime[17];
   time_t unixtime;
   struct tm tm;
+  unsigned int rate;
+  const char *format = "float32";
 
   if (m_profile == nullptr)
     return -1;
 
+  rate = m_profile->getDecimatedSampleRate();
+
+  // Remote captures are named after the channel that is actually recorded
+  if (isRecordingRemote()) {
+    rate   = SCAST(unsigned int, m_remoteRecorder->getSampleRate());
+    format = RemoteRecorder::formatName(
+          m_remoteRecorder->getResolvedFormat());
+  }
+
   unixtime = time(nullptr);
   gmtime_r(&unixtime, &tm);
   strftime(datetime, sizeof(datetime), "%Y%m%d_%H%M%SZ", &tm);
@@ -1091,10 +1161,11 @@ SourceWidget::openCaptureFile(void)
   snprintf(
         baseName,
         sizeof(baseName),
-        "sigdigger_%s_%d_%.0lf_float32_iq.raw",
+        "sigdigger_%s_%d_%.0lf_%s_iq.raw",
         datetime,
-        m_profile->getDecimatedSampleRate(),
-        m_mediator->getCurrentCenterFreq());
+        rate,
+        m_mediator->getCurrentCenterFreq(),
+        format);
 
   std::string fullPath =
       m_saverUI->getRecordSavePath() + "/" + baseName;
@@ -1114,6 +1185,8 @@ SourceWidget::openCaptureFile(void)
 void
 SourceWidget::uninstallDataSaver()
 {
+  m_remoteRecorder->setDataSaver(nullptr);
+
   if (m_dataSaver != nullptr)
     delete m_dataSaver;
 
@@ -1123,17 +1196,21 @@ SourceWidget::uninstallDataSaver()
 void
 SourceWidget::connectDataSaver()
 {
+  // These are emitted from write(), which may run in this thread with the
+  // saver locked. Handling them replaces the saver, so it must be deferred.
   connect(
         m_dataSaver,
         SIGNAL(stopped()),
         this,
-        SLOT(onSaveError()));
+        SLOT(onSaveError()),
+        Qt::QueuedConnection);
 
   connect(
         m_dataSaver,
         SIGNAL(swamped()),
         this,
-        SLOT(onSaveSwamped()));
+        SLOT(onSaveSwamped()),
+        Qt::QueuedConnection);
 
   connect(
         m_dataSaver,
@@ -1172,11 +1249,18 @@ SourceWidget::installDataSaver(int fd)
   if (m_dataSaver == nullptr) {
     if (m_profile != nullptr && m_analyzer != nullptr) {
       m_dataSaver = new FileDataSaver(fd, this);
-      m_dataSaver->setSampleRate(m_profile->getDecimatedSampleRate());
 
-      if (!m_filterInstalled) {
-        m_analyzer->registerBaseBandFilter(onBaseBandData, this);
-        m_filterInstalled = true;
+      if (isRecordingRemote()) {
+        m_dataSaver->setSampleRate(
+              SCAST(unsigned int, m_remoteRecorder->getSampleRate()));
+        m_remoteRecorder->setDataSaver(m_dataSaver);
+      } else {
+        m_dataSaver->setSampleRate(m_profile->getDecimatedSampleRate());
+
+        if (!m_filterInstalled) {
+          m_analyzer->registerBaseBandFilter(onBaseBandData, this);
+          m_filterInstalled = true;
+        }
       }
 
       connectDataSaver();
@@ -1184,6 +1268,59 @@ SourceWidget::installDataSaver(int fd)
   }
 }
 
+bool
+SourceWidget::isRecordingRemote() const
+{
+  return m_profile != nullptr
+      && m_profile->isRemote()
+      && m_remoteRecorder->isOpened();
+}
+
+static RemoteRecorderFormat
+parseRemoteFormat(std::string const &format)
+{
+  if (format == "float32")
+    return REMOTE_RECORDER_FORMAT_FLOAT32;
+  else if (format == "int16")
+    return REMOTE_RECORDER_FORMAT_INT16;
+  else if (format == "int8")
+    return REMOTE_RECORDER_FORMAT_INT8;
+
+  return REMOTE_RECORDER_FORMAT_AUTO;
+}
+
+//
+// Remote analyzers have no baseband filter. We ask for a raw channel
+// instead and open the capture file once its actual rate is known.
+//
+void
+SourceWidget::startRemoteRecording()
+{
+  m_remoteRecorder->setFormat(parseRemoteFormat(m_panelConfig->remoteFormat));
+  m_remoteRecorder->setLinkBudget(m_panelConfig->remoteLinkBudget);
+
+  if (!m_remoteRecorder->open(m_profile->getDecimatedSampleRate())) {
+    QMessageBox::warning(
+          this,
+          "SigDigger error",
+          "Failed to request a recording channel to the remote analyzer",
+          QMessageBox::Ok);
+    setRecordState(false);
+    return;
+  }
+
+  setRecordState(true);
+}
+
+void
+SourceWidget::stopRecording()
+{
+  uninstallDataSaver();
+  m_remoteRecorder->close();
+  setCaptureSize(0);
+  setRecordState(false);
+}
+
 
 ////////////////////////////////////// Slots ///////////////////////////////////
 void
@@ -1237,14 +1374,16 @@ SourceWidget::onRecordStartStop(void)
         && m_saverUI->getRecordState();
 
     if (recordState) {
-      int fd = openCaptureFile();
-      if (fd != -1)
-        installDataSaver(fd);
-      setRecordState(fd != -1);
+      if (m_profile != nullptr && m_profile->isRemote()) {
+        startRemoteRecording();
+      } else {
+        int fd = openCaptureFile();
+        if (fd != -1)
+          installDataSaver(fd);
+        setRecordState(fd != -1);
+      }
     } else {
-      uninstallDataSaver();
-      setCaptureSize(0);
-      setRecordState(false);
+      stopRecording();
     }
   }
 }
@@ -1434,23 +1573,22 @@ SourceWidget::onAntennaChanged(int)
 void
 SourceWidget::onSaveError(void)
 {
-  if (m_dataSaver != nullptr) {
-    uninstallDataSaver();
+  // Queued: ignore whatever was pending from a saver that is already gone
+  if (m_dataSaver != nullptr && sender() == m_dataSaver) {
+    stopRecording();
 
     QMessageBox::warning(
               this,
               "SigDigger error",
               "Capture file write error. Disk full?",
               QMessageBox::Ok);
-
-    setRecordState(false);
   }
 }
 
 void
 SourceWidget::onSaveSwamped(void)
 {
-  if (m_dataSaver != nullptr) {
+  if (m_dataSaver != nullptr && sender() == m_dataSaver) {
     uninstallDataSaver();
     SU_WARNING("Capture thread swamped. Maybe the selected storage device is too slow.\n");
     int fd = openCaptureFile();
@@ -1463,7 +1601,7 @@ SourceWidget::onSaveSwamped(void)
             "SigDigger error",
             "Capture swamped, but failed to reopen the capture file.",
             QMessageBox::Ok);
-      setRecordState(false);
+      stopRecording();
     }
   }
 }
@@ -1482,6 +1620,55 @@ SourceWidget::onCommit(void)
     setCaptureSize(m_dataSaver->getSize());
 }
 
+void
+SourceWidget::onRemoteRecorderOpened(qreal rate, qreal bandwidth)
+{
+  int fd;
+
+  if (!m_saverUI->getRecordState()) {
+    m_remoteRecorder->close();
+    return;
+  }
+
+  SU_INFO(
+        "Remote recording: %.0f sps channel (%.0f Hz wide), stored as %s\n",
+        rate,
+        bandwidth,
+        RemoteRecorder::formatName(m_remoteRecorder->getResolvedFormat()));
+
+  if ((fd = openCaptureFile()) != -1)
+    installDataSaver(fd);
+  else
+    stopRecording();
+}
+
+void
+SourceWidget::onRemoteRecorderError(QString error)
+{
+  stopRecording();
+
+  QMessageBox::warning(
+        this,
+        "SigDigger error",
+        error,
+        QMessageBox::Ok);
+}
+
+void
+SourceWidget::onRemoteFormatChanged()
+{
+  int index = m_ui->remoteFormatCombo->currentIndex();
+
+  if (index >= 0 && SCAST(unsigned int, index) < REMOTE_FORMAT_COUNT)
+    m_panelConfig->remoteFormat = g_remoteFormats[index];
+}
+
+void
+SourceWidget::onRemoteLinkBudgetChanged()
+{
+  m_panelConfig->remoteLinkBudget = m_ui->remoteBudgetSpin->value() * 1e3;
+}
+
 void
 SourceWidget::onAllocHistoryToggled()
 {
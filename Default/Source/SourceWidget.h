@@ -31,6 +31,7 @@ namespace Ui {
 namespace SigDigger {
   class SourceWidgetFactory;
   class FileDataSaver;
+  class RemoteRecorder;
 
   SUBOOL onBaseBandData(
       void *privdata,
@@ -65,6 +66,10 @@ namespace SigDigger {
       std::map<std::string, GainPresetSetting> agcSettings;
       unsigned int throttleRate = 196000;
 
+      // Remote recording
+      qreal remoteLinkBudget = 2.5e6; // Bytes per second, 0 = unlimited
+      std::string remoteFormat = "auto";
+
       // Overriden methods
       void deserialize(Suscan::Object const &conf) override;
       Suscan::Object &&serialize() override;
@@ -102,6 +107,7 @@ namespace SigDigger {
     // Data saving state
     bool                      m_filterInstalled = false;
     FileDataSaver            *m_dataSaver = nullptr;
+    RemoteRecorder           *m_remoteRecorder = nullptr;
 
     // Private methods
     DeviceGain *lookupGain(std::string const &name);
@@ -149,6 +155,9 @@ namespace SigDigger {
     void installDataSaver(int fd);
     void connectDataSaver();
     void uninstallDataSaver();
+    bool isRecordingRemote() const;
+    void startRemoteRecording();
+    void stopRecording();
 
   public:
     SourceWidget(SourceWidgetFactory *, UIMediator *, QWidget *parent = nullptr);
@@ -197,6 +206,12 @@ namespace SigDigger {
     void onSaveSwamped(void);
     void onSaveRate(qreal rate);
     void onCommit(void);
+
+    // Remote recording
+    void onRemoteRecorderOpened(qreal rate, qreal bandwidth);
+    void onRemoteRecorderError(QString);
+    void onRemoteFormatChanged();
+    void onRemoteLinkBudgetChanged();
   };
 }
 
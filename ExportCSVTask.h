@@ -39,9 +39,8 @@ namespace SigDigger {
       std::map<std::string, std::vector<SUCOMPLEX>> m_columns;
 
       QString m_lastError;
-      bool m_cancelFlag = false;
 
-      void breathe(quint64);
+      bool breathe(quint64);
       bool openCSV();
       bool exportToCSV();
 
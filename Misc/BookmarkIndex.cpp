@@ -0,0 +1,184 @@
+//
+//    BookmarkIndex.cpp: Interval index of bookmarks by occupied band
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "BookmarkIndex.h"
+#include <algorithm>
+
+using namespace SigDigger;
+
+bool
+BookmarkIndex::refresh()
+{
+  Suscan::Singleton *sing = Suscan::Singleton::get_instance();
+  quint64 rev = sing->getBookmarkRevision();
+
+  if (m_built && rev == m_revision)
+    return false;
+
+  this->build(sing->getBookmarkMap());
+  m_revision = rev;
+
+  return true;
+}
+
+void
+BookmarkIndex::build(QMap<qint64, Suscan::Bookmark> const &map)
+{
+  m_entries.clear();
+  m_entries.reserve(static_cast<size_t>(map.size()));
+
+  for (auto p = map.cbegin(); p != map.cend(); ++p) {
+    BookmarkIndexEntry entry;
+    qint64 lowCut  = std::min(p->info.lowFreqCut, p->info.highFreqCut);
+    qint64 highCut = std::max(p->info.lowFreqCut, p->info.highFreqCut);
+
+    entry.low  = p->info.frequency + std::min<qint64>(lowCut, 0);
+    entry.high = p->info.frequency + std::max<qint64>(highCut, 0);
+    entry.info = p->info;
+
+    m_entries.push_back(std::move(entry));
+  }
+
+  // The map is sorted by center frequency, which is almost the right order
+  std::stable_sort(
+        m_entries.begin(),
+        m_entries.end(),
+        [] (BookmarkIndexEntry const &a, BookmarkIndexEntry const &b) {
+          return a.low < b.low;
+        });
+
+  m_maxHigh.resize(m_entries.size());
+
+  if (!m_entries.empty())
+    this->buildNode(0, m_entries.size());
+
+  m_built = true;
+}
+
+qint64
+BookmarkIndex::buildNode(size_t lo, size_t hi)
+{
+  size_t mid = lo + (hi - lo) / 2;
+  qint64 max = m_entries[mid].high;
+
+  if (lo < mid)
+    max = std::max(max, this->buildNode(lo, mid));
+
+  if (mid + 1 < hi)
+    max = std::max(max, this->buildNode(mid + 1, hi));
+
+  m_maxHigh[mid] = max;
+
+  return max;
+}
+
+void
+BookmarkIndex::queryNode(
+    size_t lo,
+    size_t hi,
+    qint64 start,
+    qint64 end,
+    std::vector<const BookmarkIndexEntry *> &result) const
+{
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+
+    // Nothing in this subtree reaches the range
+    if (m_maxHigh[mid] < start)
+      return;
+
+    this->queryNode(lo, mid, start, end, result);
+
+    // Neither this node nor anything to its right starts before the end
+    if (m_entries[mid].low > end)
+      return;
+
+    if (m_entries[mid].high >= start)
+      result.push_back(&m_entries[mid]);
+
+    lo = mid + 1;
+  }
+}
+
+void
+BookmarkIndex::query(
+    qint64 start,
+    qint64 end,
+    std::vector<const BookmarkIndexEntry *> &result) const
+{
+  result.clear();
+
+  if (start <= end)
+    this->queryNode(0, m_entries.size(), start, end, result);
+}
+
+//
+// When zoomed out, most bookmarks in range would overlap each other on
+// screen anyway. Keep only the widest one of each bucket of the range,
+// which is the one most likely to be recognizable at that scale.
+//
+void
+BookmarkIndex::queryLOD(
+    qint64 start,
+    qint64 end,
+    std::vector<const BookmarkIndexEntry *> &result,
+    unsigned int buckets) const
+{
+  std::vector<int> slot;
+  std::vector<const BookmarkIndexEntry *> all;
+  qint64 span = end - start + 1;
+  size_t n = 0;
+
+  this->query(start, end, all);
+
+  if (buckets == 0 || all.size() <= buckets) {
+    result.swap(all);
+    return;
+  }
+
+  slot.assign(buckets, -1);
+
+  for (auto p : all) {
+    qint64 center = std::min(std::max(p->low / 2 + p->high / 2, start), end);
+    size_t b = static_cast<size_t>((center - start) * buckets / span);
+    int i = slot[b];
+
+    if (i == -1) {
+      slot[b] = static_cast<int>(n);
+      all[n++] = p;
+    } else if (p->high - p->low > all[i]->high - all[i]->low) {
+      all[i] = p;
+    }
+  }
+
+  all.resize(n);
+  result.swap(all);
+}
+
+size_t
+BookmarkIndex::size() const
+{
+  return m_entries.size();
+}
+
+quint64
+BookmarkIndex::revision() const
+{
+  return m_revision;
+}
@@ -0,0 +1,471 @@
+//
+//    CaptureOverview.cpp: Persistent multi-level summary of capture files
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "CaptureOverview.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace SigDigger;
+
+#define SIGDIGGER_OVERVIEW_MAGIC      "SDOVRVW"
+#define SIGDIGGER_OVERVIEW_VERSION    1
+#define SIGDIGGER_OVERVIEW_BYTE_ORDER 0x01020304
+#define SIGDIGGER_OVERVIEW_TAG_SIZE   64
+
+struct CaptureOverviewFileHeader {
+  char    magic[8];
+  quint32 version;
+  quint32 byteOrder;
+  quint32 blockSamples;
+  quint32 fanout;
+  quint32 entrySize;
+  quint32 levels;
+  quint64 captureSize;
+  qint64  captureMTime;
+  quint64 length;
+  char    tag[SIGDIGGER_OVERVIEW_TAG_SIZE];
+};
+
+static void
+makeHeader(
+    CaptureOverviewFileHeader &header,
+    QString const &capturePath,
+    QString const &tag,
+    size_t length,
+    size_t levels)
+{
+  QFileInfo info(capturePath);
+  QByteArray tagBytes = tag.toUtf8().left(SIGDIGGER_OVERVIEW_TAG_SIZE - 1);
+
+  memset(&header, 0, sizeof(CaptureOverviewFileHeader));
+  strncpy(header.magic, SIGDIGGER_OVERVIEW_MAGIC, sizeof(header.magic));
+  memcpy(header.tag, tagBytes.data(), static_cast<size_t>(tagBytes.size()));
+
+  header.version      = SIGDIGGER_OVERVIEW_VERSION;
+  header.byteOrder    = SIGDIGGER_OVERVIEW_BYTE_ORDER;
+  header.blockSamples = SIGDIGGER_OVERVIEW_BLOCK_SAMPLES;
+  header.fanout       = SIGDIGGER_OVERVIEW_FANOUT;
+  header.entrySize    = sizeof(CaptureOverviewEntry);
+  header.levels       = static_cast<quint32>(levels);
+  header.captureSize  = static_cast<quint64>(info.size());
+  header.captureMTime = info.lastModified().toMSecsSinceEpoch();
+  header.length       = length;
+}
+
+static inline void
+resetEntry(CaptureOverviewEntry &e)
+{
+  e.minI = e.minQ = +std::numeric_limits<SUFLOAT>::infinity();
+  e.maxI = e.maxQ = -std::numeric_limits<SUFLOAT>::infinity();
+  e.envelope = e.reserved = 0;
+  e.sumI = e.sumQ = e.sumPower = 0;
+}
+
+static inline void
+mergeEntry(CaptureOverviewEntry &e, CaptureOverviewEntry const &other)
+{
+  e.minI     = std::min(e.minI, other.minI);
+  e.maxI     = std::max(e.maxI, other.maxI);
+  e.minQ     = std::min(e.minQ, other.minQ);
+  e.maxQ     = std::max(e.maxQ, other.maxQ);
+  e.envelope = std::max(e.envelope, other.envelope);
+  e.sumI     += other.sumI;
+  e.sumQ     += other.sumQ;
+  e.sumPower += other.sumPower;
+}
+
+static void
+summarize(CaptureOverviewEntry &e, const SUCOMPLEX *x, size_t count)
+{
+  SUFLOAT minI = e.minI, maxI = e.maxI, minQ = e.minQ, maxQ = e.maxQ;
+  SUFLOAT maxPower = e.envelope * e.envelope;
+  double sumI = 0, sumQ = 0, sumPower = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    SUFLOAT re = SU_C_REAL(x[i]);
+    SUFLOAT im = SU_C_IMAG(x[i]);
+    SUFLOAT power = re * re + im * im;
+
+    minI = std::min(minI, re);
+    maxI = std::max(maxI, re);
+    minQ = std::min(minQ, im);
+    maxQ = std::max(maxQ, im);
+    maxPower = std::max(maxPower, power);
+
+    sumI     += static_cast<double>(re);
+    sumQ     += static_cast<double>(im);
+    sumPower += static_cast<double>(power);
+  }
+
+  e.minI = minI;
+  e.maxI = maxI;
+  e.minQ = minQ;
+  e.maxQ = maxQ;
+  e.envelope = std::sqrt(maxPower);
+  e.sumI     += sumI;
+  e.sumQ     += sumQ;
+  e.sumPower += sumPower;
+}
+
+static CaptureOverviewStats
+finishStats(CaptureOverviewEntry const &e, size_t count)
+{
+  CaptureOverviewStats stats;
+
+  if (count == 0)
+    return stats;
+
+  stats.min      = SUCOMPLEX(e.minI, e.minQ);
+  stats.max      = SUCOMPLEX(e.maxI, e.maxQ);
+  stats.mean     = SUCOMPLEX(
+        static_cast<SUFLOAT>(e.sumI / static_cast<double>(count)),
+        static_cast<SUFLOAT>(e.sumQ / static_cast<double>(count)));
+  stats.rms      = static_cast<SUFLOAT>(
+        std::sqrt(e.sumPower / static_cast<double>(count)));
+  stats.envelope = e.envelope;
+  stats.count    = count;
+
+  return stats;
+}
+
+CaptureOverview::CaptureOverview(
+    const SUCOMPLEX *data,
+    size_t length,
+    QObject *parent) : QObject(parent), m_data(data), m_length(length)
+{
+  m_complete  = false;
+  m_cancelled = false;
+}
+
+CaptureOverview::~CaptureOverview()
+{
+  this->cancel();
+}
+
+void
+CaptureOverview::cancel()
+{
+  m_cancelled = true;
+
+  if (m_worker.joinable())
+    m_worker.join();
+}
+
+QString
+CaptureOverview::cachePath(QString const &capturePath)
+{
+  QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  QByteArray hash = QCryptographicHash::hash(
+        QFileInfo(capturePath).absoluteFilePath().toUtf8(),
+        QCryptographicHash::Sha1);
+
+  if (dir.isEmpty())
+    return QString();
+
+  return dir
+      + "/overviews/"
+      + QString::fromLatin1(hash.toHex())
+      + SIGDIGGER_OVERVIEW_SUFFIX;
+}
+
+bool
+CaptureOverview::loadFrom(
+    QString const &path,
+    QString const &capturePath,
+    QString const &tag)
+{
+  QFile file(path);
+  CaptureOverviewFileHeader expected, header;
+  std::vector<std::vector<CaptureOverviewEntry>> levels;
+  size_t count = (m_length + SIGDIGGER_OVERVIEW_BLOCK_SAMPLES - 1)
+      / SIGDIGGER_OVERVIEW_BLOCK_SAMPLES;
+
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  if (file.read(reinterpret_cast<char *>(&header), sizeof(header))
+      != sizeof(header))
+    return false;
+
+  // Level sizes only depend on the length, so they need not be stored
+  while (count > 0) {
+    levels.push_back(std::vector<CaptureOverviewEntry>(count));
+    count = count > 1
+        ? (count + SIGDIGGER_OVERVIEW_FANOUT - 1) / SIGDIGGER_OVERVIEW_FANOUT
+        : 0;
+  }
+
+  makeHeader(expected, capturePath, tag, m_length, levels.size());
+
+  if (memcmp(&header, &expected, sizeof(header)) != 0)
+    return false;
+
+  for (auto &level : levels) {
+    qint64 bytes = static_cast<qint64>(
+          level.size() * sizeof(CaptureOverviewEntry));
+
+    if (file.read(reinterpret_cast<char *>(level.data()), bytes) != bytes)
+      return false;
+  }
+
+  m_levels = std::move(levels);
+
+  return true;
+}
+
+bool
+CaptureOverview::saveTo(
+    QString const &path,
+    QString const &capturePath,
+    QString const &tag) const
+{
+  QSaveFile file(path);
+  CaptureOverviewFileHeader header;
+
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+
+  makeHeader(header, capturePath, tag, m_length, m_levels.size());
+
+  if (file.write(reinterpret_cast<const char *>(&header), sizeof(header))
+      != sizeof(header))
+    return false;
+
+  for (auto &level : m_levels) {
+    qint64 bytes = static_cast<qint64>(
+          level.size() * sizeof(CaptureOverviewEntry));
+
+    if (file.write(reinterpret_cast<const char *>(level.data()), bytes)
+        != bytes)
+      return false;
+  }
+
+  return file.commit();
+}
+
+bool
+CaptureOverview::load(QString const &capturePath, QString const &tag)
+{
+  QString cached = cachePath(capturePath);
+
+  if (m_complete)
+    return true;
+
+  if (!loadFrom(capturePath + SIGDIGGER_OVERVIEW_SUFFIX, capturePath, tag)
+      && (cached.isEmpty() || !loadFrom(cached, capturePath, tag)))
+    return false;
+
+  m_complete = true;
+
+  return true;
+}
+
+bool
+CaptureOverview::build()
+{
+  size_t blocks = (m_length + SIGDIGGER_OVERVIEW_BLOCK_SAMPLES - 1)
+      / SIGDIGGER_OVERVIEW_BLOCK_SAMPLES;
+  unsigned int workers = std::thread::hardware_concurrency();
+  std::vector<CaptureOverviewEntry> first(blocks);
+  std::vector<std::thread> threads;
+  size_t chunk;
+
+  workers = std::max(
+        1u,
+        std::min(
+          workers,
+          static_cast<unsigned int>(SIGDIGGER_OVERVIEW_MAX_WORKERS)));
+  chunk = (blocks + workers - 1) / workers;
+
+  // First level: contiguous ranges of blocks, one per thread
+  auto summarizeBlocks = [&] (size_t from, size_t to) {
+    for (size_t i = from; i < to && !m_cancelled; ++i) {
+      size_t start = i * SIGDIGGER_OVERVIEW_BLOCK_SAMPLES;
+
+      resetEntry(first[i]);
+      summarize(
+            first[i],
+            m_data + start,
+            std::min<size_t>(
+              SIGDIGGER_OVERVIEW_BLOCK_SAMPLES,
+              m_length - start));
+    }
+  };
+
+  for (size_t from = chunk; from < blocks; from += chunk)
+    threads.push_back(
+          std::thread(summarizeBlocks, from, std::min(blocks, from + chunk)));
+
+  summarizeBlocks(0, std::min(blocks, chunk));
+
+  for (auto &t : threads)
+    t.join();
+
+  if (m_cancelled || blocks == 0)
+    return false;
+
+  m_levels.clear();
+  m_levels.push_back(std::move(first));
+
+  // Upper levels are small enough to be built right here
+  while (m_levels.back().size() > 1) {
+    auto const &prev = m_levels.back();
+    std::vector<CaptureOverviewEntry> next(
+          (prev.size() + SIGDIGGER_OVERVIEW_FANOUT - 1)
+          / SIGDIGGER_OVERVIEW_FANOUT);
+
+    for (size_t i = 0; i < next.size(); ++i) {
+      size_t last = std::min(prev.size(), (i + 1) * SIGDIGGER_OVERVIEW_FANOUT);
+
+      resetEntry(next[i]);
+      for (size_t j = i * SIGDIGGER_OVERVIEW_FANOUT; j < last; ++j)
+        mergeEntry(next[i], prev[j]);
+    }
+
+    m_levels.push_back(std::move(next));
+  }
+
+  return true;
+}
+
+void
+CaptureOverview::buildInBackground(QString const &capturePath, QString const &tag)
+{
+  if (m_complete || m_worker.joinable())
+    return;
+
+  m_worker = std::thread([this, capturePath, tag] () {
+    QString cached;
+
+    if (!this->build())
+      return;
+
+    m_complete = true;
+
+    if (!m_cancelled)
+      emit ready();
+
+    // Captures are often on read-only media. Keep the overview in the
+    // cache directory then.
+    if (this->saveTo(capturePath + SIGDIGGER_OVERVIEW_SUFFIX, capturePath, tag))
+      return;
+
+    cached = cachePath(capturePath);
+
+    if (!cached.isEmpty() && QDir().mkpath(QFileInfo(cached).path()))
+      this->saveTo(cached, capturePath, tag);
+  });
+}
+
+bool
+CaptureOverview::isComplete() const
+{
+  return m_complete;
+}
+
+bool
+CaptureOverview::covers(const SUCOMPLEX *data, size_t length) const
+{
+  return m_complete && data == m_data && length == m_length;
+}
+
+void
+CaptureOverview::scan(CaptureOverviewEntry &e, size_t from, size_t to) const
+{
+  if (from < to)
+    summarize(e, m_data + from, to - from);
+}
+
+CaptureOverviewStats
+CaptureOverview::stats() const
+{
+  if (!m_complete)
+    return CaptureOverviewStats();
+
+  return finishStats(m_levels.back()[0], m_length);
+}
+
+CaptureOverviewStats
+CaptureOverview::stats(size_t from, size_t to) const
+{
+  CaptureOverviewEntry e;
+  size_t lo, hi;
+
+  if (!m_complete)
+    return CaptureOverviewStats();
+
+  to = std::min(to, m_length);
+
+  if (from >= to)
+    return CaptureOverviewStats();
+
+  resetEntry(e);
+
+  // Whole blocks in the range. The last block may be shorter than the
+  // rest, and counts as whole if the range reaches the end of the data.
+  lo = (from + SIGDIGGER_OVERVIEW_BLOCK_SAMPLES - 1)
+      / SIGDIGGER_OVERVIEW_BLOCK_SAMPLES;
+  hi = to == m_length
+      ? m_levels[0].size()
+      : to / SIGDIGGER_OVERVIEW_BLOCK_SAMPLES;
+
+  if (lo >= hi) {
+    scan(e, from, to);
+    return finishStats(e, to - from);
+  }
+
+  scan(e, from, lo * SIGDIGGER_OVERVIEW_BLOCK_SAMPLES);
+  scan(e, std::min(to, hi * SIGDIGGER_OVERVIEW_BLOCK_SAMPLES), to);
+
+  // Climb up while the remaining range is aligned to whole groups
+  for (size_t level = 0; lo < hi; ++level) {
+    auto const &entries = m_levels[level];
+
+    if (level + 1 == m_levels.size()) {
+      while (lo < hi)
+        mergeEntry(e, entries[lo++]);
+      break;
+    }
+
+    while (lo < hi && lo % SIGDIGGER_OVERVIEW_FANOUT != 0)
+      mergeEntry(e, entries[lo++]);
+
+    while (lo < hi && hi % SIGDIGGER_OVERVIEW_FANOUT != 0
+           && hi != entries.size())
+      mergeEntry(e, entries[--hi]);
+
+    if (lo >= hi)
+      break;
+
+    // hi is now either a group boundary or the end of the level
+    lo /= SIGDIGGER_OVERVIEW_FANOUT;
+    hi = (hi + SIGDIGGER_OVERVIEW_FANOUT - 1) / SIGDIGGER_OVERVIEW_FANOUT;
+  }
+
+  return finishStats(e, to - from);
+}
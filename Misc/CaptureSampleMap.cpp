@@ -0,0 +1,471 @@
+//
+//    CaptureSampleMap.cpp: Capture files mapped as complex float samples
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "CaptureSampleMap.h"
+#include <QDir>
+#include <QStandardPaths>
+#include <QStorageInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace SigDigger;
+
+static inline unsigned int
+componentSize(CaptureSampleMap::Format format)
+{
+  switch (format) {
+    case CaptureSampleMap::UNSIGNED8:
+    case CaptureSampleMap::SIGNED8:
+      return 1;
+
+    case CaptureSampleMap::SIGNED16:
+      return 2;
+
+    case CaptureSampleMap::FLOAT32:
+      return 4;
+  }
+
+  return 1;
+}
+
+//
+// Plain loops over the interleaved components, so that the compiler can
+// vectorize them. Multi-byte values are read with memcpy, as the data
+// offset in the file need not be aligned.
+//
+void
+CaptureSampleMap::convert(
+    SUCOMPLEX *dest,
+    const uint8_t *src,
+    size_t count,
+    Format format,
+    unsigned int channels)
+{
+  SUFLOAT *out = reinterpret_cast<SUFLOAT *>(dest);
+  size_t n = count * channels;
+  size_t stride = channels == 1 ? 2 : 1;
+
+  if (channels == 1)
+    std::fill(dest, dest + count, SUCOMPLEX(0, 0));
+
+  switch (format) {
+    case UNSIGNED8:
+      for (size_t i = 0; i < n; ++i)
+        out[i * stride] =
+            (static_cast<SUFLOAT>(src[i]) - 128.f) * (1.f / 128.f);
+      break;
+
+    case SIGNED8:
+      for (size_t i = 0; i < n; ++i)
+        out[i * stride] =
+            static_cast<SUFLOAT>(static_cast<int8_t>(src[i])) * (1.f / 128.f);
+      break;
+
+    case SIGNED16:
+      for (size_t i = 0; i < n; ++i) {
+        int16_t x;
+        memcpy(&x, src + 2 * i, sizeof(int16_t));
+        out[i * stride] = static_cast<SUFLOAT>(x) * (1.f / 32768.f);
+      }
+      break;
+
+    case FLOAT32:
+      for (size_t i = 0; i < n; ++i) {
+        float x;
+        memcpy(&x, src + 4 * i, sizeof(float));
+        out[i * stride] = static_cast<SUFLOAT>(x);
+      }
+      break;
+  }
+}
+
+//
+// Converted captures are 2 to 8 times larger than their source. The
+// temporary directory is often a tmpfs, so they go to the cache directory,
+// which is normally on disk.
+//
+static QString
+conversionDir()
+{
+  QString path =
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+  if (!path.isEmpty() && QDir().mkpath(path))
+    return path;
+
+  return QDir::tempPath();
+}
+
+/////////////////////////////// CaptureSampleMap ///////////////////////////////
+CaptureSampleMap::CaptureSampleMap()
+{
+}
+
+CaptureSampleMap::~CaptureSampleMap()
+{
+  this->close();
+}
+
+void
+CaptureSampleMap::close()
+{
+  if (m_tempFile) {
+    if (m_tempMap != nullptr)
+      m_tempFile->unmap(m_tempMap);
+
+    m_tempFile->remove();
+    m_tempFile.reset();
+  }
+
+  m_tempMap = nullptr;
+
+  m_converted.clear();
+  m_converted.shrink_to_fit();
+
+  if (m_map != nullptr) {
+    m_file.unmap(const_cast<uchar *>(m_map));
+    m_map = nullptr;
+  }
+
+  if (m_file.isOpen())
+    m_file.close();
+
+  m_data      = nullptr;
+  m_length    = 0;
+  m_cancelled = false;
+}
+
+bool
+CaptureSampleMap::open(
+    QString const &path,
+    Format format,
+    unsigned int channels,
+    qint64 offset,
+    qint64 size)
+{
+  size_t sampleBytes = componentSize(format) * channels;
+
+  this->close();
+
+  if (channels != 1 && channels != 2) {
+    m_lastError = "Only captures with one or two channels are supported";
+    return false;
+  }
+
+  m_file.setFileName(path);
+
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    m_lastError = m_file.errorString();
+    return false;
+  }
+
+  if (size < 0 || offset + size > m_file.size())
+    size = m_file.size() - offset;
+
+  m_length = size > 0 ? static_cast<size_t>(size) / sampleBytes : 0;
+
+  if (m_length == 0) {
+    m_lastError = "The capture file contains no samples";
+    this->close();
+    return false;
+  }
+
+  // Native samples need no conversion at all. Mappings start at a page
+  // boundary, so the alignment of the samples is that of the offset.
+  if (format == FLOAT32
+      && channels == 2
+      && sizeof(SUFLOAT) == sizeof(float)
+      && offset % static_cast<qint64>(alignof(SUCOMPLEX)) == 0) {
+    m_map = m_file.map(offset, static_cast<qint64>(m_length * sizeof(SUCOMPLEX)));
+
+    if (m_map == nullptr) {
+      m_lastError = m_file.errorString();
+      this->close();
+      return false;
+    }
+
+    m_data = reinterpret_cast<const SUCOMPLEX *>(m_map);
+    return true;
+  }
+
+  // Everything else waits for convert()
+  m_file.close();
+
+  m_path     = path;
+  m_format   = format;
+  m_channels = channels;
+  m_offset   = offset;
+
+  return true;
+}
+
+//
+// The capture is read with plain reads rather than through a mapping: a
+// file truncated meanwhile is then reported as an error, instead of
+// raising SIGBUS. Samples go either to dest or to buffer.
+//
+bool
+CaptureSampleMap::convertTo(
+    QFileDevice *dest,
+    SUCOMPLEX *buffer,
+    ProgressCallback const &progress)
+{
+  QFile src(m_path);
+  size_t sampleBytes = componentSize(m_format) * m_channels;
+  std::vector<uint8_t> input;
+  std::vector<SUCOMPLEX> output;
+  size_t count;
+
+  if (!src.open(QIODevice::ReadOnly) || !src.seek(m_offset)) {
+    m_lastError = src.errorString();
+    return false;
+  }
+
+  input.resize(SIGDIGGER_CAPTURE_MAP_CHUNK_SAMPLES * sampleBytes);
+  if (dest != nullptr)
+    output.resize(SIGDIGGER_CAPTURE_MAP_CHUNK_SAMPLES);
+
+  for (size_t done = 0; done < m_length; done += count) {
+    qint64 bytes;
+    SUCOMPLEX *out = dest != nullptr ? output.data() : buffer + done;
+
+    if (progress && !progress(done, m_length)) {
+      m_cancelled = true;
+      m_lastError = "Conversion cancelled";
+      return false;
+    }
+
+    count = std::min<size_t>(SIGDIGGER_CAPTURE_MAP_CHUNK_SAMPLES, m_length - done);
+    bytes = static_cast<qint64>(count * sampleBytes);
+
+    if (src.read(reinterpret_cast<char *>(input.data()), bytes) != bytes) {
+      m_lastError = "The capture file is shorter than expected";
+      return false;
+    }
+
+    convert(out, input.data(), count, m_format, m_channels);
+
+    if (dest != nullptr) {
+      bytes = static_cast<qint64>(count * sizeof(SUCOMPLEX));
+
+      if (dest->write(reinterpret_cast<const char *>(out), bytes) != bytes) {
+        m_lastError   = dest->errorString();
+        m_writeFailed = true;
+        return false;
+      }
+    }
+  }
+
+  if (dest != nullptr && !dest->flush()) {
+    m_lastError   = dest->errorString();
+    m_writeFailed = true;
+    return false;
+  }
+
+  if (progress)
+    progress(m_length, m_length);
+
+  return true;
+}
+
+bool
+CaptureSampleMap::convert(ProgressCallback const &progress)
+{
+  qint64 bytes = static_cast<qint64>(m_length * sizeof(SUCOMPLEX));
+
+  if (!this->needsConversion())
+    return m_data != nullptr;
+
+  m_cancelled   = false;
+  m_writeFailed = false;
+
+  // Disk first, so that large captures do not need to fit in memory
+  QString dir = conversionDir();
+
+  m_tempFile = std::make_unique<QTemporaryFile>(dir + "/sigdigger-XXXXXX.cf32");
+
+  if (QStorageInfo(dir).bytesAvailable() >= bytes && m_tempFile->open()) {
+    if (this->convertTo(m_tempFile.get(), nullptr, progress)) {
+      m_tempMap = m_tempFile->map(0, bytes);
+
+      if (m_tempMap != nullptr) {
+        m_data = reinterpret_cast<const SUCOMPLEX *>(m_tempMap);
+        return true;
+      }
+    } else if (!m_writeFailed) {
+      // Cancelled, or the capture itself could not be read
+      m_tempFile->remove();
+      m_tempFile.reset();
+      return false;
+    }
+  }
+
+  // No usable temporary file: convert into memory
+  m_tempFile->remove();
+  m_tempFile.reset();
+
+  try {
+    m_converted.resize(m_length);
+  } catch (std::bad_alloc const &) {
+    m_lastError = QString::asprintf(
+          "Not enough memory or temporary disk space to convert %zu samples",
+          m_length);
+    return false;
+  }
+
+  if (!this->convertTo(nullptr, m_converted.data(), progress)) {
+    m_converted.clear();
+    m_converted.shrink_to_fit();
+    return false;
+  }
+
+  m_data = m_converted.data();
+
+  return true;
+}
+
+bool
+CaptureSampleMap::needsConversion() const
+{
+  return m_data == nullptr && m_length > 0;
+}
+
+bool
+CaptureSampleMap::cancelled() const
+{
+  return m_cancelled;
+}
+
+bool
+CaptureSampleMap::openWav(QString const &path)
+{
+  QFile file(path);
+  QByteArray header;
+  qint64 pos = 12;
+  qint64 dataOffset = -1;
+  qint64 dataSize = -1;
+  quint16 audioFormat = 0;
+  quint16 channels = 0;
+  quint16 bits = 0;
+  quint32 rate = 0;
+  Format format;
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    m_lastError = file.errorString();
+    return false;
+  }
+
+  header = file.read(12);
+
+  if (header.size() != 12
+      || memcmp(header.data(), "RIFF", 4) != 0
+      || memcmp(header.data() + 8, "WAVE", 4) != 0) {
+    m_lastError = "Not a RIFF/WAVE file";
+    return false;
+  }
+
+  // Walk the chunk list until the data chunk
+  while (dataOffset < 0 && file.seek(pos)) {
+    QByteArray chunk = file.read(8);
+    quint32 chunkSize;
+
+    if (chunk.size() != 8)
+      break;
+
+    chunkSize = qFromLittleEndian<quint32>(chunk.data() + 4);
+
+    if (memcmp(chunk.data(), "fmt ", 4) == 0) {
+      QByteArray fmt = file.read(std::min<quint32>(chunkSize, 40));
+
+      if (fmt.size() < 16)
+        break;
+
+      audioFormat = qFromLittleEndian<quint16>(fmt.data());
+      channels    = qFromLittleEndian<quint16>(fmt.data() + 2);
+      rate        = qFromLittleEndian<quint32>(fmt.data() + 4);
+      bits        = qFromLittleEndian<quint16>(fmt.data() + 14);
+
+      // WAVE_FORMAT_EXTENSIBLE: the actual format is in the subformat GUID
+      if (audioFormat == 0xfffe && fmt.size() >= 26)
+        audioFormat = qFromLittleEndian<quint16>(fmt.data() + 24);
+    } else if (memcmp(chunk.data(), "data", 4) == 0) {
+      dataOffset = pos + 8;
+
+      // Streamed files may leave the size unset
+      if (chunkSize != 0 && chunkSize != 0xffffffff)
+        dataSize = chunkSize;
+    }
+
+    pos += 8 + chunkSize + (chunkSize & 1);
+  }
+
+  file.close();
+
+  if (dataOffset < 0 || rate == 0) {
+    m_lastError = "Malformed WAV file";
+    return false;
+  }
+
+  if (audioFormat == 1 && bits == 8)
+    format = UNSIGNED8;
+  else if (audioFormat == 1 && bits == 16)
+    format = SIGNED16;
+  else if (audioFormat == 3 && bits == 32)
+    format = FLOAT32;
+  else {
+    m_lastError = QString::asprintf(
+          "Unsupported WAV sample format (format %d, %d bits per sample)",
+          audioFormat,
+          bits);
+    return false;
+  }
+
+  if (!this->open(path, format, channels, dataOffset, dataSize))
+    return false;
+
+  m_sampleRate = rate;
+
+  return true;
+}
+
+const SUCOMPLEX *
+CaptureSampleMap::data() const
+{
+  return m_data;
+}
+
+size_t
+CaptureSampleMap::length() const
+{
+  return m_length;
+}
+
+qreal
+CaptureSampleMap::sampleRate() const
+{
+  return m_sampleRate;
+}
+
+QString
+CaptureSampleMap::lastError() const
+{
+  return m_lastError;
+}
@@ -0,0 +1,85 @@
+//
+//    DeviceHotplugMonitor.cpp: Trigger device rescans on USB hot-plug
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "DeviceHotplugMonitor.h"
+#include <QFileSystemWatcher>
+#include <QDir>
+
+using namespace SigDigger;
+
+DeviceHotplugMonitor::DeviceHotplugMonitor(QObject *parent) : QObject(parent)
+{
+  m_debounce.setSingleShot(true);
+  m_debounce.setInterval(SIGDIGGER_HOTPLUG_DEBOUNCE_MS);
+
+  connect(
+        &m_debounce,
+        SIGNAL(timeout()),
+        this,
+        SIGNAL(changed()));
+
+  if (QDir(SIGDIGGER_HOTPLUG_USB_PATH).exists()) {
+    m_watcher = new QFileSystemWatcher(this);
+
+    this->watchBuses();
+
+    connect(
+          m_watcher,
+          SIGNAL(directoryChanged(QString)),
+          this,
+          SLOT(onDirectoryChanged(QString)));
+  }
+}
+
+//
+// New devices appear inside the bus directories, and new buses (e.g. a
+// USB controller coming up) in the top directory.
+//
+void
+DeviceHotplugMonitor::watchBuses()
+{
+  QDir usb(SIGDIGGER_HOTPLUG_USB_PATH);
+  QStringList paths;
+  QStringList watched = m_watcher->directories();
+
+  paths << usb.absolutePath();
+
+  for (auto const &bus : usb.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    paths << usb.absoluteFilePath(bus);
+
+  for (auto const &path : paths)
+    if (!watched.contains(path))
+      m_watcher->addPath(path);
+}
+
+bool
+DeviceHotplugMonitor::isActive() const
+{
+  return m_watcher != nullptr;
+}
+
+////////////////////////////////// Slots ///////////////////////////////////////
+void
+DeviceHotplugMonitor::onDirectoryChanged(QString path)
+{
+  if (path == QDir(SIGDIGGER_HOTPLUG_USB_PATH).absolutePath())
+    this->watchBuses();
+
+  m_debounce.start();
+}
@@ -0,0 +1,544 @@
+//
+//    DopplerTable.cpp: Shared, precomputed Doppler tables
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "DopplerTable.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace SigDigger;
+
+static inline struct timeval
+toTimeval(double t)
+{
+  struct timeval tv;
+  double sec = std::floor(t);
+
+  tv.tv_sec  = static_cast<time_t>(sec);
+  tv.tv_usec = static_cast<suseconds_t>((t - sec) * 1e6);
+
+  return tv;
+}
+
+static inline double
+fromTimeval(struct timeval const &tv)
+{
+  return static_cast<double>(tv.tv_sec) + 1e-6 * static_cast<double>(tv.tv_usec);
+}
+
+static inline qreal
+wrapAngle(qreal angle)
+{
+  return angle - 2 * M_PI * std::floor(angle / (2 * M_PI));
+}
+
+static inline qreal
+angleDiff(qreal a, qreal b)
+{
+  return std::fabs(std::remainder(a - b, 2 * M_PI));
+}
+
+// Cubic Lagrange weights (and their derivatives) for nodes at -1, 0, 1, 2
+static inline void
+lagrangeWeights(qreal x, qreal w[4], qreal dw[4])
+{
+  qreal x2 = x * x;
+
+  w[0]  = -x * (x - 1) * (x - 2) / 6;
+  w[1]  = (x + 1) * (x - 1) * (x - 2) / 2;
+  w[2]  = -(x + 1) * x * (x - 2) / 2;
+  w[3]  = (x + 1) * x * (x - 1) / 6;
+
+  dw[0] = -(3 * x2 - 6 * x + 2) / 6;
+  dw[1] = (3 * x2 - 4 * x - 1) / 2;
+  dw[2] = -(3 * x2 - 2 * x - 2) / 2;
+  dw[3] = (3 * x2 - 1) / 6;
+}
+
+namespace {
+  class DopplerEvaluator {
+    sgdp4_prediction_t m_pred;
+    bool m_init = false;
+
+  public:
+    DopplerEvaluator(orbit_t const *orbit, xyz_t const &qth)
+    {
+      xyz_t site = qth;
+      m_init = sgdp4_prediction_init(&m_pred, orbit, &site);
+    }
+
+    ~DopplerEvaluator()
+    {
+      if (m_init)
+        sgdp4_prediction_finalize(&m_pred);
+    }
+
+    bool
+    ok() const
+    {
+      return m_init;
+    }
+
+    bool
+    operator()(double t, DopplerSample &sample)
+    {
+      struct timeval tv = toTimeval(t);
+      xyz_t azel, vAzel;
+
+      if (!sgdp4_prediction_update(&m_pred, &tv))
+        return false;
+
+      sgdp4_prediction_get_azel(&m_pred, &azel);
+      sgdp4_prediction_get_vel_azel(&m_pred, &vAzel);
+
+      sample.azimuth   = azel.azimuth;
+      sample.elevation = azel.elevation;
+      sample.range     = azel.distance;
+      sample.rangeRate = vAzel.distance;
+
+      return true;
+    }
+  };
+}
+
+/////////////////////////////// DopplerTable ///////////////////////////////////
+int
+DopplerTable::window(double t, double &x) const
+{
+  int n = static_cast<int>(m_samples.size());
+  int i;
+  double u;
+
+  if (n < 4 || !this->covers(t))
+    return -1;
+
+  u = (t - m_start) / m_step;
+  i = qBound(1, static_cast<int>(std::floor(u)), n - 3);
+  x = u - i;
+
+  return i - 1;
+}
+
+bool
+DopplerTable::build(
+    orbit_t const *orbit,
+    xyz_t const &qth,
+    double start,
+    double end,
+    qreal tolerance)
+{
+  DopplerEvaluator eval(orbit, qth);
+  std::vector<DopplerSample> mid;
+  double step;
+  int n;
+
+  m_samples.clear();
+
+  if (!eval.ok() || end <= start)
+    return false;
+
+  // At least 4 samples are needed for cubic interpolation
+  n    = std::max(
+        4,
+        static_cast<int>(std::ceil((end - start) / SIGDIGGER_DOPPLER_TABLE_STEP))
+        + 1);
+  step = (end - start) / (n - 1);
+
+  m_start = start;
+  m_step  = step;
+  m_samples.resize(static_cast<size_t>(n));
+
+  for (int i = 0; i < n; ++i) {
+    if (!eval(start + i * step, m_samples[i]))
+      return false;
+
+    if (i > 0)
+      m_samples[i].azimuth = m_samples[i - 1].azimuth
+          + std::remainder(
+            m_samples[i].azimuth - m_samples[i - 1].azimuth,
+            2 * M_PI);
+  }
+
+  for (;;) {
+    qreal err = 0, azElErr = 0;
+
+    // The interpolation error is largest around the middle of each
+    // interval. These are also the samples needed to halve the step.
+    n = static_cast<int>(m_samples.size());
+    mid.resize(static_cast<size_t>(n - 1));
+
+    for (int i = 0; i < n - 1; ++i) {
+      double t = m_start + (i + .5) * m_step;
+      qreal rate, accel;
+      xyz_t pos;
+
+      if (!eval(t, mid[i]))
+        return false;
+
+      mid[i].azimuth = m_samples[i].azimuth
+          + std::remainder(mid[i].azimuth - m_samples[i].azimuth, 2 * M_PI);
+
+      this->rangeRate(t, rate, accel);
+      this->azel(t, pos);
+
+      err     = std::max(err, std::fabs(rate - mid[i].rangeRate));
+      azElErr = std::max(
+            azElErr,
+            std::max(
+              angleDiff(pos.azimuth, mid[i].azimuth),
+              std::fabs(pos.elevation - mid[i].elevation)));
+    }
+
+    m_maxError     = err;
+    m_maxAzElError = azElErr;
+
+    if (err <= tolerance || .5 * m_step < SIGDIGGER_DOPPLER_TABLE_MIN_STEP)
+      break;
+
+    std::vector<DopplerSample> merged(static_cast<size_t>(2 * n - 1));
+
+    for (int i = 0; i < n - 1; ++i) {
+      merged[2 * i]     = m_samples[i];
+      merged[2 * i + 1] = mid[i];
+    }
+
+    merged[2 * n - 2] = m_samples[n - 1];
+
+    m_samples.swap(merged);
+    m_step *= .5;
+  }
+
+  return true;
+}
+
+bool
+DopplerTable::covers(double t) const
+{
+  return !m_samples.empty() && t >= this->start() && t <= this->end();
+}
+
+bool
+DopplerTable::covers(struct timeval const &tv) const
+{
+  return this->covers(fromTimeval(tv));
+}
+
+bool
+DopplerTable::azel(double t, xyz_t &azel) const
+{
+  qreal w[4], dw[4];
+  double x;
+  int i = this->window(t, x);
+
+  if (i < 0)
+    return false;
+
+  lagrangeWeights(x, w, dw);
+
+  azel.azimuth   = 0;
+  azel.elevation = 0;
+  azel.distance  = 0;
+
+  for (int k = 0; k < 4; ++k) {
+    DopplerSample const &s = m_samples[static_cast<size_t>(i + k)];
+    azel.azimuth   += w[k] * s.azimuth;
+    azel.elevation += w[k] * s.elevation;
+    azel.distance  += w[k] * s.range;
+  }
+
+  azel.azimuth = wrapAngle(azel.azimuth);
+
+  return true;
+}
+
+bool
+DopplerTable::rangeRate(double t, qreal &rate, qreal &accel) const
+{
+  qreal w[4], dw[4];
+  double x;
+  int i = this->window(t, x);
+
+  if (i < 0)
+    return false;
+
+  lagrangeWeights(x, w, dw);
+
+  rate  = 0;
+  accel = 0;
+
+  for (int k = 0; k < 4; ++k) {
+    qreal r = m_samples[static_cast<size_t>(i + k)].rangeRate;
+    rate  += w[k] * r;
+    accel += dw[k] * r;
+  }
+
+  accel /= m_step;
+
+  return true;
+}
+
+qreal
+DopplerTable::doppler(double t, qreal frequency) const
+{
+  qreal rate, accel;
+
+  if (!this->rangeRate(t, rate, accel))
+    return 0;
+
+  return -rate * frequency / SPEED_OF_LIGHT_KM_S;
+}
+
+qreal
+DopplerTable::dopplerRate(double t, qreal frequency) const
+{
+  qreal rate, accel;
+
+  if (!this->rangeRate(t, rate, accel))
+    return 0;
+
+  return -accel * frequency / SPEED_OF_LIGHT_KM_S;
+}
+
+qreal
+DopplerTable::maxError() const
+{
+  return m_maxError;
+}
+
+qreal
+DopplerTable::maxAzElError() const
+{
+  return m_maxAzElError;
+}
+
+qreal
+DopplerTable::maxDopplerError(qreal frequency) const
+{
+  return m_maxError * std::fabs(frequency) / SPEED_OF_LIGHT_KM_S;
+}
+
+double
+DopplerTable::start() const
+{
+  return m_start;
+}
+
+double
+DopplerTable::end() const
+{
+  return m_samples.empty()
+      ? m_start
+      : m_start + m_step * static_cast<double>(m_samples.size() - 1);
+}
+
+double
+DopplerTable::step() const
+{
+  return m_step;
+}
+
+size_t
+DopplerTable::size() const
+{
+  return m_samples.size();
+}
+
+/////////////////////////// DopplerTableService ////////////////////////////////
+DopplerTableService *DopplerTableService::m_currInstance = nullptr;
+
+DopplerTableService::DopplerTableService(QObject *parent) : QObject(parent)
+{
+}
+
+DopplerTableService *
+DopplerTableService::instance()
+{
+  if (m_currInstance == nullptr)
+    m_currInstance = new DopplerTableService();
+
+  return m_currInstance;
+}
+
+QString
+DopplerTableService::makeKey(
+    orbit_t const &orbit,
+    xyz_t const &qth,
+    double start,
+    double end)
+{
+  // Orbits typed by hand may not have a name. Include the elements that
+  // tell them apart.
+  return QString::asprintf(
+        "%s:%d:%.8f:%.8f:%.8f:%.8f:%.8f:%.6f:%.6f:%.3f:%.0f:%.0f",
+        orbit.name == nullptr ? "" : orbit.name,
+        orbit.ep_year,
+        orbit.ep_day,
+        orbit.rev,
+        orbit.ecc,
+        orbit.eqinc,
+        orbit.ascn,
+        qth.lat,
+        qth.lon,
+        qth.height,
+        std::floor(start),
+        std::ceil(end));
+}
+
+qint64
+DopplerTableService::now()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void
+DopplerTableService::store(QString const &key, DopplerTablePtr const &table)
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  Entry entry;
+
+  m_pending.remove(key);
+
+  // Failures are remembered too, or consumers polling the same key
+  // would queue the same failing build over and over
+  if (!table) {
+    qint64 t = now();
+
+    if (m_failed.size() >= SIGDIGGER_DOPPLER_TABLE_MAX_ENTRIES) {
+      for (auto p = m_failed.begin(); p != m_failed.end();)
+        if (t - p.value() >= SIGDIGGER_DOPPLER_TABLE_RETRY_MS)
+          p = m_failed.erase(p);
+        else
+          ++p;
+    }
+
+    m_failed[key] = t;
+    return;
+  }
+
+  entry.table   = table;
+  entry.lastUse = ++m_useCounter;
+  m_tables[key] = entry;
+
+  while (m_tables.size() > SIGDIGGER_DOPPLER_TABLE_MAX_ENTRIES) {
+    auto oldest = m_tables.begin();
+
+    for (auto p = m_tables.begin(); p != m_tables.end(); ++p)
+      if (p->lastUse < oldest->lastUse)
+        oldest = p;
+
+    m_tables.erase(oldest);
+  }
+}
+
+void
+DopplerTableService::work()
+{
+  for (;;) {
+    Request req;
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+
+      if (m_queue.empty()) {
+        m_running = false;
+        return;
+      }
+
+      req = m_queue.front();
+      m_queue.pop_front();
+    }
+
+    auto table = std::make_shared<DopplerTable>();
+
+    if (table->build(&req.orbit.getCOrbit(), req.qth, req.start, req.end)) {
+      this->store(req.key, table);
+      emit tableReady(req.key);
+    } else {
+      this->store(req.key, DopplerTablePtr());
+    }
+  }
+}
+
+DopplerTablePtr
+DopplerTableService::find(QString const &key)
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  auto p = m_tables.find(key);
+
+  if (p == m_tables.end())
+    return DopplerTablePtr();
+
+  p->lastUse = ++m_useCounter;
+
+  return p->table;
+}
+
+DopplerTablePtr
+DopplerTableService::request(
+    orbit_t const &orbit,
+    xyz_t const &qth,
+    struct timeval const &start,
+    struct timeval const &end,
+    QString *keyPtr)
+{
+  double t0 = fromTimeval(start);
+  double t1 = fromTimeval(end);
+  QString key = makeKey(orbit, qth, t0, t1);
+  DopplerTablePtr table = this->find(key);
+
+  if (keyPtr != nullptr)
+    *keyPtr = key;
+
+  if (!table) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto failed = m_failed.find(key);
+
+    if (failed != m_failed.end()) {
+      if (now() - failed.value() < SIGDIGGER_DOPPLER_TABLE_RETRY_MS)
+        return table;
+
+      m_failed.erase(failed);
+    }
+
+    if (!m_pending.contains(key)) {
+      Request req;
+
+      req.key   = key;
+      req.orbit = Suscan::Orbit(&orbit);
+      req.qth   = qth;
+      req.start = std::floor(t0);
+      req.end   = std::ceil(t1);
+
+      m_pending[key] = true;
+      m_queue.push_back(req);
+
+      if (!m_running) {
+        // The previous worker returned right after clearing m_running
+        if (m_worker.joinable())
+          m_worker.join();
+
+        m_running = true;
+        m_worker  = std::thread(&DopplerTableService::work, this);
+      }
+    }
+  }
+
+  return table;
+}
@@ -2,11 +2,62 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <SigDiggerHelpers.h>
+#include <CaptureSampleMap.h>
+#include <CaptureOverview.h>
 #include <TimeWindow.h>
 #include <QEventLoop>
+#include <QProgressDialog>
+#include <QTimer>
+#include <atomic>
+#include <thread>
 
 using namespace SigDigger;
 
+//
+// Converts the samples in a worker thread, while the GUI keeps running
+// and shows the progress.
+//
+static bool
+convertWithProgress(CaptureSampleMap &view)
+{
+  QProgressDialog dialog("Converting samples to complex float...", "Cancel", 0, 1000);
+  QEventLoop loop;
+  QTimer timer;
+  std::atomic<int> permille(0);
+  std::atomic<bool> cancel(false);
+  std::atomic<bool> done(false);
+  bool ok = false;
+
+  dialog.setWindowTitle("Opening capture file");
+  dialog.setWindowModality(Qt::ApplicationModal);
+  dialog.setMinimumDuration(500);
+
+  std::thread worker([&] () {
+    ok = view.convert([&] (size_t converted, size_t total) {
+      permille = static_cast<int>(
+            1000. * static_cast<qreal>(converted) / static_cast<qreal>(total));
+      return !cancel;
+    });
+    done = true;
+  });
+
+  QObject::connect(&timer, &QTimer::timeout, [&] () {
+    dialog.setValue(permille);
+
+    if (dialog.wasCanceled())
+      cancel = true;
+
+    if (done)
+      loop.quit();
+  });
+
+  timer.start(50);
+  loop.exec();
+  worker.join();
+
+  return ok;
+}
+
 FileViewer::FileViewer(QObject *parent)
   : QObject{parent}
 {
@@ -54,53 +105,97 @@ FileViewer::processFile(QString path)
     return;
   }
 
-  if (!(meta.guessed & SUSCAN_SOURCE_CONFIG_GUESS_FORMAT)
-      || meta.format != SUSCAN_SOURCE_FORMAT_RAW_FLOAT32) {
+  CaptureSampleMap view;
+  QString tag;
+  bool opened = false;
+  qreal fs;
+
+  if (!(meta.guessed & SUSCAN_SOURCE_CONFIG_GUESS_FORMAT)) {
     QMessageBox::warning(
           nullptr,
           "Unsupported file format",
-          "The selected file has been recognized, but its storage format is not float32. "
-          "FileViewer currently relies on memory-mapped files to display large files, "
-          "and non-native sample formats cannot be converted on the go.");
+          "The selected file has been recognized, but its sample format could not "
+          "be determined.");
     return;
   }
 
-  if (!(meta.guessed & SUSCAN_SOURCE_CONFIG_GUESS_SAMP_RATE)) {
-    QMessageBox::warning(
-          nullptr,
-          "Unsupported file format",
-          "The selected file has been recognized, but some parameters are undefined. "
-          "Capture files need their sample format and rate to be defined prior processing.");
-    return;
+  // Non-float32 samples are converted after opening, with progress
+  switch (meta.format) {
+    case SUSCAN_SOURCE_FORMAT_RAW_FLOAT32:
+      opened = view.open(path, CaptureSampleMap::FLOAT32);
+      tag    = "cf32";
+      break;
+
+    case SUSCAN_SOURCE_FORMAT_RAW_UNSIGNED8:
+      opened = view.open(path, CaptureSampleMap::UNSIGNED8);
+      tag    = "cu8";
+      break;
+
+    case SUSCAN_SOURCE_FORMAT_RAW_SIGNED8:
+      opened = view.open(path, CaptureSampleMap::SIGNED8);
+      tag    = "cs8";
+      break;
+
+    case SUSCAN_SOURCE_FORMAT_RAW_SIGNED16:
+      opened = view.open(path, CaptureSampleMap::SIGNED16);
+      tag    = "cs16";
+      break;
+
+    case SUSCAN_SOURCE_FORMAT_WAV:
+      opened = view.openWav(path);
+      tag    = "wav";
+      break;
+
+    default:
+      QMessageBox::warning(
+            nullptr,
+            "Unsupported file format",
+            "The selected file has been recognized, but its storage format is not "
+            "supported by FileViewer. Only raw float32, uint8, int8 and int16 "
+            "captures and WAV files can be displayed.");
+      return;
   }
 
-  QFile file(path);
+  if (opened && view.needsConversion())
+    opened = convertWithProgress(view);
 
-  if (!file.open(QIODevice::ReadOnly)) {
-    QMessageBox::critical(
-          nullptr,
-          "Failed to open file",
-          "The selected file could not be opened. " + file.errorString());
+  if (!opened) {
+    if (!view.cancelled())
+      QMessageBox::critical(
+            nullptr,
+            "Failed to open file",
+            "The selected file could not be opened. " + view.lastError());
     return;
   }
 
-  const SUCOMPLEX *data = reinterpret_cast<SUCOMPLEX *>(file.map(
-        0,
-        file.size()));
+  if (meta.guessed & SUSCAN_SOURCE_CONFIG_GUESS_SAMP_RATE)
+    fs = meta.sample_rate;
+  else
+    fs = view.sampleRate();
 
-  if (data == nullptr) {
-    QMessageBox::critical(
+  if (fs <= 0) {
+    QMessageBox::warning(
           nullptr,
-          "Failed to map file",
-          "The selected file could not be mapper. " + file.errorString());
+          "Unsupported file format",
+          "The selected file has been recognized, but some parameters are undefined. "
+          "Capture files need their sample format and rate to be defined prior processing.");
     return;
   }
 
+  // Must go after the view, as it reads from it until destroyed
+  CaptureOverview overview(view.data(), view.length());
   TimeWindow *window = new TimeWindow;
 
   window->postLoadInit();
 
-  window->setData(data, file.size() / sizeof(SUCOMPLEX), meta.sample_rate, meta.sample_rate);
+  window->setData(view.data(), view.length(), fs, fs);
+
+  if (view.length() >= SIGDIGGER_OVERVIEW_MIN_SAMPLES) {
+    if (!overview.load(path, tag))
+      overview.buildInBackground(path, tag);
+
+    window->setOverview(&overview);
+  }
 
   if (meta.guessed & SUSCAN_SOURCE_CONFIG_GUESS_FREQ)
     window->setCenterFreq(meta.frequency);
@@ -117,6 +212,12 @@ FileViewer::processFile(QString path)
 
   loop.exec();
 
+  // Nothing may read the samples once view goes out of scope. Queued
+  // ready() signals may still arrive, so the window is detached too.
+  overview.cancel();
+  overview.disconnect();
+  window->setOverview(nullptr);
+  window->setData(nullptr, 0, fs, fs);
   window->deleteLater();
 }
 
@@ -171,6 +171,15 @@ GenericDataSaver::~GenericDataSaver()
     QMutexLocker locker(&this->dataMutex);
     this->writer->close();
   }
+
+  if (this->ownsWriter)
+    delete this->writer;
+}
+
+void
+GenericDataSaver::setWriterOwnership(bool owns)
+{
+  this->ownsWriter = owns;
 }
 
 // Protected by mutex
@@ -0,0 +1,176 @@
+//
+//    PSDRateController.cpp: Keep the spectrum stream within the link capacity
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "PSDRateController.h"
+#include <cmath>
+
+using namespace SigDigger;
+
+void
+PSDRateController::setTarget(double interval, unsigned int size)
+{
+  m_targetInterval = interval;
+  m_targetSize     = size;
+  m_recoverTime    = SIGDIGGER_PSD_RATE_RECOVER_TIME;
+
+  reset();
+}
+
+void
+PSDRateController::reset()
+{
+  m_interval       = m_targetInterval;
+  m_size           = m_targetSize;
+  m_lastChange     = -1;
+  m_relaxedSince   = -1;
+  m_saturated      = 0;
+  m_lastWasRecover = false;
+}
+
+bool
+PSDRateController::degrade()
+{
+  double maxInterval = 1. / SIGDIGGER_PSD_RATE_MIN_RATE;
+
+  if (m_interval < maxInterval) {
+    m_interval *= SIGDIGGER_PSD_RATE_STEP;
+    if (m_interval > maxInterval)
+      m_interval = maxInterval;
+    return true;
+  }
+
+  if (m_size > SIGDIGGER_PSD_RATE_MIN_FFT_SIZE) {
+    m_size >>= 1;
+    return true;
+  }
+
+  return false;
+}
+
+bool
+PSDRateController::recover()
+{
+  if (m_size < m_targetSize) {
+    m_size <<= 1;
+    if (m_size > m_targetSize)
+      m_size = m_targetSize;
+    return true;
+  }
+
+  if (m_interval > m_targetInterval) {
+    m_interval /= SIGDIGGER_PSD_RATE_STEP;
+    if (m_interval < m_targetInterval)
+      m_interval = m_targetInterval;
+    return true;
+  }
+
+  return false;
+}
+
+bool
+PSDRateController::feed(double now, double lag, double latency, double ttl)
+{
+  bool saturated, relaxed;
+  bool changed = false;
+
+  // Measurements are low-pass filtered: give them time to reflect the change
+  if (m_lastChange >= 0 && now - m_lastChange < SIGDIGGER_PSD_RATE_SETTLE_TIME)
+    return false;
+
+  saturated = lag > SIGDIGGER_PSD_RATE_DEGRADE_LAG || latency > ttl;
+  relaxed   = lag < SIGDIGGER_PSD_RATE_RECOVER_LAG
+      && latency < SIGDIGGER_PSD_RATE_RECOVER_TTL * ttl;
+
+  if (saturated) {
+    m_relaxedSince = -1;
+
+    if (++m_saturated >= SIGDIGGER_PSD_RATE_DEGRADE_COUNT) {
+      m_saturated = 0;
+
+      if (degrade()) {
+        // The last recovery was premature. Be more patient next time.
+        if (m_lastWasRecover) {
+          m_recoverTime *= 2;
+          if (m_recoverTime > SIGDIGGER_PSD_RATE_MAX_RECOVER_TIME)
+            m_recoverTime = SIGDIGGER_PSD_RATE_MAX_RECOVER_TIME;
+        }
+
+        m_lastWasRecover = false;
+        changed = true;
+      }
+    }
+  } else {
+    m_saturated = 0;
+
+    if (!relaxed || !isEngaged()) {
+      m_relaxedSince = -1;
+    } else if (m_relaxedSince < 0) {
+      m_relaxedSince = now;
+    } else if (now - m_relaxedSince >= m_recoverTime) {
+      m_relaxedSince = -1;
+
+      if (recover()) {
+        m_lastWasRecover = true;
+        changed = true;
+      }
+    }
+  }
+
+  if (changed)
+    m_lastChange = now;
+
+  return changed;
+}
+
+bool
+PSDRateController::isEngaged() const
+{
+  return m_size != m_targetSize
+      || std::fabs(m_interval - m_targetInterval) > 1e-9;
+}
+
+bool
+PSDRateController::isEffective(double interval, unsigned int size) const
+{
+  return size == m_size && std::fabs(interval - m_interval) < 1e-5;
+}
+
+double
+PSDRateController::interval() const
+{
+  return m_interval;
+}
+
+unsigned int
+PSDRateController::fftSize() const
+{
+  return m_size;
+}
+
+double
+PSDRateController::targetInterval() const
+{
+  return m_targetInterval;
+}
+
+unsigned int
+PSDRateController::targetFftSize() const
+{
+  return m_targetSize;
+}
@@ -0,0 +1,208 @@
+//
+//    RMSFeed.cpp: Power measurements received from a remote data logger
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include "RMSFeed.h"
+#include <algorithm>
+
+using namespace SigDigger;
+
+//////////////////////////// RMSDecimatedBuffer ////////////////////////////////
+RMSDecimatedBuffer::RMSDecimatedBuffer()
+{
+  m_buckets.reserve(RMS_FEED_SUMMARY_BUCKETS);
+}
+
+void
+RMSDecimatedBuffer::clear()
+{
+  m_buckets.clear();
+  m_span  = 1;
+  m_count = 0;
+}
+
+void
+RMSDecimatedBuffer::compact()
+{
+  size_t half = m_buckets.size() / 2;
+
+  for (size_t i = 0; i < half; ++i) {
+    RMSHistoryBucket const &a = m_buckets[2 * i];
+    RMSHistoryBucket const &b = m_buckets[2 * i + 1];
+
+    m_buckets[i].min  = std::min(a.min, b.min);
+    m_buckets[i].max  = std::max(a.max, b.max);
+    m_buckets[i].mean = .5f * (a.mean + b.mean);
+  }
+
+  m_buckets.resize(half);
+  m_span *= 2;
+}
+
+void
+RMSDecimatedBuffer::append(float value)
+{
+  if (m_count == 0) {
+    // Make room before starting a new bucket, so that it is accumulated
+    // at the span of the buckets it will live with.
+    if (m_buckets.size() == RMS_FEED_SUMMARY_BUCKETS)
+      compact();
+
+    m_min = m_max = value;
+    m_sum = 0;
+  } else {
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  m_sum += value;
+
+  if (++m_count < m_span)
+    return;
+
+  m_buckets.push_back({m_min, m_max, static_cast<float>(m_sum / m_count)});
+  m_count = 0;
+}
+
+size_t
+RMSDecimatedBuffer::span() const
+{
+  return m_span;
+}
+
+std::vector<RMSHistoryBucket> const &
+RMSDecimatedBuffer::buckets() const
+{
+  return m_buckets;
+}
+
+///////////////////////////////// RMSFeed //////////////////////////////////////
+void
+RMSFeed::onTitle(const char *title, size_t len)
+{
+  m_title.assign(title, len);
+}
+
+void
+RMSFeed::onRate(double rate)
+{
+  m_stats.rate = rate;
+}
+
+void
+RMSFeed::onSample(double timeStamp, double mag)
+{
+  float value = static_cast<float>(mag);
+
+  m_summary.append(value);
+
+  ++m_stats.samples;
+  m_stats.last          = value;
+  m_stats.lastTimeStamp = timeStamp;
+
+  if (m_detailed) {
+    if (m_pending.size() < RMS_FEED_MAX_PENDING)
+      m_pending.push_back({timeStamp, value});
+    else
+      ++m_stats.dropped;
+  }
+}
+
+bool
+RMSFeed::ingest(const char *data, size_t size)
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  uint64_t errors = m_parser.errors();
+  bool ok;
+
+  m_stats.bytes += size;
+  ok = m_parser.feed(data, size, this);
+  m_stats.errors += m_parser.errors() - errors;
+
+  return ok;
+}
+
+void
+RMSFeed::setPeer(std::string const &peer)
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  m_peer = peer;
+}
+
+void
+RMSFeed::setClosed()
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  m_stats.closed = true;
+}
+
+std::string
+RMSFeed::peer() const
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  return m_peer;
+}
+
+std::string
+RMSFeed::title() const
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  return m_title;
+}
+
+RMSFeedStats
+RMSFeed::stats() const
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  RMSFeedStats stats = m_stats;
+
+  stats.backlog = m_pending.size();
+
+  return stats;
+}
+
+size_t
+RMSFeed::summary(std::vector<RMSHistoryBucket> &buckets) const
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+
+  buckets = m_summary.buckets();
+
+  return m_summary.span();
+}
+
+void
+RMSFeed::setDetailed(bool detailed)
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+
+  m_detailed = detailed;
+  if (!detailed)
+    m_pending.clear();
+}
+
+bool
+RMSFeed::take(std::vector<RMSFeedSample> &samples)
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+
+  // Swap buffers so that neither side reallocates in steady state
+  samples.clear();
+  samples.swap(m_pending);
+
+  return !samples.empty();
+}
@@ -0,0 +1,228 @@
+//
+//    RMSHistory.cpp: Multi-resolution store of power measurements
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include "RMSHistory.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace SigDigger;
+
+RMSHistory::RMSHistory()
+{
+}
+
+RMSHistory::~RMSHistory()
+{
+  if (m_spillFile != nullptr)
+    fclose(m_spillFile);
+}
+
+void
+RMSHistory::clear()
+{
+  if (m_spillFile != nullptr) {
+    fclose(m_spillFile);
+    m_spillFile = nullptr;
+  }
+
+  m_samples.clear();
+  m_levels.clear();
+  m_spilled     = 0;
+  m_spillFailed = false;
+  m_min = m_max = m_last = 0;
+}
+
+void
+RMSHistory::feedLevel(size_t n, float min, float max, float mean)
+{
+  RMSHistoryBucket bucket;
+
+  if (n == m_levels.size())
+    m_levels.resize(n + 1);
+
+  Level &level = m_levels[n];
+
+  if (level.count == 0) {
+    level.min = min;
+    level.max = max;
+    level.sum = 0;
+  } else {
+    level.min = std::min(level.min, min);
+    level.max = std::max(level.max, max);
+  }
+
+  level.sum += mean;
+
+  if (++level.count < RMS_HISTORY_DECIMATION)
+    return;
+
+  bucket.min  = level.min;
+  bucket.max  = level.max;
+  bucket.mean = static_cast<float>(level.sum / RMS_HISTORY_DECIMATION);
+
+  if (level.buckets.empty()) {
+    level.meanMin = level.meanMax = bucket.mean;
+  } else {
+    level.meanMin = std::min(level.meanMin, bucket.mean);
+    level.meanMax = std::max(level.meanMax, bucket.mean);
+  }
+
+  level.buckets.push_back(bucket);
+  level.count = 0;
+
+  // May reallocate m_levels: `level' is not used past this point
+  feedLevel(n + 1, bucket.min, bucket.max, bucket.mean);
+}
+
+void
+RMSHistory::spill()
+{
+  if (m_spillFile == nullptr) {
+    m_spillFile = tmpfile();
+    if (m_spillFile == nullptr) {
+      m_spillFailed = true;
+      return;
+    }
+  }
+
+  if (fseek(m_spillFile, 0, SEEK_END) != 0
+      || fwrite(
+        m_samples.data(),
+        sizeof(float),
+        RMS_HISTORY_SPILL_CHUNK,
+        m_spillFile) != RMS_HISTORY_SPILL_CHUNK) {
+    // Keep everything in memory from now on
+    m_spillFailed = true;
+    return;
+  }
+
+  m_samples.erase(
+        m_samples.begin(),
+        m_samples.begin() + RMS_HISTORY_SPILL_CHUNK);
+  m_spilled += RMS_HISTORY_SPILL_CHUNK;
+}
+
+void
+RMSHistory::append(float value)
+{
+  if (size() == 0) {
+    m_min = m_max = value;
+  } else {
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  m_last = value;
+  m_samples.push_back(value);
+
+  if (!m_spillFailed
+      && m_samples.size()
+      >= RMS_HISTORY_MEMORY_SAMPLES + RMS_HISTORY_SPILL_CHUNK)
+    spill();
+
+  feedLevel(0, value, value, value);
+}
+
+size_t
+RMSHistory::size() const
+{
+  return m_spilled + m_samples.size();
+}
+
+size_t
+RMSHistory::size(unsigned int level) const
+{
+  if (level == 0)
+    return size();
+
+  if (level - 1 < m_levels.size())
+    return m_levels[level - 1].buckets.size();
+
+  return 0;
+}
+
+unsigned int
+RMSHistory::levels() const
+{
+  return 1 + static_cast<unsigned int>(m_levels.size());
+}
+
+float
+RMSHistory::last() const
+{
+  return m_last;
+}
+
+RMSHistoryBucket const &
+RMSHistory::bucket(unsigned int level, size_t index) const
+{
+  return m_levels[level - 1].buckets[index];
+}
+
+bool
+RMSHistory::extrema(unsigned int level, float &min, float &max) const
+{
+  if (size(level) == 0)
+    return false;
+
+  if (level == 0) {
+    min = m_min;
+    max = m_max;
+  } else {
+    min = m_levels[level - 1].meanMin;
+    max = m_levels[level - 1].meanMax;
+  }
+
+  return true;
+}
+
+size_t
+RMSHistory::read(size_t offset, float *out, size_t count) const
+{
+  size_t total = size();
+  size_t done = 0;
+
+  if (offset >= total)
+    return 0;
+
+  count = std::min(count, total - offset);
+
+  if (offset < m_spilled) {
+    size_t chunk = std::min(count, m_spilled - offset);
+
+    if (fseek(
+          m_spillFile,
+          static_cast<long>(offset * sizeof(float)),
+          SEEK_SET) != 0)
+      return 0;
+
+    if (fread(out, sizeof(float), chunk, m_spillFile) != chunk)
+      return 0;
+
+    done   += chunk;
+    offset += chunk;
+  }
+
+  if (done < count)
+    memcpy(
+          out + done,
+          m_samples.data() + (offset - m_spilled),
+          (count - done) * sizeof(float));
+
+  return count;
+}
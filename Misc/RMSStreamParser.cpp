@@ -0,0 +1,306 @@
+//
+//    RMSStreamParser.cpp: Parse power measurement streams
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include "RMSStreamParser.h"
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+
+using namespace SigDigger;
+
+#define RMS_STREAM_PARSER_MAX_FIELDS 4
+#define RMS_STREAM_PARSER_MAX_NUMBER 64
+
+RMSStreamListener::~RMSStreamListener()
+{
+}
+
+static inline void
+trim(const char *&b, const char *&e)
+{
+  while (b < e && (*b == ' ' || *b == '\t'))
+    ++b;
+  while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'))
+    --e;
+
+  // from_chars does not accept an explicit plus sign
+  if (b < e && *b == '+')
+    ++b;
+}
+
+static bool
+parseInteger(const char *b, const char *e, long &value)
+{
+  trim(b, e);
+
+  auto result = std::from_chars(b, e, value);
+
+  return result.ec == std::errc() && result.ptr == e;
+}
+
+static bool
+parseReal(const char *b, const char *e, double &value)
+{
+  trim(b, e);
+
+#if defined(__cpp_lib_to_chars)
+  auto result = std::from_chars(b, e, value);
+
+  return result.ec == std::errc() && result.ptr == e;
+#else
+  // No floating point from_chars in this standard library. strtod needs
+  // a terminated string, which we build on the stack.
+  char buf[RMS_STREAM_PARSER_MAX_NUMBER];
+  size_t len = static_cast<size_t>(e - b);
+  char *end;
+
+  if (len == 0 || len >= sizeof(buf))
+    return false;
+
+  memcpy(buf, b, len);
+  buf[len] = '\0';
+
+  value = strtod(buf, &end);
+
+  return end == buf + len;
+#endif
+}
+
+template<typename T>
+static inline T
+readLE(const uint8_t *p)
+{
+  T value = 0;
+
+  for (size_t i = 0; i < sizeof(T); ++i)
+    value |= static_cast<T>(p[i]) << (8 * i);
+
+  return value;
+}
+
+bool
+RMSStreamParser::parseLine(
+    const char *line,
+    size_t len,
+    RMSStreamListener *listener)
+{
+  const char *b[RMS_STREAM_PARSER_MAX_FIELDS];
+  const char *e[RMS_STREAM_PARSER_MAX_FIELDS];
+  const char *end = line + len;
+  const char *p = line;
+  unsigned int fields = 0;
+
+  // Description line allows commas and stuff
+  if (len >= 5 && memcmp(line, "DESC,", 5) == 0) {
+    const char *title = line + 5;
+    while (end > title && end[-1] == '\r')
+      --end;
+    listener->onTitle(title, static_cast<size_t>(end - title));
+    return true;
+  }
+
+  for (;;) {
+    const char *comma = static_cast<const char *>(
+          memchr(p, ',', static_cast<size_t>(end - p)));
+
+    if (fields == RMS_STREAM_PARSER_MAX_FIELDS)
+      return false;
+
+    b[fields] = p;
+    e[fields] = comma != nullptr ? comma : end;
+    ++fields;
+
+    if (comma == nullptr)
+      break;
+
+    p = comma + 1;
+  }
+
+  if (fields == 2) {
+    double rate;
+
+    if (static_cast<size_t>(e[0] - b[0]) != 4 || memcmp(b[0], "RATE", 4) != 0)
+      return false;
+
+    if (!parseReal(b[1], e[1], rate))
+      return false;
+
+    listener->onRate(rate);
+
+    return true;
+  } else if (fields == 4) {
+    long   sec;
+    double usec, mag, db;
+
+    if (!parseInteger(b[0], e[0], sec))
+      return false;
+    if (!parseReal(b[1], e[1], usec))
+      return false;
+    if (!parseReal(b[2], e[2], mag))
+      return false;
+    if (!parseReal(b[3], e[3], db))
+      return false;
+
+    listener->onSample(static_cast<double>(sec) + usec, mag);
+
+    return true;
+  }
+
+  return false;
+}
+
+bool
+RMSStreamParser::handleLine(
+    const char *line,
+    size_t len,
+    RMSStreamListener *listener)
+{
+  if (len > 0 && line[len - 1] == '\r')
+    --len;
+
+  if (len == 6 && memcmp(line, "BINARY", 6) == 0) {
+    m_binary = true;
+    return true;
+  }
+
+  if (parseLine(line, len, listener)) {
+    ++m_records;
+    return true;
+  }
+
+  ++m_errors;
+  return false;
+}
+
+void
+RMSStreamParser::handleRecord(
+    const uint8_t *record,
+    RMSStreamListener *listener)
+{
+  uint64_t tsBits  = readLE<uint64_t>(record);
+  uint32_t magBits = readLE<uint32_t>(record + 8);
+  double   timeStamp;
+  float    mag;
+
+  memcpy(&timeStamp, &tsBits, sizeof(double));
+  memcpy(&mag, &magBits, sizeof(float));
+
+  listener->onSample(timeStamp, static_cast<double>(mag));
+  ++m_records;
+}
+
+bool
+RMSStreamParser::feed(
+    const char *data,
+    size_t len,
+    RMSStreamListener *listener)
+{
+  const char *p = data;
+  const char *end = data + len;
+
+  while (p < end) {
+    if (m_binary) {
+      const uint8_t *u = reinterpret_cast<const uint8_t *>(p);
+      size_t avail = static_cast<size_t>(end - p);
+
+      // Complete a record split across blocks
+      if (m_recordLen > 0) {
+        size_t chunk = RMS_STREAM_PARSER_BINARY_RECORD - m_recordLen;
+        if (chunk > avail)
+          chunk = avail;
+
+        memcpy(m_record + m_recordLen, u, chunk);
+        m_recordLen += chunk;
+        u     += chunk;
+        avail -= chunk;
+
+        if (m_recordLen < RMS_STREAM_PARSER_BINARY_RECORD)
+          break;
+
+        handleRecord(m_record, listener);
+        m_recordLen = 0;
+      }
+
+      while (avail >= RMS_STREAM_PARSER_BINARY_RECORD) {
+        handleRecord(u, listener);
+        u     += RMS_STREAM_PARSER_BINARY_RECORD;
+        avail -= RMS_STREAM_PARSER_BINARY_RECORD;
+      }
+
+      memcpy(m_record, u, avail);
+      m_recordLen = avail;
+      break;
+    } else {
+      size_t avail = static_cast<size_t>(end - p);
+      const char *nl = static_cast<const char *>(memchr(p, '\n', avail));
+      size_t chunk = nl != nullptr ? static_cast<size_t>(nl - p) : avail;
+
+      if (m_lineLen + chunk >= RMS_STREAM_PARSER_MAX_LINE_SIZE) {
+        m_lineLen = 0;
+        return false;
+      }
+
+      if (nl == nullptr) {
+        // Incomplete line: keep it for the next block
+        memcpy(m_line + m_lineLen, p, chunk);
+        m_lineLen += chunk;
+        break;
+      }
+
+      if (m_lineLen > 0) {
+        memcpy(m_line + m_lineLen, p, chunk);
+        handleLine(m_line, m_lineLen + chunk, listener);
+        m_lineLen = 0;
+      } else {
+        handleLine(p, chunk, listener);
+      }
+
+      p = nl + 1;
+    }
+  }
+
+  return true;
+}
+
+void
+RMSStreamParser::reset()
+{
+  m_lineLen   = 0;
+  m_recordLen = 0;
+  m_binary    = false;
+  m_records   = 0;
+  m_errors    = 0;
+}
+
+bool
+RMSStreamParser::binary() const
+{
+  return m_binary;
+}
+
+uint64_t
+RMSStreamParser::records() const
+{
+  return m_records;
+}
+
+uint64_t
+RMSStreamParser::errors() const
+{
+  return m_errors;
+}
@@ -19,6 +19,7 @@
 
 #include "SNREstimator.h"
 #include <cstdio>
+#include <algorithm>
 
 using namespace SigDigger;
 
@@ -37,6 +38,11 @@ SNREstimator::recalculateModel(void)
     float intlen, start;
     float sigma2 = this->sigma * this->sigma;
 
+    if (this->modelSigma == this->sigma
+        && this->modelIntervals == this->intervals
+        && this->modelLength == this->length)
+      return;
+
     // Step 1: compute gaussian
     for (i = 0; i < this->length; ++i) {
       x = i * this->hx;
@@ -46,23 +52,59 @@ SNREstimator::recalculateModel(void)
       this->gaussian[i] = expf(-x * x / sigma2);
     }
 
-    // Step 2: Repeat in through the whole interval, N times
+    // Step 2: Repeat in through the whole interval, N times. This is the
+    // circular convolution of the gaussian against a comb of N evenly
+    // spaced deltas (linearly interpolated between bins).
     intlen = 1.f  / this->intervals;
     start = .5f * intlen;
 
-    std::fill(this->Hi.begin(), this->Hi.end(), 0.f);
-
-    for (j = 0; j < this->intervals; ++j) {
-      float skip = start + j * intlen;
-      float t = 1.f - (skip - floorf(skip));
-      unsigned int skipint = static_cast<unsigned>(floorf(this->length * skip));
+    if (this->length % this->intervals == 0) {
+      // The comb period is an integer number of bins: fold the gaussian
+      // into a single period and replicate it. O(length) instead of
+      // O(length * intervals).
+      unsigned int period = this->length / this->intervals;
+      float pos = start * this->length;
+      unsigned int skipint = static_cast<unsigned>(floorf(pos));
+      float t = 1.f - (pos - skipint);
       unsigned int i1, i2;
+
+      this->folded.resize(period);
+      std::copy(
+            this->gaussian.begin(),
+            this->gaussian.begin() + period,
+            this->folded.begin());
+
+      for (j = 1; j < this->intervals; ++j) {
+        const float *g = this->gaussian.data() + j * period;
+        float *f = this->folded.data();
+        for (i = 0; i < period; ++i)
+          f[i] += g[i];
+      }
+
+      i1 = (period - skipint % period) % period;
       for (i = 0; i < this->length; ++i) {
-        i1 = static_cast<unsigned>(this->length + i - skipint) % this->length;
-        i2 = static_cast<unsigned>(this->length + i1 - 1) % this->length;
+        i2 = i1 == 0 ? period - 1 : i1 - 1;
+
+        this->Hi[i] = t * this->folded[i1] + (1 - t) * this->folded[i2];
+
+        if (++i1 == period)
+          i1 = 0;
+      }
+    } else {
+      std::fill(this->Hi.begin(), this->Hi.end(), 0.f);
 
-        this->Hi[i] += t * this->gaussian[i1];
-        this->Hi[i] += (1 - t) * this->gaussian[i2];
+      for (j = 0; j < this->intervals; ++j) {
+        float pos = (start + j * intlen) * this->length;
+        unsigned int skipint = static_cast<unsigned>(floorf(pos));
+        float t = 1.f - (pos - skipint);
+        unsigned int i1, i2;
+        for (i = 0; i < this->length; ++i) {
+          i1 = static_cast<unsigned>(this->length + i - skipint) % this->length;
+          i2 = static_cast<unsigned>(this->length + i1 - 1) % this->length;
+
+          this->Hi[i] += t * this->gaussian[i1];
+          this->Hi[i] += (1 - t) * this->gaussian[i2];
+        }
       }
     }
 
@@ -71,46 +113,71 @@ SNREstimator::recalculateModel(void)
       if (this->Hi[i] > max)
         max = this->Hi[i];
 
-    if (max > 0.f)
+    if (max > 0.f) {
+      float k = 1.f / max;
       for (i = 0; i < this->length; ++i)
-        this->Hi[i] /= max;
+        this->Hi[i] *= k;
+    }
+
+    this->modelSigma     = this->sigma;
+    this->modelIntervals = this->intervals;
+    this->modelLength    = this->length;
   }
 }
 
+void
+SNREstimator::recalculateWeights(void)
+{
+  if (this->weightIntervals == this->intervals
+      && this->weightLength == this->length)
+    return;
+
+  // The gradient weight of each bin is the sum of the squared distances
+  // to every interval center c_j = (j + 1/2) / N. This sum has a closed
+  // form:
+  //
+  //   sum_j (x - c_j)^2 = N x^2 - N x + (4N^2 - 1) / (12N)
+  //
+  // and it only depends on the histogram length and the number of
+  // intervals, so we compute it once.
+
+  double N = this->intervals;
+  double c2 = (4. * N * N - 1.) / (12. * N);
+  double x;
+
+  this->weights.resize(this->length);
+
+  for (unsigned int i = 0; i < this->length; ++i) {
+    x = static_cast<double>(i) / this->length;
+    if (x >= .5)
+      x -= 1.;
+
+    this->weights[i] = static_cast<float>(N * x * x - N * x + c2);
+  }
+
+  this->weightIntervals = this->intervals;
+  this->weightLength    = this->length;
+}
+
 void
 SNREstimator::iterate()
 {
   if (this->length > 0 && this->intervals > 0) {
-    float delta = 0, x;
-    float term;
-    unsigned int i, j;
-    float intlen, start;
-    float skip;
-    float sigmainv = 1.f / this->sigma;
-    float sigma3inv = sigmainv * sigmainv * sigmainv;
+    float delta = 0;
+    float sigma3 = this->sigma * this->sigma * this->sigma;
+    const float *w, *hi, *ht;
 
     this->recalculateModel();
+    this->recalculateWeights();
 
-    intlen = 1.f  / this->intervals;
-    start = .5f * intlen;
+    w  = this->weights.data();
+    hi = this->Hi.data();
+    ht = this->Htilde.data();
 
-    for (i = 0; i < this->length; ++i) {
-      x = i * this->hx;
-      if (x >= .5f)
-        x -= 1.f;
-
-      term = 0;
-      for (j = 0; j < this->intervals; ++j) {
-        skip = start + j * intlen;
-        term += (x - skip) * (x - skip);
-      }
-
-      term *= (this->Hi[i] - this->Htilde[i]) / sigma3inv;
-
-      delta += term;
-    }
+    for (unsigned int i = 0; i < this->length; ++i)
+      delta += w[i] * (hi[i] - ht[i]);
 
-    this->delta = delta / this->length;
+    this->delta = delta * sigma3 / this->length;
     this->sigma += -this->alpha * this->delta;
     this->dirty = true;
   }
@@ -162,8 +229,9 @@ SNREstimator::feed(std::vector<unsigned int> const &history)
   if (max == 0)
     max = 1;
 
+  float k = 1.f / max;
   for (unsigned int i = 0; i < history.size(); ++i)
-    this->Htilde[i] = static_cast<float>(history[i]) / max;
+    this->Htilde[i] = static_cast<float>(history[i]) * k;
 
   this->iterate();
 }
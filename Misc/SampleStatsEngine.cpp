@@ -0,0 +1,424 @@
+//
+//    SampleStatsEngine.cpp: Background statistics of sample ranges
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SampleStatsEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace SigDigger;
+
+// Samples added in plain double precision before compensating
+#define SIGDIGGER_STATS_BLOCK_SAMPLES 4096
+
+namespace {
+  // Neumaier's variant of Kahan summation
+  struct CompensatedSum {
+    double sum = 0;
+    double c = 0;
+
+    void
+    add(double x)
+    {
+      double t = sum + x;
+
+      if (std::fabs(sum) >= std::fabs(x))
+        c += (sum - t) + x;
+      else
+        c += (x - t) + sum;
+
+      sum = t;
+    }
+
+    void
+    add(CompensatedSum const &other)
+    {
+      add(other.sum);
+      add(other.c);
+    }
+
+    double
+    value() const
+    {
+      return sum + c;
+    }
+  };
+
+  struct PartialStats {
+    SUFLOAT minI = +std::numeric_limits<SUFLOAT>::infinity();
+    SUFLOAT maxI = -std::numeric_limits<SUFLOAT>::infinity();
+    SUFLOAT minQ = +std::numeric_limits<SUFLOAT>::infinity();
+    SUFLOAT maxQ = -std::numeric_limits<SUFLOAT>::infinity();
+    SUFLOAT maxPower = 0;
+    CompensatedSum sumI, sumQ, sumPower;
+    std::vector<quint64> histogram;
+    bool cancelled = false;
+  };
+}
+
+static void
+accumulate(PartialStats &p, const SUCOMPLEX *x, size_t count)
+{
+  for (size_t base = 0; base < count; base += SIGDIGGER_STATS_BLOCK_SAMPLES) {
+    size_t last = std::min<size_t>(count, base + SIGDIGGER_STATS_BLOCK_SAMPLES);
+    double sumI = 0, sumQ = 0, sumPower = 0;
+
+    for (size_t i = base; i < last; ++i) {
+      SUFLOAT re = SU_C_REAL(x[i]);
+      SUFLOAT im = SU_C_IMAG(x[i]);
+      SUFLOAT power = re * re + im * im;
+
+      p.minI = std::min(p.minI, re);
+      p.maxI = std::max(p.maxI, re);
+      p.minQ = std::min(p.minQ, im);
+      p.maxQ = std::max(p.maxQ, im);
+      p.maxPower = std::max(p.maxPower, power);
+
+      sumI     += static_cast<double>(re);
+      sumQ     += static_cast<double>(im);
+      sumPower += static_cast<double>(power);
+    }
+
+    p.sumI.add(sumI);
+    p.sumQ.add(sumQ);
+    p.sumPower.add(sumPower);
+  }
+}
+
+static void
+fillHistogram(PartialStats &p, const SUCOMPLEX *x, size_t count, SUFLOAT peak)
+{
+  SUFLOAT k = static_cast<SUFLOAT>(SIGDIGGER_STATS_HISTOGRAM_BINS) / peak;
+  size_t last = SIGDIGGER_STATS_HISTOGRAM_BINS - 1;
+
+  for (size_t i = 0; i < count; ++i) {
+    size_t bin = static_cast<size_t>(SU_C_ABS(x[i]) * k);
+    ++p.histogram[std::min(bin, last)];
+  }
+}
+
+// Splits [0, count) among the workers, in chunks so that cancellation
+// requests are noticed soon.
+static bool
+runParallel(
+    std::vector<PartialStats> &partials,
+    size_t count,
+    SampleStatsEngine::CancelCallback const &cancelled,
+    std::function<void (PartialStats &, size_t, size_t)> const &func)
+{
+  std::vector<std::thread> threads;
+  size_t share = (count + partials.size() - 1) / partials.size();
+
+  auto run = [&] (size_t i) {
+    size_t from = i * share;
+    size_t to   = std::min(count, from + share);
+
+    for (size_t p = from; p < to; p += SIGDIGGER_STATS_CHUNK_SAMPLES) {
+      if (cancelled && cancelled()) {
+        partials[i].cancelled = true;
+        return;
+      }
+
+      func(
+            partials[i],
+            p,
+            std::min<size_t>(to, p + SIGDIGGER_STATS_CHUNK_SAMPLES));
+    }
+  };
+
+  for (size_t i = 1; i < partials.size(); ++i)
+    threads.push_back(std::thread(run, i));
+
+  run(0);
+
+  for (auto &t : threads)
+    t.join();
+
+  for (auto &p : partials)
+    if (p.cancelled)
+      return false;
+
+  return true;
+}
+
+static SUFLOAT
+percentile(std::vector<quint64> const &histogram, size_t count, qreal q, SUFLOAT peak)
+{
+  qreal target = q * static_cast<qreal>(count);
+  qreal binWidth = static_cast<qreal>(peak) / static_cast<qreal>(histogram.size());
+  quint64 acc = 0;
+
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    if (histogram[i] > 0 && static_cast<qreal>(acc + histogram[i]) >= target) {
+      // Assume samples are evenly spread inside the bin
+      qreal frac = (target - static_cast<qreal>(acc))
+          / static_cast<qreal>(histogram[i]);
+
+      return static_cast<SUFLOAT>((static_cast<qreal>(i) + frac) * binWidth);
+    }
+
+    acc += histogram[i];
+  }
+
+  return peak;
+}
+
+bool
+SampleStatsEngine::compute(
+    const SUCOMPLEX *data,
+    size_t count,
+    SampleStats &stats,
+    CancelCallback const &cancelled)
+{
+  unsigned int workers = std::thread::hardware_concurrency();
+  std::vector<PartialStats> partials;
+  PartialStats total;
+  SUFLOAT peak;
+  qreal meanPower;
+
+  stats = SampleStats();
+
+  if (count == 0)
+    return true;
+
+  // Not worth spawning threads for small ranges
+  workers = std::max(
+        1u,
+        std::min(
+          workers,
+          static_cast<unsigned int>(SIGDIGGER_STATS_MAX_WORKERS)));
+  workers = static_cast<unsigned int>(
+        std::min<size_t>(
+          workers,
+          (count + SIGDIGGER_STATS_CHUNK_SAMPLES - 1)
+          / SIGDIGGER_STATS_CHUNK_SAMPLES));
+  partials.resize(workers);
+
+  if (!runParallel(
+        partials,
+        count,
+        cancelled,
+        [data] (PartialStats &p, size_t from, size_t to) {
+          accumulate(p, data + from, to - from);
+        }))
+    return false;
+
+  for (auto const &p : partials) {
+    total.minI = std::min(total.minI, p.minI);
+    total.maxI = std::max(total.maxI, p.maxI);
+    total.minQ = std::min(total.minQ, p.minQ);
+    total.maxQ = std::max(total.maxQ, p.maxQ);
+    total.maxPower = std::max(total.maxPower, p.maxPower);
+    total.sumI.add(p.sumI);
+    total.sumQ.add(p.sumQ);
+    total.sumPower.add(p.sumPower);
+  }
+
+  peak      = std::sqrt(total.maxPower);
+  meanPower = total.sumPower.value() / static_cast<qreal>(count);
+
+  stats.count = count;
+  stats.min   = SUCOMPLEX(total.minI, total.minQ);
+  stats.max   = SUCOMPLEX(total.maxI, total.maxQ);
+  stats.mean  = SUCOMPLEX(
+        static_cast<SUFLOAT>(total.sumI.value() / static_cast<qreal>(count)),
+        static_cast<SUFLOAT>(total.sumQ.value() / static_cast<qreal>(count)));
+  stats.rms   = static_cast<SUFLOAT>(std::sqrt(meanPower));
+  stats.peak  = peak;
+  stats.papr  = meanPower > 0
+      ? 10 * std::log10(static_cast<qreal>(total.maxPower) / meanPower)
+      : 0;
+
+  if (!(peak > 0) || !std::isfinite(peak))
+    return true;
+
+  // Second pass: magnitude histogram, now that its range is known
+  for (auto &p : partials)
+    p.histogram.assign(SIGDIGGER_STATS_HISTOGRAM_BINS, 0);
+
+  if (!runParallel(
+        partials,
+        count,
+        cancelled,
+        [data, peak] (PartialStats &p, size_t from, size_t to) {
+          fillHistogram(p, data + from, to - from, peak);
+        }))
+    return false;
+
+  total.histogram.assign(SIGDIGGER_STATS_HISTOGRAM_BINS, 0);
+
+  for (auto const &p : partials)
+    for (size_t i = 0; i < SIGDIGGER_STATS_HISTOGRAM_BINS; ++i)
+      total.histogram[i] += p.histogram[i];
+
+  stats.p50 = percentile(total.histogram, count, .50, peak);
+  stats.p90 = percentile(total.histogram, count, .90, peak);
+  stats.p99 = percentile(total.histogram, count, .99, peak);
+
+  return true;
+}
+
+SampleStatsEngine::SampleStatsEngine(QObject *parent) : QObject(parent)
+{
+  m_generation = 0;
+  m_worker = std::thread(&SampleStatsEngine::work, this);
+}
+
+SampleStatsEngine::~SampleStatsEngine()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_running = false;
+    ++m_generation;
+  }
+
+  m_cond.notify_all();
+  m_worker.join();
+}
+
+void
+SampleStatsEngine::store(Key const &key, SampleStats const &stats)
+{
+  if (m_cache.size() >= SIGDIGGER_STATS_CACHE_ENTRIES
+      && m_cache.find(key) == m_cache.end()) {
+    auto oldest = m_cache.begin();
+
+    for (auto p = m_cache.begin(); p != m_cache.end(); ++p)
+      if (p->second.lastUse < oldest->second.lastUse)
+        oldest = p;
+
+    m_cache.erase(oldest);
+  }
+
+  m_cache[key] = Entry {stats, ++m_useCounter};
+}
+
+void
+SampleStatsEngine::work()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  for (;;) {
+    Key job;
+    quint64 generation;
+    SampleStats stats;
+    bool ok;
+
+    m_cond.wait(lock, [this] () { return m_haveJob || !m_running; });
+
+    if (!m_running)
+      break;
+
+    job        = m_job;
+    generation = m_generation;
+    m_haveJob  = false;
+    m_busy     = true;
+
+    lock.unlock();
+
+    ok = compute(
+          std::get<0>(job) + std::get<1>(job),
+          std::get<2>(job) - std::get<1>(job),
+          stats,
+          [this, generation] () { return m_generation != generation; });
+
+    lock.lock();
+
+    m_busy = false;
+
+    if (ok && m_generation == generation)
+      store(job, stats);
+    else
+      ok = false;
+
+    m_cond.notify_all();
+
+    if (ok) {
+      lock.unlock();
+      emit ready(generation);
+      lock.lock();
+    }
+  }
+}
+
+bool
+SampleStatsEngine::request(
+    const SUCOMPLEX *data,
+    size_t from,
+    size_t to,
+    SampleStats &stats)
+{
+  Key key(data, from, to);
+
+  if (data == nullptr || from >= to) {
+    stats = SampleStats();
+    return true;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto p = m_cache.find(key);
+
+    if (p != m_cache.end()) {
+      p->second.lastUse = ++m_useCounter;
+      stats = p->second.stats;
+      return true;
+    }
+
+    if (to - from > SIGDIGGER_STATS_SYNC_SAMPLES) {
+      // Whatever is being computed is no longer of interest
+      if (!(m_busy || m_haveJob) || m_job != key) {
+        ++m_generation;
+        m_job     = key;
+        m_haveJob = true;
+        m_cond.notify_all();
+      }
+
+      return false;
+    }
+  }
+
+  compute(data + from, to - from, stats);
+
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    store(key, stats);
+  }
+
+  return true;
+}
+
+quint64
+SampleStatsEngine::generation() const
+{
+  return m_generation;
+}
+
+void
+SampleStatsEngine::invalidate()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  ++m_generation;
+  m_haveJob = false;
+  m_cache.clear();
+
+  m_cond.wait(lock, [this] () { return !m_busy; });
+}
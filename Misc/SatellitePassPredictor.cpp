@@ -0,0 +1,496 @@
+//
+//    SatellitePassPredictor.cpp: Upcoming passes over the whole TLE catalog
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SatellitePassPredictor.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace SigDigger;
+
+static inline struct timeval
+toTimeval(double t)
+{
+  struct timeval tv;
+  double sec = std::floor(t);
+
+  tv.tv_sec  = static_cast<time_t>(sec);
+  tv.tv_usec = static_cast<suseconds_t>((t - sec) * 1e6);
+
+  return tv;
+}
+
+static inline double
+fromTimeval(struct timeval const &tv)
+{
+  return static_cast<double>(tv.tv_sec) + 1e-6 * static_cast<double>(tv.tv_usec);
+}
+
+qreal
+SatellitePass::duration() const
+{
+  return fromTimeval(los) - fromTimeval(aos);
+}
+
+qreal
+SatellitePass::maxDoppler(qreal frequency) const
+{
+  return maxRangeRate * frequency / SPEED_OF_LIGHT_KM_S;
+}
+
+////////////////////////////// Prediction helpers //////////////////////////////
+namespace {
+  class ElevationFunction {
+    sgdp4_prediction_t *m_pred;
+    bool m_ok = true;
+
+  public:
+    ElevationFunction(sgdp4_prediction_t *pred) : m_pred(pred) { }
+
+    bool ok() const
+    {
+      return m_ok;
+    }
+
+    bool
+    update(double t)
+    {
+      struct timeval tv = toTimeval(t);
+
+      if (!sgdp4_prediction_update(m_pred, &tv))
+        m_ok = false;
+
+      return m_ok;
+    }
+
+    double
+    operator()(double t)
+    {
+      xyz_t azel;
+
+      if (!this->update(t))
+        return -M_PI;
+
+      sgdp4_prediction_get_azel(m_pred, &azel);
+      return azel.elevation;
+    }
+
+    void
+    azelAt(double t, xyz_t &azel, xyz_t &vAzel)
+    {
+      this->update(t);
+      sgdp4_prediction_get_azel(m_pred, &azel);
+      sgdp4_prediction_get_vel_azel(m_pred, &vAzel);
+    }
+
+    // Golden section search of the culmination in [a, b]
+    double
+    maximize(double a, double b, double &max)
+    {
+      const double r = .5 * (std::sqrt(5.) - 1);
+      double c = b - r * (b - a);
+      double d = a + r * (b - a);
+      double fc = (*this)(c);
+      double fd = (*this)(d);
+
+      while (b - a > SIGDIGGER_PASS_PREDICTOR_TOLERANCE) {
+        if (fc > fd) {
+          b  = d;
+          d  = c;
+          fd = fc;
+          c  = b - r * (b - a);
+          fc = (*this)(c);
+        } else {
+          a  = c;
+          c  = d;
+          fc = fd;
+          d  = a + r * (b - a);
+          fd = (*this)(d);
+        }
+      }
+
+      max = std::max(fc, fd);
+      return fc > fd ? c : d;
+    }
+
+    // Crossing of `level' in [a, b], given f(a) and f(b) on opposite sides
+    double
+    bisect(double a, double b, double level)
+    {
+      bool aAbove = (*this)(a) >= level;
+
+      while (b - a > SIGDIGGER_PASS_PREDICTOR_TOLERANCE) {
+        double m = .5 * (a + b);
+
+        if (((*this)(m) >= level) == aAbove)
+          a = m;
+        else
+          b = m;
+      }
+
+      return .5 * (a + b);
+    }
+  };
+}
+
+SatellitePassPredictor::SatellitePassPredictor(QObject *parent) :
+  QObject(parent), m_cancel(false), m_running(false)
+{
+}
+
+SatellitePassPredictor::~SatellitePassPredictor()
+{
+  this->cancel();
+}
+
+void
+SatellitePassPredictor::invalidate()
+{
+  this->cancel();
+  m_cache.clear();
+}
+
+void
+SatellitePassPredictor::setQth(xyz_t const &qth)
+{
+  if (!m_haveQth
+      || qth.lat != m_qth.lat
+      || qth.lon != m_qth.lon
+      || qth.height != m_qth.height) {
+    this->invalidate();
+    m_qth     = qth;
+    m_haveQth = true;
+  }
+}
+
+void
+SatellitePassPredictor::setMinElevation(qreal degrees)
+{
+  if (degrees != m_minElevation) {
+    this->invalidate();
+    m_minElevation = degrees;
+  }
+}
+
+bool
+SatellitePassPredictor::findPasses(
+    Suscan::Orbit const &orbit,
+    double from,
+    double to,
+    QVector<SatellitePass> &passes)
+{
+  const orbit_t *orb = &orbit.getCOrbit();
+  struct timeval tv = toTimeval(from);
+  sgdp4_prediction_t pred;
+  xyz_t qth = m_qth;
+  double minEl = SU_DEG2RAD(m_minElevation);
+  double period, step, start, end, skipUntil;
+  double t0, t1, e0, e1;
+
+  // Geostationary satellites never rise nor set
+  if (orb->rev <= 0 || orbit_is_geo(orb) || orbit_is_decayed(orb, &tv))
+    return true;
+
+  if (!sgdp4_prediction_init(&pred, orb, &qth))
+    return false;
+
+  ElevationFunction el(&pred);
+
+  period = 86400. / orb->rev;
+  step   = qBound(
+        SIGDIGGER_PASS_PREDICTOR_MIN_STEP,
+        period / SIGDIGGER_PASS_PREDICTOR_COARSE_STEPS,
+        SIGDIGGER_PASS_PREDICTOR_MAX_STEP);
+
+  // Start half an orbit earlier, so that the culmination of a pass already
+  // in progress falls between samples. Look past the end for the same
+  // reason.
+  start     = from - std::min(.5 * period, 43200.);
+  end       = to + std::min(.5 * period, 43200.);
+  skipUntil = start;
+
+  t0 = start;
+  e0 = el(t0);
+  t1 = t0 + step;
+  e1 = el(t1);
+
+  for (double t2 = t1 + step; t2 <= end + step && el.ok(); t2 += step) {
+    double e2 = el(t2);
+
+    if (t1 > skipUntil && e1 >= e0 && e1 > e2) {
+      double max;
+      double tca = el.maximize(t0, t2, max);
+
+      if (max >= minEl) {
+        double a = tca - step, b = tca + step;
+        SatellitePass pass;
+        xyz_t azel, vAzel;
+        double aos, los;
+
+        while (el(a) >= minEl && tca - a < period)
+          a -= step;
+        while (el(b) >= minEl && b - tca < period)
+          b += step;
+
+        aos = el.bisect(a, tca, minEl);
+        los = el.bisect(tca, b, minEl);
+
+        if (los >= from && aos <= to) {
+          pass.satellite    = orbit.nameToQString();
+          pass.aos          = toTimeval(aos);
+          pass.tca          = toTimeval(tca);
+          pass.los          = toTimeval(los);
+          pass.maxElevation = SU_RAD2DEG(max);
+
+          el.azelAt(aos, azel, vAzel);
+          pass.aosAzimuth   = SU_RAD2DEG(azel.azimuth);
+          pass.maxRangeRate = std::fabs(vAzel.distance);
+
+          el.azelAt(los, azel, vAzel);
+          pass.losAzimuth   = SU_RAD2DEG(azel.azimuth);
+          pass.maxRangeRate = std::max(
+                pass.maxRangeRate,
+                std::fabs(vAzel.distance));
+
+          passes.push_back(pass);
+        }
+
+        skipUntil = los;
+      }
+    }
+
+    if (m_cancel)
+      break;
+
+    t0 = t1;
+    e0 = e1;
+    t1 = t2;
+    e1 = e2;
+  }
+
+  sgdp4_prediction_finalize(&pred);
+
+  return !m_cancel;
+}
+
+//
+// Passes of an orbit in [from, to]. The cache entry of the orbit is reused
+// as long as the window starts inside it, and only the part of the window
+// beyond its end is computed. Since passes are searched past the ends of
+// the window, a pass across the old end is found twice: it is the only one
+// that can overlap the last cached pass.
+//
+bool
+SatellitePassPredictor::updatePasses(
+    Suscan::Orbit const &orbit,
+    double from,
+    double to,
+    QVector<SatellitePass> &passes)
+{
+  const orbit_t *orb = &orbit.getCOrbit();
+  QString name = orbit.nameToQString();
+  CacheEntry entry;
+  bool cached = false;
+
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto p = m_cache.find(name);
+
+    if (p != m_cache.end()
+        && p->epochYear == orb->ep_year
+        && p->epochDay == orb->ep_day
+        && from >= p->from
+        && from <= p->to) {
+      entry  = *p;
+      cached = true;
+    }
+  }
+
+  if (!cached) {
+    entry.epochYear = orb->ep_year;
+    entry.epochDay  = orb->ep_day;
+    entry.from      = from;
+    entry.to        = from;
+  }
+
+  if (to > entry.to) {
+    QVector<SatellitePass> found;
+
+    if (!this->findPasses(orbit, entry.to, to, found))
+      return false;
+
+    for (auto const &pass : found)
+      if (entry.passes.isEmpty()
+          || timercmp(&pass.aos, &entry.passes.back().los, >))
+        entry.passes.push_back(pass);
+
+    entry.to = to;
+  }
+
+  // Passes that ended before the window will not be asked for again
+  while (!entry.passes.isEmpty()
+         && fromTimeval(entry.passes.front().los) < from)
+    entry.passes.pop_front();
+  entry.from = from;
+
+  for (auto const &pass : entry.passes)
+    if (fromTimeval(pass.los) >= from && fromTimeval(pass.aos) <= to)
+      passes.push_back(pass);
+
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_cache[name] = std::move(entry);
+  }
+
+  return true;
+}
+
+void
+SatellitePassPredictor::run(
+    QVector<Suscan::Orbit> orbits,
+    double from,
+    double to)
+{
+  std::vector<std::thread> workers;
+  std::atomic<int> next(0), done(0);
+  int total = orbits.size();
+  int every = std::max(1, total / 100);
+  unsigned int count = std::thread::hardware_concurrency();
+  QVector<SatellitePass> all;
+
+  if (count == 0)
+    count = 1;
+
+  auto work = [&] () {
+    QVector<SatellitePass> found;
+    int i;
+
+    while (!m_cancel && (i = next++) < total) {
+      QVector<SatellitePass> passes;
+
+      this->updatePasses(orbits[i], from, to, passes);
+
+      found += passes;
+
+      if (++done % every == 0)
+        emit progress(done, total);
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    all += found;
+  };
+
+  for (unsigned int i = 0; i < count; ++i)
+    workers.push_back(std::thread(work));
+
+  for (auto &t : workers)
+    t.join();
+
+  if (!m_cancel) {
+    std::sort(
+          all.begin(),
+          all.end(),
+          [] (SatellitePass const &a, SatellitePass const &b) {
+            return timercmp(&a.aos, &b.aos, <);
+          });
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      m_passes = std::move(all);
+    }
+
+    m_running = false;
+    emit finished();
+  } else {
+    m_running = false;
+  }
+}
+
+bool
+SatellitePassPredictor::start(struct timeval const &from, qreal seconds)
+{
+  Suscan::Singleton *sing = Suscan::Singleton::get_instance();
+  QVector<Suscan::Orbit> orbits;
+  double t = fromTimeval(from);
+
+  if (!m_haveQth)
+    return false;
+
+  this->cancel();
+
+  // Orbits are copied here, the singleton is not to be touched from workers
+  for (auto const &orbit : sing->getSatelliteMap())
+    orbits.push_back(orbit);
+
+  m_cancel  = false;
+  m_running = true;
+  m_thread  = std::thread(
+        &SatellitePassPredictor::run,
+        this,
+        orbits,
+        t,
+        t + seconds);
+
+  return true;
+}
+
+void
+SatellitePassPredictor::cancel()
+{
+  if (m_thread.joinable()) {
+    m_cancel = true;
+    m_thread.join();
+  }
+
+  m_running = false;
+}
+
+bool
+SatellitePassPredictor::isRunning() const
+{
+  return m_running;
+}
+
+QVector<SatellitePass>
+SatellitePassPredictor::passes() const
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+
+  return m_passes;
+}
+
+//
+// Meant for schedulers: the pass in progress at `after', or the next one.
+//
+bool
+SatellitePassPredictor::nextPass(
+    QString const &satellite,
+    struct timeval const &after,
+    SatellitePass &result) const
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+
+  for (auto const &pass : m_passes) {
+    if (pass.satellite == satellite && timercmp(&pass.los, &after, >)) {
+      result = pass;
+      return true;
+    }
+  }
+
+  return false;
+}
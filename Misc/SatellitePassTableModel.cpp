@@ -0,0 +1,171 @@
+//
+//    SatellitePassTableModel.cpp: Table of upcoming satellite passes
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <SatellitePassTableModel.h>
+#include <SuWidgetsHelpers.h>
+#include <QDateTime>
+
+using namespace SigDigger;
+
+#define PASS_TABLE_COLUMNS 8
+
+SatellitePassTableModel::SatellitePassTableModel(QObject *parent) :
+  QAbstractTableModel(parent)
+{
+}
+
+void
+SatellitePassTableModel::setPasses(QVector<SatellitePass> const &passes)
+{
+  beginResetModel();
+  this->passes = passes;
+  endResetModel();
+}
+
+void
+SatellitePassTableModel::setFrequency(qreal freq)
+{
+  this->frequency = freq;
+
+  if (!this->passes.empty())
+    emit dataChanged(
+        index(0, PASS_TABLE_COLUMNS - 1),
+        index(this->passes.size() - 1, PASS_TABLE_COLUMNS - 1));
+}
+
+SatellitePass const *
+SatellitePassTableModel::passAt(int row) const
+{
+  if (row < 0 || row >= this->passes.size())
+    return nullptr;
+
+  return &this->passes[row];
+}
+
+int
+SatellitePassTableModel::rowCount(const QModelIndex &) const
+{
+  return this->passes.size();
+}
+
+int
+SatellitePassTableModel::columnCount(const QModelIndex &) const
+{
+  // Satellite, AOS, LOS, duration, max elevation, AOS az, LOS az, Doppler
+  return PASS_TABLE_COLUMNS;
+}
+
+static QString
+formatTime(struct timeval const &tv)
+{
+  return QDateTime::fromMSecsSinceEpoch(
+        static_cast<qint64>(tv.tv_sec) * 1000).toString("yyyy-MM-dd hh:mm:ss");
+}
+
+QVariant
+SatellitePassTableModel::data(const QModelIndex &index, int role) const
+{
+  SatellitePass const *pass = this->passAt(index.row());
+
+  if (pass == nullptr)
+    return QVariant();
+
+  if (role == Qt::DisplayRole) {
+    switch (index.column()) {
+      case 0:
+        return pass->satellite;
+
+      case 1:
+        return formatTime(pass->aos);
+
+      case 2:
+        return formatTime(pass->los);
+
+      case 3:
+        return SuWidgetsHelpers::formatQuantity(pass->duration(), "s");
+
+      case 4:
+        return QString::number(pass->maxElevation, 'f', 1) + "º";
+
+      case 5:
+        return QString::number(pass->aosAzimuth, 'f', 0) + "º";
+
+      case 6:
+        return QString::number(pass->losAzimuth, 'f', 0) + "º";
+
+      case 7:
+        return this->frequency > 0
+            ? "±" + SuWidgetsHelpers::formatQuantity(
+                pass->maxDoppler(this->frequency),
+                4,
+                "Hz",
+                false)
+            : "N / A";
+    }
+  } else if (role == SIGDIGGER_PASS_SORT_ROLE) {
+    switch (index.column()) {
+      case 0:
+        return pass->satellite;
+
+      case 1:
+        return static_cast<qint64>(pass->aos.tv_sec);
+
+      case 2:
+        return static_cast<qint64>(pass->los.tv_sec);
+
+      case 3:
+        return pass->duration();
+
+      case 4:
+        return pass->maxElevation;
+
+      case 5:
+        return pass->aosAzimuth;
+
+      case 6:
+        return pass->losAzimuth;
+
+      case 7:
+        return pass->maxRangeRate;
+    }
+  }
+
+  return QVariant();
+}
+
+QVariant
+SatellitePassTableModel::headerData(int s, Qt::Orientation hor, int role) const
+{
+  if (hor == Qt::Horizontal && role == Qt::DisplayRole) {
+    const char *headers[] = {
+      "Satellite",
+      "AOS",
+      "LOS",
+      "Duration",
+      "Max. elevation",
+      "AOS azimuth",
+      "LOS azimuth",
+      "Max. Doppler"};
+
+    if (s >= 0 && s < PASS_TABLE_COLUMNS)
+      return headers[s];
+  }
+
+  return QVariant();
+}
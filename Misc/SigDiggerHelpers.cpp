@@ -197,7 +197,8 @@ SigDiggerHelpers::openSaveSamplesDialog(
     filters << "Audio file (*.wav)"
             << "Raw I/Q data (*.raw)"
             << "MATLAB/Octave script (*.m)"
-            << "MATLAB 5.0 MAT-file (*.mat)";
+            << "MATLAB 5.0 MAT-file (*.mat)"
+            << "NumPy array (*.npy)";
 
     dialog.setNameFilters(filters);
 
@@ -206,7 +207,9 @@ SigDiggerHelpers::openSaveSamplesDialog(
       QString filter = dialog.selectedNameFilter();
       ExportSamplesTask *task;
 
-      if (strstr(filter.toStdString().c_str(), ".mat") != nullptr)
+      if (strstr(filter.toStdString().c_str(), ".npy") != nullptr)
+        format = "npy";
+      else if (strstr(filter.toStdString().c_str(), ".mat") != nullptr)
         format = "mat";
       else if (strstr(filter.toStdString().c_str(), ".m") != nullptr)
         format = "m";
@@ -0,0 +1,373 @@
+//
+//    SpectrogramEngine.cpp: Tiled STFT of sample buffers
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SpectrogramEngine.h"
+#include <sigutils/taps.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace SigDigger;
+
+// Floor of the power spectrum, to keep empty bins finite (-200 dB)
+#define SIGDIGGER_SPECTROGRAM_POWER_FLOOR 1e-20f
+
+//
+// FFTW plans can be executed from any thread, but only created and
+// destroyed by one thread at a time. Plans are created out-of-place, so
+// that each worker can run them on its own buffers.
+//
+struct SpectrogramEngine::Plan {
+  unsigned int size = 0;
+  SU_FFTW(_plan) plan = nullptr;
+  std::vector<SUFLOAT> window;
+  SUFLOAT scale = 1;   // Full scale tones are 0 dB
+
+  ~Plan()
+  {
+    if (plan != nullptr)
+      SU_FFTW(_destroy_plan)(plan);
+  }
+};
+
+std::shared_ptr<SpectrogramEngine::Plan>
+SpectrogramEngine::plan(unsigned int fftSize)
+{
+  static std::mutex mutex;
+  static std::map<unsigned int, std::shared_ptr<Plan>> plans;
+  std::lock_guard<std::mutex> guard(mutex);
+  auto p = plans.find(fftSize);
+  std::shared_ptr<Plan> plan;
+  std::vector<SUCOMPLEX> ones(fftSize, 1);
+  SU_FFTW(_complex) *in, *out;
+  SUFLOAT sum = 0;
+
+  if (p != plans.end())
+    return p->second;
+
+  in  = static_cast<SU_FFTW(_complex) *>(
+        SU_FFTW(_malloc)(fftSize * sizeof(SUCOMPLEX)));
+  out = static_cast<SU_FFTW(_complex) *>(
+        SU_FFTW(_malloc)(fftSize * sizeof(SUCOMPLEX)));
+
+  if (in != nullptr && out != nullptr) {
+    plan = std::make_shared<Plan>();
+    plan->size = fftSize;
+    plan->plan = SU_FFTW(_plan_dft_1d)(
+          static_cast<int>(fftSize),
+          in,
+          out,
+          FFTW_FORWARD,
+          FFTW_ESTIMATE);
+
+    if (plan->plan == nullptr)
+      plan.reset();
+  }
+
+  if (in != nullptr)
+    SU_FFTW(_free)(in);
+
+  if (out != nullptr)
+    SU_FFTW(_free)(out);
+
+  if (!plan)
+    return plan;
+
+  su_taps_apply_blackmann_harris_complex(ones.data(), fftSize);
+
+  plan->window.resize(fftSize);
+  for (unsigned int i = 0; i < fftSize; ++i) {
+    plan->window[i] = SU_C_REAL(ones[i]);
+    sum += plan->window[i];
+  }
+
+  plan->scale = 1 / (sum * sum);
+
+  plans[fftSize] = plan;
+
+  return plan;
+}
+
+SpectrogramEngine::SpectrogramEngine(QObject *parent) : QObject(parent)
+{
+  unsigned int workers = std::thread::hardware_concurrency();
+
+  workers = std::max(
+        1u,
+        std::min(
+          workers,
+          static_cast<unsigned int>(SIGDIGGER_SPECTROGRAM_MAX_WORKERS)));
+
+  for (unsigned int i = 0; i < workers; ++i)
+    m_workers.push_back(std::thread(&SpectrogramEngine::work, this));
+}
+
+SpectrogramEngine::~SpectrogramEngine()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_running = false;
+    m_queue.clear();
+  }
+
+  m_cond.notify_all();
+
+  for (auto &t : m_workers)
+    t.join();
+}
+
+size_t
+SpectrogramEngine::hopForZoom(qreal samplesPerPixel)
+{
+  size_t hop = 1;
+
+  while (static_cast<qreal>(hop << 1) <= samplesPerPixel)
+    hop <<= 1;
+
+  return hop;
+}
+
+size_t
+SpectrogramEngine::tileSamples(size_t hop)
+{
+  return hop * SIGDIGGER_SPECTROGRAM_TILE_COLUMNS;
+}
+
+SpectrogramTilePtr
+SpectrogramEngine::compute(
+    SpectrogramTileKey const &key,
+    const SUCOMPLEX *data,
+    size_t length) const
+{
+  std::shared_ptr<Plan> plan = SpectrogramEngine::plan(key.fftSize);
+  std::shared_ptr<SpectrogramTile> tile = std::make_shared<SpectrogramTile>();
+  size_t first = key.index * tileSamples(key.hop);
+  unsigned int size = key.fftSize;
+  unsigned int half = size / 2;
+  unsigned int average;
+  size_t stride;
+  std::vector<SUFLOAT> acc(size);
+  SUCOMPLEX *in, *out;
+
+  tile->key     = key;
+  tile->columns = 0;
+  tile->max     = -std::numeric_limits<float>::infinity();
+
+  if (!plan || first >= length)
+    return tile;
+
+  tile->columns = static_cast<unsigned int>(
+        std::min<size_t>(
+          SIGDIGGER_SPECTROGRAM_TILE_COLUMNS,
+          (length - first + key.hop - 1) / key.hop));
+  tile->power.resize(static_cast<size_t>(tile->columns) * size);
+
+  // Long hops average several FFTs evenly spread over the hop
+  average = static_cast<unsigned int>(
+        qBound<size_t>(1, key.hop / size, SIGDIGGER_SPECTROGRAM_MAX_AVERAGE));
+  stride  = key.hop / average;
+
+  in  = static_cast<SUCOMPLEX *>(SU_FFTW(_malloc)(size * sizeof(SUCOMPLEX)));
+  out = static_cast<SUCOMPLEX *>(SU_FFTW(_malloc)(size * sizeof(SUCOMPLEX)));
+
+  if (in == nullptr || out == nullptr) {
+    tile->columns = 0;
+    tile->power.clear();
+  }
+
+  for (unsigned int c = 0; c < tile->columns; ++c) {
+    float *column = tile->power.data() + static_cast<size_t>(c) * size;
+
+    std::fill(acc.begin(), acc.end(), 0);
+
+    for (unsigned int k = 0; k < average; ++k) {
+      // Windows are centered in their share of the column, and padded
+      // with zeroes beyond the ends of the data
+      qint64 start = static_cast<qint64>(
+            first + c * key.hop + k * stride + stride / 2) - half;
+      qint64 lo = qBound<qint64>(0, -start, size);
+      qint64 hi = qBound<qint64>(lo, static_cast<qint64>(length) - start, size);
+
+      for (qint64 i = 0; i < lo; ++i)
+        in[i] = 0;
+
+      for (qint64 i = lo; i < hi; ++i)
+        in[i] = data[start + i] * plan->window[static_cast<size_t>(i)];
+
+      for (qint64 i = hi; i < size; ++i)
+        in[i] = 0;
+
+      SU_FFTW(_execute_dft)(
+            plan->plan,
+            reinterpret_cast<SU_FFTW(_complex) *>(in),
+            reinterpret_cast<SU_FFTW(_complex) *>(out));
+
+      for (unsigned int i = 0; i < size; ++i)
+        acc[i] += SU_C_REAL(out[i]) * SU_C_REAL(out[i])
+            + SU_C_IMAG(out[i]) * SU_C_IMAG(out[i]);
+    }
+
+    // Negative frequencies first
+    for (unsigned int i = 0; i < size; ++i) {
+      float db = SU_POWER_DB(
+            acc[i] * plan->scale / average + SIGDIGGER_SPECTROGRAM_POWER_FLOOR);
+
+      column[(i + half) % size] = db;
+      tile->max = std::max(tile->max, db);
+    }
+  }
+
+  if (in != nullptr)
+    SU_FFTW(_free)(in);
+
+  if (out != nullptr)
+    SU_FFTW(_free)(out);
+
+  return tile;
+}
+
+void
+SpectrogramEngine::store(SpectrogramTilePtr const &tile)
+{
+  size_t bytes = tile->power.size() * sizeof(float);
+
+  m_tiles[tile->key] = std::make_pair(tile, ++m_useCounter);
+  m_cacheBytes += bytes;
+
+  while (m_cacheBytes > SIGDIGGER_SPECTROGRAM_CACHE_BYTES && m_tiles.size() > 1) {
+    auto oldest = m_tiles.begin();
+
+    for (auto p = m_tiles.begin(); p != m_tiles.end(); ++p)
+      if (p->second.second < oldest->second.second)
+        oldest = p;
+
+    m_cacheBytes -= oldest->second.first->power.size() * sizeof(float);
+    m_tiles.erase(oldest);
+  }
+}
+
+void
+SpectrogramEngine::work()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  for (;;) {
+    SpectrogramTileKey key;
+    SpectrogramTilePtr tile;
+    const SUCOMPLEX *data;
+    size_t length;
+    quint64 generation;
+    bool stored = false;
+
+    m_cond.wait(lock, [this] () { return !m_running || !m_queue.empty(); });
+
+    if (!m_running)
+      break;
+
+    key = m_queue.front();
+    m_queue.pop_front();
+
+    if (m_tiles.find(key) != m_tiles.end()
+        || std::find(m_inProgress.begin(), m_inProgress.end(), key)
+           != m_inProgress.end())
+      continue;
+
+    m_inProgress.push_back(key);
+    ++m_busy;
+
+    data       = m_data;
+    length     = m_length;
+    generation = m_generation;
+
+    lock.unlock();
+    tile = this->compute(key, data, length);
+    lock.lock();
+
+    m_inProgress.erase(
+          std::find(m_inProgress.begin(), m_inProgress.end(), key));
+    --m_busy;
+
+    if (generation == m_generation) {
+      store(tile);
+      stored = true;
+    }
+
+    m_cond.notify_all();
+
+    if (stored) {
+      lock.unlock();
+      emit tileReady();
+      lock.lock();
+    }
+  }
+}
+
+void
+SpectrogramEngine::setData(const SUCOMPLEX *data, size_t length)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  ++m_generation;
+  m_queue.clear();
+  m_tiles.clear();
+  m_cacheBytes = 0;
+
+  m_cond.wait(lock, [this] () { return m_busy == 0; });
+
+  m_data   = data;
+  m_length = length;
+}
+
+size_t
+SpectrogramEngine::length() const
+{
+  return m_length;
+}
+
+SpectrogramTilePtr
+SpectrogramEngine::tile(SpectrogramTileKey const &key)
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+  auto p = m_tiles.find(key);
+
+  if (p == m_tiles.end())
+    return SpectrogramTilePtr();
+
+  p->second.second = ++m_useCounter;
+
+  return p->second.first;
+}
+
+void
+SpectrogramEngine::request(std::vector<SpectrogramTileKey> const &keys)
+{
+  std::lock_guard<std::mutex> guard(m_mutex);
+
+  // Tiles no longer visible are not worth computing
+  m_queue.clear();
+
+  if (m_data == nullptr)
+    return;
+
+  for (auto const &key : keys)
+    if (m_tiles.find(key) == m_tiles.end())
+      m_queue.push_back(key);
+
+  m_cond.notify_all();
+}
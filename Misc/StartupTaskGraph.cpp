@@ -0,0 +1,169 @@
+//
+//    StartupTaskGraph.cpp: Run initialization stages concurrently
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "StartupTaskGraph.h"
+#include <QElapsedTimer>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <deque>
+
+using namespace SigDigger;
+
+int
+StartupTaskGraph::add(
+    QString const &name,
+    QString const &message,
+    std::function<void ()> func,
+    std::vector<int> const &deps)
+{
+  StartupTask task;
+
+  task.name    = name;
+  task.message = message;
+  task.func    = func;
+  task.deps    = deps;
+
+  m_tasks.push_back(std::move(task));
+
+  return static_cast<int>(m_tasks.size() - 1);
+}
+
+void
+StartupTaskGraph::run(
+    std::function<void (QString const &)> onStart,
+    unsigned int workers)
+{
+  std::vector<std::vector<size_t>> dependents(m_tasks.size());
+  std::vector<size_t> pending(m_tasks.size());
+  std::vector<std::thread> threads;
+  std::deque<size_t> ready;
+  std::exception_ptr failure;
+  std::mutex mutex;
+  std::condition_variable cond;
+  size_t remaining = m_tasks.size();
+  bool stop = false;
+  QElapsedTimer timer;
+
+  for (size_t i = 0; i < m_tasks.size(); ++i) {
+    pending[i] = m_tasks[i].deps.size();
+    for (auto d : m_tasks[i].deps)
+      dependents[static_cast<size_t>(d)].push_back(i);
+
+    if (pending[i] == 0)
+      ready.push_back(i);
+  }
+
+  if (workers == 0) {
+    workers = std::thread::hardware_concurrency();
+    if (workers == 0 || workers > SIGDIGGER_STARTUP_MAX_WORKERS)
+      workers = SIGDIGGER_STARTUP_MAX_WORKERS;
+  }
+
+  timer.start();
+
+  auto worker = [&] (unsigned int id) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+      cond.wait(lock, [&] () { return stop || remaining == 0 || !ready.empty(); });
+
+      if (stop || remaining == 0)
+        break;
+
+      size_t index = ready.front();
+      StartupTask &task = m_tasks[index];
+      ready.pop_front();
+
+      task.worker  = id;
+      task.startNs = timer.nsecsElapsed();
+
+      lock.unlock();
+
+      try {
+        if (onStart)
+          onStart(task.message);
+        task.func();
+      } catch (...) {
+        lock.lock();
+        if (!failure)
+          failure = std::current_exception();
+        stop = true;
+        cond.notify_all();
+        break;
+      }
+
+      lock.lock();
+
+      task.endNs = timer.nsecsElapsed();
+      --remaining;
+
+      for (auto d : dependents[index])
+        if (--pending[d] == 0)
+          ready.push_back(d);
+
+      cond.notify_all();
+    }
+  };
+
+  for (unsigned int i = 1; i < workers; ++i)
+    threads.push_back(std::thread(worker, i));
+
+  worker(0);
+
+  for (auto &t : threads)
+    t.join();
+
+  m_totalNs = timer.nsecsElapsed();
+
+  if (failure)
+    std::rethrow_exception(failure);
+}
+
+std::vector<StartupTask> const &
+StartupTaskGraph::tasks() const
+{
+  return m_tasks;
+}
+
+QString
+StartupTaskGraph::report() const
+{
+  QString text;
+
+  text += QString("%1 %2 %3 %4\n")
+      .arg("Stage", -24)
+      .arg("Worker", 6)
+      .arg("Start (ms)", 11)
+      .arg("Time (ms)", 10);
+
+  for (auto const &task : m_tasks)
+    text += QString("%1 %2 %3 %4\n")
+        .arg(task.name, -24)
+        .arg(task.worker, 6)
+        .arg(task.startNs * 1e-6, 11, 'f', 1)
+        .arg((task.endNs - task.startNs) * 1e-6, 10, 'f', 1);
+
+  text += QString("%1 %2\n")
+      .arg("Total (wall clock)", -43)
+      .arg(m_totalNs * 1e-6, 10, 'f', 1);
+
+  return text;
+}
@@ -0,0 +1,125 @@
+//
+//    TextBlockWriter.cpp: Block-based, parallel text formatting
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "TextBlockWriter.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+using namespace SigDigger;
+
+// Floating point to_chars only exists in recent standard libraries.
+// Older ones get printf with enough digits to round-trip.
+char *
+SigDigger::formatReal(char *p, float x)
+{
+#if defined(__cpp_lib_to_chars)
+  return std::to_chars(p, p + SIGDIGGER_TEXT_MAX_NUMBER_LENGTH, x).ptr;
+#else
+  return p + snprintf(p, SIGDIGGER_TEXT_MAX_NUMBER_LENGTH, "%.9g", x);
+#endif // __cpp_lib_to_chars
+}
+
+char *
+SigDigger::formatReal(char *p, double x)
+{
+#if defined(__cpp_lib_to_chars)
+  return std::to_chars(p, p + SIGDIGGER_TEXT_MAX_NUMBER_LENGTH, x).ptr;
+#else
+  return p + snprintf(p, SIGDIGGER_TEXT_MAX_NUMBER_LENGTH, "%.17g", x);
+#endif // __cpp_lib_to_chars
+}
+
+char *
+SigDigger::formatString(char *p, const char *str)
+{
+  size_t len = strlen(str);
+
+  memcpy(p, str, len);
+
+  return p + len;
+}
+
+TextBlockWriter::TextBlockWriter(
+    std::ostream &os,
+    size_t maxItemLength,
+    unsigned int workers) : m_os(os), m_maxItemLength(maxItemLength)
+{
+  if (workers == 0)
+    workers = std::thread::hardware_concurrency();
+
+  m_workers = std::max(
+        1u,
+        std::min(
+          workers,
+          static_cast<unsigned int>(SIGDIGGER_TEXT_BLOCK_MAX_WORKERS)));
+  m_buffers.resize(m_workers);
+}
+
+bool
+TextBlockWriter::write(
+    size_t count,
+    Formatter const &format,
+    Progress const &progress)
+{
+  std::vector<std::thread> threads;
+  std::vector<size_t> lengths(m_workers);
+  size_t block = SIGDIGGER_TEXT_BLOCK_ITEMS;
+
+  for (auto &buf : m_buffers)
+    buf.resize(block * m_maxItemLength);
+
+  for (size_t base = 0; base < count; base += block * m_workers) {
+    size_t last = std::min(count, base + block * m_workers);
+    unsigned int chunks = static_cast<unsigned int>(
+          (last - base + block - 1) / block);
+
+    auto formatChunk = [&] (unsigned int i) {
+      size_t from = base + i * block;
+      size_t to   = std::min(last, from + block);
+      char *start = m_buffers[i].data();
+
+      lengths[i] = static_cast<size_t>(format(start, from, to) - start);
+    };
+
+    // The calling thread formats the first chunk
+    for (unsigned int i = 1; i < chunks; ++i)
+      threads.push_back(std::thread(formatChunk, i));
+
+    formatChunk(0);
+
+    for (auto &t : threads)
+      t.join();
+
+    threads.clear();
+
+    for (unsigned int i = 0; i < chunks; ++i)
+      m_os.write(m_buffers[i].data(), static_cast<std::streamsize>(lengths[i]));
+
+    if (!m_os.good())
+      return false;
+
+    if (progress && !progress(last))
+      return false;
+  }
+
+  return m_os.good();
+}
@@ -32,6 +32,7 @@ GuiConfigTab::save()
   this->guiConfig.enableMsgTTL   = this->ui->ttlCheck->isChecked();
   this->guiConfig.msgTTL         = static_cast<unsigned>(
         this->ui->ttlSpin->value());
+  this->guiConfig.adaptivePSD    = this->ui->adaptivePSDCheck->isChecked();
   this->guiConfig.infoText       = this->ui->infoTextEdit->toPlainText().toStdString();
   this->guiConfig.infoTextColor  = this->ui->infoTextColor->getColor();
 }
@@ -51,6 +52,8 @@ GuiConfigTab::refreshUi()
   this->ui->ttlLabel->setEnabled(this->ui->ttlCheck->isChecked());
   this->ui->ttlSpin->setEnabled(this->ui->ttlCheck->isChecked());
   this->ui->ttlSpin->setValue(static_cast<int>(this->guiConfig.msgTTL));
+  this->ui->adaptivePSDCheck->setChecked(this->guiConfig.adaptivePSD);
+  this->ui->adaptivePSDCheck->setEnabled(this->ui->ttlCheck->isChecked());
   this->ui->infoTextEdit->setPlainText(QString::fromStdString(this->guiConfig.infoText));
   this->ui->infoTextColor->setColor(this->guiConfig.infoTextColor);
 }
@@ -120,6 +123,12 @@ GuiConfigTab::connectAll()
         this,
         SLOT(onConfigChanged()));
 
+  connect(
+        this->ui->adaptivePSDCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onConfigChanged()));
+
   connect(
         this->ui->infoTextEdit,
         SIGNAL(textChanged()),
@@ -158,6 +167,7 @@ GuiConfigTab::onConfigChanged()
 
   this->ui->ttlLabel->setEnabled(this->ui->ttlCheck->isChecked());
   this->ui->ttlSpin->setEnabled(this->ui->ttlCheck->isChecked());
+  this->ui->adaptivePSDCheck->setEnabled(this->ui->ttlCheck->isChecked());
 
   this->modified = true;
   emit changed();
@@ -76,8 +76,10 @@ SOURCES += \
     App/RemoteControlConfig.cpp \
     App/RemoteControlServer.cpp \
     App/TLESourceConfig.cpp \
+    Audio/AudioDSPChain.cpp \
     Audio/AudioFileSaver.cpp \
     Audio/AudioPlayback.cpp \
+    Audio/AudioRingBuffer.cpp \
     Audio/GenericAudioPlayer.cpp \
     Components/AboutDialog.cpp \
     Components/AddTLESourceDialog.cpp \
@@ -85,6 +87,7 @@ SOURCES += \
     Components/DeviceGain.cpp \
     Components/DopplerDialog.cpp \
     Components/FrequencyCorrectionDialog.cpp \
+    Components/UpcomingPassesDialog.cpp \
     Components/GainSlider.cpp \
     Components/GenericDataSaverUI.cpp \
     Components/HistogramDialog.cpp \
@@ -95,7 +98,9 @@ SOURCES += \
     Components/QuickConnectDialog.cpp \
     Components/SamplerDialog.cpp \
     Components/SaveProfileDialog.cpp \
+    Components/SpectrogramView.cpp \
     Components/TimeWindow.cpp \
+    Default/Audio/AudioChannelWidget.cpp \
     Default/Audio/AudioProcessor.cpp \
     Default/Audio/AudioWidget.cpp \
     Default/Audio/AudioWidgetFactory.cpp \
@@ -125,6 +130,7 @@ SOURCES += \
     Default/RMSInspector/RMSInspector.cpp \
     Default/RMSInspector/RMSInspectorFactory.cpp \
     Default/Registration.cpp \
+    Default/Source/RemoteRecorder.cpp \
     Default/Source/SourceWidget.cpp \
     Default/Source/SourceWidgetFactory.cpp \
     Default/SourceConfig/DeviceTweaks.cpp \
@@ -138,11 +144,26 @@ SOURCES += \
     Default/SourceConfig/ToneGenSourcePageFactory.cpp \
     Misc/AutoGain.cpp \
     Misc/Averager.cpp \
+    Misc/BookmarkIndex.cpp \
+    Misc/CaptureOverview.cpp \
+    Misc/DeviceHotplugMonitor.cpp \
+    Misc/DopplerTable.cpp \
     Misc/FileViewer.cpp \
     Misc/GlobalProperty.cpp \
+    Misc/CaptureSampleMap.cpp \
     Misc/Palette.cpp \
     Misc/SNREstimator.cpp \
+    Misc/RMSFeed.cpp \
+    Misc/PSDRateController.cpp \
+    Misc/RMSHistory.cpp \
+    Misc/RMSStreamParser.cpp \
+    Misc/SampleStatsEngine.cpp \
+    Misc/SatellitePassPredictor.cpp \
+    Misc/SatellitePassTableModel.cpp \
     Misc/SigDiggerHelpers.cpp \
+    Misc/SpectrogramEngine.cpp \
+    Misc/StartupTaskGraph.cpp \
+    Misc/TextBlockWriter.cpp \
     Settings/AudioConfigTab.cpp \
     Settings/ColorConfigTab.cpp \
     Settings/ConfigDialog.cpp \
@@ -175,6 +196,7 @@ SOURCES += \
     Suscan/Plugin.cpp \
     Suscan/Serializable.cpp \
     Suscan/Source.cpp \
+    Suscan/StartupCache.cpp \
     Tasks/AGCTask.cpp \
     Tasks/CarrierDetector.cpp \
     Tasks/CarrierXlator.cpp \
@@ -203,12 +225,15 @@ SOURCES += \
     Misc/GenericDataSaver.cpp \
     Misc/FileDataSaver.cpp \
     UDP/SocketForwarder.cpp \
+    UDP/SocketStreamServer.cpp \
     Components/NetForwarderUI.cpp \
     Components/WaitingSpinnerWidget.cpp \
     Components/DeviceDialog.cpp \
     UIMediator/DeviceDialogMediator.cpp \
     Components/PanoramicDialog.cpp \
     Panoramic/Scanner.cpp \
+    Components/RMSDashboard.cpp \
+    Components/RMSIngestServer.cpp \
     Components/RMSViewer.cpp \
     Components/RMSViewTab.cpp \
     Components/RMSViewerSettingsDialog.cpp \
@@ -226,8 +251,10 @@ INSTALL_HEADERS += \
     include/Application.h \
     include/AppUI.h \
     include/AudioConfig.h \
+    include/AudioDSPChain.h \
     include/AudioFileSaver.h \
     include/AudioPlayback.h \
+    include/AudioRingBuffer.h \
     include/Averager.h \
     include/ColorConfig.h \
     include/ConfigTab.h \
@@ -238,10 +265,13 @@ INSTALL_HEADERS += \
     include/SigDiggerHelpers.h \
     include/MainSpectrum.h \
     include/MainWindow.h \
+    include/CaptureSampleMap.h \
     include/Palette.h \
     include/PersistentWidget.h \
     include/RemoteControlConfig.h \
     include/SourceConfigWidgetFactory.h \
+    include/SpectrogramEngine.h \
+    include/SpectrogramView.h \
     include/TabWidgetFactory.h \
     include/TLESourceConfig.h \
     include/ToolWidgetFactory.h \
@@ -273,7 +303,8 @@ SUSCAN_HEADERS += \
     include/Suscan/Plugin.h \
     include/Suscan/Serializable.h \
     include/Suscan/Source.h \
-    include/Suscan/SpectrumSource.h
+    include/Suscan/SpectrumSource.h \
+    include/Suscan/StartupCache.h
 
 suscan_headers.path   = $$SIGDIGGER_INSTALL_HEADERS/Suscan
 suscan_headers.files += $$SUSCAN_HEADERS
@@ -296,6 +327,7 @@ HEADERS += \
     $$INSTALL_HEADERS \
     $$SUSCAN_HEADERS \
     $$SUSCAN_MSG_HEADERS \
+    Default/Audio/AudioChannelWidget.h \
     Default/Audio/AudioProcessor.h \
     Default/Audio/AudioWidget.h \
     Default/Audio/AudioWidgetFactory.h \
@@ -325,6 +357,7 @@ HEADERS += \
     Default/RMSInspector/RMSInspector.h \
     Default/RMSInspector/RMSInspectorFactory.h \
     Default/Registration.h \
+    Default/Source/RemoteRecorder.h \
     Default/Source/SourceWidget.h \
     Default/Source/SourceWidgetFactory.h \
     Default/SourceConfig/DeviceTweaks.h \
@@ -352,6 +385,9 @@ HEADERS += \
     include/FileViewer.h \
     include/FloatingTabWindow.h \
     include/FrequencyCorrectionDialog.h \
+    include/SatellitePassPredictor.h \
+    include/SatellitePassTableModel.h \
+    include/UpcomingPassesDialog.h \
     include/GenericAudioPlayer.h \
     include/GenericDataSaverUI.h \
     include/GuiConfigTab.h \
@@ -367,6 +403,7 @@ HEADERS += \
     include/QuickConnectDialog.h \
     include/RemoteControlServer.h \
     include/RemoteControlTab.h \
+    include/SampleStatsEngine.h \
     include/SamplerDialog.h \
     include/SamplingProperties.h \
     include/AboutDialog.h \
@@ -383,13 +420,25 @@ HEADERS += \
     include/TimeWindow.h \
     include/FileDataSaver.h \
     include/SocketForwarder.h \
+    include/SocketStreamServer.h \
     include/NetForwarderUI.h \
     include/WaitingSpinnerWidget.h \
     include/DeviceDialog.h \
+    include/DeviceHotplugMonitor.h \
+    include/CaptureOverview.h \
+    include/DopplerTable.h \
     include/PanoramicDialog.h \
     include/Scanner.h \
     include/WaveSampler.h \
     include/RMSViewer.h \
+    include/RMSDashboard.h \
+    include/RMSFeed.h \
+    include/PSDRateController.h \
+    include/StartupTaskGraph.h \
+    include/TextBlockWriter.h \
+    include/RMSHistory.h \
+    include/RMSIngestServer.h \
+    include/RMSStreamParser.h \
     include/RMSViewTab.h \
     include/RMSViewerSettingsDialog.h \
     include/LogDialog.h \
@@ -397,12 +446,14 @@ HEADERS += \
     include/BackgroundTasksDialog.h \
     include/ExportSamplesTask.h \
     include/AddBookmarkDialog.h \
+    include/BookmarkIndex.h \
     include/BookmarkTableModel.h \
     include/BookmarkManagerDialog.h \
     include/TableDelegates.h
 
 
 FORMS += \
+    Default/Audio/AudioChannelWidget.ui \
     Default/Audio/AudioWidget.ui \
     Default/DefaultTab/DefaultTabWidget.ui \
     Default/FFT/FFTWidget.ui \
@@ -433,6 +484,7 @@ FORMS += \
     ui/EqualizerControl.ui \
     ui/FloatingTabWindow.ui \
     ui/FrequencyCorrectionDialog.ui \
+    ui/UpcomingPassesDialog.ui \
     ui/GainControl.ui \
     ui/GainSlider.ui \
     ui/GuiConfigTab.ui \
@@ -478,6 +530,7 @@ packagesExist(libcurl) {
 
 packagesExist(volk) {
   PKGCONFIG += volk
+  QMAKE_CXXFLAGS += -DHAVE_VOLK
 }
   
 # Sound API detection. We first check for system-specific audio libraries,
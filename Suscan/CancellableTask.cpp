@@ -25,7 +25,8 @@ Q_DECLARE_METATYPE(Suscan::CancellableTask *);
 static bool typesRegistered = false;
 
 ////////////////////////////// CancellableTask /////////////////////////////////
-CancellableTask::CancellableTask(QObject *parent) : QObject(parent)
+CancellableTask::CancellableTask(QObject *parent) :
+  QObject(parent), cancelRequested(false)
 {
   assertTypeRegistration();
 }
@@ -61,6 +62,18 @@ CancellableTask::setStatus(QString status)
   this->status = status;
 }
 
+void
+CancellableTask::requestCancel(void)
+{
+  this->cancelRequested = true;
+}
+
+bool
+CancellableTask::isCancelRequested(void) const
+{
+  return this->cancelRequested;
+}
+
 void
 CancellableTask::onWorkRequested(void)
 {
@@ -178,6 +191,7 @@ CancellableController::cancel(void)
     return false;
 
   this->cancelledState = true;
+  this->task->requestCancel();
   emit cancelling();
   emit queuedCancel();
 
@@ -31,6 +31,9 @@
 #include <UIListenerFactory.h>
 #include <InspectionWidgetFactory.h>
 #include <SourceConfigWidgetFactory.h>
+#include <Suscan/StartupCache.h>
+#include <algorithm>
+#include <thread>
 
 using namespace Suscan;
 
@@ -134,6 +137,9 @@ Singleton::Singleton()
 Singleton::~Singleton()
 {
   this->killBackgroundTaskController();
+
+  if (this->startupCache != nullptr)
+    delete this->startupCache;
 }
 
 Singleton *
@@ -204,7 +210,7 @@ Singleton::init_sources()
   if (!this->sources_initd) {
     SU_ATTEMPT(suscan_init_sources());
     suscan_source_config_walk(walk_all_sources, static_cast<void *>(this));
-    suscan_source_device_walk(walk_all_devices, static_cast<void *>(this));
+    this->refreshDevices();
     this->sources_initd = true;
   }
 }
@@ -344,13 +350,25 @@ Singleton::init_fats()
   }
 }
 
+//
+// When the startup cache holds a snapshot of an unmodified bookmark file,
+// the config context is not even loaded: it will be the first time the
+// list needs to be modified.
+//
 void
 Singleton::init_bookmarks()
 {
   unsigned int i, count;
+  qreal freq;
+
+  if (this->startupCache != nullptr
+      && this->startupCache->lookupBookmarks(this->bookmarks)) {
+    ++this->bookmarkRevision;
+    return;
+  }
+
   ConfigContext ctx("bookmarks");
   Object list = ctx.listObject();
-  qreal freq;
 
   ctx.setSave(true);
 
@@ -383,6 +401,11 @@ Singleton::init_bookmarks()
 
     } catch (Suscan::Exception const &) { }
   }
+
+  if (this->startupCache != nullptr)
+    this->startupCache->storeBookmarks(this->bookmarks);
+
+  ++this->bookmarkRevision;
 }
 
 void
@@ -458,25 +481,114 @@ Singleton::init_tle_sources()
 }
 
 
+//
+// Cached files are restored as they are. The rest are parsed in parallel
+// and inserted in directory order, so that duplicate names resolve the
+// same way they always did.
+//
+// This runs concurrently with the config stages, which use the confdb.
+// The confdb is not thread safe, so the directory is resolved by the
+// caller (see getUserTLEDir) before the stages start.
+//
 void
-Singleton::init_tle()
+Singleton::init_tle(QString const &userTLEDir)
 {
-  const char *userTLEDir;
+  std::vector<QFileInfo> files;
+  std::vector<Orbit> orbits;
+  std::vector<char> parsed, hit;
+  std::vector<size_t> misses;
+  std::vector<std::thread> threads;
+  unsigned int workers;
 
-  if ((userTLEDir = suscan_confdb_get_local_tle_path()) != nullptr) {
-    QDirIterator it(userTLEDir, QDirIterator::NoIteratorFlags);
+  if (userTLEDir.isEmpty())
+    return;
 
-    while (it.hasNext()) {
-      QFile f(it.next());
-      QFileInfo fi(f);
+  QDirIterator it(userTLEDir, QDirIterator::NoIteratorFlags);
 
-      if (fi.completeSuffix().toLower() == "tle") {
-        Orbit orbit;
-        if (orbit.loadFromFile(f.fileName().toStdString().c_str()))
-          this->satellites[orbit.nameToQString()] = orbit;
-      }
+  while (it.hasNext()) {
+    QFileInfo fi(it.next());
+
+    if (fi.completeSuffix().toLower() == "tle")
+      files.push_back(fi);
+  }
+
+  orbits.resize(files.size());
+  parsed.resize(files.size(), 0);
+  hit.resize(files.size(), 0);
+
+  for (size_t i = 0; i < files.size(); ++i) {
+    bool ok = false;
+
+    if (this->startupCache != nullptr
+        && this->startupCache->lookupOrbit(files[i], orbits[i], ok)) {
+      hit[i]    = 1;
+      parsed[i] = ok;
+    } else {
+      misses.push_back(i);
     }
   }
+
+  workers = std::thread::hardware_concurrency();
+  if (workers == 0)
+    workers = 1;
+  if (workers > misses.size())
+    workers = static_cast<unsigned>(misses.size());
+
+  for (unsigned int w = 0; w < workers; ++w)
+    threads.push_back(std::thread([&, w] () {
+      for (size_t j = w; j < misses.size(); j += workers) {
+        size_t i = misses[j];
+        parsed[i] = orbits[i].loadFromFile(
+              files[i].filePath().toStdString().c_str());
+      }
+    }));
+
+  for (auto &t : threads)
+    t.join();
+
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (!hit[i] && this->startupCache != nullptr)
+      this->startupCache->storeOrbit(files[i], parsed[i] ? &orbits[i] : nullptr);
+
+    if (parsed[i])
+      this->satellites[orbits[i].nameToQString()] = orbits[i];
+  }
+
+  SU_INFO(
+        "%d TLE files (%d from startup cache)\n",
+        static_cast<int>(files.size()),
+        static_cast<int>(files.size() - misses.size()));
+}
+
+void
+Singleton::init_startup_cache()
+{
+  if (this->startupCache == nullptr) {
+    this->startupCache = new StartupCache();
+    this->startupCache->load();
+  }
+}
+
+QString
+Singleton::getUserTLEDir() const
+{
+  const char *userTLEDir = suscan_confdb_get_local_tle_path();
+
+  return userTLEDir != nullptr ? QString(userTLEDir) : QString();
+}
+
+//
+// Call only when the bookmark list is in sync with the file on disk, i.e.
+// right after init or after saving the config.
+//
+void
+Singleton::saveStartupCache()
+{
+  if (this->startupCache != nullptr) {
+    this->startupCache->storeBookmarks(this->bookmarks);
+    if (!this->startupCache->save())
+      SU_WARNING("Failed to save startup cache\n");
+  }
 }
 
 void
@@ -524,6 +636,48 @@ Singleton::refreshDevices()
 {
   this->devices.clear();
   suscan_source_device_walk(walk_all_devices, static_cast<void *>(this));
+
+  this->deviceState.clear();
+  for (auto const &dev : this->devices)
+    this->deviceState[dev.getInstance()] = dev.isAvailable();
+}
+
+//
+// Suscan never frees the devices it discovered: those that disappear are
+// just flagged as unavailable. Devices are compared against the
+// availability recorded in the previous refresh, so that the UI can be
+// updated with what actually changed.
+//
+bool
+Singleton::updateDevices(
+    std::vector<Source::Device> &added,
+    std::vector<Source::Device> &removed)
+{
+  QHash<const suscan_source_device_t *, bool> previous = this->deviceState;
+
+  added.clear();
+  removed.clear();
+
+  this->refreshDevices();
+
+  for (auto const &dev : this->devices) {
+    auto p = previous.find(dev.getInstance());
+    bool wasAvailable = p != previous.end() && *p;
+
+    if (dev.isAvailable() && !wasAvailable)
+      added.push_back(dev);
+    else if (!dev.isAvailable() && wasAvailable)
+      removed.push_back(dev);
+
+    previous.remove(dev.getInstance());
+  }
+
+  // Devices no longer reported at all
+  for (auto const &dev : previous.keys())
+    if (previous[dev])
+      removed.push_back(Source::Device(dev, 0));
+
+  return !added.empty() || !removed.empty();
 }
 
 void
@@ -555,11 +709,15 @@ Singleton::setQth(Location const &loc)
   suscan_set_qth(&loc.site);
 }
 
+//
+// May block for a long time, and therefore is meant to be run from a worker
+// thread. The device list itself is updated from the GUI thread by
+// updateDevices().
+//
 void
 Singleton::detect_devices()
 {
   suscan_source_detect_devices();
-  this->refreshDevices();
 }
 
 void
@@ -692,23 +850,36 @@ Singleton::syncUI()
 void
 Singleton::syncBookmarks()
 {
+  bool pending = false;
+
+  for (auto const &bm : this->bookmarks)
+    if (bm.entry == -1)
+      pending = true;
+
+  // The context may have never been loaded if it came from the cache
+  if (!pending)
+    return;
+
   ConfigContext ctx("bookmarks");
   Object list = ctx.listObject();
 
+  ctx.setSave(true);
+
   // Sync all modified configurations
-  for (auto p : this->bookmarks.keys()) {
-    if (this->bookmarks[p].entry == -1) {
+  for (auto &bm : this->bookmarks) {
+    if (bm.entry == -1) {
       try {
         Object obj(SUSCAN_OBJECT_TYPE_OBJECT);
 
-        obj.set("name", this->bookmarks[p].info.name.toStdString());
-        obj.set("frequency", static_cast<double>(this->bookmarks[p].info.frequency));
-        obj.set("color", this->bookmarks[p].info.color.name().toStdString());
-        obj.set("low_freq_cut", this->bookmarks[p].info.lowFreqCut);
-        obj.set("high_freq_cut", this->bookmarks[p].info.highFreqCut);
-        obj.set("modulation", this->bookmarks[p].info.modulation.toStdString());
+        obj.set("name", bm.info.name.toStdString());
+        obj.set("frequency", static_cast<double>(bm.info.frequency));
+        obj.set("color", bm.info.color.name().toStdString());
+        obj.set("low_freq_cut", bm.info.lowFreqCut);
+        obj.set("high_freq_cut", bm.info.highFreqCut);
+        obj.set("modulation", bm.info.modulation.toStdString());
 
         list.append(std::move(obj));
+        bm.entry = static_cast<int>(list.length() - 1);
       } catch (Suscan::Exception const &) {
       }
     }
@@ -798,6 +969,36 @@ Singleton::saveProfile(Suscan::Source::Config const &profile)
           this->profiles[profile.label()].instance));
 }
 
+//
+// Removing an element from the config list shifts all the elements after
+// it, so the entry indices of the remaining bookmarks must follow. Doing
+// it for all removed entries at once keeps bulk edits linear.
+//
+void
+Singleton::dropBookmarkEntries(std::vector<int> &entries)
+{
+  if (entries.empty())
+    return;
+
+  ConfigContext ctx("bookmarks");
+  Object list = ctx.listObject();
+
+  ctx.setSave(true);
+
+  std::sort(entries.begin(), entries.end());
+
+  for (auto p = entries.rbegin(); p != entries.rend(); ++p)
+    list.remove(static_cast<unsigned>(*p));
+
+  for (auto &bm : this->bookmarks) {
+    if (bm.entry != -1) {
+      auto shift = std::lower_bound(entries.begin(), entries.end(), bm.entry)
+          - entries.begin();
+      bm.entry -= static_cast<int>(shift);
+    }
+  }
+}
+
 void
 Singleton::removeBookmark(qint64 freq)
 {
@@ -806,10 +1007,11 @@ Singleton::removeBookmark(qint64 freq)
     this->bookmarks.remove(freq);
 
     if (bm.entry != -1) {
-      ConfigContext ctx("bookmarks");
-      Object list = ctx.listObject();
-      list.remove(static_cast<unsigned>(bm.entry));
+      std::vector<int> entries = {bm.entry};
+      this->dropBookmarkEntries(entries);
     }
+
+    ++this->bookmarkRevision;
   }
 }
 
@@ -822,6 +1024,7 @@ Singleton::replaceBookmark(BookmarkInfo const& info)
 
   this->removeBookmark(info.frequency);
   this->bookmarks[info.frequency] = bm;
+  ++this->bookmarkRevision;
 }
 
 bool
@@ -834,6 +1037,7 @@ Singleton::registerBookmark(BookmarkInfo const& info)
 
   bm.info = info;
   this->bookmarks[info.frequency] = bm;
+  ++this->bookmarkRevision;
 
   return true;
 }
@@ -1098,6 +1302,12 @@ Singleton::getBookmarkFrom(qint64 freq) const
   return this->bookmarks.lowerBound(freq);
 }
 
+quint64
+Singleton::getBookmarkRevision() const
+{
+  return this->bookmarkRevision;
+}
+
 QMap<QString, Location> const &
 Singleton::getLocationMap() const
 {
@@ -18,24 +18,81 @@
 //
 
 #include <Suscan/Messages/PSDMessage.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#ifdef HAVE_VOLK
+#  include <volk/volk.h>
+#endif // HAVE_VOLK
 
 using namespace Suscan;
 
+//
+// 10 log10(x) computed as 10 log10(2) log2(x), with log2 taken from the
+// exponent bits plus an odd series on the mantissa. Good to about 1e-4 dB
+// and free of libm calls, so the loop vectorizes.
+//
+// Inputs are first clamped to the same 1e-15 floor SU_POWER_DB applies,
+// so that zero, denormal, negative or NaN bins give -150 dB instead of
+// -inf or garbage out of the exponent bits.
+//
+#define SIGDIGGER_PSD_POWER_FLOOR 1e-15f
+
+static void
+powerToDb(float *data, SUSCOUNT size)
+{
+  // Floor first: std::max returns its first argument for NaN inputs
+  for (SUSCOUNT i = 0; i < size; ++i)
+    data[i] = std::max(SIGDIGGER_PSD_POWER_FLOOR, data[i]);
+
+#ifdef HAVE_VOLK
+  volk_32f_log2_32f(data, data, static_cast<unsigned int>(size));
+  volk_32f_s32f_multiply_32f(
+        data,
+        data,
+        3.010299956639812f,
+        static_cast<unsigned int>(size));
+#else
+  for (SUSCOUNT i = 0; i < size; ++i) {
+    uint32_t bits;
+    float m, t, t2, e;
+
+    memcpy(&bits, data + i, sizeof(float));
+    e = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    memcpy(&m, &bits, sizeof(float));
+
+    t  = (m - 1) / (m + 1);
+    t2 = t * t;
+
+    data[i] = 3.010299956639812f * (e + t * (2.885390082f + t2 * (
+          .9617966939f + t2 * (.5770780164f + t2 * .4121985831f))));
+  }
+#endif // HAVE_VOLK
+}
+
+static void
+powerToDb(double *data, SUSCOUNT size)
+{
+  for (SUSCOUNT i = 0; i < size; ++i)
+    data[i] = SU_POWER_DB(data[i]);
+}
+
 PSDMessage::PSDMessage() : Message() { }
 
 PSDMessage::PSDMessage(struct suscan_analyzer_psd_msg *msg) :
   Message(SUSCAN_ANALYZER_MESSAGE_TYPE_PSD, msg)
 {
-  unsigned int i;
   SUSCOUNT half_size{msg->psd_size / 2};
-  SUFLOAT tmp;
   this->message = msg;
 
-  for (i = 0; i < half_size; ++i) {
-    tmp = msg->psd_data[i + half_size];
-    msg->psd_data[i + half_size] = SU_POWER_DB(msg->psd_data[i]);
-    msg->psd_data[i] = SU_POWER_DB(tmp);
-  }
+  // FFT order to frequency order, then to dB
+  std::swap_ranges(
+        msg->psd_data,
+        msg->psd_data + half_size,
+        msg->psd_data + half_size);
+  powerToDb(msg->psd_data, 2 * half_size);
 }
 
 SUSCOUNT
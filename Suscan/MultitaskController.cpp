@@ -238,14 +238,19 @@ MultitaskController::getTaskVector(QVector<CancellableTaskContext *> &vec) const
 void
 MultitaskController::cancelAll(void)
 {
+  for (auto p : this->taskList)
+    p->task()->requestCancel();
+
   emit cancel();
 }
 
 void
 MultitaskController::cancelByIndex(int index)
 {
-  if (index >= 0 && index < this->taskVec.size())
+  if (index >= 0 && index < this->taskVec.size()) {
+    this->taskVec[index]->task()->requestCancel();
     this->taskVec[index]->task()->cancel();
+  }
 }
 
 void
@@ -0,0 +1,272 @@
+//
+//    StartupCache.cpp: Binary snapshot of slow-to-parse startup data
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <Suscan/StartupCache.h>
+#include <QDataStream>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QFile>
+#include <cstring>
+
+using namespace Suscan;
+
+bool
+StartupCache::FileStamp::matches(QFileInfo const &info) const
+{
+  FileStamp other = FileStamp::of(info);
+
+  return other.mtime >= 0 && other.mtime == mtime && other.size == size;
+}
+
+StartupCache::FileStamp
+StartupCache::FileStamp::of(QFileInfo const &info)
+{
+  FileStamp stamp;
+
+  if (info.exists()) {
+    stamp.mtime = info.lastModified().toMSecsSinceEpoch();
+    stamp.size  = info.size();
+  }
+
+  return stamp;
+}
+
+StartupCache::StartupCache()
+{
+  const char *local = suscan_confdb_get_local_path();
+
+  if (local != nullptr)
+    m_path = QString(local) + "/" SUSCAN_STARTUP_CACHE_FILE;
+}
+
+QString
+StartupCache::bookmarkFile()
+{
+  const char *local = suscan_confdb_get_local_path();
+
+  if (local == nullptr)
+    return QString();
+
+  return QString(local) + "/bookmarks.xml";
+}
+
+//
+// A cache that fails to load for whatever reason is simply empty: every
+// lookup will miss and the data will be parsed from the original files.
+//
+bool
+StartupCache::load()
+{
+  QFile file(m_path);
+  quint32 magic, version, orbitSize, tleCount, bmCount;
+
+  m_tle.clear();
+  m_bookmarks.clear();
+  m_bookmarksValid = false;
+
+  if (m_path.isEmpty() || !file.open(QIODevice::ReadOnly))
+    return false;
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_0);
+
+  in >> magic >> version >> orbitSize;
+
+  if (magic != SUSCAN_STARTUP_CACHE_MAGIC
+      || version != SUSCAN_STARTUP_CACHE_VERSION
+      || orbitSize != sizeof(orbit_t))
+    return false;
+
+  in >> tleCount;
+  for (quint32 i = 0; i < tleCount && in.status() == QDataStream::Ok; ++i) {
+    QString path;
+    TLEEntry entry;
+
+    in >> path
+       >> entry.stamp.mtime
+       >> entry.stamp.size
+       >> entry.valid
+       >> entry.name
+       >> entry.orbit;
+
+    if (entry.valid && entry.orbit.size() != sizeof(orbit_t))
+      continue;
+
+    m_tle[path] = entry;
+  }
+
+  in >> m_bookmarkStamp.mtime >> m_bookmarkStamp.size >> bmCount;
+  for (quint32 i = 0; i < bmCount && in.status() == QDataStream::Ok; ++i) {
+    Bookmark bm;
+    qint32 entry;
+
+    in >> bm.info.name
+       >> bm.info.frequency
+       >> bm.info.color
+       >> bm.info.lowFreqCut
+       >> bm.info.highFreqCut
+       >> bm.info.modulation
+       >> entry;
+
+    bm.entry = entry;
+    m_bookmarks.append(bm);
+  }
+
+  if (in.status() != QDataStream::Ok) {
+    m_tle.clear();
+    m_bookmarks.clear();
+    return false;
+  }
+
+  m_bookmarksValid = true;
+
+  return true;
+}
+
+bool
+StartupCache::save()
+{
+  bool pruned = m_tleSeen.size() != m_tle.size();
+
+  if (m_path.isEmpty() || !(m_tleDirty || m_bookmarksDirty || pruned))
+    return true;
+
+  QSaveFile file(m_path);
+
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_0);
+
+  out << quint32(SUSCAN_STARTUP_CACHE_MAGIC)
+      << quint32(SUSCAN_STARTUP_CACHE_VERSION)
+      << quint32(sizeof(orbit_t));
+
+  // Only the TLE files that still exist are kept
+  out << quint32(m_tleSeen.size());
+  for (auto p = m_tleSeen.cbegin(); p != m_tleSeen.cend(); ++p)
+    out << p.key()
+        << p->stamp.mtime
+        << p->stamp.size
+        << p->valid
+        << p->name
+        << p->orbit;
+
+  if (m_bookmarksValid) {
+    out << m_bookmarkStamp.mtime
+        << m_bookmarkStamp.size
+        << quint32(m_bookmarks.size());
+
+    for (auto const &bm : m_bookmarks)
+      out << bm.info.name
+          << bm.info.frequency
+          << bm.info.color
+          << bm.info.lowFreqCut
+          << bm.info.highFreqCut
+          << bm.info.modulation
+          << qint32(bm.entry);
+  } else {
+    out << qint64(-1) << qint64(-1) << quint32(0);
+  }
+
+  if (!file.commit())
+    return false;
+
+  m_tle = m_tleSeen;
+  m_tleDirty = m_bookmarksDirty = false;
+
+  return true;
+}
+
+bool
+StartupCache::lookupOrbit(QFileInfo const &info, Orbit &orbit, bool &ok)
+{
+  QString path = info.absoluteFilePath();
+  auto p = m_tle.find(path);
+
+  if (p == m_tle.end() || !p->stamp.matches(info))
+    return false;
+
+  ok = p->valid;
+
+  if (ok) {
+    orbit_t copy;
+
+    memcpy(&copy, p->orbit.constData(), sizeof(orbit_t));
+    copy.name = p->name.data();
+
+    orbit = Orbit(&copy);
+  }
+
+  m_tleSeen[path] = *p;
+
+  return true;
+}
+
+void
+StartupCache::storeOrbit(QFileInfo const &info, Orbit const *orbit)
+{
+  TLEEntry entry;
+
+  entry.stamp = FileStamp::of(info);
+  entry.valid = orbit != nullptr;
+
+  if (entry.valid) {
+    orbit_t copy = orbit->getCOrbit();
+
+    entry.name = QByteArray(copy.name != nullptr ? copy.name : "");
+    copy.name = nullptr;
+    entry.orbit = QByteArray(
+          reinterpret_cast<const char *>(&copy),
+          sizeof(orbit_t));
+  }
+
+  m_tleSeen[info.absoluteFilePath()] = entry;
+  m_tleDirty = true;
+}
+
+bool
+StartupCache::lookupBookmarks(QMap<qint64, Bookmark> &map) const
+{
+  if (!m_bookmarksValid || !m_bookmarkStamp.matches(QFileInfo(bookmarkFile())))
+    return false;
+
+  map.clear();
+
+  for (auto const &bm : m_bookmarks)
+    map[bm.info.frequency] = bm;
+
+  return true;
+}
+
+//
+// Only meaningful right after the bookmark list has been parsed or saved,
+// i.e. when the entry indices match the file on disk.
+//
+void
+StartupCache::storeBookmarks(QMap<qint64, Bookmark> const &map)
+{
+  QFileInfo info(bookmarkFile());
+
+  m_bookmarkStamp  = FileStamp::of(info);
+  m_bookmarksValid = m_bookmarkStamp.mtime >= 0;
+  m_bookmarks      = map.values();
+  m_bookmarksDirty = true;
+}
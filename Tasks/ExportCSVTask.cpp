@@ -18,59 +18,74 @@
 //
 
 #include <ExportCSVTask.h>
-#include <QCoreApplication>
+#include <TextBlockWriter.h>
 
 using namespace SigDigger;
 
 #define SIGDIGGER_EXPORT_CSV_BREATHE_INTERVAL_MS 100
-#define SIGDIGGER_EXPORT_CSV_BREATHE_BLOCK_SIZE  0x10000
 
-void
+bool
 ExportCSVTask::breathe(quint64 i)
 {
   if (m_timer.elapsed() > SIGDIGGER_EXPORT_CSV_BREATHE_INTERVAL_MS) {
     m_timer.restart();
     emit progress(
-        static_cast<qreal>(i) / static_cast<qreal>(m_size - 1),
+        static_cast<qreal>(i) / static_cast<qreal>(m_size),
         "Saving data");
-    QCoreApplication::processEvents();
   }
+
+  return !isCancelRequested();
 }
 
 bool
 ExportCSVTask::exportToCSV()
 {
+  std::vector<const SUCOMPLEX *> columns;
   unsigned int c = 0;
+  bool ok;
 
   for (auto &p : m_columns) {
     if (c++ > 0)
       m_of << ",";
 
     m_of << p.first;
+    columns.push_back(p.second.data());
   }
 
   m_of << "\n";
 
-
-  for (SUSCOUNT i = 0; !m_cancelFlag && i < m_size; ++i) {
-    c = 0;
-
-    for (auto &p : m_columns) {
-      if (c++ > 0)
-        m_of << ",";
-
-      m_of
-         << SU_C_REAL(p.second[i]) << "+"
-         << SU_C_IMAG(p.second[i]) << "i";
-    }
-
-
-    if (i % SIGDIGGER_EXPORT_CSV_BREATHE_BLOCK_SIZE == 0)
-      breathe(i);
+  TextBlockWriter writer(
+        m_of,
+        columns.size() * (2 * SIGDIGGER_TEXT_MAX_NUMBER_LENGTH + 3) + 1);
+
+  ok = writer.write(
+        m_size,
+        [&columns] (char *p, size_t from, size_t to) {
+          for (size_t i = from; i < to; ++i) {
+            for (size_t j = 0; j < columns.size(); ++j) {
+              if (j > 0)
+                *p++ = ',';
+
+              p = formatReal(p, SU_C_REAL(columns[j][i]));
+              *p++ = '+';
+              p = formatReal(p, SU_C_IMAG(columns[j][i]));
+              *p++ = 'i';
+            }
+
+            *p++ = '\n';
+          }
+
+          return p;
+        },
+        [this] (size_t i) {
+          return breathe(i);
+        });
+
+  if (!ok && !isCancelRequested()) {
+    emit error("Cannot save data to " + m_path + ": " + strerror(errno));
+    return false;
   }
 
-  m_of << "];\n";
-
   return true;
 }
 
@@ -84,7 +99,7 @@ ExportCSVTask::work()
   ok = exportToCSV();
 
   if (ok) {
-    if (m_cancelFlag)
+    if (isCancelRequested())
       emit cancelled();
     else
       emit done();
@@ -96,7 +111,7 @@ ExportCSVTask::work()
 void
 ExportCSVTask::cancel()
 {
-  m_cancelFlag = true;
+  requestCancel();
 }
 
 
@@ -17,14 +17,31 @@
 //    <http://www.gnu.org/licenses/>
 //
 #include <ExportSamplesTask.h>
-#include <QCoreApplication>
+#include <TextBlockWriter.h>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
 
 using namespace SigDigger;
 
 #define SIGDIGGER_EXPORT_SAMPLES_BREATHE_INTERVAL_MS 100
 #define SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE  0x10000
+#define SIGDIGGER_EXPORT_SAMPLES_BINARY_BLOCK_SIZE   0x100000
 
-void
+// MAT-file level 5 data types and array classes
+#define MAT5_MI_INT8          1
+#define MAT5_MI_INT32         5
+#define MAT5_MI_UINT32        6
+#define MAT5_MI_SINGLE        7
+#define MAT5_MI_DOUBLE        9
+#define MAT5_MI_MATRIX        14
+#define MAT5_MX_DOUBLE_CLASS  6
+#define MAT5_MX_SINGLE_CLASS  7
+#define MAT5_HEADER_TEXT_SIZE 116
+
+#define NPY_ALIGNMENT         64
+
+bool
 ExportSamplesTask::breathe(quint64 i)
 {
   size_t size = this->data.size();
@@ -32,35 +49,59 @@ ExportSamplesTask::breathe(quint64 i)
   if (this->timer.elapsed() > SIGDIGGER_EXPORT_SAMPLES_BREATHE_INTERVAL_MS) {
     this->timer.restart();
     emit progress(
-        static_cast<qreal>(i) / static_cast<qreal>(size - 1),
+        static_cast<qreal>(i) / static_cast<qreal>(size),
         "Saving data");
-    QCoreApplication::processEvents();
   }
+
+  return !this->isCancelRequested();
 }
 
 bool
 ExportSamplesTask::exportToMatlab(void)
 {
   size_t size = this->data.size();
+  const SUCOMPLEX *samples = this->data.data();
+  char buf[2 * SIGDIGGER_TEXT_MAX_NUMBER_LENGTH];
+  TextBlockWriter writer(of, 2 * SIGDIGGER_TEXT_MAX_NUMBER_LENGTH + 8);
+  bool ok;
 
   of << "%\n";
   of << "% Time domain capture file generated by SigDigger\n";
   of << "%\n\n";
 
-  of << "sampleRate = " << this->fs << ";\n";
-  of << "deltaT = " << 1 / this->fs << ";\n";
-  of << "X = [ ";
+  of << "sampleRate = ";
+  of.write(buf, formatReal(buf, static_cast<double>(this->fs)) - buf);
+  of << ";\n";
 
-  of << std::setprecision(std::numeric_limits<float>::digits10);
+  of << "deltaT = ";
+  of.write(buf, formatReal(buf, static_cast<double>(1 / this->fs)) - buf);
+  of << ";\n";
 
+  of << "X = [ ";
 
-  for (size_t i = 0; !this->cancelFlag && i < size; ++i) {
-    of
-       << SU_C_REAL(this->data[i]) << " + "
-       << SU_C_IMAG(this->data[i]) << "i, ";
-
-    if (i % SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE == 0)
-      this->breathe(i);
+  ok = writer.write(
+        size,
+        [samples] (char *p, size_t from, size_t to) {
+          for (size_t i = from; i < to; ++i) {
+            p = formatReal(p, SU_C_REAL(samples[i]));
+            p = formatString(p, " + ");
+            p = formatReal(p, SU_C_IMAG(samples[i]));
+            p = formatString(p, "i, ");
+          }
+
+          return p;
+        },
+        [this] (size_t i) {
+          return this->breathe(i);
+        });
+
+  if (!ok && !this->isCancelRequested()) {
+    emit error(
+        "Cannot save data to MATLAB file "
+        + this->path
+        + ": "
+        + QString(strerror(errno)));
+    return false;
   }
 
   of << "];\n";
@@ -68,38 +109,44 @@ ExportSamplesTask::exportToMatlab(void)
   return true;
 }
 
+//
+// The sample buffer is already laid out as the file expects it (a 2xN
+// column-major matrix in MAT5, an array of complex numbers in NumPy), so
+// both formats are written in big blocks after a header.
+//
 bool
-ExportSamplesTask::exportToMat5(void)
+ExportSamplesTask::exportBinary(QString const &name)
 {
   size_t size = this->data.size();
-  bool ok = false;
+  size_t amount;
 
-  for (size_t i = 0; !this->cancelFlag && i < size; ++i) {
-    SU_TRYCATCH(
-          su_mat_file_stream_col(
-            this->mf,
-            SU_C_REAL(this->data[i]),
-            SU_C_IMAG(this->data[i])),
-          goto done);
-
-    if (i % SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE == 0) {
-      SU_TRYCATCH(su_mat_file_flush(mf), goto done);
-      this->breathe(i);
-    }
-  }
+  for (size_t i = 0; i < size; i += amount) {
+    amount = std::min(
+          size - i,
+          static_cast<size_t>(SIGDIGGER_EXPORT_SAMPLES_BINARY_BLOCK_SIZE));
 
-  SU_TRYCATCH(su_mat_file_flush(mf), goto done);
+    of.write(
+          reinterpret_cast<const char *>(this->data.data() + i),
+          static_cast<std::streamsize>(amount * sizeof(SUCOMPLEX)));
 
-  ok = true;
+    if (!of.good()) {
+      emit error(
+          "Cannot save data to "
+          + name
+          + " file "
+          + this->path
+          + ": "
+          + QString(strerror(errno)));
+      return false;
+    }
 
-done:
-  if (!ok)
-    emit error(
-        "Cannot save data to Mat5 file "
-        + this->path
-        + ". See error log for details.");
+    if (!this->breathe(i + amount))
+      break;
+  }
 
-  return ok;
+  of.flush();
+
+  return true;
 }
 
 bool
@@ -110,11 +157,7 @@ ExportSamplesTask::exportToWav(void)
   size_t i = 0;
   size_t amount;
 
-  for (
-       i = 0;
-       !this->cancelFlag && i < size;
-       i += SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE) {
-
+  for (i = 0; i < size; i += amount) {
     amount = size - i;
     if (amount > SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE)
       amount = SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE;
@@ -122,21 +165,14 @@ ExportSamplesTask::exportToWav(void)
     if (sf_write_float(
           this->sfp,
           reinterpret_cast<const SUFLOAT *>(this->data.data() + i),
-          2 * amount)
+          2 * static_cast<sf_count_t>(amount))
         != 2 * static_cast<sf_count_t>(amount))
         goto done;
 
-    this->breathe(i);
+    if (!this->breathe(i + amount))
+      break;
   }
 
-  if (i < size)
-    if (sf_write_float(
-        this->sfp,
-        reinterpret_cast<const SUFLOAT *>(this->data.data() + i),
-        2 * static_cast<sf_count_t>(size - i)) !=
-        2 * static_cast<sf_count_t>(size - i))
-      goto done;
-
   ok = true;
 
 done:
@@ -158,7 +194,9 @@ ExportSamplesTask::work(void)
   this->timer.start();
 
   if (this->format == "mat")
-    ok = this->exportToMat5();
+    ok = this->exportBinary("Mat5");
+  else if (this->format == "npy")
+    ok = this->exportBinary("NumPy");
   else if (this->format == "m")
     ok = this->exportToMatlab();
   else if (this->format == "wav" || this->format == "raw")
@@ -167,7 +205,7 @@ ExportSamplesTask::work(void)
     emit error("Unsupported data format " + this->format);
 
   if (ok) {
-    if (this->cancelFlag)
+    if (this->isCancelRequested())
       emit cancelled();
     else
       emit done();
@@ -179,42 +217,172 @@ ExportSamplesTask::work(void)
 void
 ExportSamplesTask::cancel(void)
 {
-  this->cancelFlag = true;
+  this->requestCancel();
+}
+
+/////////////////////////////// MAT5 helpers ///////////////////////////////////
+static inline quint32
+mat5Pad(quint32 size)
+{
+  return (size + 7) & ~7u;
+}
+
+static void
+mat5WriteTag(std::ostream &os, quint32 type, quint32 size)
+{
+  quint32 tag[2] = {type, size};
+
+  os.write(reinterpret_cast<const char *>(tag), sizeof(tag));
+}
+
+static void
+mat5WriteFileHeader(std::ostream &os)
+{
+  char text[MAT5_HEADER_TEXT_SIZE];
+  const char *desc = "MATLAB 5.0 MAT-file, created by SigDigger";
+  quint8 subsys[8] = {0};
+  quint16 version = 0x0100;
+  quint16 endian  = ('M' << 8) | 'I';
+
+  memset(text, ' ', sizeof(text));
+  memcpy(text, desc, strlen(desc));
+
+  os.write(text, sizeof(text));
+  os.write(reinterpret_cast<const char *>(subsys), sizeof(subsys));
+  os.write(reinterpret_cast<const char *>(&version), sizeof(quint16));
+  os.write(reinterpret_cast<const char *>(&endian), sizeof(quint16));
+}
+
+// Everything but the matrix data, which must follow
+static bool
+mat5WriteMatrixHeader(
+    std::ostream &os,
+    const char *name,
+    quint32 rows,
+    quint32 cols,
+    bool single)
+{
+  quint32 nameLen   = static_cast<quint32>(strlen(name));
+  quint64 dataBytes =
+      static_cast<quint64>(rows) * cols * (single ? sizeof(float) : sizeof(double));
+  quint64 total;
+  quint32 flags[2]  = {
+    static_cast<quint32>(single ? MAT5_MX_SINGLE_CLASS : MAT5_MX_DOUBLE_CLASS),
+    0};
+  quint32 dims[2]   = {rows, cols};
+  char namePad[8]   = {0};
+
+  total = 16 + 16 + 8 + mat5Pad(nameLen) + 8 + ((dataBytes + 7) & ~7ull);
+
+  // Element sizes are 32 bit
+  if (total > 0xffffffffull)
+    return false;
+
+  mat5WriteTag(os, MAT5_MI_MATRIX, static_cast<quint32>(total));
+
+  mat5WriteTag(os, MAT5_MI_UINT32, sizeof(flags));
+  os.write(reinterpret_cast<const char *>(flags), sizeof(flags));
+
+  mat5WriteTag(os, MAT5_MI_INT32, sizeof(dims));
+  os.write(reinterpret_cast<const char *>(dims), sizeof(dims));
+
+  mat5WriteTag(os, MAT5_MI_INT8, nameLen);
+  os.write(name, nameLen);
+  os.write(namePad, mat5Pad(nameLen) - nameLen);
+
+  mat5WriteTag(
+        os,
+        single ? MAT5_MI_SINGLE : MAT5_MI_DOUBLE,
+        static_cast<quint32>(dataBytes));
+
+  return true;
+}
+
+static void
+mat5WriteScalar(std::ostream &os, const char *name, double value)
+{
+  mat5WriteMatrixHeader(os, name, 1, 1, false);
+  os.write(reinterpret_cast<const char *>(&value), sizeof(double));
 }
 
 bool
 ExportSamplesTask::openMat5(void)
 {
-  su_mat_matrix_t *mtx = nullptr;
-  bool ok = false;
+  bool single = sizeof(SUFLOAT) == sizeof(float);
 
-  SU_TRYCATCH(this->mf = su_mat_file_new(), goto done);
+  if (!this->openStream())
+    return false;
 
-  SU_TRYCATCH(
-        mtx = su_mat_file_make_matrix(this->mf, "sampleRate", 1, 1),
-        goto done);
-  SU_TRYCATCH(su_mat_matrix_write_col(mtx, fs), goto done);
+  mat5WriteFileHeader(this->of);
+  mat5WriteScalar(this->of, "sampleRate", this->fs);
+  mat5WriteScalar(this->of, "deltaT", 1 / this->fs);
 
-  SU_TRYCATCH(
-        mtx = su_mat_file_make_matrix(this->mf, "deltaT", 1, 1),
-        goto done);
-  SU_TRYCATCH(su_mat_matrix_write_col(mtx, 1 / fs), goto done);
+  if (!mat5WriteMatrixHeader(
+        this->of,
+        "X",
+        2,
+        static_cast<quint32>(this->data.size()),
+        single)) {
+    this->lastError =
+          "Selection is too big for a MAT5 file. Please save it as a "
+          "NumPy array or as raw I/Q data instead.";
+    return false;
+  }
 
-  SU_TRYCATCH(
-        mtx = su_mat_file_make_streaming_matrix(this->mf, "X", 2, 0),
-        goto done);
-  SU_TRYCATCH(su_mat_file_dump(mf, path.toStdString().c_str()), goto done);
+  if (!this->of.good()) {
+    this->lastError =
+          "Cannot create Mat5 file "
+          + this->path
+          + ": "
+          + QString(strerror(errno));
+    return false;
+  }
 
-  ok = true;
+  return true;
+}
 
-done:
-  if (!ok)
+bool
+ExportSamplesTask::openNpy(void)
+{
+  std::string header;
+  quint16 headerLen;
+  quint8 preamble[10] = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0, 0, 0};
+
+  if (!this->openStream())
+    return false;
+
+  header = "{'descr': '";
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+  header += "<";
+#else
+  header += ">";
+#endif // Q_BYTE_ORDER
+  header += sizeof(SUFLOAT) == sizeof(float) ? "c8" : "c16";
+  header += "', 'fortran_order': False, 'shape': (";
+  header += std::to_string(this->data.size());
+  header += ",), }";
+
+  // Pad with spaces, so that data is aligned. The header ends with a newline
+  while ((sizeof(preamble) + header.size() + 1) % NPY_ALIGNMENT != 0)
+    header += " ";
+  header += "\n";
+
+  headerLen = static_cast<quint16>(header.size());
+  qToLittleEndian(headerLen, preamble + 8);
+
+  this->of.write(reinterpret_cast<const char *>(preamble), sizeof(preamble));
+  this->of.write(header.c_str(), static_cast<std::streamsize>(header.size()));
+
+  if (!this->of.good()) {
     this->lastError =
-          "Cannot create Mat5 file "
+          "Cannot create NumPy file "
           + this->path
-          + ". See error log for details.";
+          + ": "
+          + QString(strerror(errno));
+    return false;
+  }
 
-  return ok;
+  return true;
 }
 
 QString
@@ -224,7 +392,7 @@ ExportSamplesTask::getLastError(void) const
 }
 
 bool
-ExportSamplesTask::openMatlab(void)
+ExportSamplesTask::openStream(void)
 {
   this->of = std::ofstream(path.toStdString().c_str(), std::ofstream::binary);
 
@@ -295,13 +463,15 @@ ExportSamplesTask::attemptOpen(void)
   if (this->format == "mat")
     return this->openMat5();
   else if (this->format == "m")
-    return this->openMatlab();
+    return this->openStream();
+  else if (this->format == "npy")
+    return this->openNpy();
   else if (this->format == "wav")
     return this->openWav();
   else if (this->format == "raw")
     return this->openRaw();
   else
-    this->lastError = "Unsupported format \"" + this->lastError + "\"";
+    this->lastError = "Unsupported format \"" + this->format + "\"";
 
   return false;
 }
@@ -310,9 +480,6 @@ ExportSamplesTask::~ExportSamplesTask(void)
 {
   if (this->sfp != nullptr)
     sf_close(this->sfp);
-
-  if (this->mf != nullptr)
-    su_mat_file_destroy(this->mf);
 }
 
 ExportSamplesTask::ExportSamplesTask(
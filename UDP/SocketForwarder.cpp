@@ -23,6 +23,15 @@
 #include <sigutils/util/compat-in.h>
 #include <sigutils/util/compat-netdb.h>
 #include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#  include <netinet/udp.h>
+#  define SIGDIGGER_HAVE_SENDMMSG
+#  if defined(UDP_SEGMENT) && defined(SOL_UDP)
+#    define SIGDIGGER_HAVE_UDP_GSO
+#  endif // UDP_SEGMENT
+#endif // __linux__
 
 #ifndef MSG_NOSIGNAL
 #  define MSG_NOSIGNAL 0
@@ -39,16 +48,35 @@ namespace SigDigger {
     int fd = -1;
     bool solved = false;
     bool tcp = false;
-    char pad2[2];
+    bool header = false;
+    bool gso = false;
     unsigned int size = 0;
+    size_t payload = 0;    // Sample bytes per datagram
+    uint32_t sequence = 0;
     std::string lastError;
 
+    // Preallocated batch descriptors
+    std::vector<SigDiggerForwarderHeader> headers;
+    std::vector<uint8_t> datagram;
+#ifdef SIGDIGGER_HAVE_SENDMMSG
+    std::vector<struct iovec>   iov;
+    std::vector<struct mmsghdr> msgs;
+#endif // SIGDIGGER_HAVE_SENDMMSG
+
+    void setupDatagrams(void);
+    ssize_t writeStream(const uint8_t *data, size_t len);
+    ssize_t writeDatagrams(const uint8_t *data, size_t len);
+#ifdef SIGDIGGER_HAVE_UDP_GSO
+    ssize_t writeSegmented(const uint8_t *data, size_t len);
+#endif // SIGDIGGER_HAVE_UDP_GSO
+
   public:
     SocketDataWriter(
         std::string const &host,
         uint16_t port,
         unsigned int size,
-        bool tcp);
+        bool tcp,
+        bool header);
 
     bool prepare(void) override;
     std::string getError(void) const override;
@@ -63,10 +91,64 @@ SocketDataWriter::SocketDataWriter(
     std::string const &host,
     uint16_t port,
     unsigned int size,
-    bool tcp) :
-  host(host), port(port), tcp(tcp), size(size)
+    bool tcp,
+    bool header) :
+  host(host), port(port), tcp(tcp), header(header), size(size)
 {
-  this->pad[0] = this->pad2[0] = 0; // Shut up
+  this->pad[0] = 0; // Shut up
+}
+
+void
+SocketDataWriter::setupDatagrams(void)
+{
+  size_t datagram = this->size;
+  size_t overhead = this->header ? sizeof(SigDiggerForwarderHeader) : 0;
+  int sndbuf = SIGDIGGER_UDPFORWARDER_SNDBUF_SIZE;
+
+#ifdef IP_MTU
+  // Connected UDP sockets know the path MTU. Going above it would only
+  // cause IP fragmentation (on loopback, this is 64 KiB).
+  int mtu = 0;
+  socklen_t mtuLen = sizeof(int);
+  if (getsockopt(this->fd, IPPROTO_IP, IP_MTU, &mtu, &mtuLen) == 0
+      && mtu > SIGDIGGER_UDPFORWARDER_IPV4_UDP_OVERHEAD)
+    datagram = SU_MIN(
+          datagram,
+          static_cast<size_t>(mtu - SIGDIGGER_UDPFORWARDER_IPV4_UDP_OVERHEAD));
+#endif // IP_MTU
+
+  datagram = SU_MIN(
+        datagram,
+        static_cast<size_t>(SIGDIGGER_UDPFORWARDER_MAX_DATAGRAM_SIZE));
+
+  // Never split a sample across datagrams
+  this->payload = datagram > overhead ? datagram - overhead : 0;
+  this->payload -= this->payload % sizeof(SUCOMPLEX);
+  if (this->payload == 0)
+    this->payload = sizeof(SUCOMPLEX);
+
+  (void) setsockopt(
+        this->fd,
+        SOL_SOCKET,
+        SO_SNDBUF,
+        reinterpret_cast<const char *>(&sndbuf),
+        sizeof(int));
+
+  this->headers.resize(SIGDIGGER_UDPFORWARDER_BATCH_SIZE);
+
+#ifdef SIGDIGGER_HAVE_SENDMMSG
+  this->iov.resize(2 * SIGDIGGER_UDPFORWARDER_BATCH_SIZE);
+  this->msgs.resize(SIGDIGGER_UDPFORWARDER_BATCH_SIZE);
+#else
+  if (this->header)
+    this->datagram.resize(sizeof(SigDiggerForwarderHeader) + this->payload);
+#endif // SIGDIGGER_HAVE_SENDMMSG
+
+#ifdef SIGDIGGER_HAVE_UDP_GSO
+  // Segmentation offload can only split a contiguous buffer, so it
+  // is not used when every datagram needs its own header.
+  this->gso = !this->header;
+#endif // SIGDIGGER_HAVE_UDP_GSO
 }
 
 bool
@@ -93,15 +175,19 @@ SocketDataWriter::prepare(void)
     this->addr.sin_addr = *reinterpret_cast<struct in_addr *>(ent->h_addr);
     memset(this->addr.sin_zero, 0, 8);
 
-    if (this->tcp) {
-      if (connect(
-            this->fd,
-            reinterpret_cast<struct sockaddr *>(&this->addr),
-            sizeof(struct sockaddr_in)) == -1) {
-        this->lastError = "Cannot connect to host: " + std::string(strerror(errno));
-        return false;
-      }
+    // UDP sockets are connected too: this fixes the destination once,
+    // and lets the kernel tell us the path MTU.
+    if (connect(
+          this->fd,
+          reinterpret_cast<struct sockaddr *>(&this->addr),
+          sizeof(struct sockaddr_in)) == -1) {
+      this->lastError = "Cannot connect to host: " + std::string(strerror(errno));
+      return false;
     }
+
+    if (!this->tcp)
+      this->setupDatagrams();
+
     this->solved = true;
   }
 
@@ -121,26 +207,193 @@ SocketDataWriter::canWrite(void) const
 }
 
 ssize_t
-SocketDataWriter::write(const void *data, size_t len)
+SocketDataWriter::writeStream(const uint8_t *data, size_t len)
 {
   ssize_t sent;
 
-  if (len > this->size)
-    len = this->size;
-
-  sent = sendto(
+  sent = send(
           this->fd,
           reinterpret_cast<const char *>(data),
           len,
-          MSG_NOSIGNAL,
-          reinterpret_cast<struct sockaddr *>(&this->addr),
-          sizeof(struct sockaddr_in));
+          MSG_NOSIGNAL);
+
+  if (sent < 1)
+    this->lastError = std::string(strerror(errno));
+
+  return sent;
+}
+
+#ifdef SIGDIGGER_HAVE_UDP_GSO
+ssize_t
+SocketDataWriter::writeSegmented(const uint8_t *data, size_t len)
+{
+  union {
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+    struct cmsghdr align;
+  } control;
+  struct msghdr msg;
+  struct iovec vec;
+  struct cmsghdr *cm;
+  size_t maxLen = SIGDIGGER_UDPFORWARDER_BATCH_SIZE * this->payload;
+  ssize_t sent;
+
+  // The whole super-datagram must still fit in 64 KiB
+  maxLen = SU_MIN(
+        maxLen,
+        static_cast<size_t>(SIGDIGGER_UDPFORWARDER_MAX_DATAGRAM_SIZE)
+        - static_cast<size_t>(SIGDIGGER_UDPFORWARDER_MAX_DATAGRAM_SIZE)
+        % this->payload);
+
+  // Jumbo datagrams or short writes gain nothing from segmentation
+  if (maxLen < 2 * this->payload || len <= this->payload)
+    return this->writeDatagrams(data, len);
+
+  if (len > maxLen)
+    len = maxLen;
+
+  vec.iov_base = const_cast<uint8_t *>(data);
+  vec.iov_len  = len;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov        = &vec;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  cm = CMSG_FIRSTHDR(&msg);
+  cm->cmsg_level = SOL_UDP;
+  cm->cmsg_type  = UDP_SEGMENT;
+  cm->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+  *reinterpret_cast<uint16_t *>(CMSG_DATA(cm)) =
+      static_cast<uint16_t>(this->payload);
+
+  sent = sendmsg(this->fd, &msg, MSG_NOSIGNAL);
+
+  // Nobody listening (yet). Datagrams are lost, as with sendto().
+  if (sent < 0 && errno == ECONNREFUSED)
+    sent = static_cast<ssize_t>(len);
+
+  if (sent < 0 && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT)) {
+    // No GSO support in this kernel / NIC. Fall back to sendmmsg.
+    this->gso = false;
+    return this->writeDatagrams(data, len);
+  }
 
   if (sent < 1)
     this->lastError = std::string(strerror(errno));
 
   return sent;
 }
+#endif // SIGDIGGER_HAVE_UDP_GSO
+
+ssize_t
+SocketDataWriter::writeDatagrams(const uint8_t *data, size_t len)
+{
+  unsigned int count = 0;
+  size_t p = 0;
+
+  // Packetize as much of the buffer as fits in one batch
+  while (p < len && count < SIGDIGGER_UDPFORWARDER_BATCH_SIZE) {
+    this->headers[count].magic = htonl(SIGDIGGER_UDPFORWARDER_HEADER_MAGIC);
+    this->headers[count].sequence = htonl(this->sequence + count);
+    p += SU_MIN(this->payload, len - p);
+    ++count;
+  }
+
+#ifdef SIGDIGGER_HAVE_SENDMMSG
+  int sent;
+  size_t bytes = 0;
+
+  p = 0;
+  for (unsigned int i = 0; i < count; ++i) {
+    struct iovec *vec = &this->iov[2 * i];
+    size_t chunk = SU_MIN(this->payload, len - p);
+    unsigned int n = 0;
+
+    if (this->header) {
+      vec[n].iov_base = &this->headers[i];
+      vec[n++].iov_len = sizeof(SigDiggerForwarderHeader);
+    }
+
+    vec[n].iov_base = const_cast<uint8_t *>(data + p);
+    vec[n++].iov_len = chunk;
+
+    memset(&this->msgs[i], 0, sizeof(struct mmsghdr));
+    this->msgs[i].msg_hdr.msg_iov    = vec;
+    this->msgs[i].msg_hdr.msg_iovlen = n;
+
+    p += chunk;
+  }
+
+  sent = sendmmsg(this->fd, this->msgs.data(), count, MSG_NOSIGNAL);
+
+  // Nobody listening (yet). Datagrams are lost, as with sendto().
+  if (sent < 0 && errno == ECONNREFUSED)
+    sent = static_cast<int>(count);
+
+  if (sent < 1) {
+    this->lastError = std::string(strerror(errno));
+    return -1;
+  }
+
+  this->sequence += static_cast<uint32_t>(sent);
+
+  // Report the sample bytes of the datagrams actually sent
+  for (int i = 0; i < sent; ++i)
+    bytes += SU_MIN(this->payload, len - bytes);
+
+  return static_cast<ssize_t>(bytes);
+#else
+  ssize_t sent;
+  size_t chunk = SU_MIN(this->payload, len);
+  const uint8_t *ptr = data;
+  size_t total = chunk;
+
+  // No batching here. Send one datagram per call.
+  if (this->header) {
+    uint8_t *buf = this->datagram.data();
+    memcpy(buf, &this->headers[0], sizeof(SigDiggerForwarderHeader));
+    memcpy(buf + sizeof(SigDiggerForwarderHeader), data, chunk);
+    ptr = buf;
+    total = sizeof(SigDiggerForwarderHeader) + chunk;
+  }
+
+  sent = send(
+        this->fd,
+        reinterpret_cast<const char *>(ptr),
+        total,
+        MSG_NOSIGNAL);
+
+  // Nobody listening (yet). Datagrams are lost, as with sendto().
+  if (sent < 0 && errno == ECONNREFUSED)
+    sent = static_cast<ssize_t>(total);
+
+  if (sent < 1) {
+    this->lastError = std::string(strerror(errno));
+    return -1;
+  }
+
+  ++this->sequence;
+
+  return static_cast<ssize_t>(chunk);
+#endif // SIGDIGGER_HAVE_SENDMMSG
+}
+
+ssize_t
+SocketDataWriter::write(const void *data, size_t len)
+{
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+
+  if (this->tcp)
+    return this->writeStream(bytes, len);
+
+#ifdef SIGDIGGER_HAVE_UDP_GSO
+  if (this->gso)
+    return this->writeSegmented(bytes, len);
+#endif // SIGDIGGER_HAVE_UDP_GSO
+
+  return this->writeDatagrams(bytes, len);
+}
 
 bool
 SocketDataWriter::close(void)
@@ -165,9 +418,10 @@ SocketForwarder::SocketForwarder(
     uint16_t port,
     unsigned int size,
     bool tcp,
+    bool header,
     QObject *parent) :
   GenericDataSaver(
-    this->writer = new SocketDataWriter(host, port, size, tcp),
+    this->writer = new SocketDataWriter(host, port, size, tcp, header),
     parent)
 {
 
@@ -0,0 +1,542 @@
+//
+//    SocketStreamServer.cpp: Serve inspector data to multiple subscribers
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <SocketStreamServer.h>
+#include <sys/types.h>
+#include <sigutils/util/compat-socket.h>
+#include <sigutils/util/compat-in.h>
+#include <sigutils/util/compat-netdb.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <sys/stat.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+#endif // _WIN32
+
+#ifndef MSG_NOSIGNAL
+#  define MSG_NOSIGNAL 0
+#endif // MSG_NOSIGNAL
+
+using namespace SigDigger;
+
+namespace SigDigger {
+  typedef std::shared_ptr<const std::vector<uint8_t>> StreamBlock;
+
+  struct StreamSubscriber {
+    int fd = -1;
+    bool dead = false;
+    std::deque<StreamBlock> queue;
+    size_t headOffset = 0; // Bytes of queue.front() already sent
+    size_t queued = 0;     // Bytes pending, including the head block
+  };
+
+  class StreamServerWriter : public GenericDataWriter {
+    std::string address;
+    uint16_t port;
+    bool local;
+    int listenFd = -1;
+    int wakeFd[2] = {-1, -1};
+    std::string lastError;
+
+    std::mutex mutex;
+    std::vector<StreamSubscriber> subscribers;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    bool listenTcp(void);
+    bool listenLocal(void);
+    void wake(void);
+    void serve(void);
+    void accept(void);
+    bool flush(StreamSubscriber &);
+    void enqueue(StreamSubscriber &, StreamBlock const &, size_t offset);
+
+  public:
+    std::atomic<unsigned int> subscriberCount;
+    std::atomic<quint64> droppedBytes;
+
+    StreamServerWriter(std::string const &address, uint16_t port, bool local);
+
+    bool prepare(void) override;
+    std::string getError(void) const override;
+    bool canWrite(void) const override;
+    ssize_t write(const void *data, size_t len) override;
+    bool close(void) override;
+    ~StreamServerWriter() override;
+  };
+}
+
+StreamServerWriter::StreamServerWriter(
+    std::string const &address,
+    uint16_t port,
+    bool local) :
+  address(address),
+  port(port),
+  local(local),
+  running(false),
+  subscriberCount(0),
+  droppedBytes(0)
+{
+}
+
+std::string
+StreamServerWriter::getError(void) const
+{
+  return this->lastError;
+}
+
+bool
+StreamServerWriter::canWrite(void) const
+{
+  return this->listenFd != -1;
+}
+
+#ifdef _WIN32
+bool
+StreamServerWriter::prepare(void)
+{
+  this->lastError = "Stream server is not supported on this platform";
+  return false;
+}
+
+ssize_t
+StreamServerWriter::write(const void *, size_t len)
+{
+  return static_cast<ssize_t>(len);
+}
+
+bool
+StreamServerWriter::close(void)
+{
+  return true;
+}
+#else
+static bool
+setNonBlocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL);
+
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+bool
+StreamServerWriter::listenTcp(void)
+{
+  struct sockaddr_in addr;
+  struct hostent *ent;
+  int one = 1;
+
+  memset(&addr, 0, sizeof(struct sockaddr_in));
+  addr.sin_family = AF_INET;
+  addr.sin_port   = htons(this->port);
+
+  if (this->address.empty() || this->address == "*") {
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  } else {
+    if ((ent = gethostbyname(this->address.c_str())) == nullptr) {
+      this->lastError = "Failed to resolve address " + this->address;
+      return false;
+    }
+    addr.sin_addr = *reinterpret_cast<struct in_addr *>(ent->h_addr);
+  }
+
+  if ((this->listenFd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
+    this->lastError = "Failed to open socket: " + std::string(strerror(errno));
+    return false;
+  }
+
+  (void) setsockopt(
+        this->listenFd,
+        SOL_SOCKET,
+        SO_REUSEADDR,
+        &one,
+        sizeof(int));
+
+  if (bind(
+        this->listenFd,
+        reinterpret_cast<struct sockaddr *>(&addr),
+        sizeof(struct sockaddr_in)) == -1) {
+    this->lastError =
+        "Cannot bind to port "
+        + std::to_string(this->port)
+        + ": "
+        + std::string(strerror(errno));
+    ::close(this->listenFd);
+    this->listenFd = -1;
+    return false;
+  }
+
+  return true;
+}
+
+bool
+StreamServerWriter::listenLocal(void)
+{
+  struct sockaddr_un addr;
+  struct stat sbuf;
+
+  if (this->address.size() >= sizeof(addr.sun_path)) {
+    this->lastError = "Socket path too long: " + this->address;
+    return false;
+  }
+
+  // Remove stale sockets from previous sessions, but nothing else
+  if (stat(this->address.c_str(), &sbuf) == 0 && S_ISSOCK(sbuf.st_mode))
+    unlink(this->address.c_str());
+
+  memset(&addr, 0, sizeof(struct sockaddr_un));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, this->address.c_str(), sizeof(addr.sun_path) - 1);
+
+  if ((this->listenFd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+    this->lastError = "Failed to open socket: " + std::string(strerror(errno));
+    return false;
+  }
+
+  if (bind(
+        this->listenFd,
+        reinterpret_cast<struct sockaddr *>(&addr),
+        sizeof(struct sockaddr_un)) == -1) {
+    this->lastError =
+        "Cannot bind to "
+        + this->address
+        + ": "
+        + std::string(strerror(errno));
+    ::close(this->listenFd);
+    this->listenFd = -1;
+    return false;
+  }
+
+  return true;
+}
+
+bool
+StreamServerWriter::prepare(void)
+{
+  if (this->listenFd == -1) {
+    bool ok = this->local ? this->listenLocal() : this->listenTcp();
+
+    if (ok && ::listen(this->listenFd, SIGDIGGER_STREAM_SERVER_BACKLOG) == -1) {
+      this->lastError = "Cannot listen: " + std::string(strerror(errno));
+      ok = false;
+    }
+
+    if (ok && (pipe(this->wakeFd) == -1
+          || !setNonBlocking(this->wakeFd[0])
+          || !setNonBlocking(this->wakeFd[1])
+          || !setNonBlocking(this->listenFd))) {
+      this->lastError = "Cannot create server: " + std::string(strerror(errno));
+      ok = false;
+    }
+
+    if (!ok) {
+      this->close();
+      return false;
+    }
+
+    this->running = true;
+    this->thread  = std::thread(&StreamServerWriter::serve, this);
+  }
+
+  return true;
+}
+
+void
+StreamServerWriter::wake(void)
+{
+  char c = 0;
+  ssize_t ignored;
+
+  ignored = ::write(this->wakeFd[1], &c, 1);
+  (void) ignored;
+}
+
+void
+StreamServerWriter::accept(void)
+{
+  int fd;
+  int sndbuf = SIGDIGGER_STREAM_SERVER_SNDBUF_SIZE;
+
+  while ((fd = ::accept(this->listenFd, nullptr, nullptr)) != -1) {
+    StreamSubscriber sub;
+
+    if (!setNonBlocking(fd)) {
+      ::close(fd);
+      continue;
+    }
+
+    (void) setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(int));
+
+    sub.fd = fd;
+    this->subscribers.push_back(std::move(sub));
+  }
+
+  this->subscriberCount = static_cast<unsigned int>(this->subscribers.size());
+}
+
+// Protected by mutex
+bool
+StreamServerWriter::flush(StreamSubscriber &sub)
+{
+  while (!sub.queue.empty()) {
+    auto const &block = sub.queue.front();
+    size_t left = block->size() - sub.headOffset;
+    ssize_t sent = send(
+          sub.fd,
+          block->data() + sub.headOffset,
+          left,
+          MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        return true;
+      sub.dead = true;
+      return false;
+    }
+
+    sub.headOffset += static_cast<size_t>(sent);
+    sub.queued     -= static_cast<size_t>(sent);
+
+    if (sub.headOffset < block->size())
+      return true;
+
+    sub.queue.pop_front();
+    sub.headOffset = 0;
+  }
+
+  return true;
+}
+
+// Protected by mutex
+void
+StreamServerWriter::enqueue(
+    StreamSubscriber &sub,
+    StreamBlock const &block,
+    size_t offset)
+{
+  size_t len = block->size() - offset;
+
+  // Drop policy: discard whole buffers, oldest first. The head block may
+  // be half-sent, so it is kept to preserve sample alignment.
+  while (sub.queued + len > SIGDIGGER_STREAM_SERVER_MAX_QUEUE
+         && sub.queue.size() > 1) {
+    size_t size = sub.queue[1]->size();
+    sub.queue.erase(sub.queue.begin() + 1);
+    sub.queued -= size;
+    this->droppedBytes += size;
+  }
+
+  if (sub.queued + len > SIGDIGGER_STREAM_SERVER_MAX_QUEUE) {
+    this->droppedBytes += len;
+    return;
+  }
+
+  if (sub.queue.empty())
+    sub.headOffset = offset;
+
+  sub.queue.push_back(block);
+  sub.queued += len;
+}
+
+void
+StreamServerWriter::serve(void)
+{
+  std::vector<struct pollfd> fds;
+  char scratch[256];
+
+  while (this->running) {
+    fds.clear();
+    fds.push_back({this->wakeFd[0], POLLIN, 0});
+    fds.push_back({this->listenFd, POLLIN, 0});
+
+    {
+      std::lock_guard<std::mutex> guard(this->mutex);
+
+      for (auto const &sub : this->subscribers)
+        fds.push_back({
+              sub.fd,
+              static_cast<short>(POLLIN | (sub.queue.empty() ? 0 : POLLOUT)),
+              0});
+    }
+
+    if (poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (fds[0].revents & POLLIN)
+      while (read(this->wakeFd[0], scratch, sizeof(scratch)) > 0);
+
+    std::lock_guard<std::mutex> guard(this->mutex);
+
+    // Only this thread adds or removes subscribers, so the poll entries
+    // are still aligned with the subscriber list.
+    for (size_t i = 0; i + 2 < fds.size(); ++i) {
+      StreamSubscriber &sub = this->subscribers[i];
+      short ev = fds[i + 2].revents;
+
+      if (ev & (POLLERR | POLLHUP | POLLNVAL)) {
+        sub.dead = true;
+      } else if (ev & POLLIN) {
+        // Subscribers are not expected to talk. Read to detect EOF.
+        ssize_t got = recv(sub.fd, scratch, sizeof(scratch), MSG_DONTWAIT);
+        if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+          sub.dead = true;
+      }
+
+      if (!sub.dead && (ev & POLLOUT))
+        this->flush(sub);
+    }
+
+    for (auto it = this->subscribers.begin(); it != this->subscribers.end();) {
+      if (it->dead) {
+        ::close(it->fd);
+        it = this->subscribers.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (fds[1].revents & POLLIN)
+      this->accept();
+
+    this->subscriberCount = static_cast<unsigned int>(this->subscribers.size());
+  }
+}
+
+ssize_t
+StreamServerWriter::write(const void *data, size_t len)
+{
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  StreamBlock block;
+  bool pending = false;
+
+  std::lock_guard<std::mutex> guard(this->mutex);
+
+  for (auto &sub : this->subscribers) {
+    size_t offset = 0;
+
+    if (sub.dead)
+      continue;
+
+    // Fast path: subscriber is up to date, send straight from the
+    // committed buffer without copying it.
+    if (sub.queue.empty()) {
+      ssize_t sent = send(sub.fd, bytes, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+      if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+          sub.dead = true;
+          pending = true;
+          continue;
+        }
+        sent = 0;
+      }
+
+      offset = static_cast<size_t>(sent);
+      if (offset == len)
+        continue;
+    }
+
+    // Slow subscriber. All of them share a single copy of the buffer.
+    if (!block)
+      block = std::make_shared<const std::vector<uint8_t>>(bytes, bytes + len);
+
+    this->enqueue(sub, block, offset);
+    pending = true;
+  }
+
+  if (pending)
+    this->wake();
+
+  return static_cast<ssize_t>(len);
+}
+
+bool
+StreamServerWriter::close(void)
+{
+  if (this->running) {
+    this->running = false;
+    this->wake();
+    this->thread.join();
+  }
+
+  for (auto &sub : this->subscribers)
+    ::close(sub.fd);
+
+  this->subscribers.clear();
+  this->subscriberCount = 0;
+
+  if (this->listenFd != -1) {
+    ::close(this->listenFd);
+    this->listenFd = -1;
+
+    if (this->local)
+      unlink(this->address.c_str());
+  }
+
+  for (auto &fd : this->wakeFd) {
+    if (fd != -1) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+  return true;
+}
+#endif // _WIN32
+
+StreamServerWriter::~StreamServerWriter(void)
+{
+  this->close();
+}
+
+/////////////////////////////// SocketStreamServer /////////////////////////////
+SocketStreamServer::SocketStreamServer(
+    std::string const &address,
+    uint16_t port,
+    bool local,
+    QObject *parent) :
+  GenericDataSaver(
+    this->writer = new StreamServerWriter(address, port, local),
+    parent)
+{
+  this->setWriterOwnership(true);
+}
+
+unsigned int
+SocketStreamServer::getSubscriberCount(void) const
+{
+  return this->writer->subscriberCount;
+}
+
+quint64
+SocketStreamServer::getDroppedBytes(void) const
+{
+  return this->writer->droppedBytes;
+}
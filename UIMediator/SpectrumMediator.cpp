@@ -21,11 +21,71 @@
 #include "MainWindow.h"
 #include "GlobalProperty.h"
 #include "MainSpectrum.h"
+#include "RemoteControlServer.h"
 #include <InspectionWidgetFactory.h>
 #include <SuWidgetsHelpers.h>
+#include <QLabel>
 
 using namespace SigDigger;
 
+bool
+UIMediator::isPSDRateAdaptive() const
+{
+  return m_appConfig->guiConfig.enableMsgTTL
+      && m_appConfig->guiConfig.adaptivePSD
+      && m_appConfig->profile.isRemote();
+}
+
+void
+UIMediator::applyPSDRate()
+{
+  if (m_analyzer != nullptr) {
+    Suscan::AnalyzerParams params = m_appConfig->analyzerParams;
+
+    params.psdUpdateInterval = SCAST(float, m_psdRateController.interval());
+    params.windowSize        = m_psdRateController.fftSize();
+
+    // Restart the arrival lag estimation from the new rate
+    m_psdDelta = params.psdUpdateInterval;
+    m_psdAdj   = 0;
+
+    m_analyzer->setParams(params);
+  }
+
+  refreshPSDRateIndicator();
+}
+
+void
+UIMediator::refreshPSDRateIndicator()
+{
+  if (m_state != RUNNING || !isPSDRateAdaptive()) {
+    m_psdRateLabel->hide();
+    return;
+  }
+
+  qreal rate = 1. / m_psdRateController.interval();
+  QString text = QString::asprintf(
+        "Spectrum: %.3g fps, %u bins",
+        rate,
+        m_psdRateController.fftSize());
+
+  if (m_psdRateController.isEngaged()) {
+    text += " (reduced)";
+    m_psdRateLabel->setToolTip(
+          QString::asprintf(
+            "Spectrum rate and FFT size have been lowered to keep up with "
+            "the remote link. Requested: %.3g fps, %u bins.",
+            1. / m_psdRateController.targetInterval(),
+            m_psdRateController.targetFftSize()));
+  } else {
+    m_psdRateLabel->setToolTip(
+          "Spectrum rate and FFT size as requested");
+  }
+
+  m_psdRateLabel->setText(text);
+  m_psdRateLabel->show();
+}
+
 void
 UIMediator::feedPSD(const Suscan::PSDMessage &msg)
 {
@@ -35,7 +95,10 @@ UIMediator::feedPSD(const Suscan::PSDMessage &msg)
     qreal delta;
     qreal psdDelta;
     qreal prevDelta;
-    qreal interval = m_appConfig->analyzerParams.psdUpdateInterval;
+    bool adaptive = isPSDRateAdaptive();
+    qreal interval = adaptive
+        ? m_psdRateController.interval()
+        : m_appConfig->analyzerParams.psdUpdateInterval;
     qreal selRate = 1. / interval;
     struct timeval now, rttime, diff;
     qreal max_delta;
@@ -80,7 +143,14 @@ UIMediator::feedPSD(const Suscan::PSDMessage &msg)
       delta -= m_rtDeltaReal;
       expired = delta > max_delta;
 
-      if (m_appConfig->profile.isRemote()
+      if (adaptive) {
+        if (m_psdRateController.feed(
+              now.tv_sec + now.tv_usec * 1e-6,
+              (m_psdDelta - interval) / interval,
+              delta,
+              max_delta))
+          applyPSDRate();
+      } else if (m_appConfig->profile.isRemote()
           && fabs(m_psdAdj / interval)
           < SIGDIGGER_UI_MEDIATOR_PSD_LAG_THRESHOLD) {
         if ((m_psdDelta - interval) / interval
@@ -111,6 +181,16 @@ UIMediator::feedPSD(const Suscan::PSDMessage &msg)
 
   setSampleRate(msg.getSampleRate());
 
+  if (m_remoteControl->wantsPSD()) {
+    struct timeval tv = msg.getTimeStamp();
+    m_remoteControl->publishPSD(
+          SCAST(qreal, tv.tv_sec) + 1e-6 * SCAST(qreal, tv.tv_usec),
+          msg.getFrequency(),
+          msg.getSampleRate(),
+          msg.get(),
+          msg.size());
+  }
+
   if (!expired || msg.hasLooped()) {
     m_averager.feed(msg);
     m_ui->spectrum->feed(
@@ -30,6 +30,7 @@
 #include <QDockWidget>
 #include <QMessageBox>
 #include <QScreen>
+#include <QLabel>
 #include <QTimeSlider.h>
 #include <FloatingTabWindow.h>
 
@@ -154,6 +155,12 @@ UIMediator::getAppConfig() const
   return m_appConfig;
 }
 
+RemoteControlServer *
+UIMediator::getRemoteControl() const
+{
+  return m_remoteControl;
+}
+
 void
 UIMediator::configureUIComponent(UIComponent *comp)
 {
@@ -442,6 +449,7 @@ UIMediator::refreshUI()
       m_haveRtDelta = false;
       m_rtCalibrations = 0;
       m_rtDeltaReal = 0;
+      m_psdRateController.reset();
 
       stateString = QString("Running");
 
@@ -497,6 +505,7 @@ UIMediator::refreshUI()
 
   // Time toolbar is visible always, only if a file is selected
   refreshTimeToolbarState();
+  refreshPSDRateIndicator();
 
   m_owner->setWindowTitle(
         "SigDigger - "
@@ -701,6 +710,10 @@ UIMediator::UIMediator(QMainWindow *owner, AppUI *ui)
 
   m_requestTracker = new Suscan::AnalyzerRequestTracker(this);
 
+  m_psdRateLabel = new QLabel();
+  m_psdRateLabel->hide();
+  m_ui->main->statusBar->addPermanentWidget(m_psdRateLabel);
+
   m_remoteDevice = Suscan::Source::Device(
             "Remote device",
             "localhost",
@@ -893,10 +906,13 @@ UIMediator::notifyTimeStamp(struct timeval const &timestamp)
 }
 
 void
-UIMediator::refreshDevicesDone()
+UIMediator::refreshDevicesDone(bool changed)
 {
   m_ui->deviceDialog->refreshDone();
-  m_ui->configDialog->notifySingletonChanges();
+
+  // Repopulating the profile dialog is expensive, skip it if we can
+  if (changed)
+    m_ui->configDialog->notifySingletonChanges();
 }
 
 QMessageBox::StandardButton
@@ -963,8 +979,26 @@ void
 UIMediator::setAnalyzerParams(Suscan::AnalyzerParams const &params)
 {
   m_appConfig->analyzerParams = params;
+
+  if (m_psdRateController.isEngaged()
+      && m_psdRateController.isEffective(
+        params.psdUpdateInterval,
+        params.windowSize)) {
+    // Echo of our own adjustment: the configuration keeps what the user chose
+    m_appConfig->analyzerParams.psdUpdateInterval =
+        SCAST(float, m_psdRateController.targetInterval());
+    m_appConfig->analyzerParams.windowSize =
+        m_psdRateController.targetFftSize();
+  } else {
+    m_psdRateController.setTarget(
+          params.psdUpdateInterval,
+          params.windowSize);
+  }
+
   m_ui->spectrum->setExpectedRate(
         static_cast<int>(1.f / params.psdUpdateInterval));
+
+  refreshPSDRateIndicator();
 }
 
 void
@@ -1251,6 +1285,14 @@ UIMediator::openSettingsDialog(Suscan::Source::Config *prof)
     m_appConfig->guiConfig = m_ui->configDialog->getGuiConfig();
     m_ui->spectrum->setGuiConfig(m_appConfig->guiConfig);
     m_ui->panoramicDialog->setGuiConfig(m_appConfig->guiConfig);
+
+    // Adaptation disabled: go back to the requested spectrum settings
+    if (!isPSDRateAdaptive() && m_psdRateController.isEngaged()) {
+      m_psdRateController.reset();
+      applyPSDRate();
+    }
+
+    refreshPSDRateIndicator();
   }
 
   if (m_ui->configDialog->audioChanged()) {
@@ -29,7 +29,11 @@ namespace SigDigger {
     snd_pcm_t *pcm = nullptr;
 
   public:
-    AlsaPlayer(std::string const &dev, unsigned int rate, size_t bufSiz);
+    AlsaPlayer(
+        std::string const &dev,
+        unsigned int rate,
+        size_t bufSiz,
+        unsigned int channels = 1);
     static bool enumerateDevices(std::vector<GenericAudioDevice> &);
     static GenericAudioDevice getDefaultDevice();
     bool write(const float *, size_t) override;
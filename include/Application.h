@@ -31,9 +31,13 @@
 
 #define SIGDIGGER_AUTOSAVE_INTERVAL_MS (1800 * 1000)
 
+// After this long, the device dialog stops waiting for a sweep to finish
+#define SIGDIGGER_DEVICE_DETECT_TIMEOUT_MS 10000
+
 namespace SigDigger {
   class Scanner;
   class FileDataSaver;
+  class DeviceHotplugMonitor;
 
   class DeviceDetectWorker : public QObject {
       Q_OBJECT
@@ -76,6 +80,10 @@ namespace SigDigger {
     // Rediscover devices
     QThread *m_deviceDetectThread;
     DeviceDetectWorker *m_deviceDetectWorker;
+    DeviceHotplugMonitor *m_hotplugMonitor = nullptr;
+    QTimer m_detectTimeout;
+    bool m_detecting = false;
+    bool m_detectPending = false;
 
     // Private methods
     QString getLogText(int howMany = -1);
@@ -85,6 +93,7 @@ namespace SigDigger {
     void connectScanner();
 
     void hotApplyProfile(Suscan::Source::Config const *);
+    void requestDeviceDetect();
     void orderedHalt();
 
   public:
@@ -140,6 +149,8 @@ namespace SigDigger {
 
     // Device detect slots
     void onDetectFinished();
+    void onDetectTimeout();
+    void onHotplug();
 
     // Panoramic spectrum slots
     void onPanSpectrumStart();
@@ -0,0 +1,214 @@
+//
+//    AudioDSPChain.h: Client-side audio processing stages
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef AUDIODSPCHAIN_H
+#define AUDIODSPCHAIN_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <fftw3.h>
+
+#define SIGDIGGER_AUDIO_DSP_LOAD_ALPHA  5e-2f
+#define SIGDIGGER_AUDIO_NR_FFT_SIZE     512
+#define SIGDIGGER_AUDIO_NR_HOP          (SIGDIGGER_AUDIO_NR_FFT_SIZE / 2)
+
+namespace SigDigger {
+  //
+  // Processing stages run in the playback worker, on the real samples
+  // of a single mixer channel, right after they are pulled from its ring.
+  // Parameters are atomics so the GUI can change them at any time: each
+  // stage picks up the new values at the beginning of the next block.
+  //
+  class AudioDSPStage {
+    std::atomic<bool>  m_enabled;
+    std::atomic<float> m_cpuLoad;
+    bool  m_active  = false; // Worker-side copy of m_enabled
+    float m_loadAvg = 0;
+
+  protected:
+    std::atomic<unsigned int> m_sampRate;
+
+    virtual void reset() = 0;
+    virtual void process(float *, size_t) = 0;
+
+  public:
+    AudioDSPStage();
+    virtual ~AudioDSPStage();
+
+    virtual const char *name() const = 0;
+
+    // Delay introduced by the stage, in samples
+    virtual size_t latency() const;
+
+    void setEnabled(bool);
+    bool isEnabled() const;
+
+    // Fraction of the block duration spent in this stage
+    float getCpuLoad() const;
+    unsigned int getSampleRate() const;
+
+    // Worker side
+    void setSampleRate(unsigned int);
+    void run(float *, size_t);
+  };
+
+  class AudioDeemphasis : public AudioDSPStage {
+    std::atomic<float> m_tau; // Seconds
+    float m_curTau = 0;
+    float m_alpha  = 1;
+    float m_y      = 0;
+
+  protected:
+    void reset() override;
+    void process(float *, size_t) override;
+
+  public:
+    AudioDeemphasis();
+    const char *name() const override;
+    void setTau(float);
+  };
+
+  class AudioNotch : public AudioDSPStage {
+    std::atomic<float> m_freq; // Hz
+    std::atomic<float> m_q;
+    float m_curFreq = 0;
+    float m_curQ    = 0;
+    bool  m_bypass  = true;
+
+    // Normalized biquad coefficients and state (transposed DF-II)
+    float m_b0 = 1, m_b1 = 0, m_b2 = 0, m_a1 = 0, m_a2 = 0;
+    float m_z1 = 0, m_z2 = 0;
+
+    void design();
+
+  protected:
+    void reset() override;
+    void process(float *, size_t) override;
+
+  public:
+    AudioNotch();
+    const char *name() const override;
+    void setFrequency(float);
+    void setQ(float);
+  };
+
+  //
+  // Spectral noise reduction: Wiener-like gain over a 50% overlapped
+  // sqrt-Hann STFT, with the noise floor tracked by a minimum follower.
+  //
+  class AudioNoiseReduction : public AudioDSPStage {
+    std::atomic<float> m_strength; // 0 (off) to 1 (aggressive)
+
+    std::vector<float> m_window;
+
+    // FFTW buffers and plans, created once. The inverse is not scaled.
+    float         *m_frame    = nullptr; // FFT_SIZE windowed samples
+    fftwf_complex *m_spectrum = nullptr; // FFT_SIZE / 2 + 1 bins
+    fftwf_plan     m_forward  = nullptr;
+    fftwf_plan     m_backward = nullptr;
+
+    std::vector<float> m_input;    // Last FFT_SIZE input samples
+    std::vector<float> m_ola;      // Overlap-add accumulator
+    std::vector<float> m_output;   // HOP completed samples
+    std::vector<float> m_power;    // Smoothed power per bin
+    std::vector<float> m_noise;    // Noise floor estimate per bin
+    std::vector<float> m_gain;     // Smoothed gain per bin
+    size_t m_fill = 0;
+    bool   m_primed = false;
+
+    void processFrame();
+
+  protected:
+    void reset() override;
+    void process(float *, size_t) override;
+
+  public:
+    AudioNoiseReduction();
+    ~AudioNoiseReduction() override;
+
+    AudioNoiseReduction(AudioNoiseReduction const &) = delete;
+    AudioNoiseReduction &operator=(AudioNoiseReduction const &) = delete;
+
+    const char *name() const override;
+    size_t latency() const override;
+    void setStrength(float);
+  };
+
+  class AudioAGC : public AudioDSPStage {
+    std::atomic<float> m_target;   // dBFS
+    std::atomic<float> m_maxGain;  // dB
+    std::atomic<float> m_release;  // Seconds
+    float m_envelope = 0;
+    float m_gain     = 1;
+
+  protected:
+    void reset() override;
+    void process(float *, size_t) override;
+
+  public:
+    AudioAGC();
+    const char *name() const override;
+    void setTarget(float);
+    void setMaxGain(float);
+    void setRelease(float);
+  };
+
+  struct AudioDSPConfig {
+    bool  deemphasis   = false;
+    float deemphTau    = 50e-6f; // s
+    bool  notch        = false;
+    float notchFreq    = 1000;   // Hz
+    float notchQ       = 10;
+    bool  noiseReduction = false;
+    float nrStrength   = .5f;
+    bool  agc          = false;
+    float agcTarget    = -12;    // dBFS
+    float agcMaxGain   = 30;     // dB
+    float agcRelease   = .5f;    // s
+  };
+
+  struct AudioDSPStageStats {
+    const char *name;
+    bool  enabled;
+    float latency; // ms
+    float cpuLoad; // Fraction of real time
+  };
+
+  class AudioDSPChain {
+    AudioDeemphasis     m_deemphasis;
+    AudioNotch          m_notch;
+    AudioNoiseReduction m_noiseReduction;
+    AudioAGC            m_agc;
+
+    AudioDSPStage *m_stages[4];
+
+  public:
+    AudioDSPChain();
+
+    // Any thread
+    void setConfig(AudioDSPConfig const &);
+    void getStats(std::vector<AudioDSPStageStats> &) const;
+
+    // Playback worker only
+    void reset(unsigned int rate);
+    void process(float *, size_t, unsigned int rate);
+  };
+}
+
+#endif // AUDIODSPCHAIN_H
@@ -28,20 +28,30 @@ namespace SigDigger {
   class AudioFileSaver : public GenericDataSaver {
     Q_OBJECT
 
-    AudioFileWriter *writer = nullptr;
+    AudioFileWriter *writer = nullptr; // Owned by GenericDataSaver
 
   public:
+    enum AudioFileFormat {
+      AUDIO_FILE_FORMAT_WAV_PCM16,
+      AUDIO_FILE_FORMAT_WAV_FLOAT,
+      AUDIO_FILE_FORMAT_FLAC
+    };
+
     struct AudioFileParams {
       std::string savePath;
       AudioDemod modulation;
       SUFREQ frequency;
       unsigned int sampRate;
+      AudioFileFormat format = AUDIO_FILE_FORMAT_WAV_PCM16;
+      bool iq = false; // Save both components as a 2-channel file
     };
 
     AudioFileParams params;
 
     AudioFileSaver(AudioFileParams const &, QObject *);
-    ~AudioFileSaver();
+
+    // Approximate size of the samples written so far, in output bytes
+    quint64 getFileSize(void) const;
   };
 }
 
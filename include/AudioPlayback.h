@@ -21,45 +21,60 @@
 #define AUDIOPLAYBACK_H
 
 #include <QObject>
-#include <QMutex>
 #include <QThread>
 #include <string>
+#include <vector>
+#include <atomic>
 #include <Suscan/Library.h>
 #include <GenericAudioPlayer.h>
+#include <AudioRingBuffer.h>
+#include <AudioDSPChain.h>
 #include <sigutils/util/compat-unistd.h>
 
 #define SIGDIGGER_AUDIO_BUFFER_ALLOC static_cast<size_t>(1 << 14)
 #define SIGDIGGER_AUDIO_BUFFER_SIZE (SIGDIGGER_AUDIO_BUFFER_ALLOC / sizeof (float))
 #define SIGDIGGER_AUDIO_SAMPLE_RATE         44100
-#define SIGDIGGER_AUDIO_BUFFER_NUM          20
-#define SIGDIGGER_AUDIO_BUFFER_MIN          10
-#define SIGDIGGER_AUDIO_BUFFERING_WATERMARK 2
+#define SIGDIGGER_AUDIO_RING_ORDER          17
+#define SIGDIGGER_AUDIO_TARGET_BUFFERS      5
 
 #define SIGDIGGER_AUDIO_BUFFER_SIZE_MIN     256
 #define SIGDIGGER_AUDIO_BUFFER_DELAY_MS     20
 
-#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
-#  define QRecursiveMutex QMutex
-#endif
+#define SIGDIGGER_AUDIO_MAX_CHANNELS        8
+#define SIGDIGGER_AUDIO_OUTPUT_CHANNELS     2
+
+// Drift compensation. The consumption rate of each channel is slightly
+// adjusted so that its ring stays around the target fill level.
+#define SIGDIGGER_AUDIO_MAX_RATE_CORRECTION 5e-3
+#define SIGDIGGER_AUDIO_FILL_AVG_ALPHA      1e-2
+#define SIGDIGGER_AUDIO_DRIFT_KP            2e-3
+#define SIGDIGGER_AUDIO_DRIFT_KI            1e-5
 
 namespace SigDigger {
-  class AudioBufferList;
+  struct AudioMixerChannel;
 
   class PlaybackWorker : public QObject {
       Q_OBJECT
 
       GenericAudioPlayer *player = nullptr;  // Owned
-      AudioBufferList *instance; // Weak
+      AudioMixerChannel *channels; // Weak
       float gain = 1;
       unsigned int bufferSize;
       std::string device;
       unsigned int sampRate;
+      bool playing = false;
+      std::vector<float> mixBuffer;
+      std::vector<float> scratch;
+
+      bool mix(void);
+      bool mixChannel(AudioMixerChannel &, float *output);
+      void updateRateCorrection(AudioMixerChannel &);
 
     public:
       static unsigned int calcBufferSizeForRate(unsigned int rate);
 
       PlaybackWorker(
-          AudioBufferList *instance = nullptr,
+          AudioMixerChannel *channels = nullptr,
           std::string const &dev = "default",
           unsigned int sampRate = SIGDIGGER_AUDIO_SAMPLE_RATE);
       unsigned int getBufferSize(void) const;
@@ -79,92 +94,65 @@ namespace SigDigger {
       void finished(void);
   };
 
-  // TODO: turn into std::list
-  struct AudioBuffer {
-    AudioBuffer *next = nullptr;
-    AudioBuffer *prev = nullptr;
-    float *data = nullptr;
-
-    AudioBuffer();
-    ~AudioBuffer();
-  };
-
-  class AudioBufferList {
-    std::vector<AudioBuffer> allocation;
-
-    // Free list head. All buffers are initially here
-    AudioBuffer *freeList = nullptr;
-    unsigned int freeLen = 0;
-    unsigned int totalLen = 0;
-
-    // Current buffer. The one being filled up
-    AudioBuffer *current = nullptr;
-
-    // Playlist head. These buffers are the ones being played by
-    // the playback worker
-    AudioBuffer *playListHead = nullptr;
-    AudioBuffer *playListTail = nullptr;
-    unsigned int playListLen = 0;
-
-    // Buffer being played.
-    AudioBuffer *playBuffer = nullptr;
-
-    // Mutex to ensure ordered access
-    QRecursiveMutex listMutex;
-
-  public:
-    AudioBufferList(unsigned int num);
-
-    unsigned int
-    getFreeLen(void) const
-    {
-      return this->freeLen;
-    }
-
-    unsigned int
-    getPlayListLen(void) const
-    {
-      return this->playListLen;
-    }
-
-    void clear(void);
-
-    void reset(void);
-
-    // Takes one from the freelist, replaces current, returns pointer
-    float *reserve(void);
-
-    // Takes current and puts it in the playList
-    void commit(void);
-
-    // Takes one from the playList
-    float *next(void);
-
-    // Moves current playing buffer to the freeList
-    void release(void);
+  //
+  // Each mixer channel is fed by its own producer (usually an audio
+  // inspector) and is mixed down to a single stereo stream by the playback
+  // worker. Samples travel through a wait-free ring, and the worker only
+  // reads atomics, so neither side ever blocks on the other.
+  //
+  struct AudioMixerChannel {
+    AudioRingBuffer    ring;
+    std::atomic<bool>  enabled;
+    std::atomic<bool>  buffering;
+    std::atomic<bool>  flush;
+    std::atomic<size_t> flushMark;
+    std::atomic<float> gainL;
+    std::atomic<float> gainR;
+
+    // Consumer side. Only touched by the playback worker
+    double phase    = 0;  // Fractional read position
+    float  last     = 0;  // Last sample of the previous block
+    double ratio    = 1;  // Input samples per output sample
+    double avgError = 0;  // Smoothed fill level error
+    double integral = 0;
+
+    // Client-side processing, run by the worker before resampling
+    AudioDSPChain dsp;
+
+    // Statistics, for the UI
+    std::atomic<float>        rateCorrection;
+    std::atomic<unsigned int> underruns;
+
+    // Channel settings, as set by the user
+    float volume = 0; // dB
+    float pan    = 0; // -1 (left) to +1 (right)
+    bool  muted  = false;
+
+    AudioMixerChannel();
+
+    // Drops everything queued up to now, but not what comes after
+    void requestFlush();
   };
 
   class AudioPlayback : public QObject {
     Q_OBJECT
 
-    // Audio buffer list
-    AudioBufferList bufferList;
+    // Mixer channels
+    AudioMixerChannel channels[SIGDIGGER_AUDIO_MAX_CHANNELS];
     QThread *workerThread  = nullptr;
     PlaybackWorker *worker = nullptr;
 
-    bool buffering = true;
     bool running = false;
     bool ready = false;
-    float *current_buffer = nullptr;
     float volume = 1;
 
     std::string  device;
-    unsigned int completed = 0;
-    unsigned int ptr = 0;
     unsigned int sampRate;
     unsigned int bufferSize;
+    unsigned int openChannels = 0;
 
     void startWorker(void);
+    void refreshChannelGain(int channel);
 
     public:
       static bool enumerateDevices(std::vector<GenericAudioDevice> &);
@@ -177,13 +165,27 @@ namespace SigDigger {
       virtual ~AudioPlayback();
       unsigned int getSampleRate(void) const;
       void setSampleRate(unsigned int);
-      void write(const SUCOMPLEX *samples, SUSCOUNT size);
+      void write(int channel, const SUCOMPLEX *samples, SUSCOUNT size);
       void start(void);
       void stop(void);
       float getVolume(void) const;
       void setVolume(float);
       void cancelPlayBack(void);
 
+      // Mixer channel API
+      int openChannel(void);
+      void closeChannel(int channel);
+      unsigned int getOpenChannelCount(void) const;
+      void setChannelVolume(int channel, float volume);
+      void setChannelPan(int channel, float pan);
+      void setChannelMuted(int channel, bool muted);
+      float getChannelRateCorrection(int channel) const;
+      unsigned int getChannelUnderruns(int channel) const;
+      void setChannelDSPConfig(int channel, AudioDSPConfig const &);
+      void getChannelDSPStats(
+          int channel,
+          std::vector<AudioDSPStageStats> &) const;
+
       inline bool
       isRunning(void) const
       {
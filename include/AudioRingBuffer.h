@@ -0,0 +1,84 @@
+//
+//    AudioRingBuffer.h: Wait-free single producer, single consumer ring
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace SigDigger {
+  //
+  // Ring of float samples with exactly one producer thread and one
+  // consumer thread. Head and tail are free running counters: the producer
+  // only writes the head and the consumer only writes the tail, so neither
+  // side ever waits for the other.
+  //
+  class AudioRingBuffer {
+    std::vector<float> m_buffer;
+    size_t m_mask;
+
+    alignas(64) std::atomic<size_t> m_head; // Written by the producer
+    alignas(64) std::atomic<size_t> m_tail; // Written by the consumer
+
+  public:
+    // Capacity is 2^order samples
+    explicit AudioRingBuffer(unsigned int order);
+
+    inline size_t
+    capacity() const
+    {
+      return m_mask + 1;
+    }
+
+    inline size_t
+    available() const
+    {
+      return
+          m_head.load(std::memory_order_acquire)
+          - m_tail.load(std::memory_order_acquire);
+    }
+
+    inline size_t
+    space() const
+    {
+      return this->capacity() - this->available();
+    }
+
+    // Write position. Everything queued so far lies before it
+    inline size_t
+    mark() const
+    {
+      return m_head.load(std::memory_order_acquire);
+    }
+
+    // Producer side
+    size_t writeSpan(float **ptr);
+    void   commitWrite(size_t);
+    size_t write(const float *data, size_t len);
+
+    // Consumer side
+    size_t read(float *data, size_t len);
+    size_t skip(size_t len);
+    void   discard();
+    void   discard(size_t mark);
+  };
+}
+
+#endif // AUDIORINGBUFFER_H
@@ -0,0 +1,77 @@
+//
+//    BookmarkIndex.h: Interval index of bookmarks by occupied band
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef BOOKMARKINDEX_H
+#define BOOKMARKINDEX_H
+
+#include <Suscan/Library.h>
+#include <vector>
+
+// Above this many hits, range queries keep one bookmark per bucket
+#define SIGDIGGER_BOOKMARK_INDEX_LOD_BUCKETS 256
+
+namespace SigDigger {
+  struct BookmarkIndexEntry {
+    qint64 low;
+    qint64 high;
+    BookmarkInfo info;
+  };
+
+  //
+  // Static interval tree over [frequency + lowFreqCut,
+  // frequency + highFreqCut]. Entries are sorted by lower edge and laid out
+  // as an implicit balanced tree (the root of [lo, hi) is its middle
+  // element), each node holding the highest upper edge of its subtree.
+  // The index is rebuilt from the singleton only when its bookmark
+  // revision changes.
+  //
+  class BookmarkIndex {
+    std::vector<BookmarkIndexEntry> m_entries;
+    std::vector<qint64> m_maxHigh;
+    quint64 m_revision = 0;
+    bool    m_built = false;
+
+    qint64 buildNode(size_t lo, size_t hi);
+    void queryNode(
+        size_t lo,
+        size_t hi,
+        qint64 start,
+        qint64 end,
+        std::vector<const BookmarkIndexEntry *> &) const;
+
+  public:
+    bool refresh();
+    void build(QMap<qint64, Suscan::Bookmark> const &);
+
+    size_t size() const;
+    quint64 revision() const;
+
+    // Views remain valid until the next refresh()
+    void query(
+        qint64 start,
+        qint64 end,
+        std::vector<const BookmarkIndexEntry *> &) const;
+    void queryLOD(
+        qint64 start,
+        qint64 end,
+        std::vector<const BookmarkIndexEntry *> &,
+        unsigned int buckets = SIGDIGGER_BOOKMARK_INDEX_LOD_BUCKETS) const;
+  };
+}
+
+#endif // BOOKMARKINDEX_H
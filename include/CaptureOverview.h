@@ -0,0 +1,114 @@
+//
+//    CaptureOverview.h: Persistent multi-level summary of capture files
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef CAPTUREOVERVIEW_H
+#define CAPTUREOVERVIEW_H
+
+#include <QObject>
+#include <QString>
+#include <sigutils/types.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Samples summarized by each entry of the first level
+#define SIGDIGGER_OVERVIEW_BLOCK_SAMPLES 4096
+// Entries of a level summarized by each entry of the next one
+#define SIGDIGGER_OVERVIEW_FANOUT        16
+#define SIGDIGGER_OVERVIEW_MAX_WORKERS   8
+// Smaller captures are scanned fast enough not to need an overview file
+#define SIGDIGGER_OVERVIEW_MIN_SAMPLES   (1 << 24)
+#define SIGDIGGER_OVERVIEW_SUFFIX        ".sdoverview"
+
+namespace SigDigger {
+  struct CaptureOverviewEntry {
+    SUFLOAT minI, maxI;
+    SUFLOAT minQ, maxQ;
+    SUFLOAT envelope;   // Largest magnitude
+    SUFLOAT reserved;
+    double  sumI, sumQ;
+    double  sumPower;
+  };
+
+  struct CaptureOverviewStats {
+    SUCOMPLEX min = 0;
+    SUCOMPLEX max = 0;
+    SUCOMPLEX mean = 0;
+    SUFLOAT   rms = 0;
+    SUFLOAT   envelope = 0;
+    size_t    count = 0;
+  };
+
+  //
+  // Min, max, mean, RMS and envelope of a capture, per block of samples
+  // and then per group of blocks, up to a single entry for the whole
+  // file. Statistics of any range are assembled from the largest entries
+  // that fit in it, plus the samples at both edges.
+  //
+  // The overview is built in a background thread and then saved next to
+  // the capture (or in the cache directory, if that is not writable), so
+  // the whole file is only scanned the first time it is opened. Saved
+  // overviews are discarded if the size or modification time of the
+  // capture changes.
+  //
+  class CaptureOverview : public QObject {
+    Q_OBJECT
+
+    const SUCOMPLEX *m_data = nullptr;
+    size_t           m_length = 0;
+
+    std::vector<std::vector<CaptureOverviewEntry>> m_levels;
+
+    std::atomic<bool> m_complete;
+    std::atomic<bool> m_cancelled;
+    std::thread       m_worker;
+
+    static QString cachePath(QString const &capturePath);
+    bool loadFrom(QString const &path, QString const &capturePath, QString const &tag);
+    bool saveTo(QString const &path, QString const &capturePath, QString const &tag) const;
+    bool build();
+
+    void scan(CaptureOverviewEntry &, size_t from, size_t to) const;
+
+  public:
+    CaptureOverview(
+        const SUCOMPLEX *data,
+        size_t length,
+        QObject *parent = nullptr);
+    ~CaptureOverview() override;
+
+    // The tag identifies how samples were decoded (format, channels...)
+    bool load(QString const &capturePath, QString const &tag);
+    void buildInBackground(QString const &capturePath, QString const &tag);
+
+    // Stops the build and waits for the worker. Call before the samples
+    // are released. ready() may still be queued to receivers afterwards.
+    void cancel();
+
+    bool isComplete() const;
+    bool covers(const SUCOMPLEX *data, size_t length) const;
+
+    CaptureOverviewStats stats() const;
+    CaptureOverviewStats stats(size_t from, size_t to) const;
+
+  signals:
+    void ready();
+  };
+}
+
+#endif // CAPTUREOVERVIEW_H
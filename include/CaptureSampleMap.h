@@ -0,0 +1,118 @@
+//
+//    CaptureSampleMap.h: Capture files mapped as complex float samples
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef CAPTURESAMPLEMAP_H
+#define CAPTURESAMPLEMAP_H
+
+#include <QFile>
+#include <QString>
+#include <QTemporaryFile>
+#include <sigutils/types.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Samples converted per read from the capture file (8 MiB of output)
+#define SIGDIGGER_CAPTURE_MAP_CHUNK_SAMPLES (1 << 20)
+
+namespace SigDigger {
+  //
+  // Presents a capture file as a contiguous array of SUCOMPLEX, whatever
+  // its sample format is. float32 I/Q files are mapped as they are and open
+  // instantly. Other formats are converted up front by convert(), which is
+  // meant to run in a worker thread, into a file in the user cache
+  // directory that is then mapped read-only. The kernel pages that mapping
+  // in and out like any other file, so captures larger than the memory can
+  // still be displayed. If that file cannot be written, the samples are
+  // converted into memory instead.
+  //
+  // Converting on demand is not possible here: the waveform widgets take a
+  // plain pointer and scan the whole capture to build their overviews.
+  //
+  class CaptureSampleMap {
+  public:
+    enum Format {
+      UNSIGNED8,
+      SIGNED8,
+      SIGNED16,
+      FLOAT32
+    };
+
+    // Receives the samples converted so far and the total. Returning
+    // false cancels the conversion.
+    typedef std::function<bool (size_t, size_t)> ProgressCallback;
+
+  private:
+    QFile m_file;
+    const uint8_t *m_map = nullptr;
+    const SUCOMPLEX *m_data = nullptr;
+    size_t m_length = 0;
+    qreal m_sampleRate = 0;
+    QString m_lastError;
+
+    // Source of the conversion
+    QString m_path;
+    Format m_format = FLOAT32;
+    unsigned int m_channels = 2;
+    qint64 m_offset = 0;
+
+    std::unique_ptr<QTemporaryFile> m_tempFile;
+    uchar *m_tempMap = nullptr;
+    std::vector<SUCOMPLEX> m_converted;
+    bool m_cancelled = false;
+    bool m_writeFailed = false;
+
+    void close();
+    bool convertTo(
+        QFileDevice *dest,
+        SUCOMPLEX *buffer,
+        ProgressCallback const &);
+
+  public:
+    CaptureSampleMap();
+    ~CaptureSampleMap();
+
+    bool open(
+        QString const &path,
+        Format format,
+        unsigned int channels = 2,
+        qint64 offset = 0,
+        qint64 size = -1);
+
+    bool openWav(QString const &path);
+
+    // True after a successful open() until convert() succeeds
+    bool needsConversion() const;
+    bool convert(ProgressCallback const & = ProgressCallback());
+    bool cancelled() const;
+
+    const SUCOMPLEX *data() const;
+    size_t length() const;
+    qreal sampleRate() const;
+    QString lastError() const;
+
+    static void convert(
+        SUCOMPLEX *dest,
+        const uint8_t *src,
+        size_t count,
+        Format format,
+        unsigned int channels);
+  };
+}
+
+#endif // CAPTURESAMPLEMAP_H
@@ -33,8 +33,14 @@ namespace SigDigger {
   {
       Q_OBJECT
 
+      // Rows of the device table, in order
+      std::vector<const suscan_source_device_t *> rowDevices;
+      std::vector<bool> rowAvailable;
+
       static QPixmap getDeviceIcon(Suscan::Source::Device const &);
       void setRefreshing(bool refreshing);
+      void setHeaders(void);
+      void setRow(int row, Suscan::Source::Device const &);
       void connectAll(void);
 
     public:
@@ -0,0 +1,59 @@
+//
+//    DeviceHotplugMonitor.h: Trigger device rescans on USB hot-plug
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef DEVICEHOTPLUGMONITOR_H
+#define DEVICEHOTPLUGMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+
+// Plugging a device creates several nodes in a row. Wait for them to settle.
+#define SIGDIGGER_HOTPLUG_DEBOUNCE_MS 1500
+#define SIGDIGGER_HOTPLUG_USB_PATH    "/dev/bus/usb"
+
+class QFileSystemWatcher;
+
+namespace SigDigger {
+  //
+  // udev creates and removes a node under /dev/bus/usb/<bus> for every
+  // USB device that comes and goes. Watching those directories is enough
+  // to know when to rescan, without linking against libudev. On systems
+  // without that tree, the monitor simply never fires.
+  //
+  class DeviceHotplugMonitor : public QObject {
+    Q_OBJECT
+
+    QFileSystemWatcher *m_watcher = nullptr;
+    QTimer m_debounce;
+
+    void watchBuses();
+
+  public:
+    explicit DeviceHotplugMonitor(QObject *parent = nullptr);
+
+    bool isActive() const;
+
+  signals:
+    void changed();
+
+  public slots:
+    void onDirectoryChanged(QString);
+  };
+}
+
+#endif // DEVICEHOTPLUGMONITOR_H
@@ -0,0 +1,162 @@
+//
+//    DopplerTable.h: Shared, precomputed Doppler tables
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef DOPPLERTABLE_H
+#define DOPPLERTABLE_H
+
+#include <QObject>
+#include <QHash>
+#include <Suscan/Library.h>
+#include <sgdp4/sgdp4.h>
+#include <sys/time.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Initial and minimum sampling step of a table, in seconds
+#define SIGDIGGER_DOPPLER_TABLE_STEP        16.
+#define SIGDIGGER_DOPPLER_TABLE_MIN_STEP    .5
+// Maximum range rate interpolation error, in km/s (1 cm/s)
+#define SIGDIGGER_DOPPLER_TABLE_TOLERANCE   1e-5
+// Time added before AOS and after LOS when tabulating a pass, in seconds
+#define SIGDIGGER_DOPPLER_TABLE_MARGIN      60.
+// Tables kept by the service before the least recently used is dropped
+#define SIGDIGGER_DOPPLER_TABLE_MAX_ENTRIES 32
+// Time before a table that failed to build is attempted again, in ms
+#define SIGDIGGER_DOPPLER_TABLE_RETRY_MS    60000
+
+namespace SigDigger {
+  struct DopplerSample {
+    qreal azimuth;   // Radians, unwrapped
+    qreal elevation; // Radians
+    qreal range;     // km
+    qreal rangeRate; // km/s
+  };
+
+  //
+  // Satellite position and range rate over a time window, sampled on a
+  // uniform grid and interpolated with 4-point Lagrange polynomials. The
+  // step is halved until the interpolation error at the middle of every
+  // interval (checked against direct SGP4 evaluation) is below the
+  // tolerance. That error is kept as the bound of the table.
+  //
+  // Tables do not depend on the carrier frequency: Doppler shift and rate
+  // are derived from the range rate and its derivative at query time.
+  //
+  class DopplerTable {
+    double m_start = 0;
+    double m_step = 0;
+    qreal  m_maxError = 0;
+    qreal  m_maxAzElError = 0;
+    std::vector<DopplerSample> m_samples;
+
+    int window(double t, double &x) const;
+
+  public:
+    bool build(
+        orbit_t const *,
+        xyz_t const &qth,
+        double start,
+        double end,
+        qreal tolerance = SIGDIGGER_DOPPLER_TABLE_TOLERANCE);
+
+    bool covers(double t) const;
+    bool covers(struct timeval const &) const;
+
+    bool azel(double t, xyz_t &azel) const;
+    bool rangeRate(double t, qreal &rate, qreal &accel) const;
+
+    qreal doppler(double t, qreal frequency) const;
+    qreal dopplerRate(double t, qreal frequency) const;
+
+    // Interpolation error bounds
+    qreal maxError() const;
+    qreal maxAzElError() const;
+    qreal maxDopplerError(qreal frequency) const;
+
+    double start() const;
+    double end() const;
+    double step() const;
+    size_t size() const;
+  };
+
+  typedef std::shared_ptr<const DopplerTable> DopplerTablePtr;
+
+  //
+  // Builds Doppler tables in the background and shares them among all
+  // consumers. Tables are keyed by orbit, TLE epoch, QTH and window, so
+  // every dialog following the same pass gets the same table.
+  //
+  class DopplerTableService : public QObject {
+    Q_OBJECT
+
+    struct Request {
+      QString key;
+      Suscan::Orbit orbit;
+      xyz_t qth;
+      double start;
+      double end;
+    };
+
+    struct Entry {
+      DopplerTablePtr table;
+      quint64 lastUse;
+    };
+
+    static DopplerTableService *m_currInstance;
+
+    QHash<QString, Entry> m_tables;
+    QHash<QString, bool>  m_pending;
+    QHash<QString, qint64> m_failed;   // Key -> time of the failure
+    std::deque<Request>   m_queue;
+    quint64               m_useCounter = 0;
+
+    std::mutex  m_mutex;
+    std::thread m_worker;
+    bool        m_running = false;
+
+    DopplerTableService(QObject *parent = nullptr);
+    void work();
+    void store(QString const &, DopplerTablePtr const &);
+    static qint64 now();
+
+  public:
+    static DopplerTableService *instance();
+    static QString makeKey(
+        orbit_t const &,
+        xyz_t const &qth,
+        double start,
+        double end);
+
+    DopplerTablePtr find(QString const &key);
+    DopplerTablePtr request(
+        orbit_t const &,
+        xyz_t const &qth,
+        struct timeval const &start,
+        struct timeval const &end,
+        QString *key = nullptr);
+
+  signals:
+    void tableReady(QString key);
+  };
+}
+
+#endif // DOPPLERTABLE_H
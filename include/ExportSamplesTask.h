@@ -21,9 +21,8 @@
 
 #include <Suscan/CancellableTask.h>
 #include <QElapsedTimer>
-#include <sigutils/matfile.h>
-#include <iomanip>
 #include <fstream>
+#include <sndfile.h>
 #include "SigDiggerHelpers.h"
 
 namespace SigDigger {
@@ -33,7 +32,6 @@ namespace SigDigger {
 
       std::ofstream of;
       SNDFILE *sfp = nullptr;
-      su_mat_file_t *mf = nullptr;
 
       QElapsedTimer timer;
       QString path;
@@ -46,17 +44,16 @@ namespace SigDigger {
       QString lastError;
 
       bool openMat5(void);
-      bool openMatlab(void);
+      bool openStream(void);
+      bool openNpy(void);
       bool openWav(void);
       bool openRaw(void);
 
-      bool exportToMat5(void);
+      bool exportBinary(QString const &);
       bool exportToMatlab(void);
       bool exportToWav(void);
 
-      bool cancelFlag = false;
-
-      void breathe(quint64);
+      bool breathe(quint64);
 
     public:
       ExportSamplesTask(
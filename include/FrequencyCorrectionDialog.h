@@ -23,6 +23,7 @@
 #include <Suscan/Library.h>
 #include <sgdp4/sgdp4.h>
 #include <ColorConfig.h>
+#include <DopplerTable.h>
 #include <QTimer>
 
 #define FREQUENCY_CORRECTION_DIALOG_TIME_WINDOW_MIN (1 * 86400.0)  // 1 day
@@ -37,6 +38,8 @@ namespace Suscan {
 };
 
 namespace SigDigger {
+  class UpcomingPassesDialog;
+
   class FrequencyCorrectionDialog : public QDialog
   {
     Q_OBJECT
@@ -47,6 +50,9 @@ namespace SigDigger {
     orbit_t currentOrbit = orbit_INITIALIZER;
     QTimer timer;
     ColorConfig colors;
+    UpcomingPassesDialog *passesDialog = nullptr;
+    DopplerTablePtr dopplerTable;
+    QString dopplerTableKey;
 
     bool haveOrbit = false;
     bool realTime  = true;
@@ -75,6 +81,11 @@ namespace SigDigger {
     void parseCurrentTLE(void);
     void updatePrediction(void);
     void recalcALOS(void);
+    void requestDopplerTable(void);
+    void evaluate(
+        struct timeval const &,
+        xyz_t &azel,
+        qreal *rangeRate = nullptr);
     void connectAll(void);
     void refreshUiState(void);
     void refreshOrbit(void);
@@ -124,6 +135,9 @@ namespace SigDigger {
     void onToggleOrbitType(void);
     void onTLEEdit(void);
     void onTick(void);
+    void onShowPasses(void);
+    void onPassSelected(QString);
+    void onDopplerTableReady(QString);
 
   private:
     Ui::FrequencyCorrectionDialog *ui;
@@ -35,6 +35,7 @@ namespace SigDigger {
 
   public:
     GenericAudioPlayer(unsigned int sampleRate);
+    // Samples are interleaved, len is given in frames
     virtual bool write(const float *samples, size_t len) = 0;
     virtual ~GenericAudioPlayer();
   };
@@ -102,9 +102,15 @@ namespace SigDigger {
       quint64 writeTime = 0;
       quint64 size = 0;
 
+      bool ownsWriter = false;
+
       // Private methods
       void doCommit(void);
 
+    protected:
+      // The writer is deleted once the worker is done with it
+      void setWriterOwnership(bool);
+
     public:
       explicit GenericDataSaver(
           GenericDataWriter *writer,
@@ -42,6 +42,7 @@ namespace SigDigger {
         bool useGlInWindows;
         bool enableMsgTTL;
         unsigned int msgTTL;
+        bool adaptivePSD;
         std::string infoText;
         QColor infoTextColor;
 
@@ -32,10 +32,13 @@ namespace SigDigger {
   class InitThread: public QThread {
     Q_OBJECT
 
+    bool m_profile = false;
+
     void run() override;
 
   public:
     InitThread(QObject *parent);
+    void setProfiling(bool);
 
   signals:
     void done();
@@ -61,6 +64,7 @@ namespace SigDigger {
   public:
     Loader(Application *app);
     ~Loader();
+    void setStartupProfile(bool);
     void load();
 
   public slots:
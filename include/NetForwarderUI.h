@@ -49,7 +49,9 @@ namespace SigDigger {
     void setForwardState(bool state);
     void setForwardEnabled(bool enabled);
     void setCaptureSize(quint64 size);
+    void setServerStats(quint64 size, unsigned int subscribers, quint64 dropped);
     void setTcp(bool);
+    void setSeqHeader(bool);
 
     // Getters
     std::string getHost(void) const;
@@ -57,9 +59,13 @@ namespace SigDigger {
     unsigned int getFrameLen(void) const;
     bool getForwardState(void) const;
     bool getTcp(void) const;
+    bool isServer(void) const;
+    bool isLocalServer(void) const;
+    bool getSeqHeader(void) const;
 
   public slots:
     void onForwardStartStop(void);
+    void onSocketTypeChanged(void);
 
   signals:
     void forwardStateChanged(bool state);
@@ -0,0 +1,79 @@
+//
+//    PSDRateController.h: Keep the spectrum stream within the link capacity
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef PSDRATECONTROLLER_H
+#define PSDRATECONTROLLER_H
+
+// Relative arrival lag above which the link is considered saturated
+#define SIGDIGGER_PSD_RATE_DEGRADE_LAG    .3
+// Relative arrival lag below which the link is considered relaxed
+#define SIGDIGGER_PSD_RATE_RECOVER_LAG    .05
+// Fraction of the TTL the latency must stay under to recover
+#define SIGDIGGER_PSD_RATE_RECOVER_TTL    .5
+// Consecutive saturated updates before degrading
+#define SIGDIGGER_PSD_RATE_DEGRADE_COUNT  5
+// Seconds to wait after a change before measuring again
+#define SIGDIGGER_PSD_RATE_SETTLE_TIME    2.
+// Seconds of relaxed link before undoing one step
+#define SIGDIGGER_PSD_RATE_RECOVER_TIME   10.
+#define SIGDIGGER_PSD_RATE_MAX_RECOVER_TIME 160.
+#define SIGDIGGER_PSD_RATE_STEP           1.5
+#define SIGDIGGER_PSD_RATE_MIN_RATE       2.
+#define SIGDIGGER_PSD_RATE_MIN_FFT_SIZE   1024
+
+namespace SigDigger {
+  //
+  // Closed loop over the spectrum update interval and FFT size. The rate is
+  // lowered first and the FFT size next, one step at a time, whenever
+  // spectrum messages keep arriving late or stale. Steps are undone in
+  // reverse order after the link has been relaxed for a while. A recovery
+  // that saturates the link again doubles the time the next one waits.
+  //
+  class PSDRateController {
+    double       m_targetInterval = .04;
+    unsigned int m_targetSize     = 8192;
+    double       m_interval       = .04;
+    unsigned int m_size           = 8192;
+
+    double       m_lastChange     = -1;
+    double       m_relaxedSince   = -1;
+    double       m_recoverTime    = SIGDIGGER_PSD_RATE_RECOVER_TIME;
+    unsigned int m_saturated      = 0;
+    bool         m_lastWasRecover = false;
+
+    bool degrade();
+    bool recover();
+
+  public:
+    void setTarget(double interval, unsigned int size);
+    void reset();
+
+    // Returns true if the effective parameters changed
+    bool feed(double now, double lag, double latency, double ttl);
+
+    bool isEngaged() const;
+    bool isEffective(double interval, unsigned int size) const;
+
+    double interval() const;
+    unsigned int fftSize() const;
+    double targetInterval() const;
+    unsigned int targetFftSize() const;
+  };
+}
+
+#endif // PSDRATECONTROLLER_H
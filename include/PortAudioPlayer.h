@@ -32,7 +32,11 @@ namespace SigDigger {
     static void paFinalizer(void);
 
   public:
-    PortAudioPlayer(std::string const &dev, unsigned int rate, size_t bufSiz);
+    PortAudioPlayer(
+        std::string const &dev,
+        unsigned int rate,
+        size_t bufSiz,
+        unsigned int channels = 1);
     static GenericAudioDevice deviceIndexToDevice(PaDeviceIndex index);
     static PaDeviceIndex strToDeviceIndex(std::string const &);
     static GenericAudioDevice getDefaultDevice();
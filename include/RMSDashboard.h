@@ -0,0 +1,88 @@
+//
+//    RMSDashboard.h: Overview of all RMS viewer connections
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef RMSDASHBOARD_H
+#define RMSDASHBOARD_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <RMSIngestServer.h>
+
+#define RMS_DASHBOARD_REFRESH_MS   250
+#define RMS_DASHBOARD_CELL_WIDTH   320
+#define RMS_DASHBOARD_CELL_HEIGHT  120
+
+namespace SigDigger {
+  struct RMSDashboardCell {
+    RMSFeedPtr   feed;
+    QString      name;
+    RMSFeedStats stats;
+    std::vector<RMSHistoryBucket> summary;
+    size_t       span = 1;
+
+    // Ingest rate estimation
+    uint64_t     prevSamples = 0;
+    qreal        ingestRate = 0;
+  };
+
+  //
+  // Draws every feed in a grid of small plots, straight from the bounded
+  // summaries kept by the feeds. Cost does not depend on how much data
+  // has been received, nor on how fast.
+  //
+  class RMSDashboard : public QWidget
+  {
+    Q_OBJECT
+
+    std::vector<RMSDashboardCell> m_cells;
+    QTimer        m_timer;
+    QElapsedTimer m_clock;
+    qint64        m_lastUpdate = 0;
+
+    void relayout();
+    int  columns() const;
+    QRect cellRect(int) const;
+    int  cellAt(QPoint const &) const;
+    void paintCell(QPainter &, RMSDashboardCell const &, QRect const &);
+
+  protected:
+    void paintEvent(QPaintEvent *) override;
+    void mouseDoubleClickEvent(QMouseEvent *) override;
+    void contextMenuEvent(QContextMenuEvent *) override;
+
+  public:
+    explicit RMSDashboard(QWidget *parent = nullptr);
+
+    void addFeed(RMSFeedPtr const &);
+    void removeFeed(int);
+    int  count() const;
+    RMSFeedPtr feed(int) const;
+    QString name(int) const;
+
+  signals:
+    void feedActivated(int);
+    void feedDisconnectRequested(int);
+    void feedRemoveRequested(int);
+
+  public slots:
+    void onTimeout();
+  };
+}
+
+#endif // RMSDASHBOARD_H
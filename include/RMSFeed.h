@@ -0,0 +1,123 @@
+//
+//    RMSFeed.h: Power measurements received from a remote data logger
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef RMSFEED_H
+#define RMSFEED_H
+
+#include <RMSStreamParser.h>
+#include <RMSHistory.h>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Resolution of the whole-feed summary drawn by the dashboard
+#define RMS_FEED_SUMMARY_BUCKETS  512
+
+// Samples waiting for the GUI when a detailed view is open. Beyond this,
+// new samples are dropped and counted.
+#define RMS_FEED_MAX_PENDING      (1 << 20)
+
+namespace SigDigger {
+  struct RMSFeedSample {
+    double timeStamp;
+    float  mag;
+  };
+
+  struct RMSFeedStats {
+    uint64_t bytes   = 0;
+    uint64_t samples = 0;
+    uint64_t errors  = 0;
+    uint64_t dropped = 0;
+    size_t   backlog = 0;  // Samples not yet taken by the detailed view
+    double   rate    = 0;  // Sample rate announced by the peer
+    double   lastTimeStamp = 0;
+    float    last    = 0;
+    bool     closed  = false;
+  };
+
+  //
+  // Bounded summary of an unbounded feed: a fixed number of min / max /
+  // mean buckets, whose span doubles every time they fill up.
+  //
+  class RMSDecimatedBuffer {
+    std::vector<RMSHistoryBucket> m_buckets;
+    size_t m_span = 1;
+
+    // Bucket being filled
+    float  m_min = 0;
+    float  m_max = 0;
+    double m_sum = 0;
+    size_t m_count = 0;
+
+    void compact();
+
+  public:
+    RMSDecimatedBuffer();
+
+    void clear();
+    void append(float);
+
+    size_t span() const;
+    std::vector<RMSHistoryBucket> const &buckets() const;
+  };
+
+  //
+  // A connection to the RMS viewer. Data is received and parsed by an
+  // I/O thread (ingest), while the GUI reads summaries, statistics and,
+  // if a detailed view is open, every sample (take). Everything is
+  // protected by a single lock, taken once per received block.
+  //
+  class RMSFeed : public RMSStreamListener {
+    mutable std::mutex m_mutex;
+
+    // I/O thread only
+    RMSStreamParser    m_parser;
+
+    std::string        m_peer;
+    std::string        m_title;
+    RMSDecimatedBuffer m_summary;
+    RMSFeedStats       m_stats;
+    bool               m_detailed = false;
+    std::vector<RMSFeedSample> m_pending;
+
+  public:
+    // RMSStreamListener (with the lock held)
+    void onTitle(const char *, size_t) override;
+    void onRate(double) override;
+    void onSample(double, double) override;
+
+    // I/O thread. Returns false if the peer must be disconnected.
+    bool ingest(const char *, size_t);
+    void setPeer(std::string const &);
+    void setClosed();
+
+    // GUI thread
+    std::string peer() const;
+    std::string title() const;
+    RMSFeedStats stats() const;
+    size_t summary(std::vector<RMSHistoryBucket> &) const;
+    void setDetailed(bool);
+    bool take(std::vector<RMSFeedSample> &);
+  };
+
+  typedef std::shared_ptr<RMSFeed> RMSFeedPtr;
+}
+
+#endif // RMSFEED_H
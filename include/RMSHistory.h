@@ -0,0 +1,102 @@
+//
+//    RMSHistory.h: Multi-resolution store of power measurements
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef RMSHISTORY_H
+#define RMSHISTORY_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+
+// Every bucket of level n + 1 summarizes this many buckets of level n
+#define RMS_HISTORY_DECIMATION       16
+
+// Full-resolution samples kept in memory. Older ones go to a temporary
+// file, in chunks of RMS_HISTORY_SPILL_CHUNK samples.
+#define RMS_HISTORY_MEMORY_SAMPLES   (1 << 22)
+#define RMS_HISTORY_SPILL_CHUNK      (1 << 20)
+
+namespace SigDigger {
+  struct RMSHistoryBucket {
+    float min;
+    float max;
+    float mean;
+  };
+
+  //
+  // Append-only store of power measurements. Besides the measurements
+  // themselves (level 0) it keeps min / max / mean summaries of them at
+  // decreasing resolutions, so long captures can be drawn and fitted
+  // without walking every sample.
+  //
+  class RMSHistory {
+    struct Level {
+      std::vector<RMSHistoryBucket> buckets;
+
+      // Bucket being filled
+      float  min = 0;
+      float  max = 0;
+      double sum = 0;
+      size_t count = 0;
+
+      // Extrema of the means of all complete buckets
+      float  meanMin = 0;
+      float  meanMax = 0;
+    };
+
+    std::vector<float> m_samples; // Most recent level 0 samples
+    size_t m_spilled = 0;         // Level 0 samples in m_spillFile
+    FILE  *m_spillFile = nullptr;
+    bool   m_spillFailed = false;
+
+    float  m_min = 0;
+    float  m_max = 0;
+    float  m_last = 0;
+
+    std::vector<Level> m_levels;  // Level n + 1 at m_levels[n]
+
+    void feedLevel(size_t, float min, float max, float mean);
+    void spill();
+
+  public:
+    RMSHistory();
+    ~RMSHistory();
+
+    RMSHistory(RMSHistory const &) = delete;
+    RMSHistory &operator=(RMSHistory const &) = delete;
+
+    void clear();
+    void append(float);
+
+    size_t size() const;                  // Level 0 samples
+    size_t size(unsigned int level) const;
+    unsigned int levels() const;          // Including level 0
+    float  last() const;
+
+    // Complete buckets of level > 0
+    RMSHistoryBucket const &bucket(unsigned int level, size_t index) const;
+
+    // Range of the values stored at a given level (means, for level > 0)
+    bool extrema(unsigned int level, float &min, float &max) const;
+
+    // Level 0 samples, including those spilled to disk
+    size_t read(size_t offset, float *, size_t count) const;
+  };
+}
+
+#endif // RMSHISTORY_H
@@ -0,0 +1,92 @@
+//
+//    RMSIngestServer.h: Accept data loggers on a pool of I/O threads
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef RMSINGESTSERVER_H
+#define RMSINGESTSERVER_H
+
+#include <QTcpServer>
+#include <QMap>
+#include <memory>
+#include <vector>
+#include <list>
+#include <RMSFeed.h>
+
+#define RMS_INGEST_MAX_THREADS  4
+#define RMS_INGEST_READ_SIZE    (64 << 10)
+
+class QThread;
+class QTcpSocket;
+
+namespace SigDigger {
+  // Lives in an I/O thread. Reads and parses the sockets assigned to it.
+  class RMSIngestWorker : public QObject
+  {
+    Q_OBJECT
+
+    QMap<QTcpSocket *, RMSFeedPtr> m_sockets;
+    std::vector<char> m_buffer;
+
+    void readAll(QTcpSocket *);
+
+  public:
+    explicit RMSIngestWorker(QObject *parent = nullptr);
+    ~RMSIngestWorker() override;
+
+    void adopt(qintptr, RMSFeedPtr);
+    void close(RMSFeedPtr);
+
+  public slots:
+    void onReadyRead();
+    void onDisconnected();
+  };
+
+  //
+  // Drop-in replacement of QTcpServer for the RMS viewer: connections are
+  // accepted in the GUI thread and handed over round-robin to a small pool
+  // of I/O threads, which read and parse them. The GUI is notified of new
+  // feeds through newFeed().
+  //
+  class RMSIngestServer : public QTcpServer
+  {
+    Q_OBJECT
+
+    std::vector<QThread *>         m_threads;
+    std::vector<RMSIngestWorker *> m_workers;
+    unsigned int                   m_next = 0;
+
+    std::list<RMSFeedPtr>               m_pendingFeeds;
+    QMap<RMSFeed *, RMSIngestWorker *>  m_feedToWorker;
+
+  protected:
+    void incomingConnection(qintptr) override;
+
+  public:
+    explicit RMSIngestServer(QObject *parent = nullptr);
+    ~RMSIngestServer() override;
+
+    unsigned int threadCount() const;
+
+    RMSFeedPtr nextPendingFeed();
+    void closeFeed(RMSFeedPtr const &);
+
+  signals:
+    void newFeed();
+  };
+}
+
+#endif // RMSINGESTSERVER_H
@@ -0,0 +1,76 @@
+//
+//    RMSStreamParser.h: Parse power measurement streams
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef RMSSTREAMPARSER_H
+#define RMSSTREAMPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define RMS_STREAM_PARSER_MAX_LINE_SIZE     4096
+#define RMS_STREAM_PARSER_BINARY_RECORD     12 // f64 timestamp + f32 power
+
+namespace SigDigger {
+  class RMSStreamListener {
+  public:
+    virtual ~RMSStreamListener();
+
+    virtual void onTitle(const char *, size_t) = 0;
+    virtual void onRate(double) = 0;
+    virtual void onSample(double timeStamp, double mag) = 0;
+  };
+
+  //
+  // Incremental parser of the data loggers' text protocol:
+  //
+  //   DESC,<title>
+  //   RATE,<rate>
+  //   <sec>,<usec>,<mag>,<dB>
+  //
+  // Data is scanned in place, in whatever blocks it arrives. Only lines
+  // split across blocks are copied to a fixed buffer. A `BINARY' line
+  // switches the stream to fixed-size little endian records (f64 timestamp
+  // followed by f32 power) for high-rate feeds.
+  //
+  class RMSStreamParser {
+    char     m_line[RMS_STREAM_PARSER_MAX_LINE_SIZE];
+    size_t   m_lineLen = 0;
+    uint8_t  m_record[RMS_STREAM_PARSER_BINARY_RECORD];
+    size_t   m_recordLen = 0;
+    bool     m_binary = false;
+
+    uint64_t m_records = 0;
+    uint64_t m_errors = 0;
+
+    bool handleLine(const char *, size_t, RMSStreamListener *);
+    void handleRecord(const uint8_t *, RMSStreamListener *);
+
+  public:
+    // Returns false if the peer exceeded the maximum line size
+    bool feed(const char *, size_t, RMSStreamListener *);
+    void reset();
+
+    bool     binary() const;
+    uint64_t records() const; // Lines or binary records parsed
+    uint64_t errors() const;
+
+    static bool parseLine(const char *, size_t, RMSStreamListener *);
+  };
+}
+
+#endif // RMSSTREAMPARSER_H
@@ -26,21 +26,46 @@
 #include <vector>
 #include <ColorConfig.h>
 #include <Waveform.h>
+#include <RMSStreamParser.h>
+#include <RMSHistory.h>
+#include <RMSFeed.h>
 
 namespace Ui {
   class RMSViewTab;
 }
 
 namespace SigDigger {
-  class RMSViewTab : public QWidget
+  class RMSViewTab : public QWidget, public RMSStreamListener
   {
       Q_OBJECT
 
       QTcpSocket *socket = nullptr;
       QTimer timer;
-      std::string line;
+      RMSStreamParser m_parser;
+      std::vector<char> m_readBuffer;
+
+      // Alternatively, data parsed by an I/O thread
+      RMSFeedPtr m_feed;
+      std::vector<RMSFeedSample> m_feedBuffer;
+      std::string m_feedTitle;
+      double m_feedRate = 0;
+
+      // Integrated measurements at full resolution, and the level of
+      // m_history currently drawn in the waveform (`data')
+      RMSHistory m_history;
+      unsigned int m_displayLevel = 0;
       std::vector<SUCOMPLEX> data;
 
+      // Visible range of the waveform, in points of m_displayLevel
+      qint64 m_viewStart = 0;
+      qint64 m_viewEnd = 0;
+      bool   m_changingLevel = false;
+
+      // Set while a block of socket data is being parsed, so that the
+      // waveform is redrawn once per block instead of once per sample
+      bool m_deferRefresh = false;
+      bool m_refreshPending = false;
+
       qreal rate = 1;
       qreal first;
       qreal last;
@@ -68,8 +93,14 @@ namespace SigDigger {
       void refreshSampleRate();
       void connectAll();
       void integrateMeasure(qreal timestamp, SUFLOAT mag);
-      bool parseLine();
+      void refreshWaveform();
+      void appendToDisplay();
+      void setDisplayLevel(unsigned int);
+      unsigned int levelForView() const;
+      qreal getDisplayRate() const;
+      void refreshLastLabel();
       void processSocketData();
+      void processFeedData();
       bool saveToMatlab(QString const &);
       void disconnectSocket();
       void fitVertical();
@@ -108,6 +139,14 @@ namespace SigDigger {
 
       bool running() const;
 
+      void setFeed(RMSFeedPtr const &);
+      RMSFeedPtr feed() const;
+
+      // RMSStreamListener
+      void onTitle(const char *, size_t) override;
+      void onRate(double) override;
+      void onSample(double, double) override;
+
       explicit RMSViewTab(QWidget *parent, QTcpSocket *socket);
       ~RMSViewTab();
 
@@ -133,6 +172,7 @@ namespace SigDigger {
       void onToolTip(int, int, qreal, qreal);
       void onTimeScaleChanged();
       void onAverageTimeChanged();
+      void onHZoom(qint64, qint64);
   };
 
 }
@@ -21,9 +21,9 @@
 #define RMSVIEWER_H
 
 #include <QMainWindow>
-#include <QTcpServer>
-#include <vector>
 #include <QAbstractSocket>
+#include <vector>
+#include <RMSIngestServer.h>
 
 namespace Ui {
   class RMSViewer;
@@ -32,19 +32,23 @@ namespace Ui {
 namespace SigDigger {
   class RMSViewTab;
   class RMSViewerSettingsDialog;
+  class RMSDashboard;
 
   class RMSViewer : public QMainWindow
   {
       Q_OBJECT
 
-      QTcpServer server;
+      RMSIngestServer server;
       RMSViewerSettingsDialog *settingsDialog = nullptr;
+      RMSDashboard *dashboard = nullptr;
+      QWidget *dashboardPage = nullptr;
 
       bool     listening  = false;
       QString  listenAddr = "";
       uint16_t listenPort = 0;
 
-      void openNewView(QTcpSocket *);
+      RMSViewTab *findView(RMSFeedPtr const &) const;
+      void openFeedView(int);
       void connectAll(void);
 
       bool haveAddrData(void) const;
@@ -62,7 +66,10 @@ namespace SigDigger {
 
     public slots:
       void onAcceptError(QAbstractSocket::SocketError socketError);
-      void onNewConnection(void);
+      void onNewFeed(void);
+      void onFeedActivated(int);
+      void onFeedDisconnectRequested(int);
+      void onFeedRemoveRequested(int);
 
       void onToggleListening(void);
       void onOpenSettings(void);
@@ -21,21 +21,111 @@
 
 #include <QObject>
 #include <QMap>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QByteArray>
 #include <list>
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <sigutils/types.h>
+
+// Default maximum rate of property updates pushed to a subscriber
+#define SIGDIGGER_REMOTE_CONTROL_DEFAULT_RATE 10
+
+// Stop pushing updates to clients that do not read them
+#define SIGDIGGER_REMOTE_CONTROL_MAX_BACKLOG  (64 << 10)
+
+// Binary streams. Frames start with a zero byte, which never starts a
+// text reply, so both can be told apart on the same connection.
+#define SIGDIGGER_REMOTE_CONTROL_DEFAULT_STREAM_RATE 10
+#define SIGDIGGER_REMOTE_CONTROL_MAX_POWER_BATCH     4096
+#define SIGDIGGER_REMOTE_CONTROL_FRAME_SYNC          0x00
+#define SIGDIGGER_REMOTE_CONTROL_FRAME_PSD           0x01
+#define SIGDIGGER_REMOTE_CONTROL_FRAME_POWER         0x02
 
 class QTcpSocket;
 class QTcpServer;
+class QTimer;
 
 namespace SigDigger{
+  class RemoteControlServer;
+  class GlobalProperty;
+
+  //
+  // All fields little endian:
+  //
+  //   PSD payload:   f64 timestamp, f64 frequency, f64 sample rate,
+  //                  u32 bins, u32 decimation, f32 power[bins]
+  //   Power payload: u32 count, u32 dropped, {f64 timestamp, f32 power}[count]
+  //
+  struct RemoteControlFrameHeader {
+    uint8_t  sync;
+    uint8_t  type;
+    uint16_t source;   // Power source id, 0 for PSD
+    uint32_t sequence; // Per client and stream, to detect drops
+    uint32_t length;   // Payload bytes
+  };
+
+  struct RemoteControlPowerSample {
+    qreal timestamp;
+    qreal power;
+  };
+
+  struct RemoteControlStream {
+    qint64   interval = 1000 / SIGDIGGER_REMOTE_CONTROL_DEFAULT_STREAM_RATE;
+    qint64   lastPush = -1;
+    uint32_t sequence = 0;
+
+    // PSD: bins requested (0 = all) and last frame sent
+    unsigned int bins = 0;
+    quint64      lastFrame = 0;
+
+    // Power: samples accumulated since the last push
+    std::deque<RemoteControlPowerSample> samples;
+    uint32_t dropped = 0;
+  };
+
   struct RemoteControlClient {
     QTcpSocket *socket = nullptr;
+    RemoteControlServer *server = nullptr;
     std::list<RemoteControlClient *>::iterator iterator;
 
-    // Context (at the time being: null)
-    RemoteControlClient(QTcpSocket *);
+    // Subscriptions. Changes are coalesced in `pending' and pushed at
+    // most once every `interval' ms.
+    bool           subscribeAll = false;
+    QSet<QString>  subscriptions;
+    QSet<QString>  pending;
+    qint64         interval = 1000 / SIGDIGGER_REMOTE_CONTROL_DEFAULT_RATE;
+    qint64         lastPush = -1;
+
+    // Binary streams
+    bool                             psdStream = false;
+    RemoteControlStream              psd;
+    QMap<int, RemoteControlStream>   power;
+    QByteArray                       frame;
+
+    RemoteControlClient(QTcpSocket *, RemoteControlServer *);
     ~RemoteControlClient();
     void process();
     void write(QString const &);
+
+    bool isSubscribed(QString const &) const;
+    qint64 flush(qint64 now);
+    qint64 flushPSD(qint64 now);
+    qint64 flushPower(int, RemoteControlStream &, qint64 now);
+    void pushPowerSample(int, qreal timestamp, qreal power);
+
+  private:
+    void doSet(QStringList const &);
+    void doGet(QStringList const &);
+    void doSubscribe(QStringList const &);
+    void doUnsubscribe(QStringList const &);
+    void doRate(QStringList const &);
+    void doStream(QStringList const &);
+
+    void beginFrame(uint8_t type, uint16_t source, uint32_t sequence);
+    void endFrame();
   };
 
   class RemoteControlServer : public QObject
@@ -52,7 +142,22 @@ namespace SigDigger{
     std::list<RemoteControlClient *> m_clientList;
     QMap<QTcpSocket *, RemoteControlClient *> m_socketToClient;
 
+    // Property change notification
+    QSet<GlobalProperty *> m_watched;
+    QTimer *m_pushTimer = nullptr;
+    QElapsedTimer m_clock;
+
+    // Stream sources
+    std::vector<float> m_psd;
+    qreal    m_psdTimeStamp = 0;
+    qreal    m_psdFrequency = 0;
+    qreal    m_psdSampleRate = 0;
+    quint64  m_psdFrame = 0;
+    QMap<int, QString> m_powerSources;
+    int      m_lastPowerSource = 0;
+
     void connectAll();
+    void schedulePush(qint64 delay);
 
     void addConnection(QTcpSocket *);
     void removeConnection(QTcpSocket *);
@@ -67,10 +172,35 @@ namespace SigDigger{
     void setPort(uint16_t);
     QString getLastError() const;
 
+    void watchProperty(GlobalProperty *);
+    qint64 now() const;
+
+    // Streaming. Data is only copied if some client asked for it.
+    bool wantsPSD() const;
+    void publishPSD(
+        qreal timeStamp,
+        qreal frequency,
+        qreal sampleRate,
+        const SUFLOAT *data,
+        size_t size);
+    int  registerPowerSource(QString const &);
+    void unregisterPowerSource(int);
+    void publishPower(int, qreal timeStamp, qreal power);
+
+    QMap<int, QString> const &powerSources() const;
+    bool getPSD(
+        quint64 &frame,
+        qreal &timeStamp,
+        qreal &frequency,
+        qreal &sampleRate,
+        std::vector<float> const *&data) const;
+
   public slots:
     void onNewConnection();
     void onDataReady();
     void onDisconnect();
+    void onPropertyChanged();
+    void onPushTimeout();
   };
 }
 
@@ -43,11 +43,24 @@ namespace SigDigger {
       float delta = 0;
       unsigned int length = 0;
       std::vector<float> gaussian;
+      std::vector<float> folded; // Gaussian folded into one interval
+      std::vector<float> weights; // Gradient weights
       std::vector<float> Hi;     // Model histogram
       std::vector<float> Htilde; // Actual histogram
       float sqerr = INFINITY;
       bool dirty = false;
+
+      // Model cache. The model only depends on these.
+      float modelSigma = -1;
+      unsigned int modelIntervals = 0;
+      unsigned int modelLength = 0;
+
+      // Gradient weights cache
+      unsigned int weightIntervals = 0;
+      unsigned int weightLength = 0;
+
       void recalculateModel(void);
+      void recalculateWeights(void);
       void calculateSquareError(void);
       void iterate(void);
 
@@ -0,0 +1,126 @@
+//
+//    SampleStatsEngine.h: Background statistics of sample ranges
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SAMPLESTATSENGINE_H
+#define SAMPLESTATSENGINE_H
+
+#include <QObject>
+#include <sigutils/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+// Magnitude histogram resolution, used for percentiles
+#define SIGDIGGER_STATS_HISTOGRAM_BINS 4096
+// Samples processed between cancellation checks
+#define SIGDIGGER_STATS_CHUNK_SAMPLES  0x10000
+#define SIGDIGGER_STATS_MAX_WORKERS    8
+#define SIGDIGGER_STATS_CACHE_ENTRIES  32
+// Ranges up to this size are computed right away, in the caller thread
+#define SIGDIGGER_STATS_SYNC_SAMPLES   0x40000
+
+namespace SigDigger {
+  struct SampleStats {
+    SUCOMPLEX min = 0;
+    SUCOMPLEX max = 0;
+    SUCOMPLEX mean = 0;
+    SUFLOAT   rms = 0;
+    SUFLOAT   peak = 0;     // Largest magnitude
+    qreal     papr = 0;     // Peak to average power ratio, in dB
+    SUFLOAT   p50 = 0;      // Magnitude percentiles
+    SUFLOAT   p90 = 0;
+    SUFLOAT   p99 = 0;
+    size_t    count = 0;
+  };
+
+  //
+  // Computes statistics of sample ranges in a background thread, which
+  // splits each range among several workers. Sums are accumulated in
+  // double precision per chunk and then added with Neumaier's compensated
+  // summation, so the result does not degrade with the length of the
+  // range. Percentiles come from a magnitude histogram computed in a
+  // second pass.
+  //
+  // Only the last requested range is computed: a new request cancels the
+  // one in progress. Results are cached per range until the data changes.
+  //
+  class SampleStatsEngine : public QObject {
+    Q_OBJECT
+
+    typedef std::tuple<const SUCOMPLEX *, size_t, size_t> Key;
+
+    struct Entry {
+      SampleStats stats;
+      quint64 lastUse;
+    };
+
+    std::map<Key, Entry> m_cache;
+    quint64 m_useCounter = 0;
+
+    Key m_job;
+    bool m_haveJob = false;
+    bool m_busy = false;
+    bool m_running = true;
+    std::atomic<quint64> m_generation;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_worker;
+
+    void work();
+    void store(Key const &, SampleStats const &);
+
+  public:
+    typedef std::function<bool ()> CancelCallback;
+
+    SampleStatsEngine(QObject *parent = nullptr);
+    ~SampleStatsEngine() override;
+
+    // Returns true if the statistics are available right now. Otherwise,
+    // they are computed in the background and ready() is emitted with
+    // the generation they belong to.
+    bool request(
+        const SUCOMPLEX *data,
+        size_t from,
+        size_t to,
+        SampleStats &stats);
+
+    // Cancels pending work and drops all results. Must be called before
+    // the data is modified or released.
+    void invalidate();
+
+    // Results of other generations were invalidated, and their ready()
+    // signals must be ignored
+    quint64 generation() const;
+
+    static bool compute(
+        const SUCOMPLEX *data,
+        size_t count,
+        SampleStats &stats,
+        CancelCallback const &cancelled = CancelCallback());
+
+  signals:
+    void ready(quint64 generation);
+  };
+}
+
+#endif // SAMPLESTATSENGINE_H
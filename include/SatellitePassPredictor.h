@@ -0,0 +1,125 @@
+//
+//    SatellitePassPredictor.h: Upcoming passes over the whole TLE catalog
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SATELLITEPASSPREDICTOR_H
+#define SATELLITEPASSPREDICTOR_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <Suscan/Library.h>
+#include <sgdp4/sgdp4.h>
+#include <sys/time.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Coarse sampling step, as a fraction of the orbital period
+#define SIGDIGGER_PASS_PREDICTOR_COARSE_STEPS  20
+#define SIGDIGGER_PASS_PREDICTOR_MIN_STEP      20.
+#define SIGDIGGER_PASS_PREDICTOR_MAX_STEP      600.
+// Refinement tolerance of AOS, LOS and culmination, in seconds
+#define SIGDIGGER_PASS_PREDICTOR_TOLERANCE     1.
+
+namespace SigDigger {
+  struct SatellitePass {
+    QString satellite;
+    struct timeval aos;
+    struct timeval tca;
+    struct timeval los;
+    qreal aosAzimuth;     // Degrees
+    qreal losAzimuth;     // Degrees
+    qreal maxElevation;   // Degrees
+    qreal maxRangeRate;   // km/s, absolute value
+
+    qreal duration() const;
+    qreal maxDoppler(qreal frequency) const;
+  };
+
+  //
+  // Finds the passes of every satellite in the singleton over the QTH.
+  // Elevation is sampled at a fraction of the orbital period, and every
+  // local maximum is refined by golden section search, so that grazing
+  // passes between two samples are not missed. AOS and LOS are then
+  // bisected down to the tolerance.
+  //
+  // Satellites are spread over worker threads. Results are cached per
+  // satellite and TLE epoch while the QTH and minimum elevation stay the
+  // same. A later window that starts inside the cached one only computes
+  // what lies past its end.
+  //
+  class SatellitePassPredictor : public QObject {
+    Q_OBJECT
+
+    struct CacheEntry {
+      int    epochYear;
+      double epochDay;
+      double from;
+      double to;
+      QVector<SatellitePass> passes;
+    };
+
+    xyz_t  m_qth;
+    bool   m_haveQth = false;
+    qreal  m_minElevation = 0;
+
+    QHash<QString, CacheEntry> m_cache;
+    QVector<SatellitePass> m_passes;
+    mutable std::mutex m_mutex;
+
+    std::thread m_thread;
+    std::atomic<bool> m_cancel;
+    std::atomic<bool> m_running;
+
+    void invalidate();
+    void run(QVector<Suscan::Orbit> orbits, double from, double to);
+    bool findPasses(
+        Suscan::Orbit const &,
+        double from,
+        double to,
+        QVector<SatellitePass> &);
+    bool updatePasses(
+        Suscan::Orbit const &,
+        double from,
+        double to,
+        QVector<SatellitePass> &);
+
+  public:
+    explicit SatellitePassPredictor(QObject *parent = nullptr);
+    ~SatellitePassPredictor() override;
+
+    void setQth(xyz_t const &);
+    void setMinElevation(qreal degrees);
+
+    bool start(struct timeval const &from, qreal seconds);
+    void cancel();
+    bool isRunning() const;
+
+    QVector<SatellitePass> passes() const;
+    bool nextPass(
+        QString const &satellite,
+        struct timeval const &after,
+        SatellitePass &) const;
+
+  signals:
+    void progress(int done, int total);
+    void finished();
+  };
+}
+
+#endif // SATELLITEPASSPREDICTOR_H
@@ -0,0 +1,49 @@
+//
+//    SatellitePassTableModel.h: Table of upcoming satellite passes
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SATELLITEPASSTABLEMODEL_H
+#define SATELLITEPASSTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <SatellitePassPredictor.h>
+
+// Role holding the raw value of each column, for sorting
+#define SIGDIGGER_PASS_SORT_ROLE Qt::UserRole
+
+namespace SigDigger {
+  class SatellitePassTableModel : public QAbstractTableModel {
+      Q_OBJECT
+
+      QVector<SatellitePass> passes;
+      qreal frequency = 0;
+
+    public:
+      SatellitePassTableModel(QObject *parent);
+
+      void setPasses(QVector<SatellitePass> const &);
+      void setFrequency(qreal);
+      SatellitePass const *passAt(int row) const;
+
+      int rowCount(const QModelIndex &) const override;
+      int columnCount(const QModelIndex &) const override;
+      QVariant data(const QModelIndex &, int) const override;
+      QVariant headerData(int, Qt::Orientation, int) const override;
+  };
+}
+
+#endif // SATELLITEPASSTABLEMODEL_H
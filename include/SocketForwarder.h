@@ -25,6 +25,24 @@
 #define SIGDIGGER_UDPFORWARDER_MAX_UDP_SAMPLES \
   (SIGDIGGER_UDPFORWARDER_MAX_UDP_PAYLOAD_SIZE / static_cast<ssize_t>(sizeof(float _Complex)))
 
+// Largest payload of an IPv4 UDP datagram (65535 - 8 - 20)
+#define SIGDIGGER_UDPFORWARDER_MAX_DATAGRAM_SIZE    65507
+#define SIGDIGGER_UDPFORWARDER_IPV4_UDP_OVERHEAD    28
+
+// Datagrams per sendmmsg() / GSO call
+#define SIGDIGGER_UDPFORWARDER_BATCH_SIZE           64
+#define SIGDIGGER_UDPFORWARDER_SNDBUF_SIZE          (4 << 20)
+
+// Optional header prepended to every datagram, in network byte order.
+// The sequence number increments by one per datagram, so receivers can
+// detect (and count) lost datagrams.
+#define SIGDIGGER_UDPFORWARDER_HEADER_MAGIC         0x53444746 // "SDGF"
+
+struct SigDiggerForwarderHeader {
+  uint32_t magic;
+  uint32_t sequence;
+};
+
 namespace SigDigger {
   class SocketDataWriter;
 
@@ -39,6 +57,7 @@ namespace SigDigger {
         uint16_t port,
         unsigned int size,
         bool tcp,
+        bool header,
         QObject *parent = nullptr);
   };
 }
@@ -0,0 +1,57 @@
+//
+//    SocketStreamServer.h: Serve inspector data to multiple subscribers
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SOCKETSTREAMSERVER_H
+#define SOCKETSTREAMSERVER_H
+
+#include "GenericDataSaver.h"
+#include <string>
+
+// Data waiting to be sent to a single subscriber. Above this, whole
+// buffers are dropped (oldest first) for that subscriber only.
+#define SIGDIGGER_STREAM_SERVER_MAX_QUEUE   (8 << 20)
+#define SIGDIGGER_STREAM_SERVER_SNDBUF_SIZE (1 << 20)
+#define SIGDIGGER_STREAM_SERVER_BACKLOG     16
+
+namespace SigDigger {
+  class StreamServerWriter;
+
+  //
+  // Listening counterpart of SocketForwarder. Decoders connect to a TCP
+  // port or a Unix domain socket and receive the raw inspector samples
+  // from the moment they subscribe. A slow subscriber never stalls the
+  // others nor the capture: its backlog is bounded and dropped instead.
+  //
+  class SocketStreamServer : public GenericDataSaver {
+    Q_OBJECT
+
+    StreamServerWriter *writer; // Owned by GenericDataSaver
+
+  public:
+    SocketStreamServer(
+        std::string const &address, // Bind address, or socket path if local
+        uint16_t port,
+        bool local,
+        QObject *parent = nullptr);
+
+    unsigned int getSubscriberCount(void) const;
+    quint64 getDroppedBytes(void) const;
+  };
+}
+
+#endif // SOCKETSTREAMSERVER_H
@@ -0,0 +1,144 @@
+//
+//    SpectrogramEngine.h: Tiled STFT of sample buffers
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SPECTROGRAMENGINE_H
+#define SPECTROGRAMENGINE_H
+
+#include <QObject>
+#include <sigutils/types.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Spectra per tile
+#define SIGDIGGER_SPECTROGRAM_TILE_COLUMNS  256
+#define SIGDIGGER_SPECTROGRAM_DEFAULT_FFT   1024
+#define SIGDIGGER_SPECTROGRAM_MIN_FFT       64
+#define SIGDIGGER_SPECTROGRAM_MAX_FFT       8192
+// FFTs averaged per spectrum when the hop exceeds the FFT size
+#define SIGDIGGER_SPECTROGRAM_MAX_AVERAGE   8
+#define SIGDIGGER_SPECTROGRAM_MAX_WORKERS   4
+// Memory used by cached tiles
+#define SIGDIGGER_SPECTROGRAM_CACHE_BYTES   (64 << 20)
+
+namespace SigDigger {
+  //
+  // Identifies a tile: spectra [index * columns, (index + 1) * columns)
+  // of an STFT with the given FFT size and hop. The hop is a power of two
+  // that depends on the zoom level, so tiles are reused while panning.
+  //
+  struct SpectrogramTileKey {
+    unsigned int fftSize;
+    size_t       hop;
+    size_t       index;
+
+    bool
+    operator<(SpectrogramTileKey const &other) const
+    {
+      return std::tie(fftSize, hop, index)
+          < std::tie(other.fftSize, other.hop, other.index);
+    }
+
+    bool
+    operator==(SpectrogramTileKey const &other) const
+    {
+      return fftSize == other.fftSize
+          && hop == other.hop
+          && index == other.index;
+    }
+  };
+
+  struct SpectrogramTile {
+    SpectrogramTileKey key;
+    unsigned int columns;      // Less than the tile size at the end
+    std::vector<float> power;  // dBFS, columns x fftSize, DC centered
+    float max;
+
+    const float *
+    column(unsigned int i) const
+    {
+      return power.data() + static_cast<size_t>(i) * key.fftSize;
+    }
+  };
+
+  typedef std::shared_ptr<const SpectrogramTile> SpectrogramTilePtr;
+
+  //
+  // Computes STFT tiles of a buffer on a small thread pool. Requests
+  // replace the queue of pending tiles, so only what is visible now gets
+  // computed, in the order given. FFT plans and windows are created once
+  // per size and shared by all workers.
+  //
+  class SpectrogramEngine : public QObject {
+    Q_OBJECT
+
+    struct Plan;
+
+    const SUCOMPLEX *m_data = nullptr;
+    size_t m_length = 0;
+    quint64 m_generation = 0;
+
+    std::map<SpectrogramTileKey, std::pair<SpectrogramTilePtr, quint64>> m_tiles;
+    size_t m_cacheBytes = 0;
+    quint64 m_useCounter = 0;
+
+    std::deque<SpectrogramTileKey> m_queue;
+    std::vector<SpectrogramTileKey> m_inProgress;
+    unsigned int m_busy = 0;
+    bool m_running = true;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<std::thread> m_workers;
+
+    static std::shared_ptr<Plan> plan(unsigned int fftSize);
+
+    void work();
+    SpectrogramTilePtr compute(
+        SpectrogramTileKey const &,
+        const SUCOMPLEX *data,
+        size_t length) const;
+    void store(SpectrogramTilePtr const &);
+
+  public:
+    SpectrogramEngine(QObject *parent = nullptr);
+    ~SpectrogramEngine() override;
+
+    // Drops all tiles and waits for the workers to stop reading the
+    // previous buffer.
+    void setData(const SUCOMPLEX *data, size_t length);
+
+    size_t length() const;
+
+    SpectrogramTilePtr tile(SpectrogramTileKey const &);
+    void request(std::vector<SpectrogramTileKey> const &);
+
+    static size_t hopForZoom(qreal samplesPerPixel);
+    static size_t tileSamples(size_t hop);
+
+  signals:
+    void tileReady();
+  };
+}
+
+#endif // SPECTROGRAMENGINE_H
@@ -0,0 +1,81 @@
+//
+//    SpectrogramView.h: Spectrogram of time window captures
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SPECTROGRAMVIEW_H
+#define SPECTROGRAMVIEW_H
+
+#include <QFrame>
+#include <QImage>
+#include "SpectrogramEngine.h"
+
+// Levels shown below the strongest visible bin, in dB
+#define SIGDIGGER_SPECTROGRAM_DEFAULT_RANGE 80.
+
+namespace SigDigger {
+  //
+  // Draws the spectrogram of the samples between the horizontal limits of
+  // the waveforms. Only the tiles that intersect that range, at the hop
+  // that matches the current zoom level, are requested to the engine.
+  // The mouse wheel zooms in frequency, and double clicking resets it.
+  //
+  class SpectrogramView : public QFrame {
+    Q_OBJECT
+
+    SpectrogramEngine m_engine;
+
+    const SUCOMPLEX *m_data = nullptr;
+    size_t m_length = 0;
+    qint64 m_start = 0;
+    qint64 m_end = 0;
+
+    // Visible band, relative to the sample rate
+    qreal m_freqMin = -.5;
+    qreal m_freqMax = +.5;
+
+    unsigned int m_fftSize = SIGDIGGER_SPECTROGRAM_DEFAULT_FFT;
+    qreal m_range = SIGDIGGER_SPECTROGRAM_DEFAULT_RANGE;
+
+    QRgb m_colors[256];
+    QColor m_background = Qt::black;
+    QImage m_image;
+
+  protected:
+    void paintEvent(QPaintEvent *) override;
+    void wheelEvent(QWheelEvent *) override;
+    void mouseDoubleClickEvent(QMouseEvent *) override;
+    void contextMenuEvent(QContextMenuEvent *) override;
+
+  public:
+    explicit SpectrogramView(QWidget *parent = nullptr);
+
+    void setData(const SUCOMPLEX *data, size_t length);
+    void setTimeRange(qint64 start, qint64 end);
+    void setFftSize(unsigned int);
+    void setDynamicRange(qreal);
+    void setGradient(const QColor *gradient);
+    void setBackgroundColor(QColor const &);
+
+    unsigned int getFftSize() const;
+
+  public slots:
+    void resetFrequencyZoom();
+    void onTileReady();
+  };
+}
+
+#endif // SPECTROGRAMVIEW_H
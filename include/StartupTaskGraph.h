@@ -0,0 +1,69 @@
+//
+//    StartupTaskGraph.h: Run initialization stages concurrently
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef STARTUPTASKGRAPH_H
+#define STARTUPTASKGRAPH_H
+
+#include <QString>
+#include <functional>
+#include <vector>
+#include <string>
+
+#define SIGDIGGER_STARTUP_MAX_WORKERS 4
+
+namespace SigDigger {
+  struct StartupTask {
+    QString name;
+    QString message;
+    std::function<void ()> func;
+    std::vector<int> deps;
+
+    // Filled by run()
+    unsigned int worker = 0;
+    qint64 startNs = 0;
+    qint64 endNs   = 0;
+  };
+
+  //
+  // Stages with no path between them in the dependency graph may run at
+  // the same time, so anything touching shared state (e.g. the suscan
+  // config database) must be chained explicitly. The first exception
+  // thrown by a stage stops scheduling and is rethrown by run() once the
+  // stages in flight are done.
+  //
+  class StartupTaskGraph {
+    std::vector<StartupTask> m_tasks;
+    qint64 m_totalNs = 0;
+
+  public:
+    int add(
+        QString const &name,
+        QString const &message,
+        std::function<void ()> func,
+        std::vector<int> const &deps = std::vector<int>());
+
+    void run(
+        std::function<void (QString const &)> onStart,
+        unsigned int workers = 0);
+
+    std::vector<StartupTask> const &tasks() const;
+    QString report() const;
+  };
+}
+
+#endif // STARTUPTASKGRAPH_H
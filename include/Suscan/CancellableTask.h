@@ -21,6 +21,7 @@
 
 #include <QObject>
 #include <QThread>
+#include <atomic>
 
 namespace Suscan {
   class CancellableTask : public QObject
@@ -30,12 +31,17 @@ namespace Suscan {
     qreal prog;
     QString status;
     quint64 dataSize = 0;
+    std::atomic<bool> cancelRequested;
 
   protected:
     void setDataSize(quint64);
     void setProgress(qreal progress);
     void setStatus(QString status);
 
+    // Tasks that do all their work in a single call to work() cannot
+    // receive queued cancel requests. They should poll this instead.
+    bool isCancelRequested(void) const;
+
   public:
     explicit CancellableTask(QObject *parent = nullptr);
     virtual ~CancellableTask(void) override;
@@ -63,6 +69,9 @@ namespace Suscan {
 
     static void assertTypeRegistration(void);
 
+    // Thread-safe, may be called from any thread
+    void requestCancel(void);
+
   public slots:
     void onWorkRequested(void);
     void onCancelRequested(void);
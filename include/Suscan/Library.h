@@ -55,6 +55,7 @@ namespace Suscan {
   uint qHash(const Suscan::Source::Device &dev);
 
   class MultitaskController;
+  class StartupCache;
   class Plugin;
 
   typedef std::map<std::string, Source::Config> ConfigMap;
@@ -258,7 +259,9 @@ namespace Suscan {
 
     // Background tasks
     MultitaskController *backgroundTaskController = nullptr;
+    StartupCache *startupCache = nullptr;
     std::vector<Source::Device> devices;
+    QHash<const suscan_source_device_t *, bool> deviceState;
     ConfigMap profiles;
     std::vector<Object> palettes;
     std::vector<Object> autoGains;
@@ -271,6 +274,7 @@ namespace Suscan {
     QMap<QString, Location>         locations;
     QMap<std::string, TLESource>    tleSources;
     QMap<qint64, Bookmark>          bookmarks;
+    quint64                         bookmarkRevision = 0;
     QMap<std::string, SpectrumUnit> spectrumUnits;
     QHash<QString, Source::Config>  networkProfiles;
 
@@ -308,6 +312,7 @@ namespace Suscan {
     void syncLocations();
     void syncTLESources();
     void syncBookmarks();
+    void dropBookmarkEntries(std::vector<int> &entries);
     void initLocationsFromContext(ConfigContext &ctx, bool user);
     void initTLESourcesFromContext(ConfigContext &ctx, bool user);
 
@@ -326,8 +331,11 @@ namespace Suscan {
     void init_locations();
     void init_bookmarks();
     void init_tle_sources();
-    void init_tle();
+    void init_tle(QString const &userTLEDir);
     void init_plugins();
+    void init_startup_cache();
+    QString getUserTLEDir() const;
+    void saveStartupCache();
     void detect_devices();
     void trigger_delayed();
 
@@ -360,6 +368,9 @@ namespace Suscan {
     void removeSpectrumUnit(std::string const &);
 
     void refreshDevices();
+    bool updateDevices(
+        std::vector<Source::Device> &added,
+        std::vector<Source::Device> &removed);
     void refreshNetworkProfiles();
 
     bool registerTLE(std::string const &);
@@ -390,6 +401,7 @@ namespace Suscan {
     QMap<qint64, Bookmark>::const_iterator getFirstBookmark() const;
     QMap<qint64, Bookmark>::const_iterator getLastBookmark() const;
     QMap<qint64, Bookmark>::const_iterator getBookmarkFrom(qint64 bm) const;
+    quint64 getBookmarkRevision() const;
 
     QMap<QString, Location> const &getLocationMap() const;
     QMap<QString, Location>::const_iterator getFirstLocation() const;
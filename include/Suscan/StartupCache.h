@@ -0,0 +1,83 @@
+//
+//    StartupCache.h: Binary snapshot of slow-to-parse startup data
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef STARTUPCACHE_H
+#define STARTUPCACHE_H
+
+#include <Suscan/Library.h>
+#include <QFileInfo>
+#include <QString>
+#include <QHash>
+
+#define SUSCAN_STARTUP_CACHE_MAGIC   0x53444331 // "SDC1"
+#define SUSCAN_STARTUP_CACHE_VERSION 1
+#define SUSCAN_STARTUP_CACHE_FILE    "startup.cache"
+
+namespace Suscan {
+  //
+  // Parsed TLE files and the bookmark list, keyed by the modification time
+  // and size of the file they came from. Any mismatch (or a different
+  // orbit_t layout) makes the entry count as absent. TLE entries and the
+  // bookmark snapshot are independent, so that they can be looked up and
+  // stored from different threads.
+  //
+  class StartupCache {
+    struct FileStamp {
+      qint64 mtime = -1;
+      qint64 size  = -1;
+
+      bool matches(QFileInfo const &) const;
+      static FileStamp of(QFileInfo const &);
+    };
+
+    struct TLEEntry {
+      FileStamp  stamp;
+      bool       valid = false;
+      QByteArray name;
+      QByteArray orbit;
+    };
+
+    QString m_path;
+    QHash<QString, TLEEntry> m_tle;
+    QHash<QString, TLEEntry> m_tleSeen;
+    bool m_tleDirty = false;
+
+    FileStamp m_bookmarkStamp;
+    QList<Bookmark> m_bookmarks;
+    bool m_bookmarksValid = false;
+    bool m_bookmarksDirty = false;
+
+  public:
+    StartupCache();
+
+    static QString bookmarkFile();
+
+    bool load();
+    bool save();
+
+    // Returns true on a hit. Files that failed to parse are cached too,
+    // in which case `ok' is false.
+    bool lookupOrbit(QFileInfo const &, Orbit &, bool &ok);
+    void storeOrbit(QFileInfo const &, Orbit const *);
+
+    bool lookupBookmarks(QMap<qint64, Bookmark> &) const;
+    void storeBookmarks(QMap<qint64, Bookmark> const &);
+  };
+}
+
+#endif // STARTUPCACHE_H
@@ -0,0 +1,73 @@
+//
+//    TextBlockWriter.h: Block-based, parallel text formatting
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef TEXTBLOCKWRITER_H
+#define TEXTBLOCKWRITER_H
+
+#include <ostream>
+#include <functional>
+#include <vector>
+
+// Items formatted by each worker per block
+#define SIGDIGGER_TEXT_BLOCK_ITEMS       0x8000
+#define SIGDIGGER_TEXT_BLOCK_MAX_WORKERS 8
+
+// Room needed by formatReal() for any float or double
+#define SIGDIGGER_TEXT_MAX_NUMBER_LENGTH 32
+
+namespace SigDigger {
+  // Shortest representation that reads back to the same value. Returns
+  // a pointer past the last written character.
+  char *formatReal(char *p, float);
+  char *formatReal(char *p, double);
+  char *formatString(char *p, const char *);
+
+  //
+  // Formats large arrays as text into reusable buffers, block by block.
+  // Each block is split among several threads, each one formatting a
+  // contiguous range of items into its own buffer. Buffers are then
+  // written in order, so the output does not depend on the number of
+  // workers.
+  //
+  class TextBlockWriter {
+  public:
+    // Formats items [from, to) at the given pointer. Must not write more
+    // than maxItemLength bytes per item.
+    typedef std::function<char *(char *, size_t from, size_t to)> Formatter;
+
+    // Called after each block with the number of items written so far.
+    // Return false to stop.
+    typedef std::function<bool (size_t)> Progress;
+
+  private:
+    std::ostream &m_os;
+    size_t m_maxItemLength;
+    unsigned int m_workers;
+    std::vector<std::vector<char>> m_buffers;
+
+  public:
+    TextBlockWriter(
+        std::ostream &os,
+        size_t maxItemLength,
+        unsigned int workers = 0);
+
+    bool write(size_t count, Formatter const &, Progress const & = Progress());
+  };
+}
+
+#endif // TEXTBLOCKWRITER_H
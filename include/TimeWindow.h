@@ -28,6 +28,7 @@
 #include "HistogramDialog.h"
 #include "SamplerDialog.h"
 #include "DopplerDialog.h"
+#include "SampleStatsEngine.h"
 
 #include "WaveSampler.h"
 
@@ -41,6 +42,8 @@ namespace Ui {
 }
 
 namespace SigDigger {
+  class CaptureOverview;
+
   class TimeWindow : public QMainWindow
   {
     Q_OBJECT
@@ -65,9 +68,14 @@ namespace SigDigger {
 
     std::vector<SUCOMPLEX> m_processedData;
 
+    // Reads from the data above, must be destroyed first
+    SampleStatsEngine m_statsEngine;
+
     const SUCOMPLEX *m_displayDataPtr = nullptr;
     size_t           m_displayDataLength = 0;
 
+    const CaptureOverview *m_overview = nullptr;
+
     SUFREQ    m_centerFreq;
 
     bool m_taskRunning = false;
@@ -110,6 +118,7 @@ namespace SigDigger {
         bool keepView = false);
     const SUCOMPLEX *getDisplayData() const;
     size_t getDisplayDataLength() const;
+    bool overviewCoversDisplayData() const;
 
     static void adjustButtonToSize(
             QPushButton *button,
@@ -134,6 +143,7 @@ namespace SigDigger {
         size_t size,
         qreal fs,
         qreal bw);
+    void setOverview(const CaptureOverview *);
     void refresh();
     void setPalette(std::string const &);
     void setPaletteOffset(unsigned int);
@@ -174,6 +184,7 @@ namespace SigDigger {
     void onShowEnvelope();
     void onShowPhase();
     void onPhaseDerivative();
+    void onShowSpectrogram();
     void onPaletteChanged(int);
     void onChangePaletteOffset(int);
     void onChangePaletteContrast(int);
@@ -218,6 +229,8 @@ namespace SigDigger {
     void onWaveViewChanged();
     void onZeroCrossingComponentChanged();
     void onZeroPointChanged();
+    void onOverviewReady();
+    void onStatsReady(quint64);
   };
 }
 
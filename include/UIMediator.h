@@ -29,6 +29,7 @@
 #include <WFHelpers.h>
 #include <PersistentWidget.h>
 #include <Averager.h>
+#include <PSDRateController.h>
 #include <QMessageBox>
 
 #define SIGDIGGER_UI_MEDIATOR_DEFAULT_MIN_FREQ  0
@@ -39,6 +40,8 @@
 #define SIGDIGGER_UI_MEDIATOR_LOCAL_GRACE_PERIOD_MS  -1
 #define SIGDIGGER_UI_MEDIATOR_REMOTE_GRACE_PERIOD_MS 1000
 
+class QLabel;
+
 namespace SigDigger {
   class UIComponent;
   class TabWidget;
@@ -70,6 +73,7 @@ namespace SigDigger {
     RemoteControlServer *m_remoteControl = nullptr;
 
     QMessageBox *m_laggedMsgBox = nullptr;
+    QLabel *m_psdRateLabel = nullptr;
     std::map<std::string, QAction *> m_bandPlanMap;
 
     // Cached members
@@ -104,6 +108,7 @@ namespace SigDigger {
     bool m_haveRtDelta = false;
     unsigned int m_rtCalibrations = 0;
     qreal m_rtDeltaReal = 0;
+    PSDRateController m_psdRateController;
 
     // Private methods
     void connectMainWindow();
@@ -121,6 +126,9 @@ namespace SigDigger {
     void refreshProfile(bool updateFreqs = true);
     void refreshTimeToolbarState();
     void setCurrentAutoGain();
+    bool isPSDRateAdaptive() const;
+    void applyPSDRate();
+    void refreshPSDRateIndicator();
 
     // Other setters
     void setSourceTimeStart(struct timeval const &);
@@ -158,6 +166,7 @@ namespace SigDigger {
     Averager     *getSpectrumAverager();
     AppUI        *getAppUI() const;
     AppConfig    *getAppConfig() const;
+    RemoteControlServer *getRemoteControl() const;
     bool          addTabWidget(TabWidget *);
     bool          addUIListener(UIListener *);
     bool          closeTabWidget(TabWidget *);
@@ -202,7 +211,7 @@ namespace SigDigger {
         quint64 freqEnd,
         float *data,
         size_t size);
-    void refreshDevicesDone();
+    void refreshDevicesDone(bool changed = true);
 
     QMessageBox::StandardButton shouldReduceRate(
         QString const &label,
@@ -0,0 +1,74 @@
+//
+//    UpcomingPassesDialog.h: Sortable table of upcoming satellite passes
+//    Copyright (C) 2022 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef UPCOMINGPASSESDIALOG_H
+#define UPCOMINGPASSESDIALOG_H
+
+#include <QDialog>
+#include <QModelIndex>
+#include <sgdp4/sgdp4.h>
+#include <sys/time.h>
+
+namespace Ui {
+  class UpcomingPassesDialog;
+}
+
+class QSortFilterProxyModel;
+
+namespace SigDigger {
+  class SatellitePassPredictor;
+  class SatellitePassTableModel;
+
+  class UpcomingPassesDialog : public QDialog
+  {
+      Q_OBJECT
+
+      SatellitePassPredictor  *predictor = nullptr;
+      SatellitePassTableModel *model = nullptr;
+      QSortFilterProxyModel   *proxy = nullptr;
+      struct timeval timeStamp;
+      bool haveTimeStamp = false;
+
+      void connectAll(void);
+
+    public:
+      explicit UpcomingPassesDialog(QWidget *parent = nullptr);
+      virtual ~UpcomingPassesDialog() override;
+
+      void setQth(xyz_t const &);
+      void setFrequency(qreal);
+      void setTimestamp(struct timeval const &);
+      void refresh(void);
+
+      SatellitePassPredictor *getPredictor(void) const;
+
+    private:
+      Ui::UpcomingPassesDialog *ui;
+
+    public slots:
+      void onRefresh(void);
+      void onProgress(int, int);
+      void onFinished(void);
+      void onCellActivated(QModelIndex const &);
+
+    signals:
+      void passSelected(QString);
+  };
+}
+
+#endif // UPCOMINGPASSESDIALOG_H
@@ -105,7 +105,7 @@ getLogText(void)
 }
 
 static int
-runSigDigger(QApplication &app)
+runSigDigger(QApplication &app, bool profile)
 {
   int ret = 1;
 
@@ -113,6 +113,8 @@ runSigDigger(QApplication &app)
     Application main_app;
     Loader loader(&main_app);
 
+    loader.setStartupProfile(profile);
+
     QSurfaceFormat fmt;
     fmt.setSamples(16);
     QSurfaceFormat::setDefaultFormat(fmt);
@@ -149,6 +151,7 @@ help(const char *argv0)
 
   fprintf(stderr, "Options:\n\n");
   fprintf(stderr, "     -t, --tool=\"tool name\"  Tool to launch\n");
+  fprintf(stderr, "     -p, --startup-profile   Print the time taken by each startup stage\n");
   fprintf(stderr, "     -h, --help              This help\n\n");
   fprintf(
         stderr,
@@ -174,6 +177,7 @@ help(const char *argv0)
 
 static struct option long_options[] = {
   {"tool",  required_argument, nullptr, 't' },
+  {"startup-profile", no_argument, nullptr, 'p' },
   {"help",  no_argument,       nullptr, 'h' },
   {nullptr, 0,                 nullptr, 0 }
 };
@@ -195,6 +199,7 @@ main(int argc, char *argv[])
   QApplication app(argc, argv);
   QString appName = "SigDigger";
   int ret = EXIT_FAILURE;
+  bool profile = false;
   int c;
 
 #ifdef __APPLE__
@@ -204,7 +209,7 @@ main(int argc, char *argv[])
   while (true) {
     int option_index = 0;
 
-    c = getopt_long(argc, argv, "t:h", long_options, &option_index);
+    c = getopt_long(argc, argv, "t:ph", long_options, &option_index);
     if (c == -1)
       break;
 
@@ -213,6 +218,10 @@ main(int argc, char *argv[])
         appName = optarg;
         break;
 
+      case 'p':
+        profile = true;
+        break;
+
       case 'h':
         help(argv[0]);
         exit(EXIT_SUCCESS);
@@ -228,7 +237,7 @@ main(int argc, char *argv[])
   }
 
   if (appName == "SigDigger") {
-    ret = runSigDigger(app);
+    ret = runSigDigger(app, profile);
   } else if (appName == "RMSViewer") {
     ret = runRMSViewer(app);
   } else if (appName == "FileViewer") {